@@ -0,0 +1,139 @@
+/**
+ * @file
+ * Benchmarks for the allocators compared against `std::allocator<>`.
+ *
+ * @copyright 2023 Steve Kinneberg <steve.kinneberg@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <enhanced_containers/guarded_allocator.h>
+#include <enhanced_containers/locked_pool.h>
+#include <enhanced_containers/no_swap_allocator.h>
+#include <enhanced_containers/secure_allocator.h>
+#include <enhanced_containers/zero_on_release_allocator.h>
+
+#include <benchmark/benchmark.h>
+
+#include <array>
+#include <cstddef>
+#include <exception>
+#include <memory>
+
+namespace {
+
+/// @brief Number of blocks each thread keeps live in the multi-threaded benchmarks.
+constexpr std::size_t batch_size{64};
+/// @brief Size of the blocks used in the multi-threaded benchmarks.
+constexpr std::size_t block_size{64};
+
+/// @brief Secure allocator layered over guard pages.  Spelled as an alias for the macros below.
+using guarded_secure_allocator = ec::serialized_secure_allocator<char, ec::guarded_allocator<char>>;
+
+/**
+ * @brief
+ * Latency of a single allocate/deallocate pair.
+ *
+ * Locking memory counts against `RLIMIT_MEMLOCK`, so sizes that cannot be locked are reported as
+ * errors rather than aborting the whole run.
+ *
+ * @tparam A    The allocator being measured.
+ */
+template <typename A>
+void allocate_deallocate(benchmark::State& state)
+{
+    A allocator;
+    auto len = static_cast<std::size_t>(state.range(0));
+
+    try {
+        for (auto _ : state) {
+            auto* ptr = allocator.allocate(len);
+            benchmark::DoNotOptimize(ptr);
+            allocator.deallocate(ptr, len);
+        }
+    } catch (const std::exception& e) {
+        state.SkipWithError(e.what());
+        return;
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.SetBytesProcessed(state.iterations() * len);
+}
+
+/**
+ * @brief
+ * Throughput of many threads allocating and deallocating small blocks at the same time.
+ *
+ * Each thread keeps a batch of blocks live so that the allocations share pages with each other.
+ *
+ * @tparam A    The allocator being measured.
+ */
+template <typename A>
+void threaded_churn(benchmark::State& state)
+{
+    A allocator;
+    std::array<char*, batch_size> blocks{};
+
+    try {
+        for (auto _ : state) {
+            for (auto& b : blocks) {
+                b = allocator.allocate(block_size);
+            }
+            benchmark::ClobberMemory();
+            for (auto* b : blocks) {
+                allocator.deallocate(b, block_size);
+            }
+        }
+    } catch (const std::exception& e) {
+        state.SkipWithError(e.what());
+        return;
+    }
+    state.SetItemsProcessed(state.iterations() * batch_size);
+}
+
+} // namespace
+
+
+#define EC_ALLOCATOR_BENCHMARK(_allocator)                          \
+    BENCHMARK_TEMPLATE(allocate_deallocate, _allocator)             \
+        ->RangeMultiplier(8)                                        \
+        ->Range(16, 64 << 20)
+
+EC_ALLOCATOR_BENCHMARK(std::allocator<char>);
+EC_ALLOCATOR_BENCHMARK(ec::zero_on_release_allocator<char>);
+EC_ALLOCATOR_BENCHMARK(ec::unserialized_no_swap_allocator<char>);
+EC_ALLOCATOR_BENCHMARK(ec::serialized_no_swap_allocator<char>);
+EC_ALLOCATOR_BENCHMARK(ec::unserialized_secure_allocator<char>);
+EC_ALLOCATOR_BENCHMARK(ec::serialized_secure_allocator<char>);
+EC_ALLOCATOR_BENCHMARK(ec::locked_pool_allocator<char>);
+EC_ALLOCATOR_BENCHMARK(ec::pooled_secure_allocator<char>);
+EC_ALLOCATOR_BENCHMARK(ec::pmr::secure_allocator<char>);
+EC_ALLOCATOR_BENCHMARK(ec::guarded_allocator<char>);
+EC_ALLOCATOR_BENCHMARK(guarded_secure_allocator);
+
+
+// The unserialized allocators are not thread safe, so they only get the single thread baseline.
+#define EC_THREADED_BENCHMARK(_allocator)                           \
+    BENCHMARK_TEMPLATE(threaded_churn, _allocator)                  \
+        ->ThreadRange(1, 8)                                         \
+        ->UseRealTime()
+
+EC_THREADED_BENCHMARK(std::allocator<char>);
+EC_THREADED_BENCHMARK(ec::serialized_no_swap_allocator<char>);
+EC_THREADED_BENCHMARK(ec::serialized_secure_allocator<char>);
+EC_THREADED_BENCHMARK(ec::locked_pool_allocator<char>);
+EC_THREADED_BENCHMARK(ec::pooled_secure_allocator<char>);
+EC_THREADED_BENCHMARK(ec::pmr::secure_allocator<char>);
+EC_THREADED_BENCHMARK(guarded_secure_allocator);
+
+BENCHMARK_TEMPLATE(threaded_churn, ec::unserialized_no_swap_allocator<char>);
+BENCHMARK_TEMPLATE(threaded_churn, ec::unserialized_secure_allocator<char>);
@@ -0,0 +1,287 @@
+/**
+ * @file
+ * Benchmarks for the secure container aliases compared against the plain STL containers.
+ *
+ * @copyright 2023 Steve Kinneberg <steve.kinneberg@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <enhanced_containers/no_swap_allocator.h>
+#include <enhanced_containers/secure_flat_hash_map.h>
+#include <enhanced_containers/secure_flat_map.h>
+#include <enhanced_containers/secure_inline_string.h>
+#include <enhanced_containers/secure_map.h>
+#include <enhanced_containers/secure_string.h>
+#include <enhanced_containers/secure_unordered_map.h>
+#include <enhanced_containers/secure_vector.h>
+#include <enhanced_containers/secure_wiping_vector.h>
+
+#include <benchmark/benchmark.h>
+
+#include <cstddef>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+/**
+ * @brief
+ * Construct and destroy a string short enough for the Short String Optimization.
+ *
+ * @tparam S    The string type being measured.
+ */
+template <typename S>
+void string_sso(benchmark::State& state)
+{
+    for (auto _ : state) {
+        S s{"secret"};
+        benchmark::DoNotOptimize(s.data());
+    }
+}
+
+/**
+ * @brief
+ * Hold a short secret the way it has to be held for it to be wiped: `std::basic_string` based
+ * strings must reserve past their small string buffer so that the secure allocator sees it.
+ *
+ * @tparam S    The string type being measured.
+ */
+template <typename S>
+void string_password(benchmark::State& state)
+{
+    for (auto _ : state) {
+        S s;
+        s.reserve(32);
+        s.append("correct horse battery");
+        benchmark::DoNotOptimize(s.data());
+    }
+}
+
+/**
+ * @brief
+ * Hold a short secret as in `string_password()`, with the no swap allocators retaining released
+ * pages so that the page is not locked and unlocked again for each string.
+ *
+ * @tparam S    The string type being measured.
+ */
+template <typename S>
+void string_password_retained(benchmark::State& state)
+{
+    ec::set_no_swap_retention_policy({.max_bytes = 1 << 20});
+    string_password<S>(state);
+    ec::set_no_swap_retention_policy({});
+}
+
+/**
+ * @brief
+ * Build a string one character at a time.
+ *
+ * @tparam S    The string type being measured.
+ */
+template <typename S>
+void string_append(benchmark::State& state)
+{
+    auto len = static_cast<std::size_t>(state.range(0));
+    for (auto _ : state) {
+        S s;
+        for (std::size_t i = 0; i < len; ++i) {
+            s.push_back('x');
+        }
+        benchmark::DoNotOptimize(s.data());
+    }
+    state.SetBytesProcessed(state.iterations() * len);
+}
+
+/**
+ * @brief
+ * Copy a string.
+ *
+ * @tparam S    The string type being measured.
+ */
+template <typename S>
+void string_copy(benchmark::State& state)
+{
+    auto len = static_cast<std::size_t>(state.range(0));
+    S original(len, 'x');
+    for (auto _ : state) {
+        S copy{original};
+        benchmark::DoNotOptimize(copy.data());
+    }
+    state.SetBytesProcessed(state.iterations() * len);
+}
+
+/**
+ * @brief
+ * Fill part of a large buffer and clear it again, as when a buffer is reused for each message.
+ *
+ * @tparam V    The vector type being measured.
+ */
+template <typename V>
+void vector_clear_refill(benchmark::State& state)
+{
+    auto len = static_cast<std::size_t>(state.range(0));
+    V v;
+    v.reserve(4 << 20);
+    for (auto _ : state) {
+        v.resize(len, 'x');
+        benchmark::DoNotOptimize(v.data());
+        v.clear();
+    }
+    state.SetBytesProcessed(state.iterations() * len);
+}
+
+/**
+ * @brief
+ * Insert a number of keys into a map and then erase them all again.
+ *
+ * @tparam M    The map type being measured.
+ */
+template <typename M>
+void unordered_map_insert_erase(benchmark::State& state)
+{
+    auto count = static_cast<int>(state.range(0));
+    M m;
+    for (auto _ : state) {
+        for (int i = 0; i < count; ++i) {
+            m.emplace(i, i);
+        }
+        for (int i = 0; i < count; ++i) {
+            m.erase(i);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+}
+
+/**
+ * @brief
+ * Build an ordered map from sorted keys and destroy it again.
+ *
+ * @tparam M    The map type being measured.
+ */
+template <typename M>
+void map_build_sorted(benchmark::State& state)
+{
+    auto count = static_cast<int>(state.range(0));
+    for (auto _ : state) {
+        M m;
+        for (int i = 0; i < count; ++i) {
+            m.emplace_hint(m.end(), i, i);
+        }
+        benchmark::DoNotOptimize(m.size());
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+}
+
+/**
+ * @brief
+ * Look up every key of a map in a scattered order.
+ *
+ * The keys are visited in the order of an odd multiplier modulo the (power of two) map size so
+ * that consecutive lookups do not simply walk memory in insertion order.
+ *
+ * @tparam M    The map type being measured.
+ */
+template <typename M>
+void map_find(benchmark::State& state)
+{
+    auto count = static_cast<unsigned>(state.range(0));
+    M m;
+    for (unsigned i = 0; i < count; ++i) {
+        m.emplace_hint(m.end(), static_cast<int>(i), static_cast<int>(i));
+    }
+    for (auto _ : state) {
+        for (unsigned i = 0; i < count; ++i) {
+            benchmark::DoNotOptimize(m.find(static_cast<int>((i * 2654435761u) & (count - 1))));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+}
+
+} // namespace
+
+
+#define EC_STRING_BENCHMARKS(_string)                                           \
+    BENCHMARK_TEMPLATE(string_sso, _string);                                    \
+    BENCHMARK_TEMPLATE(string_password, _string);                               \
+    BENCHMARK_TEMPLATE(string_append, _string)->RangeMultiplier(16)->Range(16, 64 << 10); \
+    BENCHMARK_TEMPLATE(string_copy, _string)->RangeMultiplier(16)->Range(16, 64 << 10)
+
+EC_STRING_BENCHMARKS(std::string);
+EC_STRING_BENCHMARKS(ec::unserialized_secure::string);
+EC_STRING_BENCHMARKS(ec::serialized_secure::string);
+EC_STRING_BENCHMARKS(ec::concurrent_secure::string);
+EC_STRING_BENCHMARKS(ec::pooled_secure::string);
+EC_STRING_BENCHMARKS(ec::pmr::secure::string);
+EC_STRING_BENCHMARKS(ec::pmr::numa_secure::string);
+EC_STRING_BENCHMARKS(ec::secure_inline_string<32>);
+
+
+#define EC_THREADED_STRING_BENCHMARKS(_string)                                  \
+    BENCHMARK_TEMPLATE(string_password, _string)->ThreadRange(1, 8)->UseRealTime()
+
+EC_THREADED_STRING_BENCHMARKS(ec::serialized_secure::string);
+EC_THREADED_STRING_BENCHMARKS(ec::concurrent_secure::string);
+
+BENCHMARK_TEMPLATE(string_password_retained, ec::serialized_secure::string);
+BENCHMARK_TEMPLATE(string_password_retained, ec::concurrent_secure::string);
+
+
+#define EC_VECTOR_BENCHMARKS(_vector)                                           \
+    BENCHMARK_TEMPLATE(vector_clear_refill, _vector)->RangeMultiplier(64)->Range(64, 4 << 20)
+
+EC_VECTOR_BENCHMARKS(std::vector<char>);
+EC_VECTOR_BENCHMARKS(ec::serialized_secure::vector<char>);
+EC_VECTOR_BENCHMARKS(ec::serialized_secure::wiping_vector<char>);
+
+
+#define EC_MAP_BENCHMARK(_map)                                                  \
+    BENCHMARK_TEMPLATE(unordered_map_insert_erase, _map)->RangeMultiplier(16)->Range(16, 64 << 10); \
+    BENCHMARK_TEMPLATE(map_find, _map)->RangeMultiplier(32)->Range(1 << 10, 1 << 20)
+
+using std_map = std::unordered_map<int, int>;
+using unserialized_secure_map = ec::unserialized_secure::unordered_map<int, int>;
+using serialized_secure_map = ec::serialized_secure::unordered_map<int, int>;
+using concurrent_secure_map = ec::concurrent_secure::unordered_map<int, int>;
+using pooled_secure_map = ec::pooled_secure::unordered_map<int, int>;
+using pmr_secure_map = ec::pmr::secure::unordered_map<int, int>;
+using pmr_numa_secure_map = ec::pmr::numa_secure::unordered_map<int, int>;
+using serialized_secure_flat_hash_map = ec::serialized_secure::flat_hash_map<int, int>;
+using pooled_secure_flat_hash_map = ec::pooled_secure::flat_hash_map<int, int>;
+
+EC_MAP_BENCHMARK(std_map);
+EC_MAP_BENCHMARK(unserialized_secure_map);
+EC_MAP_BENCHMARK(serialized_secure_map);
+EC_MAP_BENCHMARK(concurrent_secure_map);
+EC_MAP_BENCHMARK(pooled_secure_map);
+EC_MAP_BENCHMARK(pmr_secure_map);
+EC_MAP_BENCHMARK(pmr_numa_secure_map);
+EC_MAP_BENCHMARK(serialized_secure_flat_hash_map);
+EC_MAP_BENCHMARK(pooled_secure_flat_hash_map);
+
+
+#define EC_ORDERED_MAP_BENCHMARK(_map)                                          \
+    BENCHMARK_TEMPLATE(map_build_sorted, _map)->RangeMultiplier(32)->Range(1 << 10, 1 << 20); \
+    BENCHMARK_TEMPLATE(map_find, _map)->RangeMultiplier(32)->Range(1 << 10, 1 << 20)
+
+using std_ordered_map = std::map<int, int>;
+using serialized_secure_ordered_map = ec::serialized_secure::map<int, int>;
+using node_pooled_secure_ordered_map = ec::node_pooled_secure::map<int, int>;
+using serialized_secure_flat_map = ec::serialized_secure::flat_map<int, int>;
+
+EC_ORDERED_MAP_BENCHMARK(std_ordered_map);
+EC_ORDERED_MAP_BENCHMARK(serialized_secure_ordered_map);
+EC_ORDERED_MAP_BENCHMARK(node_pooled_secure_ordered_map);
+EC_ORDERED_MAP_BENCHMARK(serialized_secure_flat_map);
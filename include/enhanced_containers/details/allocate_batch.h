@@ -0,0 +1,86 @@
+/**
+ * @internal @file
+ * Helpers to allocate and deallocate batches of single objects with any allocator.
+ *
+ * @copyright 2023 Steve Kinneberg <steve.kinneberg@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstddef>
+
+namespace ec::details {
+
+/**
+ * @internal @brief
+ * Allocate a batch of single objects.
+ *
+ * Uses the allocator's own `allocate_batch()` if it has one, otherwise allocates the objects one
+ * at a time.  Either all objects are allocated or none are.
+ *
+ * @tparam A    The allocator type.
+ * @tparam T    The type being allocated.
+ *
+ * @param alloc The allocator to allocate with.
+ * @param n     Number of objects to allocate.
+ * @param out   Array of at least `n` pointers to receive the addresses of the objects.
+ */
+template <typename A, typename T>
+void allocate_batch(A& alloc, std::size_t n, T** out)
+{
+    if constexpr (requires { alloc.allocate_batch(n, out); }) {
+        alloc.allocate_batch(n, out);
+    } else {
+        std::size_t i = 0;
+        try {
+            for (; i < n; ++i) {
+                out[i] = alloc.allocate(1);
+            }
+        } catch (...) {
+            while (i > 0) {
+                alloc.deallocate(out[--i], 1);
+            }
+            throw;
+        }
+    }
+}
+
+/**
+ * @internal @brief
+ * Deallocate a batch of single objects.
+ *
+ * Uses the allocator's own `deallocate_batch()` if it has one, otherwise deallocates the objects
+ * one at a time.
+ *
+ * @tparam A    The allocator type.
+ * @tparam T    The type being deallocated.
+ *
+ * @param alloc The allocator to deallocate with.
+ * @param ptrs  Array of the addresses of the objects.
+ * @param n     Number of objects to deallocate.
+ */
+template <typename A, typename T>
+void deallocate_batch(A& alloc, T* const* ptrs, std::size_t n)
+{
+    if constexpr (requires { alloc.deallocate_batch(ptrs, n); }) {
+        alloc.deallocate_batch(ptrs, n);
+    } else {
+        for (std::size_t i = 0; i < n; ++i) {
+            alloc.deallocate(ptrs[i], 1);
+        }
+    }
+}
+
+} // namespace ec::details
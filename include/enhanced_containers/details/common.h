@@ -36,6 +36,15 @@
 #define EC_CONSTEXPR_ALLOC inline
 #endif
 
+/**
+ * @brief
+ * Page size of the target fixed at compile-time, or 0 to query it at run-time.  Defined by the
+ * `EC_PAGE_SIZE` CMake cache variable.
+ */
+#if !defined(EC_PAGE_SIZE)
+#define EC_PAGE_SIZE 0
+#endif
+
 #if __has_cpp_attribute(nodiscard)
 #define EC_NODISCARD [[nodiscard]]
 #else
@@ -0,0 +1,253 @@
+/**
+ * @internal @file
+ * Reference counted table of page aligned memory ranges.
+ *
+ * @copyright 2023 Steve Kinneberg <steve.kinneberg@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <map>
+
+namespace ec::details {
+
+/**
+ * @internal @brief
+ * Tracks the number of allocations referencing ranges of memory pages.
+ *
+ * Rather than storing one entry per page, this stores disjoint `[start, end)` address ranges that
+ * share the same reference count in a sorted tree.  Adjacent ranges with equal reference counts
+ * are merged, so the number of entries is bounded by the number of distinct allocation boundaries
+ * rather than the number of pages.  Adding or removing a reference is logarithmic in the number of
+ * entries plus linear in the number of entries the range overlaps.
+ *
+ * All addresses passed in are expected to already be page aligned.  This class does not lock or
+ * unlock any memory; it only answers which sub-ranges will change between referenced and
+ * unreferenced so that the caller can do so.
+ */
+class page_range_table {
+  public:
+    /// @brief Integral representation of a memory address.
+    using address = std::uintptr_t;
+
+    /**
+     * @brief
+     * Invoke a function for each maximal sub-range of `[start, end)` that is not referenced.
+     *
+     * These are the sub-ranges that will become newly referenced by a call to
+     * `add_reference(start, end)`.
+     *
+     * @tparam F    Function type with the signature `void(address, address)`.
+     *
+     * @param start     Start of the range to check.
+     * @param end       End of the range to check.
+     * @param f         Function to call with the start and end of each unreferenced sub-range.
+     */
+    template <typename F>
+    void for_each_unreferenced(address start, address end, F&& f) const
+    {
+        auto cursor = start;
+        for (auto it = first_overlapping(start); cursor < end; ++it) {
+            if (it == _ranges.end() || it->first >= end) {
+                f(cursor, end);
+                break;
+            }
+            if (it->first > cursor) {
+                f(cursor, it->first);
+            }
+            cursor = it->second.end;
+        }
+    }
+
+    /**
+     * @brief
+     * Invoke a function for each maximal sub-range of `[start, end)` that is referenced exactly
+     * once.
+     *
+     * These are the sub-ranges that will become unreferenced by a call to
+     * `remove_reference(start, end)`.
+     *
+     * @tparam F    Function type with the signature `void(address, address)`.
+     *
+     * @param start     Start of the range to check.
+     * @param end       End of the range to check.
+     * @param f         Function to call with the start and end of each sub-range.
+     */
+    template <typename F>
+    void for_each_last_reference(address start, address end, F&& f) const
+    {
+        address run_start{};
+        address run_end{};
+        for (auto it = first_overlapping(start); it != _ranges.end() && it->first < end; ++it) {
+            if (it->second.ref_count != 1) {
+                continue;
+            }
+            auto s = std::max(it->first, start);
+            auto e = std::min(it->second.end, end);
+            if (run_end != s) {
+                if (run_start != run_end) {
+                    f(run_start, run_end);
+                }
+                run_start = s;
+            }
+            run_end = e;
+        }
+        if (run_start != run_end) {
+            f(run_start, run_end);
+        }
+    }
+
+    /**
+     * @brief
+     * Check that every page in `[start, end)` is referenced at least once.
+     *
+     * @param start     Start of the range to check.
+     * @param end       End of the range to check.
+     *
+     * @return  Whether or not the entire range is referenced.
+     */
+    bool is_referenced(address start, address end) const;
+
+    /**
+     * @brief
+     * Add a reference to every page in `[start, end)`.
+     *
+     * Provides the strong exception guarantee: if `std::bad_alloc` is thrown, the table is left
+     * unchanged.
+     *
+     * @param start     Start of the range to reference.
+     * @param end       End of the range to reference.
+     */
+    void add_reference(address start, address end);
+
+    /**
+     * @brief
+     * Remove a reference from every page in `[start, end)`.
+     *
+     * Provides the strong exception guarantee: if `std::bad_alloc` is thrown, the table is left
+     * unchanged.
+     *
+     * @pre `is_referenced(start, end)` must be true.
+     *
+     * @param start     Start of the range to dereference.
+     * @param end       End of the range to dereference.
+     */
+    void remove_reference(address start, address end);
+
+    /**
+     * @brief
+     * Split the ranges straddling `start` and `end` so that a following `remove_reference()` with
+     * the same bounds cannot throw.  No reference count changes.
+     *
+     * Lets a caller that has to make an OS call before updating the table do all the allocating
+     * first.  The extra entries are merged again by the update.
+     *
+     * @param start     Start of the range about to be updated.
+     * @param end       End of the range about to be updated.
+     */
+    void split_boundaries(address start, address end);
+
+    /**
+     * @brief
+     * Forget about every page in `[start, end)` regardless of its reference count.
+     *
+     * @param start     Start of the range to forget.
+     * @param end       End of the range to forget.
+     */
+    void erase(address start, address end);
+
+    /**
+     * @brief
+     * Get the reference count of the page containing an address.
+     *
+     * @param addr  Address to look up.
+     *
+     * @return  Number of references to the page containing `addr`.
+     */
+    std::uint32_t ref_count(address addr) const;
+
+    /**
+     * @brief
+     * Get the number of ranges being tracked.
+     *
+     * @return  Number of distinct ranges.
+     */
+    std::size_t size() const noexcept { return _ranges.size(); }
+
+    /**
+     * @brief
+     * Check if any pages are being tracked.
+     *
+     * @return  Whether or not the table is empty.
+     */
+    bool empty() const noexcept { return _ranges.empty(); }
+
+  private:
+    /// @brief The end and reference count of a range keyed by its start address.
+    struct range {
+        address end;                ///< @brief End of the range (exclusive).
+        std::uint32_t ref_count;    ///< @brief Number of allocations referencing the range.
+    };
+
+    /// @brief Type alias for the underlying tree.
+    using range_map = std::map<address, range>;
+
+    /// @brief Disjoint ranges sorted by start address.
+    range_map _ranges;
+
+    /**
+     * @brief
+     * Find the first range that contains or follows an address.
+     *
+     * @param addr  Address to search for.
+     *
+     * @return  Iterator to the first range whose end is past `addr`.
+     */
+    range_map::const_iterator first_overlapping(address addr) const
+    {
+        auto it = _ranges.upper_bound(addr);
+        if (it != _ranges.begin()) {
+            auto prev = std::prev(it);
+            if (prev->second.end > addr) {
+                return prev;
+            }
+        }
+        return it;
+    }
+
+    /**
+     * @brief
+     * Ensure that no range straddles an address by splitting the range containing it.
+     *
+     * @param addr  Address at which a range boundary is needed.
+     */
+    void split(address addr);
+
+    /**
+     * @brief
+     * Drop unreferenced ranges and merge adjacent ranges with equal reference counts in the
+     * neighborhood of `[start, end]`.
+     *
+     * @param start     Start of the range that was modified.
+     * @param end       End of the range that was modified.
+     */
+    void normalize(address start, address end) noexcept;
+};
+
+} // namespace ec::details
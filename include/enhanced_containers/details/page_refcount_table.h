@@ -0,0 +1,353 @@
+/**
+ * @internal @file
+ * Lock-free table of per page reference counts.
+ *
+ * @copyright 2023 Steve Kinneberg <steve.kinneberg@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <thread>
+
+namespace ec::details {
+
+/**
+ * @internal @brief
+ * Tracks the number of allocations referencing each memory page without any mutex.
+ *
+ * The counts live in a radix tree indexed by page number: a fixed root of pointers to two levels
+ * of directories, then leaves of 4096 atomic counters.  Directories and leaves are created on
+ * first use with a compare and swap, and are never freed while the table exists, so looking up a
+ * page is a few dependent loads.
+ *
+ * Referencing a page that is already referenced is a single compare and swap on its counter, as
+ * is dropping a reference that is not the last one.  Only the 0 to 1 and 1 to 0 transitions go to
+ * the caller's pin or unpin function.  While a page is in transition its counter holds a busy
+ * marker and other threads touching that page wait for the transition to finish, so a page can
+ * never be unpinned while another allocation relies on it being pinned.  Consecutive pages in
+ * transition are handed over as one run.
+ *
+ * Pages are always visited in ascending order and a thread never waits while it holds pages in
+ * transition, so concurrent updates cannot deadlock.
+ *
+ * All addresses passed in are expected to already be page aligned.
+ */
+class page_refcount_table {
+  public:
+    /// @brief Integral representation of a memory address.
+    using address = std::uintptr_t;
+
+    /**
+     * @brief
+     * Constructor.
+     *
+     * @param page_shift    Log base 2 of the page size.
+     */
+    explicit page_refcount_table(std::size_t page_shift) noexcept:
+        _page_shift{page_shift}
+    {}
+
+    /// @brief Destructor.
+    ~page_refcount_table();
+
+    /// @brief Not copyable.
+    page_refcount_table(const page_refcount_table&) = delete;
+    /// @brief Not copyable.
+    page_refcount_table& operator=(const page_refcount_table&) = delete;
+
+    /**
+     * @brief
+     * Add a reference to each page in `[start, end)`.
+     *
+     * If pinning fails, every page is returned to the state it was in before the call, unpinning
+     * any run that this call pinned, and the exception is rethrown.
+     *
+     * @tparam Pin      Function type with the signature `void(address, address)`.
+     * @tparam Unpin    Function type with the signature `void(address, address)`.
+     *
+     * @param start     Start of the range of pages.
+     * @param end       End of the range of pages.
+     * @param pin       Function to call with the start and end of each run of newly referenced pages.
+     * @param unpin     Function to call with the start and end of each run to release again on failure.
+     */
+    template <typename Pin, typename Unpin>
+    void add_reference(address start, address end, Pin&& pin, Unpin&& unpin);
+
+    /**
+     * @brief
+     * Drop a reference to each page in `[start, end)`.
+     *
+     * If unpinning a run fails, the pages of that run and all following pages keep their
+     * references, so the memory stays pinned rather than being released early, and the exception
+     * is rethrown.
+     *
+     * @tparam Unpin    Function type with the signature `void(address, address)`.
+     *
+     * @param start     Start of the range of pages.
+     * @param end       End of the range of pages.
+     * @param unpin     Function to call with the start and end of each run of no longer referenced pages.
+     *
+     * @throws std::runtime_error if any of the pages is not referenced.
+     */
+    template <typename Unpin>
+    void remove_reference(address start, address end, Unpin&& unpin);
+
+    /**
+     * @brief
+     * Check whether every page in `[start, end)` is referenced.
+     *
+     * @param start     Start of the range of pages.
+     * @param end       End of the range of pages.
+     *
+     * @return  Whether all pages are referenced.
+     */
+    bool is_referenced(address start, address end) const noexcept;
+
+    /**
+     * @brief
+     * Get the number of references to a page.
+     *
+     * @param page  Address of the page.
+     *
+     * @return  The reference count.  Pages in transition count as referenced once.
+     */
+    std::uint32_t reference_count(address page) const noexcept;
+
+    /**
+     * @brief
+     * Forget all references to the pages in `[start, end)` without unpinning them.  Not safe to
+     * call while other threads use those pages.
+     *
+     * @param start     Start of the range of pages.
+     * @param end       End of the range of pages.
+     */
+    void clear(address start, address end) noexcept;
+
+    /// @brief Log base 2 of the number of counters in a leaf.
+    static constexpr std::size_t leaf_shift{12};
+
+    /// @brief Log base 2 of the number of entries in a directory.
+    static constexpr std::size_t directory_shift{12};
+
+    /// @brief Log base 2 of the number of entries in the root.
+    static constexpr std::size_t root_shift{9};
+
+  private:
+    /// @brief Type of a reference counter.
+    using counter = std::atomic<std::uint32_t>;
+
+    /// @brief Counter value marking a page in transition between referenced and unreferenced.
+    static constexpr std::uint32_t busy{std::uint32_t{1} << 31};
+
+    /// @brief Counters for consecutive pages.
+    struct leaf {
+        std::array<counter, std::size_t{1} << leaf_shift> counts{};     ///< @brief The reference counts.
+    };
+
+    /**
+     * @brief
+     * Pointers to the next level down.
+     *
+     * @tparam Child    The type of the next level down.
+     */
+    template <typename Child>
+    struct directory {
+        std::array<std::atomic<Child*>, std::size_t{1} << directory_shift> children{};  ///< @brief The next level down.
+
+        /// @brief Destructor.
+        ~directory();
+    };
+
+    /// @brief Directory of leaves.
+    using lower_directory = directory<leaf>;
+    /// @brief Directory of directories of leaves.
+    using upper_directory = directory<lower_directory>;
+
+    /**
+     * @brief
+     * Get the counter of a page, creating the levels leading to it if necessary.
+     *
+     * @param page_number   The page number.
+     *
+     * @return  The counter.
+     */
+    counter& counter_for(address page_number);
+
+    /**
+     * @brief
+     * Get the counter of a page if it exists.
+     *
+     * @param page_number   The page number.
+     *
+     * @return  The counter, or `nullptr` if the page was never referenced.
+     */
+    counter* find_counter(address page_number) const noexcept;
+
+    /**
+     * @brief
+     * Get the counter of the next page, only walking the tree when crossing into a new leaf.
+     *
+     * @param c             Counter of the previous page, or `nullptr` for the first page.
+     * @param page_number   The page number.
+     *
+     * @return  The counter.
+     */
+    counter& next_counter(counter* c, address page_number)
+    {
+        if (c != nullptr && (page_number & ((address{1} << leaf_shift) - 1)) != 0) {
+            return *(c + 1);
+        }
+        return counter_for(page_number);
+    }
+
+    /**
+     * @brief
+     * Set the counters of a run of pages in transition, ending the transition.
+     *
+     * @param first     First page number of the run.
+     * @param last      Page number after the end of the run.
+     * @param value     The value to store.
+     */
+    void publish(address first, address last, std::uint32_t value) noexcept;
+
+    /// @brief Wait a little for another thread to finish a transition.
+    static void backoff() noexcept { std::this_thread::yield(); }
+
+    const std::size_t _page_shift;      ///< @brief Log base 2 of the page size.
+
+    /// @brief The root of the tree.
+    std::array<std::atomic<upper_directory*>, std::size_t{1} << root_shift> _root{};
+};
+
+
+template <typename Pin, typename Unpin>
+void page_refcount_table::add_reference(address start, address end, Pin&& pin, Unpin&& unpin)
+{
+    const auto first = start >> _page_shift;
+    const auto last = end >> _page_shift;
+    // Pages claimed for pinning, but not pinned yet.
+    auto run_first = first;
+    auto run_last = first;
+
+    auto flush = [&]() {
+        if (run_first != run_last) {
+            pin(run_first << _page_shift, run_last << _page_shift);
+            publish(run_first, run_last, 1);
+        }
+        run_first = run_last;
+    };
+
+    auto page = first;
+    try {
+        counter* c{};
+        for (; page < last; ++page) {
+            c = &next_counter(c, page);
+            auto n = c->load(std::memory_order_acquire);
+            for (;;) {
+                if ((n & busy) != 0) {
+                    flush();
+                    backoff();
+                    n = c->load(std::memory_order_acquire);
+                } else if (n == 0) {
+                    if (run_last != page) {
+                        // Runs are contiguous, so hand over the one before the gap first.
+                        flush();
+                        run_first = run_last = page;
+                        n = c->load(std::memory_order_acquire);
+                    } else if (c->compare_exchange_weak(n, busy, std::memory_order_acquire)) {
+                        run_last = page + 1;
+                        break;
+                    }
+                } else if (c->compare_exchange_weak(n, n + 1, std::memory_order_acq_rel)) {
+                    break;
+                }
+            }
+        }
+        flush();
+    } catch (...) {
+        // Give up the claimed run and release whatever else this call referenced.
+        publish(run_first, run_last, 0);
+        auto release = [this, &unpin](address from, address to) {
+            if (from != to) {
+                remove_reference(from << _page_shift, to << _page_shift, unpin);
+            }
+        };
+        release(first, run_first);
+        release(run_last, page);
+        throw;
+    }
+}
+
+template <typename Unpin>
+void page_refcount_table::remove_reference(address start, address end, Unpin&& unpin)
+{
+    if (!is_referenced(start, end)) {
+        throw std::runtime_error("Releasing memory not tracked by no_swap_allocator");
+    }
+
+    const auto first = start >> _page_shift;
+    const auto last = end >> _page_shift;
+    // Pages claimed for unpinning, but not unpinned yet.
+    auto run_first = first;
+    auto run_last = first;
+
+    auto flush = [&]() {
+        if (run_first != run_last) {
+            try {
+                unpin(run_first << _page_shift, run_last << _page_shift);
+            } catch (...) {
+                publish(run_first, run_last, 1);
+                throw;
+            }
+            publish(run_first, run_last, 0);
+        }
+        run_first = run_last;
+    };
+
+    counter* c{};
+    for (auto page = first; page < last; ++page) {
+        c = &next_counter(c, page);
+        auto n = c->load(std::memory_order_acquire);
+        for (;;) {
+            if ((n & busy) != 0) {
+                flush();
+                backoff();
+                n = c->load(std::memory_order_acquire);
+            } else if (n == 0) {
+                break;  // Released by a caller that misused the table; nothing left to drop.
+            } else if (n == 1) {
+                if (run_last != page) {
+                    // Runs are contiguous, so hand over the one before the gap first.
+                    flush();
+                    run_first = run_last = page;
+                    n = c->load(std::memory_order_acquire);
+                } else if (c->compare_exchange_weak(n, busy, std::memory_order_acquire)) {
+                    run_last = page + 1;
+                    break;
+                }
+            } else if (c->compare_exchange_weak(n, n - 1, std::memory_order_acq_rel)) {
+                break;
+            }
+        }
+    }
+    flush();
+}
+
+} // namespace ec::details
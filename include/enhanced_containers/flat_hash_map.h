@@ -0,0 +1,1121 @@
+/**
+ * @file
+ * Open addressing hash map that keeps all of its elements in a single allocation.
+ *
+ * @copyright 2023 Steve Kinneberg <steve.kinneberg@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <enhanced_containers/details/common.h>
+#include <enhanced_containers/secure_zero.h>
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace ec {
+
+namespace details {
+/// @internal @brief Number of control bytes examined at once while probing.
+inline constexpr std::size_t swiss_group_width{16};
+
+/// @internal @brief Control byte of a slot that has never held an element.
+inline constexpr std::uint8_t swiss_empty{0x00};
+
+/// @internal @brief Control byte of a slot whose element was erased.
+inline constexpr std::uint8_t swiss_deleted{0x01};
+
+/// @internal @brief Bit set in the control byte of a slot holding an element.
+inline constexpr std::uint8_t swiss_full{0x80};
+
+/**
+ * @internal @brief
+ * A group of consecutive control bytes of a `ec::flat_hash_map<>`.
+ *
+ * Each control byte is either `swiss_empty`, `swiss_deleted`, or `swiss_full` combined with the
+ * low 7 bits of the element's hash.  An empty table is all zeroes.  The matches are returned as
+ * bit masks with bit i set for the control byte at offset i.
+ */
+class swiss_group {
+  public:
+    /**
+     * @internal @brief
+     * Load a group of control bytes.
+     *
+     * @param ctrl  Address of the first control byte.  Need not be aligned.
+     */
+    explicit swiss_group(const std::uint8_t* ctrl) noexcept
+    {
+#if defined(__SSE2__)
+        _ctrl = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ctrl));
+#else
+        std::memcpy(_ctrl, ctrl, sizeof(_ctrl));
+#endif
+    }
+
+    /// @internal @brief Find the slots holding elements with the given control byte.
+    std::uint32_t match(std::uint8_t c) const noexcept
+    {
+#if defined(__SSE2__)
+        return static_cast<std::uint32_t>(
+            _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(static_cast<char>(c)), _ctrl)));
+#else
+        std::uint32_t mask{};
+        for (std::size_t i = 0; i < swiss_group_width; ++i) {
+            mask |= std::uint32_t{_ctrl[i] == c} << i;
+        }
+        return mask;
+#endif
+    }
+
+    /// @internal @brief Find the slots that have never held an element.
+    std::uint32_t match_empty() const noexcept { return match(swiss_empty); }
+
+    /// @internal @brief Find the slots that do not hold an element.
+    std::uint32_t match_free() const noexcept
+    {
+#if defined(__SSE2__)
+        return ~static_cast<std::uint32_t>(_mm_movemask_epi8(_ctrl)) & 0xFFFF;
+#else
+        std::uint32_t mask{};
+        for (std::size_t i = 0; i < swiss_group_width; ++i) {
+            mask |= std::uint32_t{(_ctrl[i] & swiss_full) == 0} << i;
+        }
+        return mask;
+#endif
+    }
+
+  private:
+#if defined(__SSE2__)
+    __m128i _ctrl;  ///< @internal @brief The control bytes.
+#else
+    std::uint8_t _ctrl[swiss_group_width];  ///< @internal @brief The control bytes.
+#endif
+};
+} // namespace details
+
+/**
+ * @brief
+ * Swiss table style open addressing hash map, largely compatible with `std::unordered_map`.
+ *
+ * The elements live in a single allocation together with one control byte per slot, and lookups
+ * compare 16 control bytes at a time (with SSE2 where available) before touching any element.
+ * Compared to `std::unordered_map` there is no node per element and no separate bucket array,
+ * which matters most when every allocation is locked into RAM.
+ *
+ * Erasing an element wipes its slot immediately, and growing the table wipes the old one, so no
+ * stale copies of keys or values are left behind regardless of the allocator.
+ *
+ * Unlike `std::unordered_map`, any insertion may invalidate iterators, pointers and references.
+ *
+ * @tparam Key          The key type.
+ * @tparam T            The mapped type.
+ * @tparam Hash         The hash functor type.
+ * @tparam KeyEqual     The key equality functor type.
+ * @tparam Allocator    The allocator type.
+ */
+template <typename Key,
+          typename T,
+          typename Hash = std::hash<Key>,
+          typename KeyEqual = std::equal_to<Key>,
+          typename Allocator = std::allocator<std::pair<const Key, T>>>
+class flat_hash_map {
+    /// @brief Storage for one element.
+    struct slot {
+        alignas(std::pair<const Key, T>) std::byte storage[sizeof(std::pair<const Key, T>)];
+
+        /// @brief Get the element stored in the slot.
+        std::pair<const Key, T>* value() noexcept
+        {
+            return std::launder(reinterpret_cast<std::pair<const Key, T>*>(storage));
+        }
+    };
+
+    /// @brief Allocator type used for the table.
+    using slot_allocator = typename std::allocator_traits<Allocator>::template rebind_alloc<slot>;
+    /// @brief Allocator traits for the table.
+    using slot_traits = std::allocator_traits<slot_allocator>;
+
+    /// @brief Whether or not lookups may use keys of other types.
+    static constexpr bool is_transparent = requires {
+        typename Hash::is_transparent;
+        typename KeyEqual::is_transparent;
+    };
+
+    /**
+     * @brief
+     * Iterator over the elements of the map.
+     *
+     * @tparam Const    Whether or not the elements are constant.
+     */
+    template <bool Const>
+    class iterator_impl {
+      public:
+        /// @brief The iterator category.
+        using iterator_category = std::forward_iterator_tag;
+        /// @brief Type alias for the element type.
+        using value_type = std::pair<const Key, T>;
+        /// @brief Type alias for the distance between iterators.
+        using difference_type = std::ptrdiff_t;
+        /// @brief Type alias for a reference to an element.
+        using reference = std::conditional_t<Const, const value_type&, value_type&>;
+        /// @brief Type alias for a pointer to an element.
+        using pointer = std::conditional_t<Const, const value_type*, value_type*>;
+
+        /// @brief Default constructor.
+        iterator_impl() = default;
+
+        /// @brief Converting constructor from a mutable to a constant iterator.
+        template <bool C>
+            requires (Const && !C)
+        iterator_impl(const iterator_impl<C>& other) noexcept:
+            _ctrl{other._ctrl},
+            _slot{other._slot},
+            _end{other._end}
+        {}
+
+        /// @brief Dereference.
+        reference operator*() const noexcept { return *_slot->value(); }
+        /// @brief Member access.
+        pointer operator->() const noexcept { return _slot->value(); }
+
+        /// @brief Pre-increment.
+        iterator_impl& operator++() noexcept
+        {
+            ++_ctrl;
+            ++_slot;
+            skip_free();
+            return *this;
+        }
+
+        /// @brief Post-increment.
+        iterator_impl operator++(int) noexcept { auto tmp = *this; ++*this; return tmp; }
+
+        /// @brief Equality.
+        template <bool C>
+        bool operator==(const iterator_impl<C>& other) const noexcept { return _ctrl == other._ctrl; }
+
+      private:
+        const std::uint8_t* _ctrl{};    ///< @brief Control byte of the current slot.
+        slot* _slot{};                  ///< @brief The current slot.
+        const std::uint8_t* _end{};     ///< @brief Control byte past the last slot.
+
+        /// @brief Constructor.
+        iterator_impl(const std::uint8_t* ctrl, slot* s, const std::uint8_t* end) noexcept:
+            _ctrl{ctrl},
+            _slot{s},
+            _end{end}
+        {}
+
+        /// @brief Advance to the next slot holding an element, if not already at one.
+        void skip_free() noexcept
+        {
+            while (_ctrl != _end && (*_ctrl & details::swiss_full) == 0) {
+                ++_ctrl;
+                ++_slot;
+            }
+        }
+
+        template <bool> friend class iterator_impl;
+        friend class flat_hash_map;
+    };
+
+  public:
+    /// @brief Type alias for the key type.
+    using key_type = Key;
+    /// @brief Type alias for the mapped type.
+    using mapped_type = T;
+    /// @brief Type alias for the element type.
+    using value_type = std::pair<const Key, T>;
+    /// @brief Type alias for the type representing the size of the map.
+    using size_type = std::size_t;
+    /// @brief Type alias for the type representing the distance between iterators.
+    using difference_type = std::ptrdiff_t;
+    /// @brief Type alias for the hash functor type.
+    using hasher = Hash;
+    /// @brief Type alias for the key equality functor type.
+    using key_equal = KeyEqual;
+    /// @brief Type alias for the allocator type.
+    using allocator_type = Allocator;
+    /// @brief Type alias for a reference to an element.
+    using reference = value_type&;
+    /// @brief Type alias for a constant reference to an element.
+    using const_reference = const value_type&;
+    /// @brief Iterator type.
+    using iterator = iterator_impl<false>;
+    /// @brief Constant iterator type.
+    using const_iterator = iterator_impl<true>;
+
+    /// @brief Default constructor.
+    flat_hash_map() = default;
+
+    /**
+     * @brief
+     * Construct an empty map with room for a number of elements.
+     *
+     * @param bucket_count  Minimum number of elements to make room for.
+     * @param hash          The hash functor.
+     * @param equal         The key equality functor.
+     * @param alloc         The allocator.
+     */
+    explicit flat_hash_map(size_type bucket_count,
+                           const hasher& hash = hasher{},
+                           const key_equal& equal = key_equal{},
+                           const allocator_type& alloc = allocator_type{}):
+        _hash{hash},
+        _equal{equal},
+        _alloc{alloc}
+    {
+        reserve(bucket_count);
+    }
+
+    /**
+     * @brief
+     * Construct an empty map with an allocator.
+     *
+     * @param alloc The allocator.
+     */
+    explicit flat_hash_map(const allocator_type& alloc):
+        _alloc{alloc}
+    {}
+
+    /**
+     * @brief
+     * Construct from a range of elements.
+     *
+     * @param first         Start of the range.
+     * @param last          End of the range.
+     * @param bucket_count  Minimum number of elements to make room for.
+     * @param hash          The hash functor.
+     * @param equal         The key equality functor.
+     * @param alloc         The allocator.
+     */
+    template <typename InputIt>
+    flat_hash_map(InputIt first, InputIt last,
+                  size_type bucket_count = 0,
+                  const hasher& hash = hasher{},
+                  const key_equal& equal = key_equal{},
+                  const allocator_type& alloc = allocator_type{}):
+        flat_hash_map(bucket_count, hash, equal, alloc)
+    {
+        insert(first, last);
+    }
+
+    /**
+     * @brief
+     * Construct from a list of elements.
+     *
+     * @param init          The elements.
+     * @param bucket_count  Minimum number of elements to make room for.
+     * @param hash          The hash functor.
+     * @param equal         The key equality functor.
+     * @param alloc         The allocator.
+     */
+    flat_hash_map(std::initializer_list<value_type> init,
+                  size_type bucket_count = 0,
+                  const hasher& hash = hasher{},
+                  const key_equal& equal = key_equal{},
+                  const allocator_type& alloc = allocator_type{}):
+        flat_hash_map(init.begin(), init.end(), bucket_count, hash, equal, alloc)
+    {}
+
+    /**
+     * @brief
+     * Copy constructor.
+     *
+     * @param other     The map to copy.
+     */
+    flat_hash_map(const flat_hash_map& other):
+        _hash{other._hash},
+        _equal{other._equal},
+        _alloc{slot_traits::select_on_container_copy_construction(other._alloc)}
+    {
+        copy_elements(other);
+    }
+
+    /**
+     * @brief
+     * Move constructor.
+     *
+     * @param other     The map to move from.  It is left empty.
+     */
+    flat_hash_map(flat_hash_map&& other) noexcept:
+        _hash{std::move(other._hash)},
+        _equal{std::move(other._equal)},
+        _alloc{std::move(other._alloc)}
+    {
+        steal(other);
+    }
+
+    /// @brief Destructor.
+    ~flat_hash_map() { release(); }
+
+    /**
+     * @brief
+     * Copy assignment.
+     *
+     * @param other     The map to copy.
+     */
+    flat_hash_map& operator=(const flat_hash_map& other)
+    {
+        if (this != &other) {
+            release();
+            _hash = other._hash;
+            _equal = other._equal;
+            if constexpr (slot_traits::propagate_on_container_copy_assignment::value) {
+                _alloc = other._alloc;
+            }
+            copy_elements(other);
+        }
+        return *this;
+    }
+
+    /**
+     * @brief
+     * Move assignment.
+     *
+     * @param other     The map to move from.  It is left empty.
+     */
+    flat_hash_map& operator=(flat_hash_map&& other)
+        noexcept(slot_traits::propagate_on_container_move_assignment::value ||
+                 slot_traits::is_always_equal::value)
+    {
+        if (this == &other) {
+            return *this;
+        }
+        release();
+        _hash = std::move(other._hash);
+        _equal = std::move(other._equal);
+        if constexpr (slot_traits::propagate_on_container_move_assignment::value) {
+            _alloc = std::move(other._alloc);
+            steal(other);
+        } else if (slot_traits::is_always_equal::value || _alloc == other._alloc) {
+            steal(other);
+        } else {
+            reserve(other.size());
+            for (auto& v : other) {
+                emplace(v.first, std::move(v.second));
+            }
+            other.clear();
+        }
+        return *this;
+    }
+
+    /// @brief Get the allocator.
+    allocator_type get_allocator() const { return allocator_type(_alloc); }
+
+    /// @brief Get an iterator to the first element.
+    iterator begin() noexcept { return make_iterator<false>(0, true); }
+    /// @brief Get an iterator to the first element.
+    const_iterator begin() const noexcept { return make_iterator<true>(0, true); }
+    /// @brief Get an iterator to the first element.
+    const_iterator cbegin() const noexcept { return begin(); }
+    /// @brief Get an iterator past the last element.
+    iterator end() noexcept { return make_iterator<false>(_capacity, false); }
+    /// @brief Get an iterator past the last element.
+    const_iterator end() const noexcept { return make_iterator<true>(_capacity, false); }
+    /// @brief Get an iterator past the last element.
+    const_iterator cend() const noexcept { return end(); }
+
+    /// @brief Check if the map is empty.
+    EC_NODISCARD bool empty() const noexcept { return _size == 0; }
+    /// @brief Get the number of elements.
+    size_type size() const noexcept { return _size; }
+    /// @brief Get the maximum number of elements.
+    size_type max_size() const noexcept { return slot_traits::max_size(_alloc) / 2; }
+
+    /// @brief Erase all elements, keeping the table.
+    void clear() noexcept
+    {
+        if (_capacity == 0) {
+            return;
+        }
+        destroy_elements();
+        std::memset(_ctrl, details::swiss_empty, _capacity + details::swiss_group_width);
+        _size = 0;
+        _growth_left = max_load(_capacity);
+    }
+
+    /**
+     * @brief
+     * Insert an element if its key is not present.
+     *
+     * @param value     The element.
+     *
+     * @return  Iterator to the element with the key and whether or not it was inserted.
+     */
+    std::pair<iterator, bool> insert(const value_type& value) { return try_emplace(value.first, value.second); }
+
+    /// @copydoc insert(const value_type&)
+    std::pair<iterator, bool> insert(value_type&& value)
+    {
+        return try_emplace(value.first, std::move(value.second));
+    }
+
+    /**
+     * @brief
+     * Insert an element if its key is not present.  The hint is ignored.
+     *
+     * @param value     The element.
+     *
+     * @return  Iterator to the element with the key.
+     */
+    iterator insert(const_iterator, const value_type& value) { return insert(value).first; }
+
+    /// @copydoc insert(const_iterator, const value_type&)
+    iterator insert(const_iterator, value_type&& value) { return insert(std::move(value)).first; }
+
+    /**
+     * @brief
+     * Insert a range of elements whose keys are not present.
+     *
+     * @param first     Start of the range.
+     * @param last      End of the range.
+     */
+    template <typename InputIt>
+    void insert(InputIt first, InputIt last)
+    {
+        if constexpr (std::is_base_of_v<std::forward_iterator_tag,
+                                        typename std::iterator_traits<InputIt>::iterator_category>) {
+            reserve(_size + static_cast<size_type>(std::distance(first, last)));
+        }
+        for (; first != last; ++first) {
+            emplace(*first);
+        }
+    }
+
+    /**
+     * @brief
+     * Insert a list of elements whose keys are not present.
+     *
+     * @param init  The elements.
+     */
+    void insert(std::initializer_list<value_type> init) { insert(init.begin(), init.end()); }
+
+    /**
+     * @brief
+     * Insert a value if the key is not present or assign it if it is.
+     *
+     * @param key   The key.
+     * @param obj   The value.
+     *
+     * @return  Iterator to the element with the key and whether or not it was inserted.
+     */
+    template <typename K, typename M>
+    std::pair<iterator, bool> insert_or_assign(K&& key, M&& obj)
+    {
+        auto result = try_emplace(std::forward<K>(key), std::forward<M>(obj));
+        if (!result.second) {
+            result.first->second = std::forward<M>(obj);
+        }
+        return result;
+    }
+
+    /**
+     * @brief
+     * Insert an element constructed in place if its key is not present.
+     *
+     * @param args  Arguments to construct a `value_type` from.
+     *
+     * @return  Iterator to the element with the key and whether or not it was inserted.
+     */
+    template <typename... Args>
+    std::pair<iterator, bool> emplace(Args&&... args)
+    {
+        if constexpr (sizeof...(Args) == 2) {
+            return try_emplace(std::forward<Args>(args)...);
+        } else {
+            std::pair<key_type, mapped_type> v(std::forward<Args>(args)...);
+            return try_emplace(std::move(v.first), std::move(v.second));
+        }
+    }
+
+    /**
+     * @brief
+     * Insert an element constructed in place if its key is not present.  The hint is ignored.
+     *
+     * @param args  Arguments to construct a `value_type` from.
+     *
+     * @return  Iterator to the element with the key.
+     */
+    template <typename... Args>
+    iterator emplace_hint(const_iterator, Args&&... args)
+    {
+        return emplace(std::forward<Args>(args)...).first;
+    }
+
+    /**
+     * @brief
+     * Insert a value constructed in place if the key is not present.
+     *
+     * @param key   The key.
+     * @param args  Arguments to construct the mapped value from.
+     *
+     * @return  Iterator to the element with the key and whether or not it was inserted.
+     */
+    template <typename K, typename... Args>
+        requires std::is_constructible_v<key_type, K>
+    std::pair<iterator, bool> try_emplace(K&& key, Args&&... args)
+    {
+        auto hash = hash_of(key);
+        auto index = find_index(key, hash);
+        if (index != npos) {
+            return {make_iterator<false>(index, false), false};
+        }
+
+        if (_capacity == 0) {
+            grow();
+        }
+        index = find_free(hash);
+        if (_growth_left == 0 && _ctrl[index] != details::swiss_deleted) {
+            grow();
+            index = find_free(hash);
+        }
+        std::construct_at(_slots[index].value(),
+                          std::piecewise_construct,
+                          std::forward_as_tuple(std::forward<K>(key)),
+                          std::forward_as_tuple(std::forward<Args>(args)...));
+        if (_ctrl[index] == details::swiss_empty) {
+            --_growth_left;
+        }
+        set_ctrl(index, h2(hash));
+        ++_size;
+        return {make_iterator<false>(index, false), true};
+    }
+
+    /**
+     * @brief
+     * Erase an element, wiping its slot.
+     *
+     * @param pos   Iterator to the element.
+     *
+     * @return  Iterator to the element after the erased one.
+     */
+    iterator erase(const_iterator pos)
+    {
+        auto index = static_cast<size_type>(pos._slot - _slots);
+        erase_index(index);
+        return make_iterator<false>(index, true);
+    }
+
+    /// @copydoc erase(const_iterator)
+    iterator erase(iterator pos) { return erase(const_iterator{pos}); }
+
+    /**
+     * @brief
+     * Erase the element with a key, wiping its slot.
+     *
+     * @param key   The key.
+     *
+     * @return  Number of elements erased.
+     */
+    size_type erase(const key_type& key)
+    {
+        auto index = find_index(key, hash_of(key));
+        if (index == npos) {
+            return 0;
+        }
+        erase_index(index);
+        return 1;
+    }
+
+    /**
+     * @brief
+     * Swap the contents with another map.
+     *
+     * @param other     The map to swap with.
+     */
+    void swap(flat_hash_map& other) noexcept
+    {
+        using std::swap;
+        swap(_hash, other._hash);
+        swap(_equal, other._equal);
+        if constexpr (slot_traits::propagate_on_container_swap::value) {
+            swap(_alloc, other._alloc);
+        }
+        swap(_slots, other._slots);
+        swap(_ctrl, other._ctrl);
+        swap(_capacity, other._capacity);
+        swap(_size, other._size);
+        swap(_growth_left, other._growth_left);
+    }
+
+    /**
+     * @brief
+     * Get the value mapped to a key.
+     *
+     * @param key   The key.
+     *
+     * @return  The mapped value.
+     *
+     * @throws std::out_of_range if there is no such key.
+     */
+    mapped_type& at(const key_type& key)
+    {
+        auto it = find(key);
+        if (it == end()) {
+            throw std::out_of_range("ec::flat_hash_map::at");
+        }
+        return it->second;
+    }
+
+    /// @copydoc at(const key_type&)
+    const mapped_type& at(const key_type& key) const
+    {
+        auto it = find(key);
+        if (it == end()) {
+            throw std::out_of_range("ec::flat_hash_map::at");
+        }
+        return it->second;
+    }
+
+    /**
+     * @brief
+     * Get the value mapped to a key, inserting a value initialized one if there is none.
+     *
+     * @param key   The key.
+     *
+     * @return  The mapped value.
+     */
+    mapped_type& operator[](const key_type& key) { return try_emplace(key).first->second; }
+
+    /// @copydoc operator[](const key_type&)
+    mapped_type& operator[](key_type&& key) { return try_emplace(std::move(key)).first->second; }
+
+    /**
+     * @brief
+     * Find the element with a key.
+     *
+     * @param key   The key.
+     *
+     * @return  Iterator to the element or `end()`.
+     */
+    template <typename K = key_type>
+        requires std::is_same_v<K, key_type> || is_transparent
+    iterator find(const K& key)
+    {
+        auto index = find_index(key, hash_of(key));
+        return index == npos ? end() : make_iterator<false>(index, false);
+    }
+
+    /// @copydoc find(const K&)
+    template <typename K = key_type>
+        requires std::is_same_v<K, key_type> || is_transparent
+    const_iterator find(const K& key) const
+    {
+        auto index = find_index(key, hash_of(key));
+        return index == npos ? end() : make_iterator<true>(index, false);
+    }
+
+    /**
+     * @brief
+     * Count the elements with a key.
+     *
+     * @param key   The key.
+     *
+     * @return  1 if the key is present, otherwise 0.
+     */
+    template <typename K = key_type>
+        requires std::is_same_v<K, key_type> || is_transparent
+    size_type count(const K& key) const { return contains(key) ? 1 : 0; }
+
+    /**
+     * @brief
+     * Check if a key is present.
+     *
+     * @param key   The key.
+     *
+     * @return  Whether or not there is an element with the key.
+     */
+    template <typename K = key_type>
+        requires std::is_same_v<K, key_type> || is_transparent
+    bool contains(const K& key) const { return find_index(key, hash_of(key)) != npos; }
+
+    /// @brief Get the number of slots in the table.
+    size_type bucket_count() const noexcept { return _capacity; }
+    /// @brief Get the ratio of elements to slots.
+    float load_factor() const noexcept { return _capacity == 0 ? 0.0f : float(_size) / float(_capacity); }
+    /// @brief Get the ratio of elements to slots at which the table grows.
+    float max_load_factor() const noexcept { return 7.0f / 8.0f; }
+
+    /**
+     * @brief
+     * Resize the table to have at least a number of slots and room for the current elements.
+     *
+     * @param count     Minimum number of slots.
+     */
+    void rehash(size_type count)
+    {
+        auto capacity = std::max(capacity_for(_size), count == 0 ? 0 : std::max(min_capacity, std::bit_ceil(count)));
+        if (capacity != _capacity) {
+            resize(capacity);
+        }
+    }
+
+    /**
+     * @brief
+     * Make room for a number of elements without growing the table again.
+     *
+     * @param count     Number of elements.
+     */
+    void reserve(size_type count)
+    {
+        if (count > _size + _growth_left) {
+            resize(capacity_for(count));
+        }
+    }
+
+    /// @brief Get the hash functor.
+    hasher hash_function() const { return _hash; }
+    /// @brief Get the key equality functor.
+    key_equal key_eq() const { return _equal; }
+
+    /**
+     * @brief
+     * Check if two maps hold equal elements.
+     *
+     * @return  Whether or not the maps are equal.
+     */
+    friend bool operator==(const flat_hash_map& a, const flat_hash_map& b)
+    {
+        if (a.size() != b.size()) {
+            return false;
+        }
+        for (const auto& v : a) {
+            auto it = b.find(v.first);
+            if (it == b.end() || !(it->second == v.second)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /// @brief Swap two maps.
+    friend void swap(flat_hash_map& a, flat_hash_map& b) noexcept { a.swap(b); }
+
+  private:
+    /// @brief Index returned when a key is not found.
+    static constexpr size_type npos = ~size_type{0};
+
+    /// @brief Smallest non-zero number of slots.
+    static constexpr size_type min_capacity = details::swiss_group_width;
+
+    slot* _slots{};                                 ///< @brief The slots.
+    std::uint8_t* _ctrl{};                          ///< @brief Control bytes, following the slots.
+    size_type _capacity{};                          ///< @brief Number of slots, a power of two.
+    size_type _size{};                              ///< @brief Number of elements.
+    size_type _growth_left{};                       ///< @brief Empty slots left before growing.
+    [[no_unique_address]] hasher _hash{};           ///< @brief The hash functor.
+    [[no_unique_address]] key_equal _equal{};       ///< @brief The key equality functor.
+    [[no_unique_address]] slot_allocator _alloc{};  ///< @brief The allocator.
+
+    /// @brief Maximum number of elements for a number of slots.
+    static constexpr size_type max_load(size_type capacity) noexcept { return capacity - capacity / 8; }
+
+    /// @brief Number of slots needed for a number of elements.
+    static size_type capacity_for(size_type count) noexcept
+    {
+        if (count == 0) {
+            return 0;
+        }
+        auto capacity = std::max(min_capacity, std::bit_ceil(count));
+        return max_load(capacity) < count ? capacity * 2 : capacity;
+    }
+
+    /// @brief Number of `slot`s allocated for a table, including those holding the control bytes.
+    static constexpr size_type allocation_size(size_type capacity) noexcept
+    {
+        return capacity + (capacity + details::swiss_group_width + sizeof(slot) - 1) / sizeof(slot);
+    }
+
+    /**
+     * @brief
+     * Mix the user supplied hash so that both the probe position and the 7 bits kept in the
+     * control byte are well distributed, even for identity hashes such as `std::hash<int>`.
+     */
+    template <typename K>
+    size_type hash_of(const K& key) const
+    {
+        auto h = static_cast<std::uint64_t>(_hash(key)) * 0x9E3779B97F4A7C15ull;
+        return static_cast<size_type>(h ^ (h >> 32));
+    }
+
+    /// @brief Get the control byte for a hash.
+    static std::uint8_t h2(size_type hash) noexcept
+    {
+        return static_cast<std::uint8_t>(details::swiss_full | (hash & 0x7F));
+    }
+
+    /**
+     * @brief
+     * Set a control byte, mirroring the first group after the last slot so that a group can be
+     * loaded starting at any slot.
+     */
+    void set_ctrl(size_type index, std::uint8_t c) noexcept
+    {
+        _ctrl[index] = c;
+        _ctrl[((index - details::swiss_group_width) & (_capacity - 1)) + details::swiss_group_width] = c;
+    }
+
+    /// @brief Make an iterator for a slot.
+    template <bool Const>
+    iterator_impl<Const> make_iterator(size_type index, bool skip) const noexcept
+    {
+        iterator_impl<Const> it{_ctrl + index, _slots + index, _ctrl + _capacity};
+        if (skip) {
+            it.skip_free();
+        }
+        return it;
+    }
+
+    /**
+     * @brief
+     * Find the slot holding a key.
+     *
+     * Groups are probed quadratically, which visits every group since the number of slots is a
+     * power of two, and the search stops at the first group with a slot that has never been used.
+     *
+     * @return  Index of the slot or `npos`.
+     */
+    template <typename K>
+    size_type find_index(const K& key, size_type hash) const
+    {
+        if (_capacity == 0) {
+            return npos;
+        }
+        auto mask = _capacity - 1;
+        auto c = h2(hash);
+        auto pos = (hash >> 7) & mask;
+        for (size_type step = details::swiss_group_width;; step += details::swiss_group_width) {
+            details::swiss_group g{_ctrl + pos};
+            for (auto m = g.match(c); m != 0; m &= m - 1) {
+                auto index = (pos + static_cast<size_type>(std::countr_zero(m))) & mask;
+                if (_equal(_slots[index].value()->first, key)) {
+                    return index;
+                }
+            }
+            if (g.match_empty() != 0) {
+                return npos;
+            }
+            pos = (pos + step) & mask;
+        }
+    }
+
+    /// @brief Find the first slot not holding an element on the probe sequence of a hash.
+    size_type find_free(size_type hash) const noexcept
+    {
+        auto mask = _capacity - 1;
+        auto pos = (hash >> 7) & mask;
+        for (size_type step = details::swiss_group_width;; step += details::swiss_group_width) {
+            auto m = details::swiss_group{_ctrl + pos}.match_free();
+            if (m != 0) {
+                return (pos + static_cast<size_type>(std::countr_zero(m))) & mask;
+            }
+            pos = (pos + step) & mask;
+        }
+    }
+
+    /**
+     * @brief
+     * Destroy the element in a slot and wipe the slot.
+     *
+     * The slot can go straight back to empty, rather than becoming a tombstone, if no probe could
+     * ever have passed over it: that is, if it is not inside a run of a whole group of slots
+     * without an empty one.
+     */
+    void erase_index(size_type index) noexcept
+    {
+        std::destroy_at(_slots[index].value());
+        secure_zero(&_slots[index], sizeof(slot));
+        --_size;
+
+        auto mask = _capacity - 1;
+        auto before = details::swiss_group{_ctrl + ((index - details::swiss_group_width) & mask)}.match_empty();
+        auto after = details::swiss_group{_ctrl + index}.match_empty();
+        auto run = static_cast<size_type>(std::countl_zero(static_cast<std::uint16_t>(before)) +
+                                          std::countr_zero(static_cast<std::uint16_t>(after)));
+        if (before != 0 && after != 0 && run < details::swiss_group_width) {
+            set_ctrl(index, details::swiss_empty);
+            ++_growth_left;
+        } else {
+            set_ctrl(index, details::swiss_deleted);
+        }
+    }
+
+    /// @brief Grow the table, or just clear out tombstones if they take up most of the room.
+    void grow()
+    {
+        if (_capacity == 0) {
+            resize(min_capacity);
+        } else if (_size * 2 <= max_load(_capacity)) {
+            resize(_capacity);
+        } else {
+            resize(_capacity * 2);
+        }
+    }
+
+    /**
+     * @brief
+     * Move all elements into a new table and wipe the old one.
+     *
+     * Elements are only moved if neither that nor hashing their keys can throw.  Otherwise they
+     * are copied, unless they cannot be, so that an exception leaves the old table untouched.
+     *
+     * @param capacity  Number of slots in the new table.
+     */
+    void resize(size_type capacity)
+    {
+        constexpr bool move_elements = (std::is_nothrow_move_constructible_v<value_type> &&
+                                        std::is_nothrow_invocable_v<const hasher&, const key_type&>) ||
+                                       !std::is_copy_constructible_v<value_type>;
+
+        auto* old_slots = _slots;
+        auto* old_ctrl = _ctrl;
+        auto old_capacity = _capacity;
+        auto old_growth_left = _growth_left;
+
+        if (capacity == 0) {
+            _slots = nullptr;
+            _ctrl = nullptr;
+        } else {
+            _slots = slot_traits::allocate(_alloc, allocation_size(capacity));
+            _ctrl = reinterpret_cast<std::uint8_t*>(_slots + capacity);
+            std::memset(_ctrl, details::swiss_empty, capacity + details::swiss_group_width);
+        }
+        _capacity = capacity;
+        _growth_left = max_load(capacity) - _size;
+
+        try {
+            for (size_type i = 0; i < old_capacity; ++i) {
+                if ((old_ctrl[i] & details::swiss_full) != 0) {
+                    auto* v = old_slots[i].value();
+                    auto hash = hash_of(v->first);
+                    auto index = find_free(hash);
+                    if constexpr (move_elements) {
+                        std::construct_at(_slots[index].value(), std::move(*v));
+                    } else {
+                        std::construct_at(_slots[index].value(), std::as_const(*v));
+                    }
+                    set_ctrl(index, h2(hash));
+                }
+            }
+        } catch (...) {
+            if (_slots != nullptr) {
+                destroy_elements();
+                slot_traits::deallocate(_alloc, _slots, allocation_size(capacity));
+            }
+            _slots = old_slots;
+            _ctrl = old_ctrl;
+            _capacity = old_capacity;
+            _growth_left = old_growth_left;
+            throw;
+        }
+
+        if (old_slots != nullptr) {
+            for (size_type i = 0; i < old_capacity; ++i) {
+                if ((old_ctrl[i] & details::swiss_full) != 0) {
+                    std::destroy_at(old_slots[i].value());
+                }
+            }
+            secure_zero(old_slots, old_capacity * sizeof(slot));
+            slot_traits::deallocate(_alloc, old_slots, allocation_size(old_capacity));
+        }
+    }
+
+    /// @brief Destroy all elements and wipe their slots.
+    void destroy_elements() noexcept
+    {
+        for (size_type i = 0; i < _capacity; ++i) {
+            if ((_ctrl[i] & details::swiss_full) != 0) {
+                std::destroy_at(_slots[i].value());
+                secure_zero(&_slots[i], sizeof(slot));
+            }
+        }
+    }
+
+    /// @brief Destroy all elements and free the table.
+    void release() noexcept
+    {
+        if (_slots != nullptr) {
+            destroy_elements();
+            slot_traits::deallocate(_alloc, _slots, allocation_size(_capacity));
+        }
+        _slots = nullptr;
+        _ctrl = nullptr;
+        _capacity = 0;
+        _size = 0;
+        _growth_left = 0;
+    }
+
+    /// @brief Take the table of another map, leaving it empty.
+    void steal(flat_hash_map& other) noexcept
+    {
+        _slots = std::exchange(other._slots, nullptr);
+        _ctrl = std::exchange(other._ctrl, nullptr);
+        _capacity = std::exchange(other._capacity, 0);
+        _size = std::exchange(other._size, 0);
+        _growth_left = std::exchange(other._growth_left, 0);
+    }
+
+    /// @brief Copy the elements of another map into this empty one.
+    void copy_elements(const flat_hash_map& other)
+    {
+        reserve(other.size());
+        for (const auto& v : other) {
+            try_emplace(v.first, v.second);
+        }
+    }
+};
+
+/**
+ * @brief
+ * Erase all elements satisfying a predicate.
+ *
+ * @param c     The map.
+ * @param pred  The predicate.
+ *
+ * @return  Number of elements erased.
+ */
+template <typename Key, typename T, typename Hash, typename KeyEqual, typename Allocator, typename Pred>
+std::size_t erase_if(flat_hash_map<Key, T, Hash, KeyEqual, Allocator>& c, Pred pred)
+{
+    auto old_size = c.size();
+    for (auto it = c.begin(); it != c.end();) {
+        if (pred(*it)) {
+            it = c.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    return old_size - c.size();
+}
+
+} // namespace ec
@@ -0,0 +1,880 @@
+/**
+ * @file
+ * Sorted associative container adapter over a pair of random access containers.
+ *
+ * @copyright 2023 Steve Kinneberg <steve.kinneberg@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <enhanced_containers/details/common.h>
+
+#include <algorithm>
+#include <compare>
+#include <cstddef>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <numeric>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace ec {
+
+/// @brief Tag type indicating that input is already sorted and free of duplicates.
+struct sorted_unique_t {
+    /// @brief Explicit default constructor, as for the standard tag types.
+    explicit sorted_unique_t() = default;
+};
+
+/// @brief Tag indicating that input is already sorted and free of duplicates.
+inline constexpr sorted_unique_t sorted_unique{};
+
+namespace details {
+/**
+ * @internal @brief
+ * Random access iterator over the elements of a `ec::flat_map<>` that pairs up the iterators of
+ * its key and mapped containers.
+ *
+ * Dereferencing yields a pair of references rather than a reference to a pair, the same as for
+ * `std::flat_map`.
+ *
+ * @tparam KeyIt    Iterator type of the key container.
+ * @tparam MappedIt Iterator type of the mapped container.
+ */
+template <typename KeyIt, typename MappedIt>
+class flat_map_iterator {
+  public:
+    /// @brief The iterator category.
+    using iterator_category = std::random_access_iterator_tag;
+    /// @brief The iterator concept.
+    using iterator_concept = std::random_access_iterator_tag;
+    /// @brief Type alias for the element type.
+    using value_type = std::pair<std::iter_value_t<KeyIt>, std::iter_value_t<MappedIt>>;
+    /// @brief Type alias for the type returned by dereferencing.
+    using reference = std::pair<std::iter_reference_t<KeyIt>, std::iter_reference_t<MappedIt>>;
+    /// @brief Type alias for the distance between iterators.
+    using difference_type = std::ptrdiff_t;
+
+    /// @brief Holder for the pair of references so that `operator->()` works.
+    struct pointer {
+        reference ref;  ///< @brief The pair of references.
+
+        /// @brief Access the pair of references.
+        reference* operator->() noexcept { return &ref; }
+    };
+
+    /// @brief Default constructor.
+    flat_map_iterator() = default;
+
+    /**
+     * @brief
+     * Constructor.
+     *
+     * @param key       Iterator into the key container.
+     * @param mapped    Iterator into the mapped container at the same position.
+     */
+    flat_map_iterator(KeyIt key, MappedIt mapped):
+        _key{key},
+        _mapped{mapped}
+    {}
+
+    /**
+     * @brief
+     * Converting constructor from a mutable to a constant iterator.
+     *
+     * @param other     The iterator to convert.
+     */
+    template <typename K, typename M>
+        requires std::is_convertible_v<K, KeyIt> && std::is_convertible_v<M, MappedIt>
+    flat_map_iterator(const flat_map_iterator<K, M>& other):
+        _key{other.key_iterator()},
+        _mapped{other.mapped_iterator()}
+    {}
+
+    /// @brief Get the iterator into the key container.
+    KeyIt key_iterator() const { return _key; }
+    /// @brief Get the iterator into the mapped container.
+    MappedIt mapped_iterator() const { return _mapped; }
+
+    /// @brief Dereference.
+    reference operator*() const { return {*_key, *_mapped}; }
+    /// @brief Member access.
+    pointer operator->() const { return {**this}; }
+    /// @brief Subscript.
+    reference operator[](difference_type n) const { return {_key[n], _mapped[n]}; }
+
+    /// @brief Pre-increment.
+    flat_map_iterator& operator++() { ++_key; ++_mapped; return *this; }
+    /// @brief Post-increment.
+    flat_map_iterator operator++(int) { auto tmp = *this; ++*this; return tmp; }
+    /// @brief Pre-decrement.
+    flat_map_iterator& operator--() { --_key; --_mapped; return *this; }
+    /// @brief Post-decrement.
+    flat_map_iterator operator--(int) { auto tmp = *this; --*this; return tmp; }
+    /// @brief Advance.
+    flat_map_iterator& operator+=(difference_type n) { _key += n; _mapped += n; return *this; }
+    /// @brief Retreat.
+    flat_map_iterator& operator-=(difference_type n) { _key -= n; _mapped -= n; return *this; }
+
+    /// @brief Advance a copy.
+    friend flat_map_iterator operator+(flat_map_iterator it, difference_type n) { return it += n; }
+    /// @brief Advance a copy.
+    friend flat_map_iterator operator+(difference_type n, flat_map_iterator it) { return it += n; }
+    /// @brief Retreat a copy.
+    friend flat_map_iterator operator-(flat_map_iterator it, difference_type n) { return it -= n; }
+    /// @brief Distance between iterators.
+    friend difference_type operator-(const flat_map_iterator& a, const flat_map_iterator& b)
+    {
+        return a._key - b._key;
+    }
+    /// @brief Equality.
+    friend bool operator==(const flat_map_iterator& a, const flat_map_iterator& b) { return a._key == b._key; }
+    /// @brief Ordering.
+    friend auto operator<=>(const flat_map_iterator& a, const flat_map_iterator& b) { return a._key <=> b._key; }
+
+  private:
+    KeyIt _key{};       ///< @brief Iterator into the key container.
+    MappedIt _mapped{}; ///< @brief Iterator into the mapped container.
+};
+
+/**
+ * @internal @brief
+ * Get the permutation that stably sorts a range of keys, dropping all but the first of equivalent
+ * keys.
+ *
+ * @param keys      The keys.
+ * @param compare   The comparison functor.
+ *
+ * @return  Indices of the keys to keep, in sorted order.
+ */
+template <typename KeyContainer, typename Compare>
+std::vector<std::size_t> sorted_unique_permutation(const KeyContainer& keys, const Compare& compare)
+{
+    std::vector<std::size_t> order(keys.size());
+    std::iota(order.begin(), order.end(), std::size_t{0});
+    std::stable_sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) {
+        return compare(keys[a], keys[b]);
+    });
+    order.erase(std::unique(order.begin(), order.end(), [&](std::size_t a, std::size_t b) {
+        return !compare(keys[a], keys[b]) && !compare(keys[b], keys[a]);
+    }), order.end());
+    return order;
+}
+
+/**
+ * @internal @brief
+ * Rebuild a container from a subset of its elements in a given order.
+ *
+ * The new container uses the same allocator as the old one, and the old one is cleared before it
+ * is replaced so that its memory is released.
+ *
+ * @param c         The container to rebuild.
+ * @param order     Indices of the elements to keep, in order.
+ */
+template <typename Container>
+void apply_permutation(Container& c, const std::vector<std::size_t>& order)
+{
+    Container result(c.get_allocator());
+    result.reserve(order.size());
+    for (auto i : order) {
+        result.push_back(std::move(c[i]));
+    }
+    c.clear();
+    c = std::move(result);
+}
+} // namespace details
+
+/**
+ * @brief
+ * Associative container of unique keys kept in sorted order in one random access container and
+ * the values mapped to them in a second one, compatible with C++23 `std::flat_map`.
+ *
+ * Lookups are binary searches over contiguous keys, which is considerably more cache friendly
+ * than chasing tree nodes, and the whole map occupies just two allocations.  Insertion and erasure
+ * are linear in the size of the map, so this is best for tables that are built once and then
+ * mostly read.
+ *
+ * Iterators and references are invalidated by any insertion or erasure.
+ *
+ * @tparam Key              The key type.
+ * @tparam T                The mapped type.
+ * @tparam Compare          The comparison functor type.
+ * @tparam KeyContainer     The container holding the keys.
+ * @tparam MappedContainer  The container holding the mapped values.
+ */
+template <typename Key,
+          typename T,
+          typename Compare = std::less<Key>,
+          typename KeyContainer = std::vector<Key>,
+          typename MappedContainer = std::vector<T>>
+class flat_map {
+  public:
+    /// @brief Type alias for the key type.
+    using key_type = Key;
+    /// @brief Type alias for the mapped type.
+    using mapped_type = T;
+    /// @brief Type alias for the element type.
+    using value_type = std::pair<key_type, mapped_type>;
+    /// @brief Type alias for the comparison functor type.
+    using key_compare = Compare;
+    /// @brief Type alias for the type returned by dereferencing an iterator.
+    using reference = std::pair<const key_type&, mapped_type&>;
+    /// @brief Type alias for the type returned by dereferencing a constant iterator.
+    using const_reference = std::pair<const key_type&, const mapped_type&>;
+    /// @brief Type alias for the type representing the size of the map.
+    using size_type = std::size_t;
+    /// @brief Type alias for the type representing the distance between iterators.
+    using difference_type = std::ptrdiff_t;
+    /// @brief Type alias for the container holding the keys.
+    using key_container_type = KeyContainer;
+    /// @brief Type alias for the container holding the mapped values.
+    using mapped_container_type = MappedContainer;
+    /// @brief Iterator type.
+    using iterator = details::flat_map_iterator<typename KeyContainer::const_iterator,
+                                                typename MappedContainer::iterator>;
+    /// @brief Constant iterator type.
+    using const_iterator = details::flat_map_iterator<typename KeyContainer::const_iterator,
+                                                      typename MappedContainer::const_iterator>;
+    /// @brief Reverse iterator type.
+    using reverse_iterator = std::reverse_iterator<iterator>;
+    /// @brief Constant reverse iterator type.
+    using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+    /// @brief The underlying containers, as returned by `extract()`.
+    struct containers {
+        key_container_type keys;        ///< @brief The sorted keys.
+        mapped_container_type values;   ///< @brief The mapped values in the order of the keys.
+    };
+
+    /// @brief Functor comparing elements by their keys.
+    class value_compare {
+      public:
+        /// @brief Compare two elements by their keys.
+        bool operator()(const_reference a, const_reference b) const { return _comp(a.first, b.first); }
+
+      private:
+        key_compare _comp;  ///< @brief The key comparison functor.
+
+        /// @brief Constructor.
+        explicit value_compare(key_compare comp): _comp{comp} {}
+
+        friend class flat_map;
+    };
+
+    /// @brief Default constructor.
+    flat_map(): flat_map(key_compare{}) {}
+
+    /**
+     * @brief
+     * Construct an empty map with a comparison functor.
+     *
+     * @param comp  The comparison functor.
+     */
+    explicit flat_map(const key_compare& comp):
+        _comp{comp}
+    {}
+
+    /**
+     * @brief
+     * Construct from a pair of containers which are sorted and made unique.
+     *
+     * @param keys      The keys.
+     * @param values    The values mapped to the keys.  Must be the same size as `keys`.
+     * @param comp      The comparison functor.
+     */
+    flat_map(key_container_type keys, mapped_container_type values, const key_compare& comp = key_compare{}):
+        _c{std::move(keys), std::move(values)},
+        _comp{comp}
+    {
+        sort_unique();
+    }
+
+    /**
+     * @brief
+     * Construct from a pair of containers that are already sorted and unique.
+     *
+     * @param keys      The sorted, unique keys.
+     * @param values    The values mapped to the keys.  Must be the same size as `keys`.
+     * @param comp      The comparison functor.
+     */
+    flat_map(sorted_unique_t, key_container_type keys, mapped_container_type values,
+             const key_compare& comp = key_compare{}):
+        _c{std::move(keys), std::move(values)},
+        _comp{comp}
+    {}
+
+    /**
+     * @brief
+     * Construct from a range of elements.
+     *
+     * @param first     Start of the range.
+     * @param last      End of the range.
+     * @param comp      The comparison functor.
+     */
+    template <typename InputIt>
+    flat_map(InputIt first, InputIt last, const key_compare& comp = key_compare{}):
+        _comp{comp}
+    {
+        insert(first, last);
+    }
+
+    /**
+     * @brief
+     * Construct from a list of elements.
+     *
+     * @param init  The elements.
+     * @param comp  The comparison functor.
+     */
+    flat_map(std::initializer_list<value_type> init, const key_compare& comp = key_compare{}):
+        flat_map(init.begin(), init.end(), comp)
+    {}
+
+    /// @brief Get an iterator to the first element.
+    iterator begin() noexcept { return {_c.keys.cbegin(), _c.values.begin()}; }
+    /// @brief Get an iterator to the first element.
+    const_iterator begin() const noexcept { return {_c.keys.cbegin(), _c.values.cbegin()}; }
+    /// @brief Get an iterator past the last element.
+    iterator end() noexcept { return {_c.keys.cend(), _c.values.end()}; }
+    /// @brief Get an iterator past the last element.
+    const_iterator end() const noexcept { return {_c.keys.cend(), _c.values.cend()}; }
+    /// @brief Get an iterator to the first element.
+    const_iterator cbegin() const noexcept { return begin(); }
+    /// @brief Get an iterator past the last element.
+    const_iterator cend() const noexcept { return end(); }
+    /// @brief Get a reverse iterator to the last element.
+    reverse_iterator rbegin() noexcept { return reverse_iterator{end()}; }
+    /// @brief Get a reverse iterator to the last element.
+    const_reverse_iterator rbegin() const noexcept { return const_reverse_iterator{end()}; }
+    /// @brief Get a reverse iterator before the first element.
+    reverse_iterator rend() noexcept { return reverse_iterator{begin()}; }
+    /// @brief Get a reverse iterator before the first element.
+    const_reverse_iterator rend() const noexcept { return const_reverse_iterator{begin()}; }
+
+    /// @brief Check if the map is empty.
+    EC_NODISCARD bool empty() const noexcept { return _c.keys.empty(); }
+    /// @brief Get the number of elements.
+    size_type size() const noexcept { return _c.keys.size(); }
+    /// @brief Get the maximum number of elements.
+    size_type max_size() const noexcept { return std::min(_c.keys.max_size(), _c.values.max_size()); }
+
+    /**
+     * @brief
+     * Get the value mapped to a key, inserting a value initialized one if there is none.
+     *
+     * @param key   The key.
+     *
+     * @return  The mapped value.
+     */
+    mapped_type& operator[](const key_type& key) { return try_emplace(key).first->second; }
+
+    /**
+     * @brief
+     * Get the value mapped to a key, inserting a value initialized one if there is none.
+     *
+     * @param key   The key.
+     *
+     * @return  The mapped value.
+     */
+    mapped_type& operator[](key_type&& key) { return try_emplace(std::move(key)).first->second; }
+
+    /**
+     * @brief
+     * Get the value mapped to a key.
+     *
+     * @param key   The key.
+     *
+     * @return  The mapped value.
+     *
+     * @throws std::out_of_range if there is no such key.
+     */
+    mapped_type& at(const key_type& key)
+    {
+        auto it = find(key);
+        if (it == end()) {
+            throw std::out_of_range("ec::flat_map::at");
+        }
+        return it->second;
+    }
+
+    /// @copydoc at(const key_type&)
+    const mapped_type& at(const key_type& key) const
+    {
+        auto it = find(key);
+        if (it == end()) {
+            throw std::out_of_range("ec::flat_map::at");
+        }
+        return it->second;
+    }
+
+    /**
+     * @brief
+     * Insert an element constructed in place if its key is not present.
+     *
+     * @param args  Arguments to construct a `value_type` from.
+     *
+     * @return  Iterator to the element with the key and whether or not it was inserted.
+     */
+    template <typename... Args>
+    std::pair<iterator, bool> emplace(Args&&... args)
+    {
+        value_type v(std::forward<Args>(args)...);
+        return try_emplace(std::move(v.first), std::move(v.second));
+    }
+
+    /**
+     * @brief
+     * Insert an element constructed in place if its key is not present.
+     *
+     * The hint is ignored since finding the position is cheap compared to inserting.
+     *
+     * @param args  Arguments to construct a `value_type` from.
+     *
+     * @return  Iterator to the element with the key.
+     */
+    template <typename... Args>
+    iterator emplace_hint(const_iterator, Args&&... args)
+    {
+        return emplace(std::forward<Args>(args)...).first;
+    }
+
+    /**
+     * @brief
+     * Insert an element if its key is not present.
+     *
+     * @param value     The element.
+     *
+     * @return  Iterator to the element with the key and whether or not it was inserted.
+     */
+    std::pair<iterator, bool> insert(const value_type& value) { return try_emplace(value.first, value.second); }
+
+    /// @copydoc insert(const value_type&)
+    std::pair<iterator, bool> insert(value_type&& value)
+    {
+        return try_emplace(std::move(value.first), std::move(value.second));
+    }
+
+    /**
+     * @brief
+     * Insert an element if its key is not present.  The hint is ignored.
+     *
+     * @param value     The element.
+     *
+     * @return  Iterator to the element with the key.
+     */
+    iterator insert(const_iterator, const value_type& value) { return insert(value).first; }
+
+    /// @copydoc insert(const_iterator, const value_type&)
+    iterator insert(const_iterator, value_type&& value) { return insert(std::move(value)).first; }
+
+    /**
+     * @brief
+     * Insert a range of elements whose keys are not present.
+     *
+     * The elements are appended and then everything is sorted once, which is much faster than
+     * inserting them one at a time.  Of elements with equivalent keys, the first one is kept.
+     *
+     * @param first     Start of the range.
+     * @param last      End of the range.
+     */
+    template <typename InputIt>
+    void insert(InputIt first, InputIt last)
+    {
+        auto old_size = size();
+        try {
+            for (; first != last; ++first) {
+                value_type v(*first);
+                _c.keys.insert(_c.keys.end(), std::move(v.first));
+                try {
+                    _c.values.insert(_c.values.end(), std::move(v.second));
+                } catch (...) {
+                    _c.keys.pop_back();
+                    throw;
+                }
+            }
+        } catch (...) {
+            _c.keys.erase(_c.keys.begin() + old_size, _c.keys.end());
+            _c.values.erase(_c.values.begin() + old_size, _c.values.end());
+            throw;
+        }
+        sort_unique();
+    }
+
+    /**
+     * @brief
+     * Insert a list of elements whose keys are not present.
+     *
+     * @param init  The elements.
+     */
+    void insert(std::initializer_list<value_type> init) { insert(init.begin(), init.end()); }
+
+    /**
+     * @brief
+     * Insert a value constructed in place if the key is not present.
+     *
+     * @param key   The key.
+     * @param args  Arguments to construct the mapped value from.
+     *
+     * @return  Iterator to the element with the key and whether or not it was inserted.
+     */
+    template <typename K, typename... Args>
+        requires std::is_constructible_v<key_type, K>
+    std::pair<iterator, bool> try_emplace(K&& key, Args&&... args)
+    {
+        auto pos = key_lower_bound(key);
+        auto index = pos - _c.keys.cbegin();
+        if (pos != _c.keys.cend() && !_comp(key, *pos)) {
+            return {begin() + index, false};
+        }
+        _c.keys.emplace(pos, std::forward<K>(key));
+        try {
+            _c.values.emplace(_c.values.begin() + index, std::forward<Args>(args)...);
+        } catch (...) {
+            _c.keys.erase(_c.keys.begin() + index);
+            throw;
+        }
+        return {begin() + index, true};
+    }
+
+    /**
+     * @brief
+     * Insert a value if the key is not present or assign it if it is.
+     *
+     * @param key   The key.
+     * @param obj   The value.
+     *
+     * @return  Iterator to the element with the key and whether or not it was inserted.
+     */
+    template <typename K, typename M>
+    std::pair<iterator, bool> insert_or_assign(K&& key, M&& obj)
+    {
+        auto result = try_emplace(std::forward<K>(key), std::forward<M>(obj));
+        if (!result.second) {
+            result.first->second = std::forward<M>(obj);
+        }
+        return result;
+    }
+
+    /**
+     * @brief
+     * Move the underlying containers out of the map, leaving it empty.
+     *
+     * @return  The containers.
+     */
+    containers extract() &&
+    {
+        containers result{std::move(_c)};
+        clear();
+        return result;
+    }
+
+    /**
+     * @brief
+     * Replace the underlying containers.
+     *
+     * @param keys      The sorted, unique keys.
+     * @param values    The values mapped to the keys.  Must be the same size as `keys`.
+     */
+    void replace(key_container_type&& keys, mapped_container_type&& values)
+    {
+        _c.keys = std::move(keys);
+        _c.values = std::move(values);
+    }
+
+    /**
+     * @brief
+     * Erase an element.
+     *
+     * @param pos   Iterator to the element.
+     *
+     * @return  Iterator to the element after the erased one.
+     */
+    iterator erase(iterator pos) { return erase(const_iterator{pos}); }
+
+    /// @copydoc erase(iterator)
+    iterator erase(const_iterator pos)
+    {
+        auto index = pos - cbegin();
+        _c.keys.erase(_c.keys.begin() + index);
+        _c.values.erase(_c.values.begin() + index);
+        return begin() + index;
+    }
+
+    /**
+     * @brief
+     * Erase a range of elements.
+     *
+     * @param first     Start of the range.
+     * @param last      End of the range.
+     *
+     * @return  Iterator to the element after the erased ones.
+     */
+    iterator erase(const_iterator first, const_iterator last)
+    {
+        auto start = first - cbegin();
+        auto stop = last - cbegin();
+        _c.keys.erase(_c.keys.begin() + start, _c.keys.begin() + stop);
+        _c.values.erase(_c.values.begin() + start, _c.values.begin() + stop);
+        return begin() + start;
+    }
+
+    /**
+     * @brief
+     * Erase the element with a key.
+     *
+     * @param key   The key.
+     *
+     * @return  Number of elements erased.
+     */
+    size_type erase(const key_type& key)
+    {
+        auto it = find(key);
+        if (it == end()) {
+            return 0;
+        }
+        erase(it);
+        return 1;
+    }
+
+    /**
+     * @brief
+     * Swap the contents with another map.
+     *
+     * @param other     The map to swap with.
+     */
+    void swap(flat_map& other) noexcept
+    {
+        using std::swap;
+        swap(_c.keys, other._c.keys);
+        swap(_c.values, other._c.values);
+        swap(_comp, other._comp);
+    }
+
+    /// @brief Erase all elements.
+    void clear() noexcept
+    {
+        _c.keys.clear();
+        _c.values.clear();
+    }
+
+    /// @brief Get the key comparison functor.
+    key_compare key_comp() const { return _comp; }
+    /// @brief Get the element comparison functor.
+    value_compare value_comp() const { return value_compare{_comp}; }
+    /// @brief Get the sorted keys.
+    const key_container_type& keys() const noexcept { return _c.keys; }
+    /// @brief Get the mapped values in the order of the keys.
+    const mapped_container_type& values() const noexcept { return _c.values; }
+
+    /**
+     * @brief
+     * Find the element with a key.
+     *
+     * @param key   The key.
+     *
+     * @return  Iterator to the element or `end()`.
+     */
+    template <typename K = key_type>
+        requires std::is_same_v<K, key_type> || requires { typename Compare::is_transparent; }
+    iterator find(const K& key)
+    {
+        auto it = lower_bound(key);
+        return (it != end() && !_comp(key, it->first)) ? it : end();
+    }
+
+    /// @copydoc find(const K&)
+    template <typename K = key_type>
+        requires std::is_same_v<K, key_type> || requires { typename Compare::is_transparent; }
+    const_iterator find(const K& key) const
+    {
+        auto it = lower_bound(key);
+        return (it != end() && !_comp(key, it->first)) ? it : end();
+    }
+
+    /**
+     * @brief
+     * Count the elements with a key.
+     *
+     * @param key   The key.
+     *
+     * @return  1 if the key is present, otherwise 0.
+     */
+    template <typename K = key_type>
+        requires std::is_same_v<K, key_type> || requires { typename Compare::is_transparent; }
+    size_type count(const K& key) const { return contains(key) ? 1 : 0; }
+
+    /**
+     * @brief
+     * Check if a key is present.
+     *
+     * @param key   The key.
+     *
+     * @return  Whether or not there is an element with the key.
+     */
+    template <typename K = key_type>
+        requires std::is_same_v<K, key_type> || requires { typename Compare::is_transparent; }
+    bool contains(const K& key) const { return find(key) != end(); }
+
+    /**
+     * @brief
+     * Find the first element whose key is not ordered before a key.
+     *
+     * @param key   The key.
+     *
+     * @return  Iterator to the element or `end()`.
+     */
+    template <typename K = key_type>
+        requires std::is_same_v<K, key_type> || requires { typename Compare::is_transparent; }
+    iterator lower_bound(const K& key) { return begin() + (key_lower_bound(key) - _c.keys.cbegin()); }
+
+    /// @copydoc lower_bound(const K&)
+    template <typename K = key_type>
+        requires std::is_same_v<K, key_type> || requires { typename Compare::is_transparent; }
+    const_iterator lower_bound(const K& key) const
+    {
+        return begin() + (key_lower_bound(key) - _c.keys.cbegin());
+    }
+
+    /**
+     * @brief
+     * Find the first element whose key is ordered after a key.
+     *
+     * @param key   The key.
+     *
+     * @return  Iterator to the element or `end()`.
+     */
+    template <typename K = key_type>
+        requires std::is_same_v<K, key_type> || requires { typename Compare::is_transparent; }
+    iterator upper_bound(const K& key)
+    {
+        return begin() + (std::upper_bound(_c.keys.cbegin(), _c.keys.cend(), key, _comp) - _c.keys.cbegin());
+    }
+
+    /// @copydoc upper_bound(const K&)
+    template <typename K = key_type>
+        requires std::is_same_v<K, key_type> || requires { typename Compare::is_transparent; }
+    const_iterator upper_bound(const K& key) const
+    {
+        return begin() + (std::upper_bound(_c.keys.cbegin(), _c.keys.cend(), key, _comp) - _c.keys.cbegin());
+    }
+
+    /**
+     * @brief
+     * Find the range of elements with a key.
+     *
+     * @param key   The key.
+     *
+     * @return  The range, which holds at most one element.
+     */
+    template <typename K = key_type>
+        requires std::is_same_v<K, key_type> || requires { typename Compare::is_transparent; }
+    std::pair<iterator, iterator> equal_range(const K& key)
+    {
+        auto first = lower_bound(key);
+        auto last = (first != end() && !_comp(key, first->first)) ? std::next(first) : first;
+        return {first, last};
+    }
+
+    /// @copydoc equal_range(const K&)
+    template <typename K = key_type>
+        requires std::is_same_v<K, key_type> || requires { typename Compare::is_transparent; }
+    std::pair<const_iterator, const_iterator> equal_range(const K& key) const
+    {
+        auto first = lower_bound(key);
+        auto last = (first != end() && !_comp(key, first->first)) ? std::next(first) : first;
+        return {first, last};
+    }
+
+    /**
+     * @brief
+     * Check if two maps hold equal elements.
+     *
+     * @return  Whether or not the maps are equal.
+     */
+    friend bool operator==(const flat_map& a, const flat_map& b)
+    {
+        return std::ranges::equal(a._c.keys, b._c.keys) && std::ranges::equal(a._c.values, b._c.values);
+    }
+
+    /// @brief Swap two maps.
+    friend void swap(flat_map& a, flat_map& b) noexcept { a.swap(b); }
+
+  private:
+    containers _c;                          ///< @brief The keys and mapped values.
+    [[no_unique_address]] key_compare _comp; ///< @brief The key comparison functor.
+
+    /**
+     * @brief
+     * Find the position of the first key not ordered before a key.
+     *
+     * @param key   The key.
+     *
+     * @return  Iterator into the key container.
+     */
+    template <typename K>
+    typename key_container_type::const_iterator key_lower_bound(const K& key) const
+    {
+        return std::lower_bound(_c.keys.cbegin(), _c.keys.cend(), key, _comp);
+    }
+
+    /// @brief Restore the invariants after the containers have been filled in arbitrary order.
+    void sort_unique()
+    {
+        auto order = details::sorted_unique_permutation(_c.keys, _comp);
+        try {
+            details::apply_permutation(_c.keys, order);
+            details::apply_permutation(_c.values, order);
+        } catch (...) {
+            clear();
+            throw;
+        }
+    }
+};
+
+/**
+ * @brief
+ * Erase all elements satisfying a predicate.
+ *
+ * @param c     The map.
+ * @param pred  The predicate, taking a `const_reference`.
+ *
+ * @return  Number of elements erased.
+ */
+template <typename Key, typename T, typename Compare, typename KeyContainer, typename MappedContainer,
+          typename Pred>
+std::size_t erase_if(flat_map<Key, T, Compare, KeyContainer, MappedContainer>& c, Pred pred)
+{
+    auto containers = std::move(c).extract();
+    std::size_t kept = 0;
+    for (std::size_t i = 0; i < containers.keys.size(); ++i) {
+        if (!pred(std::pair<const Key&, const T&>{containers.keys[i], containers.values[i]})) {
+            if (kept != i) {
+                containers.keys[kept] = std::move(containers.keys[i]);
+                containers.values[kept] = std::move(containers.values[i]);
+            }
+            ++kept;
+        }
+    }
+    auto erased = containers.keys.size() - kept;
+    containers.keys.erase(containers.keys.begin() + kept, containers.keys.end());
+    containers.values.erase(containers.values.begin() + kept, containers.values.end());
+    c.replace(std::move(containers.keys), std::move(containers.values));
+    return erased;
+}
+
+} // namespace ec
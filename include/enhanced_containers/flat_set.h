@@ -0,0 +1,477 @@
+/**
+ * @file
+ * Sorted associative container adapter over a random access container.
+ *
+ * @copyright 2023 Steve Kinneberg <steve.kinneberg@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <enhanced_containers/flat_map.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace ec {
+
+/**
+ * @brief
+ * Associative container of unique keys kept in sorted order in a random access container,
+ * compatible with C++23 `std::flat_set`.
+ *
+ * Lookups are binary searches over contiguous keys and the whole set occupies a single allocation.
+ * Insertion and erasure are linear in the size of the set, so this is best for sets that are
+ * built once and then mostly read.
+ *
+ * Iterators and references are invalidated by any insertion or erasure.
+ *
+ * @tparam Key          The key type.
+ * @tparam Compare      The comparison functor type.
+ * @tparam KeyContainer The container holding the keys.
+ */
+template <typename Key, typename Compare = std::less<Key>, typename KeyContainer = std::vector<Key>>
+class flat_set {
+  public:
+    /// @brief Type alias for the key type.
+    using key_type = Key;
+    /// @brief Type alias for the element type.
+    using value_type = Key;
+    /// @brief Type alias for the comparison functor type.
+    using key_compare = Compare;
+    /// @brief Type alias for the element comparison functor type.
+    using value_compare = Compare;
+    /// @brief Type alias for a reference to an element.
+    using reference = value_type&;
+    /// @brief Type alias for a constant reference to an element.
+    using const_reference = const value_type&;
+    /// @brief Type alias for the type representing the size of the set.
+    using size_type = std::size_t;
+    /// @brief Type alias for the type representing the distance between iterators.
+    using difference_type = std::ptrdiff_t;
+    /// @brief Type alias for the container holding the keys.
+    using container_type = KeyContainer;
+    /// @brief Iterator type.  Keys cannot be modified in place.
+    using iterator = typename KeyContainer::const_iterator;
+    /// @brief Constant iterator type.
+    using const_iterator = typename KeyContainer::const_iterator;
+    /// @brief Reverse iterator type.
+    using reverse_iterator = std::reverse_iterator<iterator>;
+    /// @brief Constant reverse iterator type.
+    using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+    /// @brief Default constructor.
+    flat_set(): flat_set(key_compare{}) {}
+
+    /**
+     * @brief
+     * Construct an empty set with a comparison functor.
+     *
+     * @param comp  The comparison functor.
+     */
+    explicit flat_set(const key_compare& comp):
+        _comp{comp}
+    {}
+
+    /**
+     * @brief
+     * Construct from a container which is sorted and made unique.
+     *
+     * @param keys  The keys.
+     * @param comp  The comparison functor.
+     */
+    explicit flat_set(container_type keys, const key_compare& comp = key_compare{}):
+        _keys{std::move(keys)},
+        _comp{comp}
+    {
+        sort_unique();
+    }
+
+    /**
+     * @brief
+     * Construct from a container that is already sorted and unique.
+     *
+     * @param keys  The sorted, unique keys.
+     * @param comp  The comparison functor.
+     */
+    flat_set(sorted_unique_t, container_type keys, const key_compare& comp = key_compare{}):
+        _keys{std::move(keys)},
+        _comp{comp}
+    {}
+
+    /**
+     * @brief
+     * Construct from a range of keys.
+     *
+     * @param first     Start of the range.
+     * @param last      End of the range.
+     * @param comp      The comparison functor.
+     */
+    template <typename InputIt>
+    flat_set(InputIt first, InputIt last, const key_compare& comp = key_compare{}):
+        _comp{comp}
+    {
+        insert(first, last);
+    }
+
+    /**
+     * @brief
+     * Construct from a list of keys.
+     *
+     * @param init  The keys.
+     * @param comp  The comparison functor.
+     */
+    flat_set(std::initializer_list<value_type> init, const key_compare& comp = key_compare{}):
+        flat_set(init.begin(), init.end(), comp)
+    {}
+
+    /// @brief Get an iterator to the first element.
+    const_iterator begin() const noexcept { return _keys.cbegin(); }
+    /// @brief Get an iterator past the last element.
+    const_iterator end() const noexcept { return _keys.cend(); }
+    /// @brief Get an iterator to the first element.
+    const_iterator cbegin() const noexcept { return _keys.cbegin(); }
+    /// @brief Get an iterator past the last element.
+    const_iterator cend() const noexcept { return _keys.cend(); }
+    /// @brief Get a reverse iterator to the last element.
+    const_reverse_iterator rbegin() const noexcept { return const_reverse_iterator{end()}; }
+    /// @brief Get a reverse iterator before the first element.
+    const_reverse_iterator rend() const noexcept { return const_reverse_iterator{begin()}; }
+
+    /// @brief Check if the set is empty.
+    EC_NODISCARD bool empty() const noexcept { return _keys.empty(); }
+    /// @brief Get the number of elements.
+    size_type size() const noexcept { return _keys.size(); }
+    /// @brief Get the maximum number of elements.
+    size_type max_size() const noexcept { return _keys.max_size(); }
+
+    /**
+     * @brief
+     * Insert a key constructed in place if it is not present.
+     *
+     * @param args  Arguments to construct the key from.
+     *
+     * @return  Iterator to the key and whether or not it was inserted.
+     */
+    template <typename... Args>
+    std::pair<iterator, bool> emplace(Args&&... args)
+    {
+        return insert(value_type(std::forward<Args>(args)...));
+    }
+
+    /**
+     * @brief
+     * Insert a key constructed in place if it is not present.  The hint is ignored.
+     *
+     * @param args  Arguments to construct the key from.
+     *
+     * @return  Iterator to the key.
+     */
+    template <typename... Args>
+    iterator emplace_hint(const_iterator, Args&&... args)
+    {
+        return emplace(std::forward<Args>(args)...).first;
+    }
+
+    /**
+     * @brief
+     * Insert a key if it is not present.
+     *
+     * @param key   The key.
+     *
+     * @return  Iterator to the key and whether or not it was inserted.
+     */
+    std::pair<iterator, bool> insert(const value_type& key) { return insert_unique(key); }
+
+    /// @copydoc insert(const value_type&)
+    std::pair<iterator, bool> insert(value_type&& key) { return insert_unique(std::move(key)); }
+
+    /**
+     * @brief
+     * Insert a key if it is not present.  The hint is ignored.
+     *
+     * @param key   The key.
+     *
+     * @return  Iterator to the key.
+     */
+    iterator insert(const_iterator, const value_type& key) { return insert(key).first; }
+
+    /// @copydoc insert(const_iterator, const value_type&)
+    iterator insert(const_iterator, value_type&& key) { return insert(std::move(key)).first; }
+
+    /**
+     * @brief
+     * Insert a range of keys that are not present.
+     *
+     * The keys are appended and then everything is sorted once.
+     *
+     * @param first     Start of the range.
+     * @param last      End of the range.
+     */
+    template <typename InputIt>
+    void insert(InputIt first, InputIt last)
+    {
+        auto old_size = size();
+        try {
+            _keys.insert(_keys.end(), first, last);
+        } catch (...) {
+            _keys.erase(_keys.begin() + old_size, _keys.end());
+            throw;
+        }
+        sort_unique();
+    }
+
+    /**
+     * @brief
+     * Insert a list of keys that are not present.
+     *
+     * @param init  The keys.
+     */
+    void insert(std::initializer_list<value_type> init) { insert(init.begin(), init.end()); }
+
+    /**
+     * @brief
+     * Move the underlying container out of the set, leaving it empty.
+     *
+     * @return  The container.
+     */
+    container_type extract() &&
+    {
+        container_type result{std::move(_keys)};
+        clear();
+        return result;
+    }
+
+    /**
+     * @brief
+     * Replace the underlying container.
+     *
+     * @param keys  The sorted, unique keys.
+     */
+    void replace(container_type&& keys) { _keys = std::move(keys); }
+
+    /**
+     * @brief
+     * Erase an element.
+     *
+     * @param pos   Iterator to the element.
+     *
+     * @return  Iterator to the element after the erased one.
+     */
+    iterator erase(const_iterator pos) { return _keys.erase(pos); }
+
+    /**
+     * @brief
+     * Erase a range of elements.
+     *
+     * @param first     Start of the range.
+     * @param last      End of the range.
+     *
+     * @return  Iterator to the element after the erased ones.
+     */
+    iterator erase(const_iterator first, const_iterator last) { return _keys.erase(first, last); }
+
+    /**
+     * @brief
+     * Erase a key.
+     *
+     * @param key   The key.
+     *
+     * @return  Number of elements erased.
+     */
+    size_type erase(const key_type& key)
+    {
+        auto it = find(key);
+        if (it == end()) {
+            return 0;
+        }
+        erase(it);
+        return 1;
+    }
+
+    /**
+     * @brief
+     * Swap the contents with another set.
+     *
+     * @param other     The set to swap with.
+     */
+    void swap(flat_set& other) noexcept
+    {
+        using std::swap;
+        swap(_keys, other._keys);
+        swap(_comp, other._comp);
+    }
+
+    /// @brief Erase all elements.
+    void clear() noexcept { _keys.clear(); }
+
+    /// @brief Get the key comparison functor.
+    key_compare key_comp() const { return _comp; }
+    /// @brief Get the element comparison functor.
+    value_compare value_comp() const { return _comp; }
+
+    /**
+     * @brief
+     * Find a key.
+     *
+     * @param key   The key.
+     *
+     * @return  Iterator to the key or `end()`.
+     */
+    template <typename K = key_type>
+        requires std::is_same_v<K, key_type> || requires { typename Compare::is_transparent; }
+    const_iterator find(const K& key) const
+    {
+        auto it = lower_bound(key);
+        return (it != end() && !_comp(key, *it)) ? it : end();
+    }
+
+    /**
+     * @brief
+     * Count the elements equivalent to a key.
+     *
+     * @param key   The key.
+     *
+     * @return  1 if the key is present, otherwise 0.
+     */
+    template <typename K = key_type>
+        requires std::is_same_v<K, key_type> || requires { typename Compare::is_transparent; }
+    size_type count(const K& key) const { return contains(key) ? 1 : 0; }
+
+    /**
+     * @brief
+     * Check if a key is present.
+     *
+     * @param key   The key.
+     *
+     * @return  Whether or not the key is present.
+     */
+    template <typename K = key_type>
+        requires std::is_same_v<K, key_type> || requires { typename Compare::is_transparent; }
+    bool contains(const K& key) const { return find(key) != end(); }
+
+    /**
+     * @brief
+     * Find the first element not ordered before a key.
+     *
+     * @param key   The key.
+     *
+     * @return  Iterator to the element or `end()`.
+     */
+    template <typename K = key_type>
+        requires std::is_same_v<K, key_type> || requires { typename Compare::is_transparent; }
+    const_iterator lower_bound(const K& key) const { return std::lower_bound(begin(), end(), key, _comp); }
+
+    /**
+     * @brief
+     * Find the first element ordered after a key.
+     *
+     * @param key   The key.
+     *
+     * @return  Iterator to the element or `end()`.
+     */
+    template <typename K = key_type>
+        requires std::is_same_v<K, key_type> || requires { typename Compare::is_transparent; }
+    const_iterator upper_bound(const K& key) const { return std::upper_bound(begin(), end(), key, _comp); }
+
+    /**
+     * @brief
+     * Find the range of elements equivalent to a key.
+     *
+     * @param key   The key.
+     *
+     * @return  The range, which holds at most one element.
+     */
+    template <typename K = key_type>
+        requires std::is_same_v<K, key_type> || requires { typename Compare::is_transparent; }
+    std::pair<const_iterator, const_iterator> equal_range(const K& key) const
+    {
+        auto first = lower_bound(key);
+        auto last = (first != end() && !_comp(key, *first)) ? std::next(first) : first;
+        return {first, last};
+    }
+
+    /**
+     * @brief
+     * Check if two sets hold equal keys.
+     *
+     * @return  Whether or not the sets are equal.
+     */
+    friend bool operator==(const flat_set& a, const flat_set& b) { return std::ranges::equal(a._keys, b._keys); }
+
+    /// @brief Swap two sets.
+    friend void swap(flat_set& a, flat_set& b) noexcept { a.swap(b); }
+
+  private:
+    container_type _keys;                       ///< @brief The sorted keys.
+    [[no_unique_address]] key_compare _comp;    ///< @brief The key comparison functor.
+
+    /**
+     * @brief
+     * Insert a key if it is not present.
+     *
+     * @param key   The key.
+     *
+     * @return  Iterator to the key and whether or not it was inserted.
+     */
+    template <typename K>
+    std::pair<iterator, bool> insert_unique(K&& key)
+    {
+        auto pos = lower_bound(key);
+        if (pos != end() && !_comp(key, *pos)) {
+            return {pos, false};
+        }
+        return {_keys.insert(pos, std::forward<K>(key)), true};
+    }
+
+    /// @brief Restore the invariants after the container has been filled in arbitrary order.
+    void sort_unique()
+    {
+        auto order = details::sorted_unique_permutation(_keys, _comp);
+        try {
+            details::apply_permutation(_keys, order);
+        } catch (...) {
+            clear();
+            throw;
+        }
+    }
+};
+
+/**
+ * @brief
+ * Erase all elements satisfying a predicate.
+ *
+ * @param c     The set.
+ * @param pred  The predicate.
+ *
+ * @return  Number of elements erased.
+ */
+template <typename Key, typename Compare, typename KeyContainer, typename Pred>
+std::size_t erase_if(flat_set<Key, Compare, KeyContainer>& c, Pred pred)
+{
+    auto keys = std::move(c).extract();
+    auto it = std::remove_if(keys.begin(), keys.end(), [&pred](const Key& k) { return pred(k); });
+    auto erased = static_cast<std::size_t>(keys.end() - it);
+    keys.erase(it, keys.end());
+    c.replace(std::move(keys));
+    return erased;
+}
+
+} // namespace ec
@@ -0,0 +1,238 @@
+/**
+ * @file
+ * Allocator that places every allocation flush against an inaccessible guard page.
+ *
+ * @copyright 2023 Steve Kinneberg <steve.kinneberg@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <enhanced_containers/details/common.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <vector>
+
+namespace ec {
+
+/**
+ * @brief
+ * Process wide heap that places every allocation so that it ends exactly where an inaccessible
+ * (`PROT_NONE`) guard page begins.
+ *
+ * Reading or writing even one byte past the end of an allocation faults immediately instead of
+ * silently touching a neighbor.  Optionally, a canary is placed right before the start of each
+ * allocation and verified on deallocation to catch underruns.  A corrupted canary aborts the
+ * process since the heap can no longer be trusted.
+ *
+ * To keep the cost per allocation down, the heap reserves large inaccessible regions up front and
+ * carves slots of data pages out of them, leaving one inaccessible page between neighboring
+ * slots.  Allocating a slot just makes its data pages accessible and deallocating it makes them
+ * inaccessible again, dropping their contents, so each costs a single OS call.  Freed slots are
+ * kept per page count and reused.  Allocations larger than `max_slot_size` get a dedicated mapping with a guard page on
+ * either side that is returned to the OS on deallocation.
+ *
+ * The heap does not lock or wipe memory.  Layer it under `ec::serialized_secure_allocator<>` for
+ * that.  It is thread safe.
+ */
+class guarded_heap {
+  public:
+    /// @brief Number of bytes of the canary placed before each allocation.
+    static constexpr std::size_t canary_size{16};
+    /// @brief Number of bytes reserved at once for carving slots.
+    static constexpr std::size_t region_size{64 * 1024 * 1024};
+    /// @brief Largest slot carved from a region.  Larger requests get a dedicated mapping.
+    static constexpr std::size_t max_slot_size{256 * 1024};
+
+    /**
+     * @brief
+     * Get the heap singleton.
+     *
+     * @return  Reference to the heap.
+     */
+    static guarded_heap& get_instance();
+
+    /// @brief Copying is not allowed.
+    guarded_heap(const guarded_heap&) = delete;
+    /// @brief Copying is not allowed.
+    guarded_heap& operator=(const guarded_heap&) = delete;
+
+    /**
+     * @brief
+     * Allocate memory that ends flush against a guard page.
+     *
+     * @param len       Number of bytes to allocate.
+     * @param alignment Required alignment.  Must be a power of two no larger than a page.
+     * @param canary    Whether or not to place a canary before the allocation.
+     *
+     * @return  Address of the allocated memory.
+     */
+    void* allocate(std::size_t len, std::size_t alignment, bool canary);
+
+    /**
+     * @brief
+     * Deallocate memory, verifying its canary first.
+     *
+     * @param ptr       Address of the memory to be deallocated.
+     * @param len       Number of bytes that were requested when the memory was allocated.
+     * @param alignment Alignment that was requested when the memory was allocated.
+     * @param canary    Whether or not a canary was placed when the memory was allocated.
+     */
+    void deallocate(void* ptr, std::size_t len, std::size_t alignment, bool canary);
+
+  private:
+    /// @brief Mutex to protect the regions and the free slots.
+    std::mutex _mutex;
+
+    /// @brief Next unused page of the current region.
+    std::byte* _next{};
+
+    /// @brief End of the current region.
+    std::byte* _end{};
+
+    /// @brief Freed slots indexed by their number of data pages.
+    std::vector<std::vector<std::byte*>> _free_slots;
+
+    /// @brief Secret mixed into every canary so that they cannot be predicted.
+    const std::uint64_t _canary_secret;
+
+    /// @brief Page size of the system.
+    const std::size_t _page_size;
+
+    /// @brief Constructor - made private to prevent accidental instantiation by others.
+    guarded_heap();
+
+    /**
+     * @brief
+     * Get a slot of inaccessible data pages followed by a guard page.
+     *
+     * @param pages     Number of data pages needed.
+     *
+     * @return  Start of the slot's data pages.
+     */
+    std::byte* take_slot(std::size_t pages);
+
+    /**
+     * @brief
+     * Compute the canary for an allocation.
+     *
+     * @param ptr   Address of the allocation.
+     *
+     * @return  The value expected in each word of the canary.
+     */
+    std::uint64_t canary_value(const void* ptr) const noexcept;
+};
+
+/**
+ * @brief
+ * This is a C++ STL compatible allocator that allocates from the `ec::guarded_heap`, so that
+ * buffer overruns fault rather than leak into neighboring memory.
+ *
+ * It is meant for small amounts of key material since every allocation costs at least one page.
+ * Use it as the upstream allocator of the secure allocators to also lock and wipe the memory:
+ *
+ * @code
+ * ec::serialized_secure::vector<std::uint8_t, ec::guarded_allocator<std::uint8_t>> key(32);
+ * key[32] = 0;     // Segmentation fault rather than silent corruption.
+ * @endcode
+ *
+ * @tparam T        The type being allocated.
+ * @tparam Canaries Whether or not to check for underruns with a canary on deallocation.
+ */
+template <typename T, bool Canaries = true>
+struct guarded_allocator {
+    /// @brief Type alias for the type being allocated.
+    using value_type = T;
+    /// @brief Type alias for the type representing the size of allocations.
+    using size_type = std::size_t;
+    /// @brief Type alias for the type representing the distance between pointers.
+    using difference_type = std::ptrdiff_t;
+    /// @brief Compile-time indication about how to handle the allocator when moving containers.
+    using propagate_on_container_move_assignment = std::true_type;
+    /**
+     * @brief Compile-time indication about how whether different instances of the allocator are
+     * considered the same or not.
+     */
+    using is_always_equal = std::true_type;
+    /**
+     * @brief Freed slots must be closed right away, so the no swap allocators never park blocks from
+     * this allocator for reuse.
+     */
+    using parks_released_blocks = std::false_type;
+
+    /**
+     * @internal @brief
+     * Define the rebind struct so that std::allocator_traits keeps the canary setting.
+     */
+    template <typename U>
+    struct rebind {
+        /// @brief The rebound allocator type.
+        using other = guarded_allocator<U, Canaries>;
+    };
+
+    /// @brief Default constructor.
+    guarded_allocator() = default;
+
+    /**
+     * @brief
+     * Constructor to copy from an alternate allocation type.
+     *
+     * @tparam U    The alternate type for the allocator being copied from.
+     */
+    template <typename U>
+    guarded_allocator(const guarded_allocator<U, Canaries>&) noexcept
+    {}
+
+    /**
+     * @brief
+     * Allocate the requested amount of memory.
+     *
+     * @param len   Number of type T to allocate.
+     *
+     * @return  Address of the allocated memory.
+     */
+    EC_NODISCARD
+    T* allocate(std::size_t len)
+    {
+        static_assert(alignof(T) <= 4096, "guarded_allocator does not support page aligned types");
+        return static_cast<T*>(guarded_heap::get_instance().allocate(len * sizeof(T), alignof(T), Canaries));
+    }
+
+    /**
+     * @brief
+     * Deallocate a block of memory.
+     *
+     * @param ptr   Address of the memory to be deallcoated.
+     * @param len   Number of type T to deallocate.
+     */
+    void deallocate(T* ptr, std::size_t len)
+    {
+        guarded_heap::get_instance().deallocate(ptr, len * sizeof(T), alignof(T), Canaries);
+    }
+
+    /**
+     * @brief
+     * All guarded allocators share the same heap so they are always equal.
+     *
+     * @return  Always true.
+     */
+    template <typename U>
+    bool operator==(const guarded_allocator<U, Canaries>&) const noexcept { return true; }
+};
+
+} // namespace ec
@@ -0,0 +1,427 @@
+/**
+ * @file
+ * Pool of memory that is locked to RAM up front and a C++ allocator usable by STL containers that
+ * allocates from it.
+ *
+ * @copyright 2023 Steve Kinneberg <steve.kinneberg@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <enhanced_containers/details/common.h>
+#include <enhanced_containers/no_swap_allocator.h>
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+
+namespace ec {
+
+/**
+ * @brief
+ * Snapshot of the memory usage of the `ec::locked_pool`.
+ *
+ * The `locked_bytes_high_water_mark` is the figure to use when sizing `RLIMIT_MEMLOCK`.
+ */
+struct locked_pool_statistics {
+    std::size_t locked_bytes;                   ///< @brief Bytes currently locked by the pool.
+    std::size_t locked_bytes_high_water_mark;   ///< @brief Most bytes ever locked by the pool.
+    std::size_t in_use_bytes;                   ///< @brief Bytes currently handed out.
+    std::size_t in_use_bytes_high_water_mark;   ///< @brief Most bytes ever handed out at once.
+};
+
+/**
+ * @brief
+ * How the `ec::locked_pool` obtains memory that cannot be swapped out.
+ */
+enum class locked_pool_backend {
+    mlock,          ///< @brief Anonymous memory that is locked with a separate call after mapping.
+    map_locked,     ///< @brief Anonymous memory mapped with `MAP_LOCKED` (Linux).
+    memfd_secret,   ///< @brief `memfd_secret()` memory, also removed from the kernel direct map (Linux 5.14+).
+};
+
+/**
+ * @brief
+ * Process wide pool of memory that is locked to RAM when it is obtained from the OS rather than
+ * on every allocation.
+ *
+ * Memory is mapped from the OS in `chunk_size` chunks which are locked with a single call each.
+ * Chunks are cut into slabs, and slabs into blocks of power-of-two size classes between
+ * `min_block_size` and `max_block_size` bytes.  Freed blocks go on a per size class free list and
+ * are reused, so once the pool has warmed up allocating and deallocating small and medium sized
+ * blocks makes no system calls at all.  Chunks are never returned to the OS.
+ *
+ * Requests larger than `max_block_size` get a dedicated mapping that is locked on allocation and
+ * unmapped on deallocation.  On Linux, when the library is built with `ENABLE_HUGE_PAGES`,
+ * dedicated mappings of at least `huge_page_size()` bytes are backed by huge pages to cut TLB
+ * misses on large buffers: reserved hugetlbfs pages if there are enough of them and the length is
+ * a whole number of huge pages, otherwise transparent huge pages on a huge page aligned mapping.
+ * `memfd_secret()` memory cannot use huge pages and takes precedence.
+ *
+ * On Linux the memory is preferably obtained already unswappable: from `memfd_secret()` when the
+ * library is built with `ENABLE_MEMFD_SECRET` and the kernel supports it, otherwise by mapping it
+ * with `MAP_LOCKED`.  Only if neither is available is it mapped normally and locked afterwards.
+ * The choice is made at run-time, falling back when a mechanism turns out to be unavailable.
+ *
+ * The chunks are registered with the no swap allocator state as a permanent reference, so it is
+ * safe to layer one of the no swap allocators on top of the pool.
+ *
+ * The pool is thread safe.  Each size class has its own mutex.  On top of that, every thread keeps
+ * a small magazine of free blocks for each size class up to `max_cached_block_size` bytes.  Those
+ * allocations and deallocations touch only the calling thread's magazine, so the common case takes
+ * no locks and makes no system calls.  Magazines are refilled from and returned to the shared size
+ * classes in batches of `magazine_batch` blocks.  When a thread exits, its magazines are returned to
+ * the shared size classes, and blocks it still owns may be deallocated by any other thread.
+ */
+class locked_pool {
+  public:
+    /// @brief Smallest block handed out.
+    static constexpr std::size_t min_block_size{16};
+    /// @brief Largest block served from a size class.  Larger requests get a dedicated mapping.
+    static constexpr std::size_t max_block_size{256 * 1024};
+    /// @brief Size of the slabs carved from a chunk for a size class.
+    static constexpr std::size_t slab_size{64 * 1024};
+    /// @brief Size of the chunks mapped and locked from the OS.
+    static constexpr std::size_t chunk_size{1024 * 1024};
+    /// @brief Largest block cached per thread.
+    static constexpr std::size_t max_cached_block_size{1024};
+    /// @brief Number of blocks moved between a thread's magazine and the shared size class at once.
+    static constexpr std::size_t magazine_batch{16};
+
+    /**
+     * @brief
+     * Get the pool singleton object.
+     *
+     * The pool is intentionally never destroyed so that it outlives any global (static) scope
+     * containers that use it.
+     *
+     * @return  The pool singleton object.
+     */
+    static locked_pool& get_instance();
+
+    /**
+     * @brief
+     * Allocate a block of locked memory.
+     *
+     * @param len   Number of bytes to allocate.
+     *
+     * @return  Address of the allocated memory.
+     */
+    EC_NODISCARD
+    void* allocate(std::size_t len);
+
+    /**
+     * @brief
+     * Return a block of memory to the pool.
+     *
+     * @param ptr   Address of the memory to be deallocated.
+     * @param len   Number of bytes that were requested when the memory was allocated.
+     */
+    void deallocate(void* ptr, std::size_t len);
+
+    /**
+     * @brief
+     * Get the number of bytes actually reserved for a request of a given size.
+     *
+     * @param len   Number of bytes requested.
+     *
+     * @return  Number of usable bytes in the block that would be handed out.
+     */
+    std::size_t block_size(std::size_t len) const noexcept;
+
+    /**
+     * @brief
+     * Get the current memory usage of the pool.
+     *
+     * Blocks sitting in per-thread magazines are counted as in use.
+     *
+     * @return  Snapshot of the memory usage of the pool.
+     */
+    locked_pool_statistics statistics() const noexcept;
+
+    /**
+     * @brief
+     * Get the mechanism currently used to obtain memory from the OS.
+     *
+     * @return  The backend in use.
+     */
+    locked_pool_backend backend() const noexcept { return _backend.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief
+     * Get the size of the huge pages used for large dedicated mappings.
+     *
+     * @return  Number of bytes in a huge page, or 0 if huge pages are not used.
+     */
+    std::size_t huge_page_size() const noexcept { return _huge_page_size; }
+
+  private:
+    /// @brief Intrusive free list node stored in unused blocks.
+    struct free_block {
+        free_block* next;   ///< @brief Next free block in the size class.
+    };
+
+    /// @brief Free list and current slab of a single size class.
+    struct alignas(64) size_class {
+        std::mutex mutex;               ///< @brief Mutex to protect this size class.
+        free_block* free_list{};        ///< @brief Blocks that have been returned to the pool.
+        std::byte* slab_cursor{};       ///< @brief Next unused block in the current slab.
+        std::byte* slab_end{};          ///< @brief End of the current slab.
+    };
+
+    /// @brief Number of size classes.
+    static constexpr std::size_t size_class_count{std::countr_zero(max_block_size) -
+                                                  std::countr_zero(min_block_size) + 1};
+    /// @brief Number of size classes cached per thread.
+    static constexpr std::size_t cached_class_count{std::countr_zero(max_cached_block_size) -
+                                                    std::countr_zero(min_block_size) + 1};
+    /// @brief Most blocks a magazine holds before half of them are returned.
+    static constexpr std::size_t magazine_capacity{magazine_batch * 2};
+
+    /// @brief Free blocks of a single size class owned by one thread.
+    struct magazine {
+        free_block* head;       ///< @brief First free block.
+        std::size_t count;      ///< @brief Number of free blocks.
+    };
+
+    /// @brief Per thread magazines.  Defined in the implementation.
+    struct thread_cache;
+
+    /// @brief The size classes, indexed by log2(block size / min_block_size).
+    std::array<size_class, size_class_count> _size_classes;
+
+    /// @brief Mutex to protect the current chunk.
+    std::mutex _chunk_mutex;
+    std::byte* _chunk_cursor{};     ///< @brief Next unused slab in the current chunk.
+    std::byte* _chunk_end{};        ///< @brief End of the current chunk.
+
+    std::atomic<std::size_t> _locked_bytes{};               ///< @brief Bytes currently locked.
+    std::atomic<std::size_t> _locked_bytes_high_water{};    ///< @brief Most bytes ever locked.
+    std::atomic<std::size_t> _in_use_bytes{};               ///< @brief Bytes currently handed out.
+    std::atomic<std::size_t> _in_use_bytes_high_water{};    ///< @brief Most bytes ever handed out.
+
+    /// @brief The best mechanism for obtaining memory that has not failed yet.
+    std::atomic<locked_pool_backend> _backend;
+
+    /// @brief Page size of the system.
+    const std::size_t _page_size;
+
+    /// @brief Huge page size of the system, or 0 if huge pages are not used.
+    const std::size_t _huge_page_size;
+
+    /// @brief Constructor - made private to prevent accidental instantiation by others.
+    locked_pool();
+
+    /**
+     * @brief
+     * Get the index of the size class serving a request.
+     *
+     * @param len   Number of bytes requested.  Must not exceed `max_block_size`.
+     *
+     * @return  Index into `_size_classes`.
+     */
+    static std::size_t size_class_index(std::size_t len) noexcept;
+
+    /**
+     * @brief
+     * Get the calling thread's magazines.
+     *
+     * @return  The magazines, or `nullptr` if the thread is exiting and has already returned them.
+     */
+    static thread_cache* local_cache() noexcept;
+
+    /**
+     * @brief
+     * Take a block from a size class.
+     *
+     * @param sc            The size class.  Its mutex must be held.
+     * @param block_size    The block size of the size class.
+     *
+     * @return  Address of the block.
+     */
+    void* take_block(size_class& sc, std::size_t block_size);
+
+    /**
+     * @brief
+     * Move a batch of blocks from the shared size class into an empty magazine.
+     *
+     * @param index     Index of the size class.
+     * @param mag       The magazine to fill.
+     */
+    void refill_magazine(std::size_t index, magazine& mag);
+
+    /**
+     * @brief
+     * Return blocks from a magazine to the shared size class.
+     *
+     * @param index     Index of the size class.
+     * @param mag       The magazine to drain.
+     * @param count     Number of blocks to return.
+     */
+    void drain_magazine(std::size_t index, magazine& mag, std::size_t count) noexcept;
+
+    /**
+     * @brief
+     * Carve a new slab for a size class out of the current chunk, mapping a new chunk if needed.
+     *
+     * @param sc            The size class that needs a slab.  Its mutex must be held.
+     * @param block_size    The block size of the size class.
+     */
+    void refill(size_class& sc, std::size_t block_size);
+
+    /**
+     * @brief
+     * Map and lock a region of memory from the OS.
+     *
+     * @param len   Number of bytes to map.  Must be a multiple of the page size.
+     *
+     * @return  Address of the mapped memory.
+     */
+    void* map_locked(std::size_t len);
+
+    /**
+     * @brief
+     * Unlock and unmap a region of memory previously obtained from `map_locked()`.
+     *
+     * @param ptr   Address of the mapped memory.
+     * @param len   Number of bytes mapped.
+     */
+    void unmap_locked(void* ptr, std::size_t len);
+
+    /**
+     * @brief
+     * Adjust a usage counter and its high water mark.
+     *
+     * @param counter       The counter to adjust.
+     * @param high_water    The high water mark of the counter.
+     * @param len           Number of bytes to add.
+     */
+    static void add_usage(std::atomic<std::size_t>& counter, std::atomic<std::size_t>& high_water,
+                          std::size_t len) noexcept;
+};
+
+/**
+ * @brief
+ * This is a C++ STL compatible allocator that allocates memory from the `ec::locked_pool`.
+ *
+ * All memory handed out is already locked to RAM, so this does not need to track pages or make
+ * any system calls in the steady state.  It is safe to use in multi-threaded applications.
+ *
+ * @code
+ * if (condition) {
+ *     std::basic_string<char, std::char_traits<char>, ec::locked_pool_allocator<char>> password = read_from_console();
+ *     // password locked to RAM.
+ *     process_password(password);  // Takes a std::string_view.
+ *  }  // password destroyed - memory returned to the pool, still locked.
+ * @endcode
+ *
+ * Important note: Memory returned to the pool is not wiped.  Use `ec::pooled_secure_allocator<>`
+ *                 for that.
+ *
+ * @tparam T    The type being allocated.
+ */
+template <typename T>
+struct locked_pool_allocator {
+    /// @brief Type alias for the type being allocated.
+    using value_type = T;
+    /// @brief Type alias for the type representing the size of allocations.
+    using size_type = std::size_t;
+    /// @brief Type alias for the type representing the distance between pointers.
+    using difference_type = std::ptrdiff_t;
+    /// @brief Compile-time indication about how to handle the allocator when moving containers.
+    using propagate_on_container_move_assignment = std::true_type;
+    /**
+     * @brief Compile-time indication about how whether different instances of the allocator are
+     * considered the same or not.
+     */
+    using is_always_equal = std::true_type;
+
+    /// @brief Default constructor.
+    locked_pool_allocator() = default;
+
+    /**
+     * @brief
+     * Constructor to copy from an alternate allocation type.
+     *
+     * @tparam U    The alternate type for the allocator being copied from.
+     */
+    template <typename U>
+    locked_pool_allocator(const locked_pool_allocator<U>&) noexcept
+    {}
+
+    /**
+     * @brief
+     * Allocate the requested amount of memory.
+     *
+     * @param len   Number of type T to allocate.
+     *
+     * @return  Address of the allocated memory.
+     */
+    EC_NODISCARD
+    T* allocate(std::size_t len)
+    {
+        static_assert(alignof(T) <= locked_pool::min_block_size,
+                      "locked_pool_allocator does not support over-aligned types");
+        return static_cast<T*>(locked_pool::get_instance().allocate(len * sizeof(T)));
+    }
+
+#if defined(__cpp_lib_allocate_at_least)
+    /**
+     * @brief
+     * Allocate at least the requested amount of memory.
+     *
+     * The whole block of the size class serving the request is reported so that growing
+     * containers can use it before allocating again.
+     *
+     * @param len   Number of type T to allocate.
+     *
+     * @return  Address and number of type T of the allocated memory.
+     */
+    EC_NODISCARD
+    std::allocation_result<T*> allocate_at_least(std::size_t len)
+    {
+        auto& pool = locked_pool::get_instance();
+        auto size = pool.block_size(len * sizeof(T));
+        return {allocate(len), size / sizeof(T)};
+    }
+#endif
+
+    /**
+     * @brief
+     * Deallocate a block of memory.
+     *
+     * @param ptr   Address of the memory to be deallcoated.
+     * @param len   Number of type T to deallocate.
+     */
+    void deallocate(T* ptr, std::size_t len)
+    {
+        locked_pool::get_instance().deallocate(ptr, len * sizeof(T));
+    }
+
+    /**
+     * @brief
+     * All pool allocators share the same pool so they are always equal.
+     *
+     * @return  Always true.
+     */
+    template <typename U>
+    bool operator==(const locked_pool_allocator<U>&) const noexcept { return true; }
+};
+
+} // namespace ec
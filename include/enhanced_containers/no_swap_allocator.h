@@ -20,42 +20,163 @@
 
 #pragma once
 
+#include <enhanced_containers/details/allocate_batch.h>
 #include <enhanced_containers/details/common.h>
+#include <enhanced_containers/details/page_range_table.h>
+#include <enhanced_containers/details/page_refcount_table.h>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <bitset>
+#include <chrono>
+#include <cstdint>
 #include <memory>
 #include <mutex>
-#include <unordered_map>
+#include <type_traits>
+#include <utility>
 
 #if __cplusplus >= 201603L
 #include <memory_resource>
 #endif
 
 namespace ec {
+
+/**
+ * @brief
+ * Point in time view of the memory pinned by the no swap allocators, for metrics exporters.
+ *
+ * Each counter is read atomically, but not all of them at the same instant, so counters that are
+ * changing may be off by a few operations relative to each other.
+ */
+struct no_swap_allocator_stats {
+    std::uint64_t pinned_pages{};           ///< @brief Pages currently locked to RAM.
+    std::uint64_t pinned_bytes{};           ///< @brief Bytes currently locked to RAM (whole pages).
+    std::uint64_t pinned_bytes_limit{};     ///< @brief Most bytes the process may lock (`RLIMIT_MEMLOCK`), or the maximum value if unlimited.
+    std::uint64_t live_allocations{};       ///< @brief Allocations currently tracked.
+    std::uint64_t retained_pages{};         ///< @brief Pages kept locked for reuse after their last allocation was released (included in pinned_pages).
+    std::uint64_t pin_calls{};              ///< @brief OS calls made to lock memory.
+    std::uint64_t unpin_calls{};            ///< @brief OS calls made to unlock memory.
+    std::uint64_t pin_failures{};           ///< @brief OS calls to lock memory that failed.
+    std::uint64_t bytes_wiped{};            ///< @brief Bytes wiped by `ec::secure_zero()` process wide.
+    std::chrono::nanoseconds syscall_time{};    ///< @brief Time spent in the OS calls to lock and unlock memory.
+};
+
+/**
+ * @brief
+ * Policy for keeping pages locked after the last allocation using them is released.
+ *
+ * Containers that are created and destroyed in a loop keep allocating from the same few pages, and
+ * by default each iteration locks and unlocks those pages again.  With a nonzero byte budget, a
+ * released block is parked instead of being returned to the upstream allocator, and its pages that
+ * no other allocation uses are retained: they stay locked (the zero on release allocators have
+ * already wiped them).  The next allocation of the same size from the same kind of allocator gets
+ * the parked block back, which makes no OS call at all.  Retained pages are unlocked and parked
+ * blocks returned upstream all at once when the retained pages add up to more than `max_bytes`, or
+ * when pages have been retained for longer than `max_idle` without ever all being reused.  Both
+ * are checked when memory is released; `ec::release_retained_pages()` releases them at any other
+ * time.
+ *
+ * Since a parked block is still allocated from the upstream allocator, the upstream allocator
+ * cannot return its pages to the OS (e.g., glibc trimming the top of the heap) and later map fresh,
+ * unlocked pages at the same address.  Pages are only ever retained while a parked block covers
+ * them.  Parked blocks are returned from whichever thread releases them, so only blocks from
+ * stateless upstream allocators are parked (see `ec::details::can_park_blocks()`), and
+ * neither the batch deallocations nor `ec::pmr::no_swap_resource` park blocks.  No more than
+ * `max_bytes` bytes of blocks are parked at a time, and allocations spanning more than
+ * `max_allocation` bytes of pages are never parked, since malloc typically maps those on their own
+ * anyway.
+ */
+struct no_swap_retention_policy {
+    std::size_t max_bytes{};                    ///< @brief Most bytes of pages retained, or 0 to unlock pages right away (the default).
+    std::chrono::nanoseconds max_idle{std::chrono::milliseconds{100}};  ///< @brief Longest time pages are retained before being unlocked.
+    std::size_t max_allocation{64 * 1024};      ///< @brief Largest allocation, in bytes of whole pages, whose pages are retained.
+};
+
 namespace details {
+/**
+ * @internal @brief
+ * Check if the no swap allocators may park blocks released to them rather than returning them to an
+ * upstream allocator right away.
+ *
+ * Parked blocks are returned later from a default constructed upstream allocator, so by default
+ * only stateless allocators qualify.  An allocator overrides this by defining the member type
+ * `parks_released_blocks` as `std::true_type` or `std::false_type`, e.g., when it must get freed
+ * memory back right away.
+ *
+ * @tparam A    The upstream allocator type.
+ *
+ * @return  Whether blocks from `A` may be parked.
+ */
+template <typename A>
+constexpr bool can_park_blocks() noexcept
+{
+    if constexpr (requires { typename A::parks_released_blocks; }) {
+        return A::parks_released_blocks::value;
+    } else {
+        return std::allocator_traits<A>::is_always_equal::value && std::is_default_constructible_v<A>;
+    }
+}
+
 /**
  * @internal @brief
  * Tracks reference counts to memory pages allocated via one of the no swap allocators.
  *
  * This is implemented as a signleton so that we can ensure that it gets initialized in time for use
- * by global (static) scope containers.  Each instance of the no swap allocators will get a
- * std::shared_ptr<> to ensure that this state information remains vaild for the lifetime of all
- * containers that use any of the no swap allocators.
+ * by global (static) scope containers.  The singleton is created on first use in a thread safe
+ * manner and is intentionally never destroyed so that this state information remains valid for
+ * the lifetime of all containers that use any of the no swap allocators, including global (static)
+ * scope containers destroyed during program exit.
+ *
+ * The address space is divided into fixed size regions (`shard_region_size` bytes) and each region
+ * is hashed onto one of `shard_count` shards.  Every shard has its own page range table and its own
+ * mutex, so serialized allocations from threads that touch disjoint regions do not contend with
+ * each other.  The following guarantees hold across shards:
+ *
+ *   - Every page belongs to exactly one shard, so the decision to lock or unlock a page is always
+ *     made under that one shard's mutex.
+ *   - An allocation that spans several regions holds the mutexes of all shards involved for the
+ *     duration of the update.  They are always acquired in ascending shard order so concurrent
+ *     multi-shard updates cannot deadlock.
+ *   - Because all involved shards are held at once, contiguous runs of pages that cross region
+ *     boundaries are still locked or unlocked with a single OS call.
+ *   - If locking memory fails part way through, every shard is returned to the state it was in
+ *     before the call.
+ *
+ * The concurrent variants instead count references per page in a lock-free
+ * `ec::details::page_refcount_table`.  That table holds a single reference in the shards for every
+ * page it has referenced at all, so only the first and last concurrent reference to a page take
+ * the shard mutexes, and pages shared with the other allocators are still locked and unlocked
+ * correctly.
+ *
+ * Under a `ec::no_swap_retention_policy`, blocks released to the allocators may be parked, and
+ * pages that become unreferenced that way are retained instead of unlocked.  Each shard keeps its
+ * retained pages in a second page range table, and a retained page is never referenced at the same
+ * time.  Referencing a retained page moves it back out of that table without locking it again,
+ * which is safe since the parked blocks keep the retained pages mapped.
  */
 class no_swap_allocator_state {
   public:
     /**
      * @brief
-     * Get a shared pointer to the state singleton object.
+     * Get the state singleton object.
      *
-     * @return  A shared pointer to the state singleton object.
+     * Once the singleton has been created this is a single load of an initialization guard.
+     *
+     * @return  Reference to the state singleton object.
      */
-    static std::shared_ptr<no_swap_allocator_state> get_state_object();
+    static no_swap_allocator_state& get_state_object()
+    {
+        static no_swap_allocator_state* self{new no_swap_allocator_state{}};
+        return *self;
+    }
 
     /**
      * @brief
      * Record a new memory allocation.
      *
      * This will lock the referenced pages of memory so that the OS will not swap them out if the
-     * pages have not already be marked as such.
+     * pages have not already be marked as such.  Contiguous runs of newly referenced pages are
+     * locked with a single OS call per run rather than one call per page.
      *
      * @param ptr   Pointer to the newly allocated memory.
      * @param len   Number of bytes in the newly allocated memory.
@@ -67,7 +188,8 @@ class no_swap_allocator_state {
      * Process the deallocation of a memory region.
      *
      * This will unlock the referenced pages of memory so that the OS can swap them back out again
-     * if there are no other allocations using the referenced pages.
+     * if there are no other allocations using the referenced pages.  Contiguous runs of released
+     * pages are unlocked with a single OS call per run rather than one call per page.
      *
      * @param ptr   Pointer to the memory being deallocated.
      * @param len   Number of bytes in the memory being deallocated.
@@ -76,111 +198,1079 @@ class no_swap_allocator_state {
 
     /**
      * @brief
-     * Record a new memory allocation.
+     * Record a new memory allocation.
+     *
+     * This will lock the referenced pages of memory so that the OS will not swap them out if the
+     * pages have not already be marked as such.  Only the shards covering the allocation are
+     * locked while doing so.
+     *
+     * @param ptr   Pointer to the newly allocated memory.
+     * @param len   Number of bytes in the newly allocated memory.
+     */
+    void serialized_add_allocation(void* ptr, std::size_t len);
+
+    /**
+     * @brief
+     * Process the deallocation of a memory region.
+     *
+     * This will unlock the referenced pages of memory so that the OS can swap them back out again
+     * if there are no other allocations using the referenced pages.  Only the shards covering the
+     * allocation are locked while doing so.
+     *
+     * @param ptr   Pointer to the memory being deallocated.
+     * @param len   Number of bytes in the memory being deallocated.
+     */
+    void serialized_remove_allocation(void* ptr, std::size_t len);
+
+    /**
+     * @brief
+     * Record a batch of new memory allocations of the same length.
+     *
+     * Works like calling `serialized_add_allocation()` for each of them, except that the shard
+     * mutexes are acquired only once for the whole batch.  Either all allocations are recorded or
+     * none are.
+     *
+     * @tparam T    The type of the allocations.
+     *
+     * @param ptrs  Array of pointers to the newly allocated memory.
+     * @param n     Number of allocations.
+     * @param len   Number of bytes in each allocation.
+     */
+    template <typename T>
+    void serialized_add_allocations(T* const* ptrs, std::size_t n, std::size_t len);
+
+    /**
+     * @brief
+     * Process the deallocation of a batch of memory regions of the same length.
+     *
+     * Works like calling `serialized_remove_allocation()` for each of them, except that the shard
+     * mutexes are acquired only once for the whole batch.
+     *
+     * @tparam T    The type of the allocations.
+     *
+     * @param ptrs  Array of pointers to the memory being deallocated.
+     * @param n     Number of allocations.
+     * @param len   Number of bytes in each allocation.
+     */
+    template <typename T>
+    void serialized_remove_allocations(T* const* ptrs, std::size_t n, std::size_t len);
+
+    /**
+     * @brief
+     * Record a new memory allocation whose pages the caller has already locked by other means,
+     * e.g., by mapping them with `MAP_LOCKED`.
+     *
+     * No OS call is made here.  The pages are only tracked so that no swap allocations sharing
+     * them do not unlock them.  Deallocate with `serialized_release_mapping()` before unmapping them.
+     *
+     * @param ptr   Pointer to the newly allocated memory.
+     * @param len   Number of bytes in the newly allocated memory.
+     */
+    void serialized_adopt_allocation(void* ptr, std::size_t len);
+
+    /**
+     * @brief
+     * Process the deallocation of memory that the caller is about to return to the OS, e.g., with
+     * `munmap()`.
+     *
+     * Works like `serialized_remove_allocation()` except that the pages are never retained, since
+     * their lock would not outlive the mapping.
+     *
+     * @param ptr   Pointer to the memory being deallocated.
+     * @param len   Number of bytes in the memory being deallocated.
+     */
+    void serialized_release_mapping(void* ptr, std::size_t len);
+
+    /**
+     * @brief
+     * Record a new memory allocation without taking any mutex in the common case.
+     *
+     * Pages that are already referenced by another concurrent allocation only get their counters
+     * incremented.  Runs of newly referenced pages are added to the shards as with
+     * `serialized_add_allocation()`, which locks them if no other allocation already has.
+     *
+     * @param ptr   Pointer to the newly allocated memory.
+     * @param len   Number of bytes in the newly allocated memory.
+     */
+    void concurrent_add_allocation(void* ptr, std::size_t len);
+
+    /**
+     * @brief
+     * Process the deallocation of a memory region without taking any mutex in the common case.
+     *
+     * Pages still referenced by other concurrent allocations only get their counters decremented.
+     * Runs of pages that are no longer referenced are removed from the shards as with
+     * `serialized_remove_allocation()`, which unlocks them if no other allocation uses them.
+     *
+     * @param ptr   Pointer to the memory being deallocated.
+     * @param len   Number of bytes in the memory being deallocated.
+     */
+    void concurrent_remove_allocation(void* ptr, std::size_t len);
+
+    /**
+     * @brief
+     * Record a batch of new memory allocations of the same length.
+     *
+     * Works like calling `concurrent_add_allocation()` for each of them.  Either all allocations
+     * are recorded or none are.
+     *
+     * @tparam T    The type of the allocations.
+     *
+     * @param ptrs  Array of pointers to the newly allocated memory.
+     * @param n     Number of allocations.
+     * @param len   Number of bytes in each allocation.
+     */
+    template <typename T>
+    void concurrent_add_allocations(T* const* ptrs, std::size_t n, std::size_t len);
+
+    /**
+     * @brief
+     * Process the deallocation of a batch of memory regions of the same length.
+     *
+     * Works like calling `concurrent_remove_allocation()` for each of them.
+     *
+     * @tparam T    The type of the allocations.
+     *
+     * @param ptrs  Array of pointers to the memory being deallocated.
+     * @param n     Number of allocations.
+     * @param len   Number of bytes in each allocation.
+     */
+    template <typename T>
+    void concurrent_remove_allocations(T* const* ptrs, std::size_t n, std::size_t len)
+    {
+        for (std::size_t i = 0; i < n; ++i) {
+            concurrent_remove_allocation(ptrs[i], len);
+        }
+    }
+
+    /// @brief Function returning a parked block to the upstream allocator it came from.
+    using release_block_function = void (*)(void* ptr, std::size_t len);
+
+    /**
+     * @brief
+     * Park a block instead of deallocating it, if the retention policy allows.
+     *
+     * The block is removed as with `remove_allocation()`, except that pages that no other
+     * allocation uses are retained rather than unlocked.  When the block is parked, the caller must
+     * not return it to the upstream allocator.  It is returned with `release` once the retained
+     * pages are released, unless it is reused before that.
+     *
+     * @param ptr       Pointer to the memory being deallocated.
+     * @param len       Number of bytes in the memory being deallocated.
+     * @param release   Function returning the block to its upstream allocator.  Blocks are only
+     *                  reused by allocations passing the same function.
+     *
+     * @return  Whether the block was parked.
+     */
+    bool park_allocation(void* ptr, std::size_t len, release_block_function release);
+
+    /**
+     * @brief
+     * Park a block instead of deallocating it, if the retention policy allows.
+     *
+     * Works like `park_allocation()` except that the block is removed as with
+     * `serialized_remove_allocation()`.
+     *
+     * @param ptr       Pointer to the memory being deallocated.
+     * @param len       Number of bytes in the memory being deallocated.
+     * @param release   Function returning the block to its upstream allocator.
+     *
+     * @return  Whether the block was parked.
+     */
+    bool serialized_park_allocation(void* ptr, std::size_t len, release_block_function release);
+
+    /**
+     * @brief
+     * Park a block instead of deallocating it, if the retention policy allows.
+     *
+     * Works like `park_allocation()` except that the block is removed as with
+     * `concurrent_remove_allocation()`.
+     *
+     * @param ptr       Pointer to the memory being deallocated.
+     * @param len       Number of bytes in the memory being deallocated.
+     * @param release   Function returning the block to its upstream allocator.
+     *
+     * @return  Whether the block was parked.
+     */
+    bool concurrent_park_allocation(void* ptr, std::size_t len, release_block_function release);
+
+    /**
+     * @brief
+     * Take a parked block for a new allocation and record it as with `add_allocation()`.
+     *
+     * Pages of the block that are still retained are referenced again without any OS call.  Does
+     * not take any mutex when no block is parked.
+     *
+     * @param len       Number of bytes to allocate.
+     * @param release   Function the block was parked with.
+     *
+     * @return  The block, or nullptr if no block of `len` bytes was parked with `release`.
+     */
+    void* reuse_allocation(std::size_t len, release_block_function release);
+
+    /**
+     * @brief
+     * Take a parked block for a new allocation and record it as with
+     * `serialized_add_allocation()`.
+     *
+     * @param len       Number of bytes to allocate.
+     * @param release   Function the block was parked with.
+     *
+     * @return  The block, or nullptr if no block of `len` bytes was parked with `release`.
+     */
+    void* serialized_reuse_allocation(std::size_t len, release_block_function release);
+
+    /**
+     * @brief
+     * Take a parked block for a new allocation and record it as with
+     * `concurrent_add_allocation()`.
+     *
+     * @param len       Number of bytes to allocate.
+     * @param release   Function the block was parked with.
+     *
+     * @return  The block, or nullptr if no block of `len` bytes was parked with `release`.
+     */
+    void* concurrent_reuse_allocation(std::size_t len, release_block_function release);
+
+    /**
+     * @brief
+     * Get the page a pointer exists in.
+     *
+     * @param ptr   Pointer to convert to a base page address.
+     *
+     * @return  Pointer to the page containing ptr;
+     */
+    std::byte* to_page(void* ptr) const noexcept
+    {
+        return reinterpret_cast<std::byte*>(reinterpret_cast<std::uintptr_t>(ptr) & ~page_mask());
+    }
+
+    /**
+     * @brief
+     * Get the page size of the system.
+     *
+     * @return  Number of bytes in a page of memory.
+     */
+    std::size_t page_size() const noexcept { return std::size_t{1} << _page_shift; }
+
+    /**
+     * @brief
+     * Get the current allocation statistics.
+     *
+     * This only reads atomic counters and never takes any shard mutex, so it is cheap enough to be
+     * polled frequently and never delays allocations.
+     *
+     * @return  The statistics.
+     */
+    no_swap_allocator_stats snapshot() const noexcept;
+
+    /**
+     * @brief
+     * Set the policy for retaining pages after their last allocation is released.
+     *
+     * Pages retained beyond what the new policy allows are unlocked right away.
+     *
+     * @param policy    The new policy.
+     */
+    void set_retention_policy(const no_swap_retention_policy& policy);
+
+    /**
+     * @brief
+     * Unlock all retained pages and return all parked blocks to their upstream allocators.
+     *
+     * Holds the mutexes of all shards while unlocking.  Pages are unlocked in as few OS calls as
+     * their layout allows, and the blocks are only returned once their pages are unlocked.
+     */
+    void release_retained_pages();
+
+#ifdef EC_UNIT_TEST_SUPPORT
+    /**
+     * This method exists only to aid certain unit tests to ensure that all tests can start from a
+     * known state.  All this does is remove all the pages in the specified memory region without
+     * calling the OS unlock API.
+     *
+     * @param ptr   Pointer to the memory to be removed from tracking.
+     * @param len   Number of bytes in the memory to be removed from tracking.
+     */
+    void clear_pages(void* ptr, std::size_t len);
+
+    /**
+     * This method exists only to aid certain unit tests to check if any shard mutex is locked or
+     * not.
+     *
+     * @return  An indication of whether any shard mutex is locked or not.
+     */
+    bool is_lock_held();
+#endif
+
+    /// @brief Number of independently locked shards.
+    static constexpr std::size_t shard_count{64};
+
+    /// @brief Log base 2 of the size of the address regions that are hashed onto shards.
+    static constexpr std::size_t shard_region_shift{21};
+
+    /// @brief Size of the address regions that are hashed onto shards (2 MiB).
+    static constexpr std::size_t shard_region_size{std::size_t{1} << shard_region_shift};
+
+    /// @brief Most blocks parked at a time.
+    static constexpr std::size_t max_parked_blocks{64};
+
+  private:
+    /// @brief Type alias for the address type used in the page range tables.
+    using address = page_range_table::address;
+
+    /**
+     * @brief
+     * Statistics counters.  They are only ever updated with relaxed atomic operations so that
+     * `snapshot()` can read them without taking any mutex.
+     */
+    struct counters {
+        std::atomic<std::uint64_t> pinned_pages{};          ///< @brief Pages locked and not yet unlocked.
+        std::atomic<std::uint64_t> live_allocations{};      ///< @brief Allocations added and not yet removed.
+        std::atomic<std::uint64_t> pin_calls{};             ///< @brief OS calls made to lock memory.
+        std::atomic<std::uint64_t> unpin_calls{};           ///< @brief OS calls made to unlock memory.
+        std::atomic<std::uint64_t> pin_failures{};          ///< @brief OS calls to lock memory that failed.
+        std::atomic<std::uint64_t> syscall_nanoseconds{};   ///< @brief Time spent in OS calls.
+    };
+
+    /**
+     * @brief
+     * A slice of the page tracking state with its own mutex.  Aligned to a cache line so that
+     * shards used by different threads do not falsely share.
+     *
+     * Each shard also carries the statistics counters for operations starting in its regions, so
+     * that the counters are spread out the same way as the mutexes.  Counts are only meaningful
+     * summed over all the shards.
+     */
+    struct alignas(64) shard {
+        std::mutex mutex;               ///< @brief Mutex to protect page_ranges.
+        page_range_table page_ranges;   ///< @brief Pages in this shard and their reference counts.
+        page_range_table retained;      ///< @brief Unreferenced pages in this shard that are still locked.
+        counters stats;                 ///< @brief Statistics for operations starting in this shard.
+    };
+
+    /// @brief Set of shards involved in an update.
+    using shard_set = std::bitset<shard_count>;
+
+    /// @brief The shards holding the page reference counts.
+    std::array<shard, shard_count> _shards;
+
+#if EC_PAGE_SIZE
+    static_assert(std::has_single_bit(std::size_t{EC_PAGE_SIZE}), "EC_PAGE_SIZE must be a power of 2");
+
+    /// @brief Log base 2 of the page size of the system, fixed at compile-time.
+    static constexpr std::size_t _page_shift{std::countr_zero(std::size_t{EC_PAGE_SIZE})};
+#else
+    /**
+     * @brief
+     * Log base 2 of the page size of the system.  Only need to get this once, so store the result
+     * in a variable.
+     */
+    const std::size_t _page_shift;
+#endif
+
+    /// @brief Per page reference counts of the concurrent allocations.
+    page_refcount_table _concurrent_pages{_page_shift};
+
+    std::atomic<std::uint64_t> _retain_max_bytes{};         ///< @brief Retention byte budget, 0 when disabled.
+    std::atomic<std::int64_t> _retain_max_idle{};           ///< @brief Longest retention time in nanoseconds.
+    std::atomic<std::uint64_t> _retain_max_allocation{};    ///< @brief Largest allocation retained, in bytes.
+    std::atomic<std::uint64_t> _retained_pages{};           ///< @brief Pages retained over all shards.
+    std::atomic<std::int64_t> _retained_since{};            ///< @brief Steady clock time in nanoseconds the retained pages were last all reused.
+
+    /// @brief A released block kept allocated from its upstream allocator.
+    struct parked_block {
+        void* ptr{};                        ///< @brief Start of the block.
+        std::size_t len{};                  ///< @brief Number of bytes in the block.
+        release_block_function release{};   ///< @brief Function returning the block upstream.
+    };
+
+    std::mutex _parked_mutex;                                   ///< @brief Mutex to protect the parked blocks.  Always taken before any shard mutex.
+    std::array<parked_block, max_parked_blocks> _parked{};      ///< @brief The parked blocks.
+    std::size_t _parked_count{};                                ///< @brief Number of parked blocks.
+    std::atomic<std::uint64_t> _parked_bytes{};                 ///< @brief Bytes in the parked blocks.
+
+    /**
+     * @brief
+     * Get the mask of the offset bits within a page.
+     *
+     * @return  The page size minus 1.
+     */
+    std::uintptr_t page_mask() const noexcept { return (std::uintptr_t{1} << _page_shift) - 1; }
+
+    /**
+     * @brief
+     * The real default constructor - made private to prevent accidental instantiation by others.
+     */
+    no_swap_allocator_state();
+
+    /**
+     * @brief
+     * Helper function to get the range of pages spanned by a memory region.
+     *
+     * @param ptr   Pointer to the start of the memory region.
+     * @param len   Number of bytes in the memory region.
+     *
+     * @return  Start of the first page and end of the last page of the memory region.
+     */
+    std::pair<address, address> to_page_range(void* ptr, std::size_t len) const noexcept
+    {
+        auto start = reinterpret_cast<address>(ptr) & ~page_mask();
+        if (len == 0) {
+            return {start, start};
+        }
+        auto end = (reinterpret_cast<address>(ptr) + len + page_mask()) & ~page_mask();
+        return {start, end};
+    }
+
+    /**
+     * @brief
+     * Get the shard responsible for the region containing an address.
+     *
+     * @param addr  Address to look up.
+     *
+     * @return  Index of the shard.
+     */
+    static std::size_t shard_index(address addr) noexcept;
+
+    /**
+     * @brief
+     * Get the statistics counters to charge an operation starting at an address to.
+     *
+     * @param addr  Address the operation starts at.
+     *
+     * @return  Reference to the counters.
+     */
+    counters& stats_for(address addr) noexcept { return _shards[shard_index(addr)].stats; }
+
+    /**
+     * @brief
+     * Lock a run of pages to RAM, keeping the statistics up to date.
+     *
+     * @param start     Start of the run.
+     * @param end       End of the run.
+     */
+    void pin_run(address start, address end);
+
+    /**
+     * @brief
+     * Unlock a run of pages from RAM, keeping the statistics up to date.
+     *
+     * @param start     Start of the run.
+     * @param end       End of the run.
+     */
+    void unpin_run(address start, address end);
+
+    /**
+     * @brief
+     * Get the set of shards covering a range of pages.
+     *
+     * @param start     Start of the range of pages.
+     * @param end       End of the range of pages.
+     *
+     * @return  The set of shards.
+     */
+    static shard_set shards_for(address start, address end) noexcept;
+
+    /**
+     * @brief
+     * Lock the mutexes of a set of shards in ascending order.
+     *
+     * @param shards    The set of shards to lock.
+     */
+    void lock_shards(const shard_set& shards);
+
+    /**
+     * @brief
+     * Unlock the mutexes of a set of shards.
+     *
+     * @param shards    The set of shards to unlock.
+     */
+    void unlock_shards(const shard_set& shards) noexcept;
+
+    /**
+     * @brief
+     * Split a range of pages where it crosses into the region of another shard and invoke a function
+     * for each piece.
+     *
+     * @tparam F    Function type with the signature `void(shard&, address, address)`.
+     *
+     * @param start     Start of the range of pages.
+     * @param end       End of the range of pages.
+     * @param f         Function to call with the owning shard and the bounds of each piece.
+     */
+    template <typename F>
+    void for_each_piece(address start, address end, F&& f);
+
+    /**
+     * @brief
+     * Invoke a function for each maximal sub-range of a piece of a shard that is not locked, i.e.,
+     * neither referenced nor retained.
+     *
+     * @tparam F    Function type with the signature `void(address, address)`.
+     *
+     * @param s         The shard owning the piece.
+     * @param start     Start of the piece.
+     * @param end       End of the piece.
+     * @param f         Function to call with the start and end of each sub-range.
+     */
+    template <typename F>
+    static void for_each_unlocked(shard& s, address start, address end, F&& f)
+    {
+        s.page_ranges.for_each_unreferenced(start, end, [&s, &f](address run_start, address run_end) {
+            s.retained.for_each_unreferenced(run_start, run_end, f);
+        });
+    }
+
+    /**
+     * @brief
+     * Reference a range of pages and lock any pages that were neither referenced nor retained.
+     *
+     * The caller must hold the mutexes of all shards involved (or be single threaded).
+     *
+     * @param start     Start of the range of pages.
+     * @param end       End of the range of pages.
+     */
+    void add_pages(address start, address end);
+
+    /**
+     * @brief
+     * Dereference a range of pages and unlock or retain any pages that are no longer referenced.
+     *
+     * The caller must hold the mutexes of all shards involved (or be single threaded).
+     *
+     * @param start     Start of the range of pages.
+     * @param end       End of the range of pages.
+     * @param retain    Whether to retain the pages rather than unlock them.
+     */
+    void remove_pages(address start, address end, bool retain);
+
+    /**
+     * @brief
+     * Reference a range of pages, holding the mutexes of the shards involved while doing so.
+     *
+     * @param start     Start of the range of pages.
+     * @param end       End of the range of pages.
+     */
+    void serialized_add_pages(address start, address end);
+
+    /**
+     * @brief
+     * Dereference a range of pages, holding the mutexes of the shards involved while doing so.
+     *
+     * @param start     Start of the range of pages.
+     * @param end       End of the range of pages.
+     * @param retain    Whether to retain the pages rather than unlock them.
+     */
+    void serialized_remove_pages(address start, address end, bool retain);
+
+    /**
+     * @brief
+     * Reference a range of pages in the concurrent page reference counts, adding the runs that
+     * become referenced to the shards.
+     *
+     * @param start     Start of the range of pages.
+     * @param end       End of the range of pages.
+     */
+    void concurrent_add_pages(address start, address end);
+
+    /**
+     * @brief
+     * Dereference a range of pages in the concurrent page reference counts, removing the runs that
+     * become unreferenced from the shards.
+     *
+     * @param start     Start of the range of pages.
+     * @param end       End of the range of pages.
+     * @param retain    Whether to retain the pages rather than unlock them.
+     */
+    void concurrent_remove_pages(address start, address end, bool retain);
+
+    /**
+     * @brief
+     * Park a block if the retention policy allows, removing its pages with a function.
+     *
+     * @tparam F    Function type with the signature `void(address, address)` that dereferences
+     *              and retains a range of pages.
+     *
+     * @param ptr       Pointer to the memory being deallocated.
+     * @param len       Number of bytes in the memory being deallocated.
+     * @param release   Function returning the block to its upstream allocator.
+     * @param remove    Function removing the pages of the block.
+     *
+     * @return  Whether the block was parked.
+     */
+    template <typename F>
+    bool park(void* ptr, std::size_t len, release_block_function release, F&& remove);
+
+    /**
+     * @brief
+     * Take a parked block for a new allocation, adding its pages with a function.
+     *
+     * @tparam F    Function type with the signature `void(address, address)` that references a
+     *              range of pages.
+     *
+     * @param len       Number of bytes to allocate.
+     * @param release   Function the block was parked with.
+     * @param add       Function adding the pages of the block.
+     *
+     * @return  The block, or nullptr if no matching block was parked.
+     */
+    template <typename F>
+    void* reuse(std::size_t len, release_block_function release, F&& add);
+
+    /**
+     * @brief
+     * Check whether the retention policy applies to an allocation spanning a range of pages.
+     *
+     * @param start     Start of the range of pages.
+     * @param end       End of the range of pages.
+     *
+     * @return  Whether a block spanning the pages may be parked.
+     */
+    bool should_retain(address start, address end) const noexcept
+    {
+        return _retain_max_bytes.load(std::memory_order_relaxed) != 0 &&
+               end - start <= _retain_max_allocation.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief
+     * Retain a run of locked pages that just became unreferenced, or unlock them if they cannot be
+     * tracked.
+     *
+     * The caller must hold the mutex of the shard (or be single threaded).
+     *
+     * @param s         The shard owning the run.
+     * @param start     Start of the run.
+     * @param end       End of the run.
+     */
+    void retain_run(shard& s, address start, address end);
+
+    /**
+     * @brief
+     * Stop retaining the pages of a piece of a shard, leaving them locked.
+     *
+     * The caller must hold the mutex of the shard (or be single threaded).
+     *
+     * @param s         The shard owning the piece.
+     * @param start     Start of the piece.
+     * @param end       End of the piece.
+     */
+    void reclaim_retained(shard& s, address start, address end);
+
+    /**
+     * @brief
+     * Release all retained pages and parked blocks if the pages exceed the byte budget or have
+     * been retained for too long, or if retention is disabled.  Must be called without holding
+     * any mutex.
+     */
+    void release_retained_if_due();
+
+    template <typename, typename>
+    friend class serialized_no_swap_allocator;
+
+    template <typename, typename>
+    friend class concurrent_no_swap_allocator;
+
+    template <typename, typename>
+    friend class unserialized_no_swap_allocator;
+};
+
+template <typename T>
+void no_swap_allocator_state::serialized_add_allocations(T* const* ptrs, std::size_t n, std::size_t len)
+{
+    shard_set shards;
+    for (std::size_t i = 0; i < n; ++i) {
+        auto [start, end] = to_page_range(ptrs[i], len);
+        shards |= shards_for(start, end);
+    }
+
+    lock_shards(shards);
+    std::size_t i = 0;
+    try {
+        for (; i < n; ++i) {
+            auto [start, end] = to_page_range(ptrs[i], len);
+            add_pages(start, end);
+        }
+    } catch (...) {
+        while (i > 0) {
+            auto [start, end] = to_page_range(ptrs[--i], len);
+            try {
+                remove_pages(start, end, false);
+            } catch (...) {
+            }
+        }
+        unlock_shards(shards);
+        throw;
+    }
+    unlock_shards(shards);
+    if (n != 0) {
+        stats_for(reinterpret_cast<address>(ptrs[0])).live_allocations.fetch_add(n, std::memory_order_relaxed);
+    }
+}
+
+template <typename T>
+void no_swap_allocator_state::serialized_remove_allocations(T* const* ptrs, std::size_t n, std::size_t len)
+{
+    shard_set shards;
+    for (std::size_t i = 0; i < n; ++i) {
+        auto [start, end] = to_page_range(ptrs[i], len);
+        shards |= shards_for(start, end);
+    }
+
+    lock_shards(shards);
+    try {
+        for (std::size_t i = 0; i < n; ++i) {
+            auto [start, end] = to_page_range(ptrs[i], len);
+            remove_pages(start, end, false);
+            stats_for(start).live_allocations.fetch_sub(1, std::memory_order_relaxed);
+        }
+    } catch (...) {
+        unlock_shards(shards);
+        throw;
+    }
+    unlock_shards(shards);
+    release_retained_if_due();
+}
+
+template <typename T>
+void no_swap_allocator_state::concurrent_add_allocations(T* const* ptrs, std::size_t n, std::size_t len)
+{
+    std::size_t i = 0;
+    try {
+        for (; i < n; ++i) {
+            concurrent_add_allocation(ptrs[i], len);
+        }
+    } catch (...) {
+        while (i > 0) {
+            try {
+                concurrent_remove_allocation(ptrs[--i], len);
+            } catch (...) {
+            }
+        }
+        throw;
+    }
+}
+
+} // namespace details
+
+/**
+ * @brief
+ * Get the current statistics of the memory pinned by all the no swap allocators.
+ *
+ * Safe to call from any thread at any rate; it never waits for allocations in progress.
+ *
+ * @return  The statistics.
+ */
+inline no_swap_allocator_stats no_swap_allocator_snapshot() noexcept
+{
+    return details::no_swap_allocator_state::get_state_object().snapshot();
+}
+
+/**
+ * @brief
+ * Set the policy for keeping pages locked after their last no swap allocation is released.
+ *
+ * @param policy    The new policy.  The default constructed policy unlocks pages right away.
+ */
+inline void set_no_swap_retention_policy(const no_swap_retention_policy& policy)
+{
+    details::no_swap_allocator_state::get_state_object().set_retention_policy(policy);
+}
+
+/**
+ * @brief
+ * Unlock all pages retained under the `ec::no_swap_retention_policy`, e.g., when going idle.
+ */
+inline void release_retained_pages()
+{
+    details::no_swap_allocator_state::get_state_object().release_retained_pages();
+}
+
+/**
+ * @brief
+ * This is a C++ STL compatible allocator adapter that will ensure that the allocated memory does
+ * not get swapped out to disk until after it is deallocated.
+ *
+ * This version accesses shared global state information without an kind of serialization (i.e.,
+ * mutex locking).  As such, it is only suitable for single threaded applications.
+ *
+ * @code
+ * if (condition) {
+ *     std::basic_string<char, std::char_traits<char>, ec::unserialized_no_swap_allocator<char>> password = read_from_console();
+ *     // password locked to RAM.
+ *     process_password(password);  // Takes a std::string_view.
+ *  }  // password destroyed - memory can be swapped again.
+ * @endcode
+ *
+ * Important note: Some care must be taken with certain containers.  For example, `std::string` is
+ *                 allowed to use an optimization called Short String Optimization (SSO).  This
+ *                 means that for strings below a certain length, the `std::string` implementation
+ *                 may not actually allocate any memory.  Such strings can still be swapped out.
+ *                 Whether or not SSO is employed and what the maximum length of a "short string"
+ *                 is, is implementation defined.
+ *
+ * @tparam T    The type being allocated.
+ * @tparam A    The actual allocator being wrapped.
+ */
+template <typename T, typename A = std::allocator<T>>
+struct unserialized_no_swap_allocator {
+  private:
+    /// @brief Type alias for the upstream allocator.
+    using upstream_allocator = A;
+    /// @brief Alias for allocator traits.
+    using upstream_traits = std::allocator_traits<upstream_allocator>;
+
+  public:
+    /// @brief Type alias for the type being allocated.
+    using value_type = typename upstream_traits::value_type;
+    /// @brief Type alias for the type representing the size of allocations.
+    using size_type = typename upstream_traits::size_type;
+    /// @brief Type alias for the type representing the distance between pointers.
+    using difference_type = typename upstream_traits::difference_type;
+    /// @brief Compile-time indication about how to handle the allocator when copying containers.
+    using propagate_on_container_copy_assignment = typename upstream_traits::propagate_on_container_copy_assignment;
+    /// @brief Compile-time indication about how to handle the allocator when moving containers.
+    using propagate_on_container_move_assignment = typename upstream_traits::propagate_on_container_move_assignment;
+    /// @brief Compile-time indication about how to handle the allocator when swapping containers.
+    using propagate_on_container_swap = typename upstream_traits::propagate_on_container_swap;
+    /**
+     * @brief Compile-time indication about how whether different instances of the allocator are
+     * considered the same or not.
+     */
+    using is_always_equal = typename upstream_traits::is_always_equal;
+
+    /**
+     * @internal @brief
+     * Define the rebind struct so that std::allocator_traits knows how to properly apply new
+     * template parameter values.
+     */
+    template <typename U, typename... Us>
+    struct rebind {
+        /// @brief The rebound allocator type.
+        using other = unserialized_no_swap_allocator<U, typename upstream_traits::template rebind_alloc<U, Us...>>;
+    };
+
+    /// @brief Default constructor.
+    unserialized_no_swap_allocator() = default;
+    /// @brief Move constructor.
+    unserialized_no_swap_allocator(unserialized_no_swap_allocator&&) = default;
+    /// @brief Copy constructor.
+    unserialized_no_swap_allocator(const unserialized_no_swap_allocator&) = default;
+
+    /**
+     * @brief
+     * Constructor to wrap a specific upstream allocator.
+     *
+     * @param upstream  The allocator that will manage the actual memory allocations.
+     */
+    explicit unserialized_no_swap_allocator(const upstream_allocator& upstream):
+        _upstream_allocator(upstream)
+    {}
+
+    /**
+     * @brief
+     * Get the allocator for a copy of a container.
+     *
+     * @return  An allocator over whatever the upstream allocator picks for the copy.
+     */
+    unserialized_no_swap_allocator select_on_container_copy_construction() const
+    {
+        return unserialized_no_swap_allocator{upstream_traits::select_on_container_copy_construction(_upstream_allocator)};
+    }
+
+    /**
+     * @brief
+     * Constructor to move from an alternate allocation type.
+     *
+     * @tparam Ts   The type parameters for the alternate form to move from.
+     *
+     * @param other     The allocator being moved from.
+     */
+    template <typename... Ts>
+    unserialized_no_swap_allocator(unserialized_no_swap_allocator<Ts...>&& other):
+        _upstream_allocator(std::move(other._upstream_allocator))
+    {}
+
+    /**
+     * @brief
+     * Constructor to copy from an alternate allocation type.
+     *
+     * @tparam Ts   The type parameters for the alternate form to copy from.
+     *
+     * @param other     The allocator being copied from.
+     */
+    template <typename... Ts>
+    unserialized_no_swap_allocator(const unserialized_no_swap_allocator<Ts...>& other):
+        _upstream_allocator(other._upstream_allocator)
+    {}
+
+    /**
+     * @brief
+     * Allocate the requested amount of memory.
+     *
+     * @param len   Number of type T to allocate.
+     *
+     * @return  Address of the allocated memory.
+     */
+    EC_NODISCARD
+    T* allocate(std::size_t len)
+    {
+        auto& state = details::no_swap_allocator_state::get_state_object();
+        if constexpr (details::can_park_blocks<upstream_allocator>()) {
+            if (auto* ptr = state.reuse_allocation(len * sizeof(T), &release_parked)) {
+                return static_cast<T*>(ptr);
+            }
+        }
+        T* ptr = _upstream_allocator.allocate(len);
+        state.add_allocation(ptr, len * sizeof(T));
+        return ptr;
+    }
+
+#if defined(__cpp_lib_allocate_at_least)
+    /**
+     * @brief
+     * Allocate at least the requested amount of memory.
+     *
+     * The capacity reported is whatever the upstream allocator actually handed out, all of which
+     * gets locked.  Any slack beyond that in the last locked page still belongs to the upstream
+     * allocator, so it is not reported.
+     *
+     * @param len   Number of type T to allocate.
+     *
+     * @return  Address and number of type T of the allocated memory.
+     */
+    EC_NODISCARD
+    auto allocate_at_least(std::size_t len)
+    {
+        auto& state = details::no_swap_allocator_state::get_state_object();
+        if constexpr (details::can_park_blocks<upstream_allocator>()) {
+            if (auto* ptr = state.reuse_allocation(len * sizeof(T), &release_parked)) {
+                return decltype(_upstream_allocator.allocate_at_least(len)){static_cast<T*>(ptr), len};
+            }
+        }
+        auto r = _upstream_allocator.allocate_at_least(len);
+        state.add_allocation(r.ptr, r.count * sizeof(T));
+        return r;
+    }
+#endif
+
+    /**
+     * @brief
+     * Deallocate a block of memory.
      *
-     * This will lock the referenced pages of memory so that the OS will not swap them out if the
-     * pages have not already be marked as such.
+     * Important note: This will unlock the memory so that it can be swapped before the upstream
+     * allocator is invoked to deallocate the memory.
+     * Under a `ec::no_swap_retention_policy` the memory may instead be parked for reuse, and only
+     * returned to the upstream allocator once it is released.
      *
-     * @param ptr   Pointer to the newly allocated memory.
-     * @param len   Number of bytes in the newly allocated memory.
+     * @param ptr   Address of the memory to be deallcoated.
+     * @param len   Number of type T to deallocate.
      */
-    void serialized_add_allocation(void* ptr, std::size_t len)
+    void deallocate(T* ptr, std::size_t len)
     {
-        std::lock_guard lk{_mutex};
-        add_allocation(ptr, len);
+        auto& state = details::no_swap_allocator_state::get_state_object();
+        if constexpr (details::can_park_blocks<upstream_allocator>()) {
+            if (state.park_allocation(ptr, len * sizeof(T), &release_parked)) {
+                return;
+            }
+        }
+        state.remove_allocation(ptr, len * sizeof(T));
+        _upstream_allocator.deallocate(ptr, len);
     }
 
     /**
      * @brief
-     * Process the deallocation of a memory region.
-     *
-     * This will unlock the referenced pages of memory so that the OS can swap them back out again
-     * if there are no other allocations using the referenced pages.
+     * Allocate a batch of single objects.  Either all objects are allocated or none are.
      *
-     * @param ptr   Pointer to the memory being deallocated.
-     * @param len   Number of bytes in the memory being deallocated.
+     * @param n     Number of objects to allocate.
+     * @param out   Array of at least `n` pointers to receive the addresses of the objects.
      */
-    void serialized_remove_allocation(void* ptr, std::size_t len)
+    void allocate_batch(std::size_t n, T** out)
     {
-        std::lock_guard lk{_mutex};
-        remove_allocation(ptr, len);
+        details::allocate_batch(_upstream_allocator, n, out);
+        auto& state = details::no_swap_allocator_state::get_state_object();
+        std::size_t i = 0;
+        try {
+            for (; i < n; ++i) {
+                state.add_allocation(out[i], sizeof(T));
+            }
+        } catch (...) {
+            while (i > 0) {
+                state.remove_allocation(out[--i], sizeof(T));
+            }
+            details::deallocate_batch(_upstream_allocator, out, n);
+            throw;
+        }
     }
 
-#ifdef EC_UNIT_TEST_SUPPORT
     /**
-     * This method exists only to aid certain unit tests to ensure that all tests can start from a
-     * known state.  All this does is remove all the pages in the specified memory region without
-     * calling the OS unlock API.
+     * @brief
+     * Deallocate a batch of single objects.
      *
-     * @param ptr   Pointer to the memory to be removed from tracking.
-     * @param len   Number of bytes in the memory to be removed from tracking.
+     * @param ptrs  Array of the addresses of the objects.
+     * @param n     Number of objects to deallocate.
      */
-    void clear_pages(void* ptr, std::size_t len);
+    void deallocate_batch(T* const* ptrs, std::size_t n)
+    {
+        auto& state = details::no_swap_allocator_state::get_state_object();
+        for (std::size_t i = 0; i < n; ++i) {
+            state.remove_allocation(ptrs[i], sizeof(T));
+        }
+        details::deallocate_batch(_upstream_allocator, ptrs, n);
+    }
 
     /**
-     * This method exists only to aid certain unit tests to check if the mutex is locked or not.
+     * @brief
+     * Check if memory allocated by one allocator can be deallocated by another.
+     *
+     * The allocated pages state is process wide, so this only depends on the upstream allocators.
+     *
+     * @tparam U    The alternate type for the allocator being compared with.
+     * @tparam B    The upstream allocator type of the allocator being compared with.
+     *
+     * @param other     The allocator being compared with.
      *
-     * @return  An indication of whether the mutex is locked or not.
+     * @return  Whether or not the upstream allocators are equal.
      */
-    bool is_lock_held();
-#endif
+    template <typename U, typename B>
+    bool operator==(const unserialized_no_swap_allocator<U, B>& other) const noexcept
+    {
+        return _upstream_allocator == other._upstream_allocator;
+    }
 
   private:
-    /// @brief The signleton pointer to ourself.
-    static std::shared_ptr<no_swap_allocator_state> _self;
-
-    /// @brief A mapping of page pointers and the number of allocations in those pages.
-    std::unordered_map<void*, std::uint32_t> _page_ref_count;
-
-    /// @brief Mutex to protect _page_ref_count in multi-threaded applications.
-    mutable std::mutex _mutex;
-
-    /**
-     * @brief
-     * Page size of the system.  Only need to get this once, so store the result in a variable.
-     */
-    const std::size_t _page_size;
-
-    /**
-     * @brief
-     * The real default constructor - made private to prevent accidental instantiation by others.
-     */
-    no_swap_allocator_state();
+    [[no_unique_address]] upstream_allocator _upstream_allocator{};    ///< @brief The real allocator that will manage the actual memory allocations.
 
     /**
      * @brief
-     * Helper function to get the page a pointer exists in.
+     * Return a block parked by the no swap allocator state to a default constructed upstream
+     * allocator.
      *
-     * Apparently, good, old-fashioned bit masking is not liked by modern C++ compilers.  The STL
-     * provides a function called `std::align()` which can be made to do the trick but it has some
-     * odd side effects.
-     *
-     * @param ptr   Pointer to convert to a base page address.
-     *
-     * @return  Pointer to the page containing ptr;
+     * @param ptr   Address of the block.
+     * @param len   Number of bytes in the block.
      */
-    std::byte* to_page(void* ptr);
-
-    template <typename, typename>
-    friend class serialized_no_swap_allocator;
+    static void release_parked(void* ptr, std::size_t len)
+    {
+        upstream_allocator upstream{};
+        upstream.deallocate(static_cast<T*>(ptr), len / sizeof(T));
+    }
 
     template <typename, typename>
     friend class unserialized_no_swap_allocator;
 };
 
-} // namespace details
-
 /**
  * @brief
  * This is a C++ STL compatible allocator adapter that will ensure that the allocated memory does
  * not get swapped out to disk until after it is deallocated.
  *
- * This version accesses shared global state information without an kind of serialization (i.e.,
- * mutex locking).  As such, it is only suitable for single threaded applications.
+ * This version accesses shared global state information with serialization (i.e., mutex locking).
+ * As such, it is safe to use in multi-threaded applications.
  *
  * @code
  * if (condition) {
- *     std::basic_string<char, std::char_traits<char>, ec::unserialized_no_swap_allocator<char>> password = read_from_console();
+ *     std::basic_string<char, std::char_traits<char>, ec::serialized_no_swap_allocator<char>> password = read_from_console();
  *     // password locked to RAM.
  *     process_password(password);  // Takes a std::string_view.
  *  }  // password destroyed - memory can be swapped again.
@@ -197,7 +1287,7 @@ class no_swap_allocator_state {
  * @tparam A    The actual allocator being wrapped.
  */
 template <typename T, typename A = std::allocator<T>>
-struct unserialized_no_swap_allocator {
+struct serialized_no_swap_allocator {
   private:
     /// @brief Type alias for the upstream allocator.
     using upstream_allocator = A;
@@ -228,29 +1318,50 @@ struct unserialized_no_swap_allocator {
      * Define the rebind struct so that std::allocator_traits knows how to properly apply new
      * template parameter values.
      */
-    template <typename U, typename... Us>
+    template <typename U>
     struct rebind {
         /// @brief The rebound allocator type.
-        using other = unserialized_no_swap_allocator<U, typename upstream_traits::template rebind_alloc<U, Us...>>;
+        using other = serialized_no_swap_allocator<U, typename upstream_traits::template rebind_alloc<U>>;
     };
 
     /// @brief Default constructor.
-    unserialized_no_swap_allocator() = default;
+    serialized_no_swap_allocator() = default;
     /// @brief Move constructor.
-    unserialized_no_swap_allocator(unserialized_no_swap_allocator&&) = default;
+    serialized_no_swap_allocator(serialized_no_swap_allocator&&) = default;
     /// @brief Copy constructor.
-    unserialized_no_swap_allocator(const unserialized_no_swap_allocator&) = default;
+    serialized_no_swap_allocator(const serialized_no_swap_allocator&) = default;
+
+    /**
+     * @brief
+     * Constructor to wrap a specific upstream allocator.
+     *
+     * @param upstream  The allocator that will manage the actual memory allocations.
+     */
+    explicit serialized_no_swap_allocator(const upstream_allocator& upstream):
+        _upstream_allocator(upstream)
+    {}
+
+    /**
+     * @brief
+     * Get the allocator for a copy of a container.
+     *
+     * @return  An allocator over whatever the upstream allocator picks for the copy.
+     */
+    serialized_no_swap_allocator select_on_container_copy_construction() const
+    {
+        return serialized_no_swap_allocator{upstream_traits::select_on_container_copy_construction(_upstream_allocator)};
+    }
 
     /**
      * @brief
      * Constructor to move from an alternate allocation type.
      *
-     * @tparam Ts   The type parameters for the alternate form to move from.
+     * @tparam U    The alternate type for the allocator being moved from.
      *
      * @param other     The allocator being moved from.
      */
-    template <typename... Ts>
-    unserialized_no_swap_allocator(unserialized_no_swap_allocator<Ts...>&& other):
+    template <typename U>
+    serialized_no_swap_allocator(serialized_no_swap_allocator<U>&& other):
         _upstream_allocator(std::move(other._upstream_allocator))
     {}
 
@@ -258,15 +1369,16 @@ struct unserialized_no_swap_allocator {
      * @brief
      * Constructor to copy from an alternate allocation type.
      *
-     * @tparam Ts   The type parameters for the alternate form to copy from.
+     * @tparam U    The alternate type for the allocator being copied from.
      *
      * @param other     The allocator being copied from.
      */
-    template <typename... Ts>
-    unserialized_no_swap_allocator(const unserialized_no_swap_allocator<Ts...>& other):
+    template <typename U>
+    serialized_no_swap_allocator(const serialized_no_swap_allocator<U>& other):
         _upstream_allocator(other._upstream_allocator)
     {}
 
+#if __has_cpp_attribute(nodiscard)
     /**
      * @brief
      * Allocate the requested amount of memory.
@@ -275,11 +1387,18 @@ struct unserialized_no_swap_allocator {
      *
      * @return  Address of the allocated memory.
      */
-    EC_NODISCARD
+    [[nodiscard]]
+#endif
     T* allocate(std::size_t len)
     {
+        auto& state = details::no_swap_allocator_state::get_state_object();
+        if constexpr (details::can_park_blocks<upstream_allocator>()) {
+            if (auto* ptr = state.serialized_reuse_allocation(len * sizeof(T), &release_parked)) {
+                return static_cast<T*>(ptr);
+            }
+        }
         T* ptr = _upstream_allocator.allocate(len);
-        _state->add_allocation(ptr, len * sizeof(T));
+        state.serialized_add_allocation(ptr, len * sizeof(T));
         return ptr;
     }
 
@@ -288,15 +1407,24 @@ struct unserialized_no_swap_allocator {
      * @brief
      * Allocate at least the requested amount of memory.
      *
+     * The capacity reported is whatever the upstream allocator actually handed out, all of which
+     * gets locked.
+     *
      * @param len   Number of type T to allocate.
      *
-     * @return  Address of the allocated memory.
+     * @return  Address and number of type T of the allocated memory.
      */
     EC_NODISCARD
     auto allocate_at_least(std::size_t len)
     {
+        auto& state = details::no_swap_allocator_state::get_state_object();
+        if constexpr (details::can_park_blocks<upstream_allocator>()) {
+            if (auto* ptr = state.serialized_reuse_allocation(len * sizeof(T), &release_parked)) {
+                return decltype(_upstream_allocator.allocate_at_least(len)){static_cast<T*>(ptr), len};
+            }
+        }
         auto r = _upstream_allocator.allocate_at_least(len);
-        _state->add_allocation(r.ptr, r.count);
+        state.serialized_add_allocation(r.ptr, r.count * sizeof(T));
         return r;
     }
 #endif
@@ -307,23 +1435,97 @@ struct unserialized_no_swap_allocator {
      *
      * Important note: This will unlock the memory so that it can be swapped before the upstream
      * allocator is invoked to deallocate the memory.
+     * Under a `ec::no_swap_retention_policy` the memory may instead be parked for reuse, and only
+     * returned to the upstream allocator once it is released.
      *
      * @param ptr   Address of the memory to be deallcoated.
      * @param len   Number of type T to deallocate.
      */
     void deallocate(T* ptr, std::size_t len)
     {
-        _state->remove_allocation(ptr, len * sizeof(T));
+        auto& state = details::no_swap_allocator_state::get_state_object();
+        if constexpr (details::can_park_blocks<upstream_allocator>()) {
+            if (state.serialized_park_allocation(ptr, len * sizeof(T), &release_parked)) {
+                return;
+            }
+        }
+        state.serialized_remove_allocation(ptr, len * sizeof(T));
         _upstream_allocator.deallocate(ptr, len);
     }
 
+    /**
+     * @brief
+     * Allocate a batch of single objects.  Either all objects are allocated or none are.
+     *
+     * The shared state is locked only once for the whole batch.
+     *
+     * @param n     Number of objects to allocate.
+     * @param out   Array of at least `n` pointers to receive the addresses of the objects.
+     */
+    void allocate_batch(std::size_t n, T** out)
+    {
+        details::allocate_batch(_upstream_allocator, n, out);
+        try {
+            details::no_swap_allocator_state::get_state_object().serialized_add_allocations(out, n, sizeof(T));
+        } catch (...) {
+            details::deallocate_batch(_upstream_allocator, out, n);
+            throw;
+        }
+    }
+
+    /**
+     * @brief
+     * Deallocate a batch of single objects.
+     *
+     * The shared state is locked only once for the whole batch.
+     *
+     * @param ptrs  Array of the addresses of the objects.
+     * @param n     Number of objects to deallocate.
+     */
+    void deallocate_batch(T* const* ptrs, std::size_t n)
+    {
+        details::no_swap_allocator_state::get_state_object().serialized_remove_allocations(ptrs, n, sizeof(T));
+        details::deallocate_batch(_upstream_allocator, ptrs, n);
+    }
+
+    /**
+     * @brief
+     * Check if memory allocated by one allocator can be deallocated by another.
+     *
+     * The allocated pages state is process wide, so this only depends on the upstream allocators.
+     *
+     * @tparam U    The alternate type for the allocator being compared with.
+     * @tparam B    The upstream allocator type of the allocator being compared with.
+     *
+     * @param other     The allocator being compared with.
+     *
+     * @return  Whether or not the upstream allocators are equal.
+     */
+    template <typename U, typename B>
+    bool operator==(const serialized_no_swap_allocator<U, B>& other) const noexcept
+    {
+        return _upstream_allocator == other._upstream_allocator;
+    }
+
   private:
-    /// @brief Shared pointer to the allocated pages state.
-    std::shared_ptr<details::no_swap_allocator_state> _state{details::no_swap_allocator_state::get_state_object()};
-    upstream_allocator _upstream_allocator{};    ///< @brief The real allocator that will manage the actual memory allocations.
+    [[no_unique_address]] upstream_allocator _upstream_allocator{};    ///< @brief The real allocator that will manage the actual memory allocations.
+
+    /**
+     * @brief
+     * Return a block parked by the no swap allocator state to a default constructed upstream
+     * allocator.
+     *
+     * @param ptr   Address of the block.
+     * @param len   Number of bytes in the block.
+     */
+    static void release_parked(void* ptr, std::size_t len)
+    {
+        upstream_allocator upstream{};
+        upstream.deallocate(static_cast<T*>(ptr), len / sizeof(T));
+    }
 
     template <typename, typename>
-    friend class unserialized_no_swap_allocator;
+    friend class serialized_no_swap_allocator;
 };
 
 /**
@@ -331,12 +1533,14 @@ struct unserialized_no_swap_allocator {
  * This is a C++ STL compatible allocator adapter that will ensure that the allocated memory does
  * not get swapped out to disk until after it is deallocated.
  *
- * This version accesses shared global state information with serialization (i.e., mutex locking).
- * As such, it is safe to use in multi-threaded applications.
+ * This version keeps a lock-free reference count per page, so it is safe to use in multi-threaded
+ * applications and an allocation on a page that is already locked is a single atomic update.
+ * Only the first allocation on a page and the last deallocation from it take a mutex, to lock or
+ * unlock the page.  It may be freely mixed with the other no swap allocators.
  *
  * @code
  * if (condition) {
- *     std::basic_string<char, std::char_traits<char>, ec::serialized_no_swap_allocator<char>> password = read_from_console();
+ *     std::basic_string<char, std::char_traits<char>, ec::concurrent_no_swap_allocator<char>> password = read_from_console();
  *     // password locked to RAM.
  *     process_password(password);  // Takes a std::string_view.
  *  }  // password destroyed - memory can be swapped again.
@@ -353,7 +1557,7 @@ struct unserialized_no_swap_allocator {
  * @tparam A    The actual allocator being wrapped.
  */
 template <typename T, typename A = std::allocator<T>>
-struct serialized_no_swap_allocator {
+struct concurrent_no_swap_allocator {
   private:
     /// @brief Type alias for the upstream allocator.
     using upstream_allocator = A;
@@ -387,15 +1591,36 @@ struct serialized_no_swap_allocator {
     template <typename U>
     struct rebind {
         /// @brief The rebound allocator type.
-        using other = serialized_no_swap_allocator<U, typename upstream_traits::template rebind_alloc<U>>;
+        using other = concurrent_no_swap_allocator<U, typename upstream_traits::template rebind_alloc<U>>;
     };
 
     /// @brief Default constructor.
-    serialized_no_swap_allocator() = default;
+    concurrent_no_swap_allocator() = default;
     /// @brief Move constructor.
-    serialized_no_swap_allocator(serialized_no_swap_allocator&&) = default;
+    concurrent_no_swap_allocator(concurrent_no_swap_allocator&&) = default;
     /// @brief Copy constructor.
-    serialized_no_swap_allocator(const serialized_no_swap_allocator&) = default;
+    concurrent_no_swap_allocator(const concurrent_no_swap_allocator&) = default;
+
+    /**
+     * @brief
+     * Constructor to wrap a specific upstream allocator.
+     *
+     * @param upstream  The allocator that will manage the actual memory allocations.
+     */
+    explicit concurrent_no_swap_allocator(const upstream_allocator& upstream):
+        _upstream_allocator(upstream)
+    {}
+
+    /**
+     * @brief
+     * Get the allocator for a copy of a container.
+     *
+     * @return  An allocator over whatever the upstream allocator picks for the copy.
+     */
+    concurrent_no_swap_allocator select_on_container_copy_construction() const
+    {
+        return concurrent_no_swap_allocator{upstream_traits::select_on_container_copy_construction(_upstream_allocator)};
+    }
 
     /**
      * @brief
@@ -406,7 +1631,7 @@ struct serialized_no_swap_allocator {
      * @param other     The allocator being moved from.
      */
     template <typename U>
-    serialized_no_swap_allocator(serialized_no_swap_allocator<U>&& other):
+    concurrent_no_swap_allocator(concurrent_no_swap_allocator<U>&& other):
         _upstream_allocator(std::move(other._upstream_allocator))
     {}
 
@@ -419,7 +1644,7 @@ struct serialized_no_swap_allocator {
      * @param other     The allocator being copied from.
      */
     template <typename U>
-    serialized_no_swap_allocator(const serialized_no_swap_allocator<U>& other):
+    concurrent_no_swap_allocator(const concurrent_no_swap_allocator<U>& other):
         _upstream_allocator(other._upstream_allocator)
     {}
 
@@ -436,27 +1661,40 @@ struct serialized_no_swap_allocator {
 #endif
     T* allocate(std::size_t len)
     {
+        auto& state = details::no_swap_allocator_state::get_state_object();
+        if constexpr (details::can_park_blocks<upstream_allocator>()) {
+            if (auto* ptr = state.concurrent_reuse_allocation(len * sizeof(T), &release_parked)) {
+                return static_cast<T*>(ptr);
+            }
+        }
         T* ptr = _upstream_allocator.allocate(len);
-        _state->serialized_add_allocation(ptr, len * sizeof(T));
+        state.concurrent_add_allocation(ptr, len * sizeof(T));
         return ptr;
     }
 
+#if defined(__cpp_lib_allocate_at_least)
     /**
      * @brief
      * Allocate at least the requested amount of memory.
      *
+     * The capacity reported is whatever the upstream allocator actually handed out, all of which
+     * gets locked.
+     *
      * @param len   Number of type T to allocate.
      *
-     * @return  Address of the allocated memory.
+     * @return  Address and number of type T of the allocated memory.
      */
-#if defined(__cpp_lib_allocate_at_least)
-#if __has_cpp_attribute(nodiscard)
-    [[nodiscard]]
-#endif
-    auto* allocate_at_least(std::size_t len)
+    EC_NODISCARD
+    auto allocate_at_least(std::size_t len)
     {
+        auto& state = details::no_swap_allocator_state::get_state_object();
+        if constexpr (details::can_park_blocks<upstream_allocator>()) {
+            if (auto* ptr = state.concurrent_reuse_allocation(len * sizeof(T), &release_parked)) {
+                return decltype(_upstream_allocator.allocate_at_least(len)){static_cast<T*>(ptr), len};
+            }
+        }
         auto r = _upstream_allocator.allocate_at_least(len);
-        _state->serialized_add_allocation(r.ptr, r.count);
+        state.concurrent_add_allocation(r.ptr, r.count * sizeof(T));
         return r;
     }
 #endif
@@ -467,23 +1705,185 @@ struct serialized_no_swap_allocator {
      *
      * Important note: This will unlock the memory so that it can be swapped before the upstream
      * allocator is invoked to deallocate the memory.
+     * Under a `ec::no_swap_retention_policy` the memory may instead be parked for reuse, and only
+     * returned to the upstream allocator once it is released.
      *
      * @param ptr   Address of the memory to be deallcoated.
      * @param len   Number of type T to deallocate.
      */
     void deallocate(T* ptr, std::size_t len)
     {
-        _state->serialized_remove_allocation(ptr, len * sizeof(T));
+        auto& state = details::no_swap_allocator_state::get_state_object();
+        if constexpr (details::can_park_blocks<upstream_allocator>()) {
+            if (state.concurrent_park_allocation(ptr, len * sizeof(T), &release_parked)) {
+                return;
+            }
+        }
+        state.concurrent_remove_allocation(ptr, len * sizeof(T));
         _upstream_allocator.deallocate(ptr, len);
     }
 
+    /**
+     * @brief
+     * Allocate a batch of single objects.  Either all objects are allocated or none are.
+     *
+     * No mutex is taken unless pages have to be locked.
+     *
+     * @param n     Number of objects to allocate.
+     * @param out   Array of at least `n` pointers to receive the addresses of the objects.
+     */
+    void allocate_batch(std::size_t n, T** out)
+    {
+        details::allocate_batch(_upstream_allocator, n, out);
+        try {
+            details::no_swap_allocator_state::get_state_object().concurrent_add_allocations(out, n, sizeof(T));
+        } catch (...) {
+            details::deallocate_batch(_upstream_allocator, out, n);
+            throw;
+        }
+    }
+
+    /**
+     * @brief
+     * Deallocate a batch of single objects.
+     *
+     * No mutex is taken unless pages have to be unlocked.
+     *
+     * @param ptrs  Array of the addresses of the objects.
+     * @param n     Number of objects to deallocate.
+     */
+    void deallocate_batch(T* const* ptrs, std::size_t n)
+    {
+        details::no_swap_allocator_state::get_state_object().concurrent_remove_allocations(ptrs, n, sizeof(T));
+        details::deallocate_batch(_upstream_allocator, ptrs, n);
+    }
+
+    /**
+     * @brief
+     * Check if memory allocated by one allocator can be deallocated by another.
+     *
+     * The allocated pages state is process wide, so this only depends on the upstream allocators.
+     *
+     * @tparam U    The alternate type for the allocator being compared with.
+     * @tparam B    The upstream allocator type of the allocator being compared with.
+     *
+     * @param other     The allocator being compared with.
+     *
+     * @return  Whether or not the upstream allocators are equal.
+     */
+    template <typename U, typename B>
+    bool operator==(const concurrent_no_swap_allocator<U, B>& other) const noexcept
+    {
+        return _upstream_allocator == other._upstream_allocator;
+    }
+
   private:
-    /// @brief Shared pointer to the allocated pages state.
-    std::shared_ptr<details::no_swap_allocator_state> _state{details::no_swap_allocator_state::get_state_object()};
-    upstream_allocator _upstream_allocator{};    ///< @brief The real allocator that will manage the actual memory allocations.
+    [[no_unique_address]] upstream_allocator _upstream_allocator{};    ///< @brief The real allocator that will manage the actual memory allocations.
+
+    /**
+     * @brief
+     * Return a block parked by the no swap allocator state to a default constructed upstream
+     * allocator.
+     *
+     * @param ptr   Address of the block.
+     * @param len   Number of bytes in the block.
+     */
+    static void release_parked(void* ptr, std::size_t len)
+    {
+        upstream_allocator upstream{};
+        upstream.deallocate(static_cast<T*>(ptr), len / sizeof(T));
+    }
 
     template <typename, typename>
-    friend class serialized_no_swap_allocator;
+    friend class concurrent_no_swap_allocator;
+};
+
+#if __cplusplus >= 201603L
+namespace pmr {
+
+/**
+ * @brief
+ * This is a `std::pmr::memory_resource` that prevents the memory it hands out from being swapped
+ * out to disk.
+ *
+ * Memory is obtained from an upstream resource and its pages are locked to RAM in the same way
+ * and with the same shared page tracking as `ec::serialized_no_swap_allocator<>`, so the two may
+ * be freely mixed.  It is safe to use in multi-threaded applications.
+ *
+ * Typically this sits upstream of one of the standard pooling resources so that whole arenas are
+ * locked at once:
+ *
+ * @code
+ * ec::pmr::no_swap_resource no_swap;
+ * std::pmr::monotonic_buffer_resource arena{&no_swap};
+ * std::pmr::string password{read_from_console(), &arena};  // password locked to RAM.
+ * @endcode
+ *
+ * Important note: The same Short String Optimization (SSO) caveats as for
+ *                 `ec::serialized_no_swap_allocator<>` apply.
+ */
+class no_swap_resource: public std::pmr::memory_resource {
+  public:
+    /**
+     * @brief
+     * Constructor.
+     *
+     * @param upstream  The resource that will manage the actual memory allocations.
+     */
+    explicit no_swap_resource(std::pmr::memory_resource* upstream = std::pmr::get_default_resource()) noexcept:
+        _upstream{upstream}
+    {}
+
+    /// @brief Copying is not allowed, just like the standard resources.
+    no_swap_resource(const no_swap_resource&) = delete;
+    /// @brief Copying is not allowed, just like the standard resources.
+    no_swap_resource& operator=(const no_swap_resource&) = delete;
+
+    /**
+     * @brief
+     * Get the upstream resource.
+     *
+     * @return  The resource that manages the actual memory allocations.
+     */
+    std::pmr::memory_resource* upstream_resource() const noexcept { return _upstream; }
+
+  protected:
+    /**
+     * @brief
+     * Allocate memory from the upstream resource and lock it to RAM.
+     *
+     * @param len       Number of bytes to allocate.
+     * @param alignment Required alignment of the memory.
+     *
+     * @return  Address of the allocated memory.
+     */
+    void* do_allocate(std::size_t len, std::size_t alignment) override;
+
+    /**
+     * @brief
+     * Unlock memory so that it can be swapped and return it to the upstream resource.
+     *
+     * @param ptr       Address of the memory to be deallocated.
+     * @param len       Number of bytes to deallocate.
+     * @param alignment Alignment the memory was allocated with.
+     */
+    void do_deallocate(void* ptr, std::size_t len, std::size_t alignment) override;
+
+    /**
+     * @brief
+     * Check if memory allocated from this resource can be deallocated by another one.
+     *
+     * @param other     The other resource.
+     *
+     * @return  Whether or not the resources are interchangeable.
+     */
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+  private:
+    std::pmr::memory_resource* _upstream;   ///< @brief The resource that manages the actual memory allocations.
 };
 
+} // namespace pmr
+#endif
+
 } // namespace ec
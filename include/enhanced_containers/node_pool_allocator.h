@@ -0,0 +1,446 @@
+/**
+ * @file
+ * Allocator adapter that carves single object allocations out of larger upstream chunks.
+ *
+ * @copyright 2023 Steve Kinneberg <steve.kinneberg@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <enhanced_containers/details/allocate_batch.h>
+#include <enhanced_containers/details/common.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace ec {
+namespace details {
+/**
+ * @internal @brief
+ * Free lists of fixed size blocks carved out of chunks allocated from an upstream allocator.
+ *
+ * Each block size has its own free list and its own chunks.  Chunks start out at
+ * `min_chunk_size` bytes and double in size up to `max_chunk_size` bytes as a block size keeps
+ * needing more, so small containers stay small while large ones only need a handful of chunks.
+ * Chunks are returned to the upstream allocator when the pool is destroyed.
+ *
+ * @tparam A    Upstream allocator of `std::max_align_t`.
+ */
+template <typename A>
+class node_pool {
+  public:
+    /// @brief Size of the first chunk allocated for a block size.
+    static constexpr std::size_t min_chunk_size{4096};
+    /// @brief Size of the largest chunks.
+    static constexpr std::size_t max_chunk_size{1024 * 1024};
+    /// @brief Largest block size served from chunks.
+    static constexpr std::size_t max_block_size{max_chunk_size / 16};
+
+    /**
+     * @brief
+     * Constructor.
+     *
+     * @param upstream  The allocator to get chunks from.
+     */
+    explicit node_pool(const A& upstream):
+        _upstream_allocator(upstream)
+    {}
+
+    /// @brief Copying is not allowed.
+    node_pool(const node_pool&) = delete;
+    /// @brief Copying is not allowed.
+    node_pool& operator=(const node_pool&) = delete;
+
+    /// @brief Destructor - returns all chunks to the upstream allocator.
+    ~node_pool()
+    {
+        for (auto [ptr, count] : _chunks) {
+            _upstream_allocator.deallocate(ptr, count);
+        }
+    }
+
+    /**
+     * @brief
+     * Allocate a batch of blocks.
+     *
+     * @tparam T    The type the blocks are for.
+     *
+     * @param block_size    Size of the blocks.  Must not exceed `max_block_size`.
+     * @param n             Number of blocks to allocate.
+     * @param out           Array of at least `n` pointers to receive the addresses of the blocks.
+     */
+    template <typename T>
+    void allocate_batch(std::size_t block_size, std::size_t n, T** out)
+    {
+        std::lock_guard lk{_mutex};
+        auto& sc = get_class(block_size);
+        std::size_t i = 0;
+        try {
+            for (; i < n; ++i) {
+                out[i] = static_cast<T*>(take_block(sc));
+            }
+        } catch (...) {
+            while (i > 0) {
+                put_block(sc, out[--i]);
+            }
+            throw;
+        }
+    }
+
+    /**
+     * @brief
+     * Deallocate a batch of blocks.
+     *
+     * @tparam T    The type the blocks are for.
+     *
+     * @param block_size    Size of the blocks.
+     * @param ptrs          Array of the addresses of the blocks.
+     * @param n             Number of blocks to deallocate.
+     */
+    template <typename T>
+    void deallocate_batch(std::size_t block_size, T* const* ptrs, std::size_t n)
+    {
+        std::lock_guard lk{_mutex};
+        auto& sc = get_class(block_size);
+        for (std::size_t i = 0; i < n; ++i) {
+            put_block(sc, ptrs[i]);
+        }
+    }
+
+    /**
+     * @brief
+     * Get the number of chunks allocated from the upstream allocator.
+     *
+     * @return  Number of chunks.
+     */
+    std::size_t chunk_count()
+    {
+        std::lock_guard lk{_mutex};
+        return _chunks.size();
+    }
+
+  private:
+    /// @brief Type alias for the chunk element type.
+    using chunk_type = typename std::allocator_traits<A>::value_type;
+
+    /// @brief A free block.
+    struct free_block {
+        free_block* next;   ///< @brief Next free block of the same size.
+    };
+
+    /// @brief Free list and current chunk of a single block size.
+    struct size_class {
+        std::size_t block_size;             ///< @brief Size of the blocks.
+        std::size_t next_chunk_size;        ///< @brief Size of the next chunk to allocate.
+        free_block* free_list{};            ///< @brief Blocks that have been freed.
+        std::byte* cursor{};                ///< @brief Next never used block in the current chunk.
+        std::byte* end{};                   ///< @brief End of the current chunk.
+    };
+
+    /// @brief Mutex to protect the pool, since copies of an allocator may be used concurrently.
+    std::mutex _mutex;
+
+    [[no_unique_address]] A _upstream_allocator;    ///< @brief The allocator the chunks come from.
+
+    /// @brief The block sizes in use.  Containers rarely use more than two.
+    std::vector<size_class> _classes;
+
+    /// @brief Chunks allocated from upstream and their lengths in `chunk_type` units.
+    std::vector<std::pair<chunk_type*, std::size_t>> _chunks;
+
+    /**
+     * @brief
+     * Get the size class of a block size, adding it if necessary.
+     *
+     * @param block_size    Size of the blocks.
+     *
+     * @return  The size class.
+     */
+    size_class& get_class(std::size_t block_size)
+    {
+        for (auto& sc : _classes) {
+            if (sc.block_size == block_size) {
+                return sc;
+            }
+        }
+        return _classes.emplace_back(size_class{block_size, std::max(min_chunk_size, block_size)});
+    }
+
+    /**
+     * @brief
+     * Take a block from a size class, allocating a new chunk if needed.
+     *
+     * @param sc    The size class.
+     *
+     * @return  Address of the block.
+     */
+    void* take_block(size_class& sc)
+    {
+        if (sc.free_list != nullptr) {
+            return std::exchange(sc.free_list, sc.free_list->next);
+        }
+        if (static_cast<std::size_t>(sc.end - sc.cursor) < sc.block_size) {
+            auto count = sc.next_chunk_size / sizeof(chunk_type);
+            _chunks.reserve(_chunks.size() + 1);
+            auto* chunk = _upstream_allocator.allocate(count);
+            _chunks.emplace_back(chunk, count);
+            sc.cursor = reinterpret_cast<std::byte*>(chunk);
+            sc.end = sc.cursor + count * sizeof(chunk_type);
+            sc.next_chunk_size = std::min(sc.next_chunk_size * 2, max_chunk_size);
+        }
+        return std::exchange(sc.cursor, sc.cursor + sc.block_size);
+    }
+
+    /**
+     * @brief
+     * Put a block back on the free list of its size class.
+     *
+     * @param sc    The size class.
+     * @param ptr   Address of the block.
+     */
+    static void put_block(size_class& sc, void* ptr) noexcept
+    {
+        auto* block = ::new (ptr) free_block{};
+        block->next = std::exchange(sc.free_list, block);
+    }
+};
+} // namespace details
+
+/**
+ * @brief
+ * This is a C++ STL compatible allocator adapter that serves single object allocations, as made
+ * by node based containers, from a pool of larger chunks allocated from the upstream allocator.
+ *
+ * Layered over one of the no swap allocators, this means that the upstream allocator locks and
+ * tracks a handful of chunks rather than every node.  Allocations of more than one object are
+ * passed straight through to the upstream allocator.
+ *
+ * Each default constructed allocator gets its own pool which is shared by copies and rebound
+ * copies of it, and released when the last of them is destroyed.  Copy constructing a container
+ * gives the new container its own pool.  Memory returned to the pool is neither wiped nor
+ * returned to the upstream allocator until the pool is destroyed, so put an
+ * `ec::zero_on_release_allocator<>` on top for secrets.  See `ec::node_pooled_secure_allocator<>`.
+ *
+ * It supports `allocate_batch()` and `deallocate_batch()` to allocate many nodes at once.
+ *
+ * @tparam T    The type being allocated.
+ * @tparam A    The actual allocator being wrapped.
+ */
+template <typename T, typename A = std::allocator<T>>
+struct node_pool_allocator {
+  private:
+    /// @brief Type alias for the upstream allocator.
+    using upstream_allocator = A;
+    /// @brief Alias for allocator traits.
+    using upstream_traits = std::allocator_traits<upstream_allocator>;
+    /// @brief Type alias for the pool shared by all rebound forms of the allocator.
+    using pool_type = details::node_pool<typename upstream_traits::template rebind_alloc<std::max_align_t>>;
+
+  public:
+    /// @brief Type alias for the type being allocated.
+    using value_type = typename upstream_traits::value_type;
+    /// @brief Type alias for the type representing the size of allocations.
+    using size_type = typename upstream_traits::size_type;
+    /// @brief Type alias for the type representing the distance between pointers.
+    using difference_type = typename upstream_traits::difference_type;
+    /// @brief Compile-time indication about how to handle the allocator when copying containers.
+    using propagate_on_container_copy_assignment = std::false_type;
+    /// @brief Compile-time indication about how to handle the allocator when moving containers.
+    using propagate_on_container_move_assignment = std::true_type;
+    /// @brief Compile-time indication about how to handle the allocator when swapping containers.
+    using propagate_on_container_swap = std::true_type;
+    /**
+     * @brief Compile-time indication about how whether different instances of the allocator are
+     * considered the same or not.
+     */
+    using is_always_equal = std::false_type;
+
+    /// @brief Size of the blocks single objects are allocated in.
+    static constexpr std::size_t block_size{(std::max(sizeof(T), sizeof(void*)) + alignof(void*) - 1) &
+                                            ~(alignof(void*) - 1)};
+
+    /**
+     * @internal @brief
+     * Define the rebind struct so that std::allocator_traits knows how to properly apply new
+     * template parameter values.
+     */
+    template <typename U, typename... Us>
+    struct rebind {
+        /// @brief The rebound allocator type.
+        using other = node_pool_allocator<U, typename upstream_traits::template rebind_alloc<U, Us...>>;
+    };
+
+    /// @brief Default constructor.  Creates a new pool.
+    node_pool_allocator():
+        node_pool_allocator(upstream_allocator{})
+    {}
+
+    /**
+     * @brief
+     * Constructor to create a new pool over a specific upstream allocator.
+     *
+     * @param upstream  The allocator that will manage the actual memory allocations.
+     */
+    explicit node_pool_allocator(const upstream_allocator& upstream):
+        _upstream_allocator(upstream),
+        _pool{std::make_shared<pool_type>(typename upstream_traits::template rebind_alloc<std::max_align_t>(upstream))}
+    {}
+
+    /**
+     * @brief
+     * Copy constructor.  Shares the pool.
+     *
+     * There is deliberately no move constructor, since a moved-from container must still be able
+     * to allocate.
+     */
+    node_pool_allocator(const node_pool_allocator&) = default;
+
+    /**
+     * @brief
+     * Constructor to copy from an alternate allocation type.  Shares the pool.
+     *
+     * @tparam Ts   The type parameters for the alternate form to copy from.
+     *
+     * @param other     The allocator being copied from.
+     */
+    template <typename... Ts>
+    node_pool_allocator(const node_pool_allocator<Ts...>& other):
+        _upstream_allocator(other._upstream_allocator),
+        _pool{other._pool}
+    {}
+
+    /// @brief Copy assignment.  Shares the pool.
+    node_pool_allocator& operator=(const node_pool_allocator&) = default;
+
+    /**
+     * @brief
+     * Get the allocator for a copy of a container.
+     *
+     * @return  An allocator with a new pool over the same upstream allocator.
+     */
+    node_pool_allocator select_on_container_copy_construction() const
+    {
+        return node_pool_allocator{_upstream_allocator};
+    }
+
+    /**
+     * @brief
+     * Allocate the requested amount of memory.
+     *
+     * @param len   Number of type T to allocate.
+     *
+     * @return  Address of the allocated memory.
+     */
+    EC_NODISCARD
+    T* allocate(std::size_t len)
+    {
+        if (len != 1 || !pooled) {
+            return _upstream_allocator.allocate(len);
+        }
+        T* ptr;
+        _pool->allocate_batch(block_size, 1, &ptr);
+        return ptr;
+    }
+
+    /**
+     * @brief
+     * Deallocate a block of memory.
+     *
+     * @param ptr   Address of the memory to be deallcoated.
+     * @param len   Number of type T to deallocate.
+     */
+    void deallocate(T* ptr, std::size_t len)
+    {
+        if (len != 1 || !pooled) {
+            _upstream_allocator.deallocate(ptr, len);
+            return;
+        }
+        _pool->deallocate_batch(block_size, &ptr, 1);
+    }
+
+    /**
+     * @brief
+     * Allocate a batch of single objects.  Either all objects are allocated or none are.
+     *
+     * @param n     Number of objects to allocate.
+     * @param out   Array of at least `n` pointers to receive the addresses of the objects.
+     */
+    void allocate_batch(std::size_t n, T** out)
+    {
+        if constexpr (pooled) {
+            _pool->allocate_batch(block_size, n, out);
+        } else {
+            details::allocate_batch(_upstream_allocator, n, out);
+        }
+    }
+
+    /**
+     * @brief
+     * Deallocate a batch of single objects.
+     *
+     * @param ptrs  Array of the addresses of the objects.
+     * @param n     Number of objects to deallocate.
+     */
+    void deallocate_batch(T* const* ptrs, std::size_t n)
+    {
+        if constexpr (pooled) {
+            _pool->deallocate_batch(block_size, ptrs, n);
+        } else {
+            details::deallocate_batch(_upstream_allocator, ptrs, n);
+        }
+    }
+
+    /**
+     * @brief
+     * Get the number of chunks the pool has allocated from the upstream allocator.
+     *
+     * @return  Number of chunks.
+     */
+    std::size_t chunk_count() const { return _pool->chunk_count(); }
+
+    /**
+     * @brief
+     * Check if memory allocated by one allocator can be deallocated by another.
+     *
+     * @tparam Ts   The type parameters for the alternate form being compared with.
+     *
+     * @param other     The allocator being compared with.
+     *
+     * @return  Whether or not the allocators share a pool.
+     */
+    template <typename... Ts>
+    bool operator==(const node_pool_allocator<Ts...>& other) const noexcept
+    {
+        return _pool == other._pool;
+    }
+
+  private:
+    /// @brief Whether or not single objects of type T come from the pool.
+    static constexpr bool pooled{block_size <= pool_type::max_block_size &&
+                                 alignof(T) <= alignof(std::max_align_t)};
+
+    [[no_unique_address]] upstream_allocator _upstream_allocator;   ///< @brief The real allocator that will manage the actual memory allocations.
+    std::shared_ptr<pool_type> _pool;                               ///< @brief The pool shared by copies of this allocator.
+
+    template <typename, typename>
+    friend struct node_pool_allocator;
+};
+
+} // namespace ec
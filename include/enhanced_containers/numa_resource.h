@@ -0,0 +1,210 @@
+/**
+ * @file
+ * Secure memory resources that keep memory local to a NUMA node.
+ *
+ * @copyright 2023 Steve Kinneberg <steve.kinneberg@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstddef>
+
+#if __cplusplus >= 201603L
+#include <memory_resource>
+#endif
+
+namespace ec {
+
+#if __cplusplus >= 201603L
+namespace pmr {
+
+/// @brief Highest number of NUMA nodes that get their own arena.
+constexpr unsigned max_numa_nodes = 64;
+
+/**
+ * @brief
+ * Get the NUMA node of the CPU the calling thread is running on.
+ *
+ * @return  The node number, or 0 if the platform has no notion of NUMA nodes.
+ */
+unsigned current_numa_node() noexcept;
+
+/**
+ * @brief
+ * This is a `std::pmr::memory_resource` that maps whole pages of memory from one NUMA node and
+ * locks them to RAM.
+ *
+ * The memory policy is set before the pages are first touched, so locking them faults them in on
+ * the node and, being locked, they are never migrated afterwards.  The node is only preferred: if
+ * it has run out of memory, or has none that this process may use, pages come from another node
+ * rather than the allocation failing.
+ *
+ * Every allocation is its own mapping rounded up to whole pages, so it is meant to sit upstream of
+ * a pooling resource, such as in the arenas from `ec::pmr::get_numa_local_resource()`.  It does not
+ * zero out memory itself, since the pages are returned to the OS which clears them before reuse.
+ */
+class numa_node_resource: public std::pmr::memory_resource {
+  public:
+    /**
+     * @brief
+     * Constructor.
+     *
+     * @param node  The NUMA node to allocate memory from.  Allocating fails unless it is below
+     *              `ec::pmr::max_numa_nodes`.
+     */
+    explicit numa_node_resource(unsigned node) noexcept:
+        _node{node}
+    {}
+
+    /// @brief Copying is not allowed, just like the standard resources.
+    numa_node_resource(const numa_node_resource&) = delete;
+    /// @brief Copying is not allowed, just like the standard resources.
+    numa_node_resource& operator=(const numa_node_resource&) = delete;
+
+    /**
+     * @brief
+     * Get the NUMA node.
+     *
+     * @return  The NUMA node memory is allocated from.
+     */
+    unsigned node() const noexcept { return _node; }
+
+  protected:
+    /**
+     * @brief
+     * Map memory on the NUMA node and lock it to RAM.
+     *
+     * @param len       Number of bytes to allocate.
+     * @param alignment Required alignment of the memory.  At most the page size.
+     *
+     * @return  Address of the allocated memory.
+     *
+     * @throws std::out_of_range if the node is not below `ec::pmr::max_numa_nodes`.
+     */
+    void* do_allocate(std::size_t len, std::size_t alignment) override;
+
+    /**
+     * @brief
+     * Unlock memory and return it to the OS.
+     *
+     * @param ptr       Address of the memory to be deallocated.
+     * @param len       Number of bytes to deallocate.
+     * @param alignment Alignment the memory was allocated with.
+     */
+    void do_deallocate(void* ptr, std::size_t len, std::size_t alignment) override;
+
+    /**
+     * @brief
+     * Check if memory allocated from this resource can be deallocated by another one.
+     *
+     * @param other     The other resource.
+     *
+     * @return  Whether or not the resources are interchangeable.
+     */
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+  private:
+    unsigned _node;     ///< @brief The NUMA node memory is allocated from.
+};
+
+/**
+ * @brief
+ * Get the process wide secure arena of a NUMA node.
+ *
+ * The arena is a `std::pmr::synchronized_pool_resource` over an `ec::pmr::numa_node_resource`,
+ * with memory zeroed out as it is deallocated back into the pool.  Each node's arena is created on
+ * first use and intentionally never destroyed so that it outlives any global (static) scope
+ * containers that use it.
+ *
+ * @param node  The NUMA node.
+ *
+ * @return  The secure arena of the node.
+ *
+ * @throws std::out_of_range if `node` is not below `ec::pmr::max_numa_nodes`.
+ */
+std::pmr::memory_resource* get_numa_local_resource(unsigned node);
+
+/**
+ * @brief
+ * Get the process wide secure arena of the NUMA node the calling thread is running on.
+ *
+ * @return  The secure arena of the current node.
+ */
+inline std::pmr::memory_resource* get_numa_local_resource()
+{
+    return get_numa_local_resource(current_numa_node() % max_numa_nodes);
+}
+
+/**
+ * @brief
+ * This is a `std::pmr::polymorphic_allocator<>` that defaults to the secure arena of the NUMA
+ * node the constructing thread is running on.
+ *
+ * The node is picked once, when the allocator is constructed.  A container keeps its allocator
+ * when it is moved or when its allocator is rebound for nodes and buckets, so a container created
+ * on one of a node's worker threads allocates from that node for its whole life, wherever it is
+ * used afterwards.  A container copy constructed from one using this allocator gets the arena of
+ * the node the copying thread is running on.
+ *
+ * @tparam T    The type being allocated.
+ */
+template <typename T>
+class numa_secure_allocator: public std::pmr::polymorphic_allocator<T> {
+  public:
+    /// @brief Default constructor - allocates from `ec::pmr::get_numa_local_resource()`.
+    numa_secure_allocator():
+        std::pmr::polymorphic_allocator<T>{get_numa_local_resource()}
+    {}
+
+    /**
+     * @brief
+     * Constructor to allocate from a specific resource.
+     *
+     * @param resource  The resource to allocate from.  Should be a secure resource or have one
+     *                  upstream of it.
+     */
+    numa_secure_allocator(std::pmr::memory_resource* resource) noexcept:
+        std::pmr::polymorphic_allocator<T>{resource}
+    {}
+
+    /// @brief Copy constructor.
+    numa_secure_allocator(const numa_secure_allocator&) = default;
+
+    /**
+     * @brief
+     * Constructor to copy from an alternate allocation type.
+     *
+     * @tparam U    The alternate type for the allocator being copied from.
+     *
+     * @param other     The allocator being copied from.
+     */
+    template <typename U>
+    numa_secure_allocator(const numa_secure_allocator<U>& other) noexcept:
+        std::pmr::polymorphic_allocator<T>{other.resource()}
+    {}
+
+    /**
+     * @brief
+     * Get the allocator to use for a copy constructed container.
+     *
+     * @return  An allocator using the arena of the current NUMA node.
+     */
+    numa_secure_allocator select_on_container_copy_construction() const { return {}; }
+};
+
+} // namespace pmr
+#endif
+
+} // namespace ec
@@ -20,7 +20,10 @@
 
 #pragma once
 
+#include <enhanced_containers/locked_pool.h>
 #include <enhanced_containers/no_swap_allocator.h>
+#include <enhanced_containers/node_pool_allocator.h>
+#include <enhanced_containers/numa_resource.h>
 #include <enhanced_containers/zero_on_release_allocator.h>
 
 namespace ec {
@@ -58,6 +61,40 @@ namespace ec {
 template <typename T, typename A = std::allocator<T>>
 using serialized_secure_allocator = zero_on_release_allocator<T, serialized_no_swap_allocator<T, A>>;
 
+/**
+ * @brief
+ * This is a C++ STL compatible allocator adapter that will ensure that the allocated memory is
+ * zeroed out on deallocation.
+ *
+ * It is actually a composition of the `ec::zero_on_release_allocator<>` and
+ * `ec::concurrent_no_swap_allocator<>` defined in such a way as to ensure that deallocated memory
+ * gets zeroed out before it gets unlocked.
+ *
+ * This version keeps a lock-free reference count per page, so it is safe to use in multi-threaded
+ * applications and only the first allocation on a page and the last deallocation from it take a
+ * mutex.
+ *
+ * @code
+ * if (condition) {
+ *     std::basic_string<char, std::char_traits<char>, ec::concurrent_secure_allocator<char>> password = read_from_console();
+ *     // password locked to RAM.
+ *     process_password(password);  // Takes a std::string_view.
+ *  }  // password destroyed - memory automatically zeroed out here and can be swapped again.
+ * @endcode
+ *
+ * Important note: Some care must be taken with certain containers.  For example, `std::string` is
+ *                 allowed to use an optimization called Short String Optimization (SSO).  This
+ *                 means that for strings below a certain length, the `std::string` implementation
+ *                 may not actually allocate any memory.  Such strings can still be swapped out and
+ *                 will not be zeored out on deallocation.  Whether or not SSO is employed and what
+ *                 the maximum length of a "short string" is, is implementation defined.
+ *
+ * @tparam T    The type being allocated.
+ * @tparam A    The actual allocator being wrapped.
+ */
+template <typename T, typename A = std::allocator<T>>
+using concurrent_secure_allocator = zero_on_release_allocator<T, concurrent_no_swap_allocator<T, A>>;
+
 /**
  * @brief
  * This is a C++ STL compatible allocator adapter that will ensure that the allocated memory is
@@ -91,5 +128,226 @@ using serialized_secure_allocator = zero_on_release_allocator<T, serialized_no_s
 template <typename T, typename A = std::allocator<T>>
 using unserialized_secure_allocator = zero_on_release_allocator<T, unserialized_no_swap_allocator<T, A>>;
 
+/**
+ * @brief
+ * This is a C++ STL compatible allocator adapter that will ensure that the allocated memory is
+ * zeroed out on deallocation.
+ *
+ * It is actually a composition of the `ec::zero_on_release_allocator<>` and
+ * `ec::locked_pool_allocator<>`.  Memory comes from the `ec::locked_pool` which is locked to RAM
+ * in large chunks up front, so once the pool has warmed up allocations and deallocations make no
+ * system calls.  Deallocated memory is zeroed out before it goes back to the pool.
+ *
+ * The pool is thread safe, so this is safe to use in multi-threaded applications.
+ *
+ * @code
+ * if (condition) {
+ *     std::basic_string<char, std::char_traits<char>, ec::pooled_secure_allocator<char>> password = read_from_console();
+ *     // password locked to RAM.
+ *     process_password(password);  // Takes a std::string_view.
+ *  }  // password destroyed - memory automatically zeroed out here and returned to the pool.
+ * @endcode
+ *
+ * Important note: The same Short String Optimization (SSO) caveats as for the other secure
+ *                 allocators apply.
+ *
+ * @tparam T    The type being allocated.
+ */
+template <typename T>
+using pooled_secure_allocator = zero_on_release_allocator<T, locked_pool_allocator<T>>;
+
+/**
+ * @brief
+ * This is a C++ STL compatible allocator adapter for node based containers that ensures that the
+ * allocated memory is zeroed out on deallocation.
+ *
+ * It is actually a composition of the `ec::zero_on_release_allocator<>`,
+ * `ec::node_pool_allocator<>` and `ec::serialized_no_swap_allocator<>`.  Every node is zeroed out
+ * when the container deallocates it, but only the pool's chunks are locked and tracked, so
+ * building a large map or list costs a handful of locked chunks rather than one tracked
+ * allocation per node.  Each container gets its own pool, released when the container is
+ * destroyed.
+ *
+ * It is safe to use in multi-threaded applications.
+ *
+ * @tparam T    The type being allocated.
+ * @tparam A    The actual allocator being wrapped.
+ */
+template <typename T, typename A = std::allocator<T>>
+using node_pooled_secure_allocator = zero_on_release_allocator<T, node_pool_allocator<T, serialized_no_swap_allocator<T, A>>>;
+
+
+#if __cplusplus >= 201603L
+namespace pmr {
+
+/**
+ * @brief
+ * This is a `std::pmr::memory_resource` that prevents the memory it hands out from being swapped
+ * out to disk and ensures that it gets zeroed out on deallocation.
+ *
+ * It is actually a composition of the `ec::pmr::zero_on_release_resource` and
+ * `ec::pmr::no_swap_resource` arranged so that deallocated memory gets zeroed out before it gets
+ * unlocked.  It is safe to use in multi-threaded applications.
+ *
+ * It is intended to sit upstream of one of the standard pooling resources to build request scoped
+ * secure arenas:
+ *
+ * @code
+ * if (condition) {
+ *     ec::pmr::secure_resource secure;
+ *     std::pmr::monotonic_buffer_resource arena{&secure};
+ *     ec::pmr::secure::string password{read_from_console(), &arena};
+ *     process_password(password);  // Takes a std::string_view.
+ *  }  // arena destroyed - all of its memory zeroed out here and can be swapped again.
+ * @endcode
+ *
+ * Important note: A pooling resource layered on top keeps memory that containers deallocate until
+ *                 the pooling resource itself is released or destroyed.  Only then is it zeroed
+ *                 out, so keep such arenas short lived.
+ */
+class secure_resource: public std::pmr::memory_resource {
+  public:
+    /**
+     * @brief
+     * Constructor.
+     *
+     * @param upstream  The resource that will manage the actual memory allocations.
+     */
+    explicit secure_resource(std::pmr::memory_resource* upstream = std::pmr::get_default_resource()) noexcept:
+        _no_swap{upstream}
+    {}
+
+    /// @brief Copying is not allowed, just like the standard resources.
+    secure_resource(const secure_resource&) = delete;
+    /// @brief Copying is not allowed, just like the standard resources.
+    secure_resource& operator=(const secure_resource&) = delete;
+
+    /**
+     * @brief
+     * Get the upstream resource.
+     *
+     * @return  The resource that manages the actual memory allocations.
+     */
+    std::pmr::memory_resource* upstream_resource() const noexcept { return _no_swap.upstream_resource(); }
+
+  protected:
+    /**
+     * @brief
+     * Allocate memory from the upstream resource and lock it to RAM.
+     *
+     * @param len       Number of bytes to allocate.
+     * @param alignment Required alignment of the memory.
+     *
+     * @return  Address of the allocated memory.
+     */
+    void* do_allocate(std::size_t len, std::size_t alignment) override
+    {
+        return _zero_on_release.allocate(len, alignment);
+    }
+
+    /**
+     * @brief
+     * Zero out memory, unlock it so that it can be swapped and return it to the upstream resource.
+     *
+     * @param ptr       Address of the memory to be deallocated.
+     * @param len       Number of bytes to deallocate.
+     * @param alignment Alignment the memory was allocated with.
+     */
+    void do_deallocate(void* ptr, std::size_t len, std::size_t alignment) override
+    {
+        _zero_on_release.deallocate(ptr, len, alignment);
+    }
+
+    /**
+     * @brief
+     * Check if memory allocated from this resource can be deallocated by another one.
+     *
+     * @param other     The other resource.
+     *
+     * @return  Whether or not the resources are interchangeable.
+     */
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+    {
+        const auto* that = dynamic_cast<const secure_resource*>(&other);
+        return that != nullptr && upstream_resource()->is_equal(*that->upstream_resource());
+    }
+
+  private:
+    no_swap_resource _no_swap;                                  ///< @brief Locks the memory to RAM.
+    zero_on_release_resource _zero_on_release{&_no_swap};       ///< @brief Zeros out the memory.
+};
+
+/**
+ * @brief
+ * Get the process wide secure resource.
+ *
+ * Its upstream is `std::pmr::new_delete_resource()` so that it may itself be installed as the
+ * default resource.  It is intentionally never destroyed so that it outlives any global (static)
+ * scope containers that use it.
+ *
+ * @return  The process wide secure resource.
+ */
+inline secure_resource* get_secure_resource()
+{
+    static secure_resource* self{new secure_resource{std::pmr::new_delete_resource()}};
+    return self;
+}
+
+/**
+ * @brief
+ * This is a `std::pmr::polymorphic_allocator<>` that defaults to `ec::pmr::get_secure_resource()`
+ * instead of the default resource.
+ *
+ * A container copy constructed from one using this allocator gets the process wide secure
+ * resource rather than the default resource, so copies never silently leave secure memory.
+ *
+ * @tparam T    The type being allocated.
+ */
+template <typename T>
+class secure_allocator: public std::pmr::polymorphic_allocator<T> {
+  public:
+    /// @brief Default constructor - allocates from `ec::pmr::get_secure_resource()`.
+    secure_allocator() noexcept:
+        std::pmr::polymorphic_allocator<T>{get_secure_resource()}
+    {}
+
+    /**
+     * @brief
+     * Constructor to allocate from a specific resource.
+     *
+     * @param resource  The resource to allocate from.  Should be a secure resource or have one
+     *                  upstream of it.
+     */
+    secure_allocator(std::pmr::memory_resource* resource) noexcept:
+        std::pmr::polymorphic_allocator<T>{resource}
+    {}
+
+    /// @brief Copy constructor.
+    secure_allocator(const secure_allocator&) = default;
+
+    /**
+     * @brief
+     * Constructor to copy from an alternate allocation type.
+     *
+     * @tparam U    The alternate type for the allocator being copied from.
+     *
+     * @param other     The allocator being copied from.
+     */
+    template <typename U>
+    secure_allocator(const secure_allocator<U>& other) noexcept:
+        std::pmr::polymorphic_allocator<T>{other.resource()}
+    {}
+
+    /**
+     * @brief
+     * Get the allocator to use for a copy constructed container.
+     *
+     * @return  An allocator using the process wide secure resource.
+     */
+    secure_allocator select_on_container_copy_construction() const noexcept { return {}; }
+};
+
+} // namespace pmr
+#endif
 
 } // namespace ec
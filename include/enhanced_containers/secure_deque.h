@@ -45,3 +45,51 @@ namespace ec::serialized_secure {
 template <typename T, typename Allocator = std::allocator<T>>
 using deque = std::deque<T, ec::serialized_secure_allocator<T, Allocator>>;
 }
+
+namespace ec::concurrent_secure {
+/**
+ * @brief
+ * Alias of `std::deque<>` that wraps the real alloctor with `ec::concurrent_secure_allocator<>`.
+ *
+ * @tparam T            The value type stored in the deque.
+ * @tparam Allocator    The real allocator (default: `std:allocator<T>`).
+ */
+template <typename T, typename Allocator = std::allocator<T>>
+using deque = std::deque<T, ec::concurrent_secure_allocator<T, Allocator>>;
+}
+
+namespace ec::pooled_secure {
+/**
+ * @brief
+ * Alias of `std::deque<>` that allocates from the locked pool with
+ * `ec::pooled_secure_allocator<>`.
+ *
+ * @tparam T            The value type stored in the deque.
+ */
+template <typename T>
+using deque = std::deque<T, ec::pooled_secure_allocator<T>>;
+}
+
+namespace ec::pmr::secure {
+/**
+ * @brief
+ * Alias of `std::deque<>` that allocates from a memory resource with
+ * `ec::pmr::secure_allocator<>`.
+ *
+ * @tparam T            The value type stored in the deque.
+ */
+template <typename T>
+using deque = std::deque<T, ec::pmr::secure_allocator<T>>;
+}
+
+namespace ec::pmr::numa_secure {
+/**
+ * @brief
+ * Alias of `std::deque<>` that allocates from a memory resource with
+ * `ec::pmr::numa_secure_allocator<>`.
+ *
+ * @tparam T            The value type stored in the deque.
+ */
+template <typename T>
+using deque = std::deque<T, ec::pmr::numa_secure_allocator<T>>;
+}
@@ -0,0 +1,155 @@
+/**
+ * @file
+ * A collection of aliases to `ec::flat_hash_map` that use the secure allocators.
+ *
+ * @copyright 2023 Steve Kinneberg <steve.kinneberg@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <enhanced_containers/flat_hash_map.h>
+#include <enhanced_containers/secure_allocator.h>
+
+namespace ec::unserialized_secure {
+/**
+ * @brief
+ * Alias of `ec::flat_hash_map<>` that wraps the real alloctor with
+ * `ec::unserialized_secure_allocator<>`.
+ *
+ * The whole table is a single locked allocation, instead of one per element plus a bucket array
+ * as with `ec::unserialized_secure::unordered_map<>`.
+ *
+ * @tparam Key          The key type stored in the map.
+ * @tparam T            The value type stored in the map.
+ * @tparam Hash         The hash functor type.
+ * @tparam KeyEqual     The equal functor type for Key.
+ * @tparam Allocator    The real allocator (default: `std:allocator<std::pair<const Key, T>>`).
+ */
+template <typename Key,
+          typename T,
+          typename Hash = std::hash<Key>,
+          typename KeyEqual = std::equal_to<Key>,
+          typename Allocator = std::allocator<std::pair<const Key, T>>>
+using flat_hash_map = ec::flat_hash_map<Key, T, Hash, KeyEqual,
+                                        ec::unserialized_secure_allocator<std::pair<const Key, T>,
+                                                                          Allocator>>;
+}
+
+namespace ec::serialized_secure {
+/**
+ * @brief
+ * Alias of `ec::flat_hash_map<>` that wraps the real alloctor with
+ * `ec::serialized_secure_allocator<>`.
+ *
+ * The whole table is a single locked allocation, instead of one per element plus a bucket array
+ * as with `ec::serialized_secure::unordered_map<>`.
+ *
+ * @tparam Key          The key type stored in the map.
+ * @tparam T            The value type stored in the map.
+ * @tparam Hash         The hash functor type.
+ * @tparam KeyEqual     The equal functor type for Key.
+ * @tparam Allocator    The real allocator (default: `std:allocator<std::pair<const Key, T>>`).
+ */
+template <typename Key,
+          typename T,
+          typename Hash = std::hash<Key>,
+          typename KeyEqual = std::equal_to<Key>,
+          typename Allocator = std::allocator<std::pair<const Key, T>>>
+using flat_hash_map = ec::flat_hash_map<Key, T, Hash, KeyEqual,
+                                        ec::serialized_secure_allocator<std::pair<const Key, T>,
+                                                                        Allocator>>;
+}
+
+namespace ec::concurrent_secure {
+/**
+ * @brief
+ * Alias of `ec::flat_hash_map<>` that wraps the real alloctor with
+ * `ec::concurrent_secure_allocator<>`.
+ *
+ * The whole table is a single locked allocation, instead of one per element plus a bucket array
+ * as with `ec::concurrent_secure::unordered_map<>`.
+ *
+ * @tparam Key          The key type stored in the map.
+ * @tparam T            The value type stored in the map.
+ * @tparam Hash         The hash functor type.
+ * @tparam KeyEqual     The equal functor type for Key.
+ * @tparam Allocator    The real allocator (default: `std:allocator<std::pair<const Key, T>>`).
+ */
+template <typename Key,
+          typename T,
+          typename Hash = std::hash<Key>,
+          typename KeyEqual = std::equal_to<Key>,
+          typename Allocator = std::allocator<std::pair<const Key, T>>>
+using flat_hash_map = ec::flat_hash_map<Key, T, Hash, KeyEqual,
+                                        ec::concurrent_secure_allocator<std::pair<const Key, T>,
+                                                                        Allocator>>;
+}
+
+namespace ec::pooled_secure {
+/**
+ * @brief
+ * Alias of `ec::flat_hash_map<>` that allocates from the locked pool with
+ * `ec::pooled_secure_allocator<>`.
+ *
+ * @tparam Key          The key type stored in the map.
+ * @tparam T            The value type stored in the map.
+ * @tparam Hash         The hash functor type.
+ * @tparam KeyEqual     The equal functor type for Key.
+ */
+template <typename Key,
+          typename T,
+          typename Hash = std::hash<Key>,
+          typename KeyEqual = std::equal_to<Key>>
+using flat_hash_map = ec::flat_hash_map<Key, T, Hash, KeyEqual,
+                                        ec::pooled_secure_allocator<std::pair<const Key, T>>>;
+}
+
+namespace ec::pmr::secure {
+/**
+ * @brief
+ * Alias of `ec::flat_hash_map<>` that allocates from a memory resource with
+ * `ec::pmr::secure_allocator<>`.
+ *
+ * @tparam Key          The key type stored in the map.
+ * @tparam T            The value type stored in the map.
+ * @tparam Hash         The hash functor type.
+ * @tparam KeyEqual     The equal functor type for Key.
+ */
+template <typename Key,
+          typename T,
+          typename Hash = std::hash<Key>,
+          typename KeyEqual = std::equal_to<Key>>
+using flat_hash_map = ec::flat_hash_map<Key, T, Hash, KeyEqual,
+                                        ec::pmr::secure_allocator<std::pair<const Key, T>>>;
+}
+
+namespace ec::pmr::numa_secure {
+/**
+ * @brief
+ * Alias of `ec::flat_hash_map<>` that allocates from a memory resource with
+ * `ec::pmr::numa_secure_allocator<>`.
+ *
+ * @tparam Key          The key type stored in the map.
+ * @tparam T            The value type stored in the map.
+ * @tparam Hash         The hash functor type.
+ * @tparam KeyEqual     The equal functor type for Key.
+ */
+template <typename Key,
+          typename T,
+          typename Hash = std::hash<Key>,
+          typename KeyEqual = std::equal_to<Key>>
+using flat_hash_map = ec::flat_hash_map<Key, T, Hash, KeyEqual,
+                                        ec::pmr::numa_secure_allocator<std::pair<const Key, T>>>;
+}
@@ -0,0 +1,140 @@
+/**
+ * @file
+ * A collection of aliases to `ec::flat_map` that keep their keys and values in secure vectors.
+ *
+ * @copyright 2023 Steve Kinneberg <steve.kinneberg@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <enhanced_containers/flat_map.h>
+#include <enhanced_containers/secure_vector.h>
+
+namespace ec::unserialized_secure {
+/**
+ * @brief
+ * Alias of `ec::flat_map<>` over a pair of `ec::unserialized_secure::vector<>`s.
+ *
+ * The keys and values live in two contiguous locked allocations, which pins far fewer pages than a
+ * node based map and is wiped in one pass per allocation when the map is destroyed.
+ *
+ * @tparam Key          The key type stored in the map.
+ * @tparam T            The value type stored in the map.
+ * @tparam Compare      The comparison functor type.
+ * @tparam Allocator    The real allocator, rebound for the keys and values
+ *                      (default: `std:allocator<Key>`).
+ */
+template <typename Key,
+          typename T,
+          typename Compare = std::less<Key>,
+          typename Allocator = std::allocator<Key>>
+using flat_map = ec::flat_map<
+    Key, T, Compare,
+    vector<Key, typename std::allocator_traits<Allocator>::template rebind_alloc<Key>>,
+    vector<T, typename std::allocator_traits<Allocator>::template rebind_alloc<T>>>;
+}
+
+namespace ec::serialized_secure {
+/**
+ * @brief
+ * Alias of `ec::flat_map<>` over a pair of `ec::serialized_secure::vector<>`s.
+ *
+ * The keys and values live in two contiguous locked allocations, which pins far fewer pages than a
+ * node based map and is wiped in one pass per allocation when the map is destroyed.
+ *
+ * @tparam Key          The key type stored in the map.
+ * @tparam T            The value type stored in the map.
+ * @tparam Compare      The comparison functor type.
+ * @tparam Allocator    The real allocator, rebound for the keys and values
+ *                      (default: `std:allocator<Key>`).
+ */
+template <typename Key,
+          typename T,
+          typename Compare = std::less<Key>,
+          typename Allocator = std::allocator<Key>>
+using flat_map = ec::flat_map<
+    Key, T, Compare,
+    vector<Key, typename std::allocator_traits<Allocator>::template rebind_alloc<Key>>,
+    vector<T, typename std::allocator_traits<Allocator>::template rebind_alloc<T>>>;
+}
+
+namespace ec::concurrent_secure {
+/**
+ * @brief
+ * Alias of `ec::flat_map<>` over a pair of `ec::concurrent_secure::vector<>`s.
+ *
+ * The keys and values live in two contiguous locked allocations, which pins far fewer pages than a
+ * node based map and is wiped in one pass per allocation when the map is destroyed.
+ *
+ * @tparam Key          The key type stored in the map.
+ * @tparam T            The value type stored in the map.
+ * @tparam Compare      The comparison functor type.
+ * @tparam Allocator    The real allocator, rebound for the keys and values
+ *                      (default: `std:allocator<Key>`).
+ */
+template <typename Key,
+          typename T,
+          typename Compare = std::less<Key>,
+          typename Allocator = std::allocator<Key>>
+using flat_map = ec::flat_map<
+    Key, T, Compare,
+    vector<Key, typename std::allocator_traits<Allocator>::template rebind_alloc<Key>>,
+    vector<T, typename std::allocator_traits<Allocator>::template rebind_alloc<T>>>;
+}
+
+namespace ec::pooled_secure {
+/**
+ * @brief
+ * Alias of `ec::flat_map<>` over a pair of `ec::pooled_secure::vector<>`s.
+ *
+ * @tparam Key          The key type stored in the map.
+ * @tparam T            The value type stored in the map.
+ * @tparam Compare      The comparison functor type.
+ */
+template <typename Key,
+          typename T,
+          typename Compare = std::less<Key>>
+using flat_map = ec::flat_map<Key, T, Compare, vector<Key>, vector<T>>;
+}
+
+namespace ec::pmr::secure {
+/**
+ * @brief
+ * Alias of `ec::flat_map<>` over a pair of `ec::pmr::secure::vector<>`s.
+ *
+ * @tparam Key          The key type stored in the map.
+ * @tparam T            The value type stored in the map.
+ * @tparam Compare      The comparison functor type.
+ */
+template <typename Key,
+          typename T,
+          typename Compare = std::less<Key>>
+using flat_map = ec::flat_map<Key, T, Compare, vector<Key>, vector<T>>;
+}
+
+namespace ec::pmr::numa_secure {
+/**
+ * @brief
+ * Alias of `ec::flat_map<>` over a pair of `ec::pmr::numa_secure::vector<>`s.
+ *
+ * @tparam Key          The key type stored in the map.
+ * @tparam T            The value type stored in the map.
+ * @tparam Compare      The comparison functor type.
+ */
+template <typename Key,
+          typename T,
+          typename Compare = std::less<Key>>
+using flat_map = ec::flat_map<Key, T, Compare, vector<Key>, vector<T>>;
+}
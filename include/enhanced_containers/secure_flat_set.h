@@ -0,0 +1,107 @@
+/**
+ * @file
+ * A collection of aliases to `ec::flat_set` that keep their keys in a secure vector.
+ *
+ * @copyright 2023 Steve Kinneberg <steve.kinneberg@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <enhanced_containers/flat_set.h>
+#include <enhanced_containers/secure_vector.h>
+
+namespace ec::unserialized_secure {
+/**
+ * @brief
+ * Alias of `ec::flat_set<>` over an `ec::unserialized_secure::vector<>`.
+ *
+ * @tparam Key          The key type stored in the set.
+ * @tparam Compare      The comparison functor type.
+ * @tparam Allocator    The real allocator (default: `std:allocator<Key>`).
+ */
+template <typename Key,
+          typename Compare = std::less<Key>,
+          typename Allocator = std::allocator<Key>>
+using flat_set = ec::flat_set<Key, Compare, vector<Key, Allocator>>;
+}
+
+namespace ec::serialized_secure {
+/**
+ * @brief
+ * Alias of `ec::flat_set<>` over an `ec::serialized_secure::vector<>`.
+ *
+ * @tparam Key          The key type stored in the set.
+ * @tparam Compare      The comparison functor type.
+ * @tparam Allocator    The real allocator (default: `std:allocator<Key>`).
+ */
+template <typename Key,
+          typename Compare = std::less<Key>,
+          typename Allocator = std::allocator<Key>>
+using flat_set = ec::flat_set<Key, Compare, vector<Key, Allocator>>;
+}
+
+namespace ec::concurrent_secure {
+/**
+ * @brief
+ * Alias of `ec::flat_set<>` over an `ec::concurrent_secure::vector<>`.
+ *
+ * @tparam Key          The key type stored in the set.
+ * @tparam Compare      The comparison functor type.
+ * @tparam Allocator    The real allocator (default: `std:allocator<Key>`).
+ */
+template <typename Key,
+          typename Compare = std::less<Key>,
+          typename Allocator = std::allocator<Key>>
+using flat_set = ec::flat_set<Key, Compare, vector<Key, Allocator>>;
+}
+
+namespace ec::pooled_secure {
+/**
+ * @brief
+ * Alias of `ec::flat_set<>` over an `ec::pooled_secure::vector<>`.
+ *
+ * @tparam Key          The key type stored in the set.
+ * @tparam Compare      The comparison functor type.
+ */
+template <typename Key,
+          typename Compare = std::less<Key>>
+using flat_set = ec::flat_set<Key, Compare, vector<Key>>;
+}
+
+namespace ec::pmr::secure {
+/**
+ * @brief
+ * Alias of `ec::flat_set<>` over an `ec::pmr::secure::vector<>`.
+ *
+ * @tparam Key          The key type stored in the set.
+ * @tparam Compare      The comparison functor type.
+ */
+template <typename Key,
+          typename Compare = std::less<Key>>
+using flat_set = ec::flat_set<Key, Compare, vector<Key>>;
+}
+
+namespace ec::pmr::numa_secure {
+/**
+ * @brief
+ * Alias of `ec::flat_set<>` over an `ec::pmr::numa_secure::vector<>`.
+ *
+ * @tparam Key          The key type stored in the set.
+ * @tparam Compare      The comparison functor type.
+ */
+template <typename Key,
+          typename Compare = std::less<Key>>
+using flat_set = ec::flat_set<Key, Compare, vector<Key>>;
+}
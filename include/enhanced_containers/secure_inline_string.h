@@ -0,0 +1,669 @@
+/**
+ * @file
+ * String with an inline buffer for short secrets that is wiped whenever its contents go away.
+ *
+ * @copyright 2023 Steve Kinneberg <steve.kinneberg@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <enhanced_containers/details/common.h>
+#include <enhanced_containers/secure_allocator.h>
+#include <enhanced_containers/secure_zero.h>
+
+#include <algorithm>
+#include <compare>
+#include <cstddef>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+namespace ec {
+
+/**
+ * @brief
+ * String that keeps up to `N` characters in an inline buffer and wipes that buffer whenever its
+ * contents are cleared, moved out or destroyed.
+ *
+ * `ec::serialized_secure::string` keeps short strings in the `std::basic_string` small string
+ * buffer, which the secure allocator never sees and so never wipes, and forcing them onto the
+ * heap with `reserve()` costs an allocation per secret.  This string instead wipes the inline
+ * buffer itself, and only allocates from `Allocator` once the contents outgrow it.
+ *
+ * The inline buffer lives wherever the string object does, so it is only locked into RAM if the
+ * object is (e.g. when the string is itself a member of a secure container).
+ *
+ * @tparam N            Number of characters, not counting the terminating null, kept inline.
+ * @tparam CharT        The character type.
+ * @tparam Traits       The character traits type.
+ * @tparam Allocator    Allocator used for contents longer than `N`.
+ */
+template <std::size_t N,
+          typename CharT = char,
+          typename Traits = std::char_traits<CharT>,
+          typename Allocator = ec::serialized_secure_allocator<CharT>>
+class basic_secure_inline_string {
+    static_assert(std::is_trivial_v<CharT>, "Character type must be trivial.");
+    static_assert(N > 0, "Inline buffer must hold at least one character.");
+
+    /// @brief Allocator traits.
+    using alloc_traits = std::allocator_traits<Allocator>;
+
+  public:
+    /// @brief Type alias for the character traits type.
+    using traits_type = Traits;
+    /// @brief Type alias for the character type.
+    using value_type = CharT;
+    /// @brief Type alias for the allocator type.
+    using allocator_type = Allocator;
+    /// @brief Type alias for the type representing the size of the string.
+    using size_type = std::size_t;
+    /// @brief Type alias for the type representing the distance between iterators.
+    using difference_type = std::ptrdiff_t;
+    /// @brief Type alias for a reference to a character.
+    using reference = CharT&;
+    /// @brief Type alias for a constant reference to a character.
+    using const_reference = const CharT&;
+    /// @brief Type alias for a pointer to a character.
+    using pointer = CharT*;
+    /// @brief Type alias for a constant pointer to a character.
+    using const_pointer = const CharT*;
+    /// @brief Iterator type.
+    using iterator = CharT*;
+    /// @brief Constant iterator type.
+    using const_iterator = const CharT*;
+    /// @brief Reverse iterator type.
+    using reverse_iterator = std::reverse_iterator<iterator>;
+    /// @brief Constant reverse iterator type.
+    using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+    /// @brief Type alias for the matching string view type.
+    using view_type = std::basic_string_view<CharT, Traits>;
+
+    /// @brief Special value meaning "until the end of the string".
+    static constexpr size_type npos = static_cast<size_type>(-1);
+
+    /// @brief Number of characters kept inline.
+    static constexpr size_type inline_capacity = N;
+
+    /// @brief Default constructor.
+    basic_secure_inline_string() noexcept(noexcept(Allocator())):
+        basic_secure_inline_string(Allocator())
+    {}
+
+    /**
+     * @brief
+     * Construct an empty string with an allocator.
+     *
+     * @param alloc     The allocator.
+     */
+    explicit basic_secure_inline_string(const Allocator& alloc) noexcept:
+        _alloc{alloc}
+    {}
+
+    /**
+     * @brief
+     * Construct a string of repeated characters.
+     *
+     * @param count     Number of characters.
+     * @param ch        The character.
+     * @param alloc     The allocator.
+     */
+    basic_secure_inline_string(size_type count, CharT ch, const Allocator& alloc = Allocator()):
+        basic_secure_inline_string(alloc)
+    {
+        append(count, ch);
+    }
+
+    /**
+     * @brief
+     * Construct from a character array.
+     *
+     * @param s         The characters.
+     * @param count     Number of characters.
+     * @param alloc     The allocator.
+     */
+    basic_secure_inline_string(const CharT* s, size_type count, const Allocator& alloc = Allocator()):
+        basic_secure_inline_string(alloc)
+    {
+        append(s, count);
+    }
+
+    /**
+     * @brief
+     * Construct from a null terminated string.
+     *
+     * @param s         The string.
+     * @param alloc     The allocator.
+     */
+    basic_secure_inline_string(const CharT* s, const Allocator& alloc = Allocator()):
+        basic_secure_inline_string(s, Traits::length(s), alloc)
+    {}
+
+    /**
+     * @brief
+     * Construct from a string view.
+     *
+     * @param sv        The string view.
+     * @param alloc     The allocator.
+     */
+    explicit basic_secure_inline_string(view_type sv, const Allocator& alloc = Allocator()):
+        basic_secure_inline_string(sv.data(), sv.size(), alloc)
+    {}
+
+    /**
+     * @brief
+     * Construct from a range of characters.
+     *
+     * @param first     Start of the range.
+     * @param last      End of the range.
+     * @param alloc     The allocator.
+     */
+    template <std::input_iterator InputIt>
+    basic_secure_inline_string(InputIt first, InputIt last, const Allocator& alloc = Allocator()):
+        basic_secure_inline_string(alloc)
+    {
+        for (; first != last; ++first) {
+            push_back(*first);
+        }
+    }
+
+    /**
+     * @brief
+     * Construct from a list of characters.
+     *
+     * @param init      The characters.
+     * @param alloc     The allocator.
+     */
+    basic_secure_inline_string(std::initializer_list<CharT> init, const Allocator& alloc = Allocator()):
+        basic_secure_inline_string(init.begin(), init.size(), alloc)
+    {}
+
+    /**
+     * @brief
+     * Copy constructor.
+     *
+     * @param other     The string to copy.
+     */
+    basic_secure_inline_string(const basic_secure_inline_string& other):
+        basic_secure_inline_string(other.data(), other.size(),
+                                   alloc_traits::select_on_container_copy_construction(other._alloc))
+    {}
+
+    /**
+     * @brief
+     * Move constructor.
+     *
+     * Heap contents are taken over.  Inline contents are copied and then wiped from `other`.
+     *
+     * @param other     The string to move from.  It is left empty.
+     */
+    basic_secure_inline_string(basic_secure_inline_string&& other) noexcept:
+        _alloc{std::move(other._alloc)}
+    {
+        take(other);
+    }
+
+    /// @brief Destructor.  Wipes the inline buffer.
+    ~basic_secure_inline_string()
+    {
+        release();
+        wipe(_inline, N + 1);
+    }
+
+    /**
+     * @brief
+     * Copy assignment.
+     *
+     * @param other     The string to copy.
+     */
+    basic_secure_inline_string& operator=(const basic_secure_inline_string& other)
+    {
+        if (this != &other) {
+            if constexpr (alloc_traits::propagate_on_container_copy_assignment::value) {
+                if (_alloc != other._alloc) {
+                    release();
+                }
+                _alloc = other._alloc;
+            }
+            assign(other.data(), other.size());
+        }
+        return *this;
+    }
+
+    /**
+     * @brief
+     * Move assignment.
+     *
+     * @param other     The string to move from.  It is left empty.
+     */
+    basic_secure_inline_string& operator=(basic_secure_inline_string&& other)
+        noexcept(alloc_traits::propagate_on_container_move_assignment::value ||
+                 alloc_traits::is_always_equal::value)
+    {
+        if (this == &other) {
+            return *this;
+        }
+        if constexpr (alloc_traits::propagate_on_container_move_assignment::value) {
+            release();
+            _alloc = std::move(other._alloc);
+            take(other);
+        } else if (alloc_traits::is_always_equal::value || _alloc == other._alloc) {
+            release();
+            take(other);
+        } else {
+            assign(other.data(), other.size());
+            other.clear();
+        }
+        return *this;
+    }
+
+    /// @brief Assign a string view.
+    basic_secure_inline_string& operator=(view_type sv) { return assign(sv.data(), sv.size()); }
+    /// @brief Assign a null terminated string.
+    basic_secure_inline_string& operator=(const CharT* s) { return assign(s, Traits::length(s)); }
+
+    /**
+     * @brief
+     * Replace the contents with a character array.
+     *
+     * @param s         The characters.
+     * @param count     Number of characters.
+     *
+     * @return  This string.
+     */
+    basic_secure_inline_string& assign(const CharT* s, size_type count)
+    {
+        if (count > _capacity) {
+            // The source may be part of this string, so grow into a copy before truncating.
+            reallocate(count);
+        }
+        Traits::move(_data, s, count);
+        set_size(count);
+        return *this;
+    }
+
+    /// @copydoc assign(const CharT*, size_type)
+    basic_secure_inline_string& assign(view_type sv) { return assign(sv.data(), sv.size()); }
+
+    /// @brief Get the allocator.
+    allocator_type get_allocator() const noexcept { return _alloc; }
+
+    /**
+     * @brief
+     * Get a character with bounds checking.
+     *
+     * @param pos   Index of the character.
+     *
+     * @return  The character.
+     *
+     * @throws std::out_of_range if `pos` is not less than `size()`.
+     */
+    reference at(size_type pos)
+    {
+        if (pos >= _size) {
+            throw std::out_of_range("ec::basic_secure_inline_string::at");
+        }
+        return _data[pos];
+    }
+
+    /// @copydoc at(size_type)
+    const_reference at(size_type pos) const
+    {
+        if (pos >= _size) {
+            throw std::out_of_range("ec::basic_secure_inline_string::at");
+        }
+        return _data[pos];
+    }
+
+    /// @brief Get a character.
+    reference operator[](size_type pos) noexcept { return _data[pos]; }
+    /// @brief Get a character.
+    const_reference operator[](size_type pos) const noexcept { return _data[pos]; }
+    /// @brief Get the first character.
+    reference front() noexcept { return _data[0]; }
+    /// @brief Get the first character.
+    const_reference front() const noexcept { return _data[0]; }
+    /// @brief Get the last character.
+    reference back() noexcept { return _data[_size - 1]; }
+    /// @brief Get the last character.
+    const_reference back() const noexcept { return _data[_size - 1]; }
+    /// @brief Get the characters.
+    CharT* data() noexcept { return _data; }
+    /// @brief Get the characters.
+    const CharT* data() const noexcept { return _data; }
+    /// @brief Get the characters as a null terminated string.
+    const CharT* c_str() const noexcept { return _data; }
+    /// @brief Get a view of the characters.
+    view_type view() const noexcept { return {_data, _size}; }
+    /// @brief Get a view of the characters.
+    operator view_type() const noexcept { return view(); }
+
+    /// @brief Get an iterator to the first character.
+    iterator begin() noexcept { return _data; }
+    /// @brief Get an iterator to the first character.
+    const_iterator begin() const noexcept { return _data; }
+    /// @brief Get an iterator to the first character.
+    const_iterator cbegin() const noexcept { return _data; }
+    /// @brief Get an iterator past the last character.
+    iterator end() noexcept { return _data + _size; }
+    /// @brief Get an iterator past the last character.
+    const_iterator end() const noexcept { return _data + _size; }
+    /// @brief Get an iterator past the last character.
+    const_iterator cend() const noexcept { return _data + _size; }
+    /// @brief Get a reverse iterator to the last character.
+    reverse_iterator rbegin() noexcept { return reverse_iterator{end()}; }
+    /// @brief Get a reverse iterator to the last character.
+    const_reverse_iterator rbegin() const noexcept { return const_reverse_iterator{end()}; }
+    /// @brief Get a reverse iterator before the first character.
+    reverse_iterator rend() noexcept { return reverse_iterator{begin()}; }
+    /// @brief Get a reverse iterator before the first character.
+    const_reverse_iterator rend() const noexcept { return const_reverse_iterator{begin()}; }
+
+    /// @brief Check if the string is empty.
+    EC_NODISCARD bool empty() const noexcept { return _size == 0; }
+    /// @brief Get the number of characters.
+    size_type size() const noexcept { return _size; }
+    /// @brief Get the number of characters.
+    size_type length() const noexcept { return _size; }
+    /// @brief Get the maximum number of characters.
+    size_type max_size() const noexcept { return alloc_traits::max_size(_alloc) - 1; }
+    /// @brief Get the number of characters that fit without allocating.
+    size_type capacity() const noexcept { return _capacity; }
+    /// @brief Check if the characters are in the inline buffer.
+    bool is_inline() const noexcept { return _data == _inline; }
+
+    /**
+     * @brief
+     * Make room for a number of characters.
+     *
+     * @param count     Number of characters.
+     */
+    void reserve(size_type count)
+    {
+        if (count > _capacity) {
+            reallocate(count);
+        }
+    }
+
+    /// @brief Move the characters back inline if they fit, or into a smaller allocation if not.
+    void shrink_to_fit()
+    {
+        if (!is_inline() && _size < _capacity) {
+            reallocate(_size);
+        }
+    }
+
+    /// @brief Erase and wipe all characters, keeping the capacity.
+    void clear() noexcept { set_size(0); }
+
+    /**
+     * @brief
+     * Append a character.
+     *
+     * @param ch    The character.
+     */
+    void push_back(CharT ch)
+    {
+        if (_size == _capacity) {
+            reallocate(grown_capacity(_size + 1));
+        }
+        _data[_size] = ch;
+        _data[++_size] = CharT{};
+    }
+
+    /// @brief Erase and wipe the last character.
+    void pop_back() noexcept { set_size(_size - 1); }
+
+    /**
+     * @brief
+     * Append a character array.
+     *
+     * @param s         The characters.
+     * @param count     Number of characters.
+     *
+     * @return  This string.
+     */
+    basic_secure_inline_string& append(const CharT* s, size_type count)
+    {
+        if (_size + count > _capacity) {
+            // The source may be part of this string, so copy from the new buffer.
+            auto offset = s - _data;
+            bool aliased = s >= _data && s < _data + _size;
+            reallocate(grown_capacity(_size + count));
+            if (aliased) {
+                s = _data + offset;
+            }
+        }
+        Traits::copy(_data + _size, s, count);
+        _size += count;
+        _data[_size] = CharT{};
+        return *this;
+    }
+
+    /// @copydoc append(const CharT*, size_type)
+    basic_secure_inline_string& append(view_type sv) { return append(sv.data(), sv.size()); }
+
+    /**
+     * @brief
+     * Append repeated characters.
+     *
+     * @param count     Number of characters.
+     * @param ch        The character.
+     *
+     * @return  This string.
+     */
+    basic_secure_inline_string& append(size_type count, CharT ch)
+    {
+        if (_size + count > _capacity) {
+            reallocate(grown_capacity(_size + count));
+        }
+        Traits::assign(_data + _size, count, ch);
+        _size += count;
+        _data[_size] = CharT{};
+        return *this;
+    }
+
+    /// @brief Append a string view.
+    basic_secure_inline_string& operator+=(view_type sv) { return append(sv); }
+    /// @brief Append a null terminated string.
+    basic_secure_inline_string& operator+=(const CharT* s) { return append(s, Traits::length(s)); }
+    /// @brief Append a character.
+    basic_secure_inline_string& operator+=(CharT ch) { push_back(ch); return *this; }
+
+    /**
+     * @brief
+     * Erase characters, wiping the ones no longer in use.
+     *
+     * @param pos       Index of the first character to erase.
+     * @param count     Number of characters to erase.
+     *
+     * @return  This string.
+     *
+     * @throws std::out_of_range if `pos` is greater than `size()`.
+     */
+    basic_secure_inline_string& erase(size_type pos = 0, size_type count = npos)
+    {
+        if (pos > _size) {
+            throw std::out_of_range("ec::basic_secure_inline_string::erase");
+        }
+        count = std::min(count, _size - pos);
+        Traits::move(_data + pos, _data + pos + count, _size - pos - count);
+        set_size(_size - count);
+        return *this;
+    }
+
+    /**
+     * @brief
+     * Change the number of characters, wiping any that are removed.
+     *
+     * @param count     New number of characters.
+     * @param ch        Character to append if growing.
+     */
+    void resize(size_type count, CharT ch = CharT{})
+    {
+        if (count < _size) {
+            set_size(count);
+        } else {
+            append(count - _size, ch);
+        }
+    }
+
+    /**
+     * @brief
+     * Swap the contents with another string.
+     *
+     * @param other     The string to swap with.
+     */
+    void swap(basic_secure_inline_string& other) noexcept
+    {
+        if (this == &other) {
+            return;
+        }
+        basic_secure_inline_string tmp{std::move(other)};
+        other = std::move(*this);
+        *this = std::move(tmp);
+    }
+
+    /**
+     * @brief
+     * Compare with a string view.
+     *
+     * @param sv    The string view.
+     *
+     * @return  Negative, zero or positive as for `std::basic_string::compare()`.
+     */
+    int compare(view_type sv) const noexcept { return view().compare(sv); }
+
+    /// @brief Equality with anything convertible to a string view.
+    friend bool operator==(const basic_secure_inline_string& a, view_type b) noexcept { return a.view() == b; }
+    /// @brief Ordering with anything convertible to a string view.
+    friend auto operator<=>(const basic_secure_inline_string& a, view_type b) noexcept { return a.view() <=> b; }
+
+    /// @brief Swap two strings.
+    friend void swap(basic_secure_inline_string& a, basic_secure_inline_string& b) noexcept { a.swap(b); }
+
+  private:
+    CharT* _data{_inline};                          ///< @brief The characters.
+    size_type _size{};                              ///< @brief Number of characters.
+    size_type _capacity{N};                         ///< @brief Room for characters in `_data`.
+    [[no_unique_address]] Allocator _alloc;         ///< @brief Allocator for long contents.
+    CharT _inline[N + 1]{};                         ///< @brief Inline buffer for short contents.
+
+    /// @brief Wipe characters.
+    static void wipe(CharT* p, size_type count) noexcept
+    {
+        if (count != 0) {
+            secure_zero(p, count * sizeof(CharT));
+        }
+    }
+
+    /// @brief Get the capacity to grow to so that appending repeatedly is amortized constant time.
+    size_type grown_capacity(size_type count) const noexcept { return std::max(count, 2 * _capacity); }
+
+    /// @brief Set the number of characters, wiping any that are removed.
+    void set_size(size_type count) noexcept
+    {
+        if (count < _size) {
+            wipe(_data + count, _size - count);
+        }
+        _size = count;
+        _data[_size] = CharT{};
+    }
+
+    /**
+     * @brief
+     * Move the characters into a buffer with room for a number of characters.
+     *
+     * The inline buffer is used if they fit, otherwise a new allocation.  The old buffer is wiped
+     * if inline, otherwise returned to the allocator.
+     *
+     * @param count     Number of characters to make room for.
+     */
+    void reallocate(size_type count)
+    {
+        if (count > max_size()) {
+            throw std::length_error("ec::basic_secure_inline_string");
+        }
+        if (count <= N) {
+            if (!is_inline()) {
+                Traits::copy(_inline, _data, _size + 1);
+                alloc_traits::deallocate(_alloc, _data, _capacity + 1);
+                _data = _inline;
+                _capacity = N;
+            }
+            return;
+        }
+        auto* p = alloc_traits::allocate(_alloc, count + 1);
+        Traits::copy(p, _data, _size + 1);
+        if (is_inline()) {
+            wipe(_inline, _size);
+        } else {
+            alloc_traits::deallocate(_alloc, _data, _capacity + 1);
+        }
+        _data = p;
+        _capacity = count;
+    }
+
+    /// @brief Return any allocation and become an empty inline string.
+    void release() noexcept
+    {
+        if (!is_inline()) {
+            alloc_traits::deallocate(_alloc, _data, _capacity + 1);
+            _data = _inline;
+            _capacity = N;
+            _size = 0;
+            _inline[0] = CharT{};
+        }
+    }
+
+    /**
+     * @brief
+     * Take over the contents of another string, leaving it empty.
+     *
+     * This string must not hold an allocation, and its allocator must be equal to `other`'s.
+     */
+    void take(basic_secure_inline_string& other) noexcept
+    {
+        set_size(0);
+        if (other.is_inline()) {
+            Traits::copy(_inline, other._inline, other._size + 1);
+            _data = _inline;
+            _size = other._size;
+            _capacity = N;
+            other.set_size(0);
+        } else {
+            _data = std::exchange(other._data, other._inline);
+            _size = std::exchange(other._size, 0);
+            _capacity = std::exchange(other._capacity, N);
+            other._inline[0] = CharT{};
+        }
+    }
+};
+
+/**
+ * @brief
+ * String of `char` that keeps up to `N` characters inline and wipes them when they go away.
+ *
+ * @tparam N    Number of characters kept inline.
+ */
+template <std::size_t N>
+using secure_inline_string = basic_secure_inline_string<N, char>;
+
+} // namespace ec
@@ -30,12 +30,12 @@ namespace ec::unserialized_secure {
  * @tparam Key          The key type stored in the multimap.
  * @tparam T            The value type stored in the map.
  * @tparam Compare      The comparison functor type.
- * @tparam Allocator    The real allocator (default: `std:allocator<Key>`).
+ * @tparam Allocator    The real allocator (default: `std:allocator<std::pair<const Key, T>>`).
  */
 template <typename Key,
           typename T,
           typename Compare = std::less<Key>,
-          typename Allocator = std::allocator<Key>>
+          typename Allocator = std::allocator<std::pair<const Key, T>>>
 using multimap = std::multimap<Key, T, Compare,
                                ec::unserialized_secure_allocator<std::pair<const Key, T>, Allocator>>;
 }
@@ -48,12 +48,100 @@ namespace ec::serialized_secure {
  * @tparam Key          The key type stored in the multimap.
  * @tparam T            The value type stored in the map.
  * @tparam Compare      The comparison functor type.
- * @tparam Allocator    The real allocator (default: `std:allocator<Key>`).
+ * @tparam Allocator    The real allocator (default: `std:allocator<std::pair<const Key, T>>`).
  */
 template <typename Key,
           typename T,
           typename Compare = std::less<Key>,
-          typename Allocator = std::allocator<Key>>
+          typename Allocator = std::allocator<std::pair<const Key, T>>>
 using multimap = std::multimap<Key, T, Compare,
                                ec::serialized_secure_allocator<std::pair<const Key, T>, Allocator>>;
 }
+
+namespace ec::concurrent_secure {
+/**
+ * @brief
+ * Alias of `std::multimap<>` that wraps the real alloctor with `ec::concurrent_secure_allocator<>`.
+ *
+ * @tparam Key          The key type stored in the multimap.
+ * @tparam T            The value type stored in the map.
+ * @tparam Compare      The comparison functor type.
+ * @tparam Allocator    The real allocator (default: `std:allocator<std::pair<const Key, T>>`).
+ */
+template <typename Key,
+          typename T,
+          typename Compare = std::less<Key>,
+          typename Allocator = std::allocator<std::pair<const Key, T>>>
+using multimap = std::multimap<Key, T, Compare,
+                               ec::concurrent_secure_allocator<std::pair<const Key, T>, Allocator>>;
+}
+
+namespace ec::node_pooled_secure {
+/**
+ * @brief
+ * Alias of `std::multimap<>` that wraps the real alloctor with
+ * `ec::node_pooled_secure_allocator<>`.
+ *
+ * @tparam Key          The key type stored in the multimap.
+ * @tparam T            The value type stored in the map.
+ * @tparam Compare      The comparison functor type.
+ * @tparam Allocator    The real allocator (default: `std:allocator<std::pair<const Key, T>>`).
+ */
+template <typename Key,
+          typename T,
+          typename Compare = std::less<Key>,
+          typename Allocator = std::allocator<std::pair<const Key, T>>>
+using multimap = std::multimap<Key, T, Compare,
+                               ec::node_pooled_secure_allocator<std::pair<const Key, T>, Allocator>>;
+}
+
+namespace ec::pooled_secure {
+/**
+ * @brief
+ * Alias of `std::multimap<>` that allocates from the locked pool with
+ * `ec::pooled_secure_allocator<>`.
+ *
+ * @tparam Key          The key type stored in the multimap.
+ * @tparam T            The value type stored in the map.
+ * @tparam Compare      The comparison functor type.
+ */
+template <typename Key,
+          typename T,
+          typename Compare = std::less<Key>>
+using multimap = std::multimap<Key, T, Compare,
+                               ec::pooled_secure_allocator<std::pair<const Key, T>>>;
+}
+
+namespace ec::pmr::secure {
+/**
+ * @brief
+ * Alias of `std::multimap<>` that allocates from a memory resource with
+ * `ec::pmr::secure_allocator<>`.
+ *
+ * @tparam Key          The key type stored in the multimap.
+ * @tparam T            The value type stored in the map.
+ * @tparam Compare      The comparison functor type.
+ */
+template <typename Key,
+          typename T,
+          typename Compare = std::less<Key>>
+using multimap = std::multimap<Key, T, Compare,
+                               ec::pmr::secure_allocator<std::pair<const Key, T>>>;
+}
+
+namespace ec::pmr::numa_secure {
+/**
+ * @brief
+ * Alias of `std::multimap<>` that allocates from a memory resource with
+ * `ec::pmr::numa_secure_allocator<>`.
+ *
+ * @tparam Key          The key type stored in the multimap.
+ * @tparam T            The value type stored in the map.
+ * @tparam Compare      The comparison functor type.
+ */
+template <typename Key,
+          typename T,
+          typename Compare = std::less<Key>>
+using multimap = std::multimap<Key, T, Compare,
+                               ec::pmr::numa_secure_allocator<std::pair<const Key, T>>>;
+}
@@ -52,3 +52,76 @@ template <typename Key,
 using multiset = std::multiset<Key, Compare, ec::serialized_secure_allocator<Key, Allocator>>;
 }
 
+namespace ec::concurrent_secure {
+/**
+ * @brief
+ * Alias of `std::multiset<>` that wraps the real alloctor with `ec::concurrent_secure_allocator<>`.
+ *
+ * @tparam Key          The key type stored in the multiset.
+ * @tparam Compare      The comparison functor type.
+ * @tparam Allocator    The real allocator (default: `std:allocator<Key>`).
+ */
+template <typename Key,
+          typename Compare = std::less<Key>,
+          typename Allocator = std::allocator<Key>>
+using multiset = std::multiset<Key, Compare, ec::concurrent_secure_allocator<Key, Allocator>>;
+}
+
+namespace ec::node_pooled_secure {
+/**
+ * @brief
+ * Alias of `std::multiset<>` that wraps the real alloctor with
+ * `ec::node_pooled_secure_allocator<>`.
+ *
+ * @tparam Key          The key type stored in the multiset.
+ * @tparam Compare      The comparison functor type.
+ * @tparam Allocator    The real allocator (default: `std:allocator<Key>`).
+ */
+template <typename Key,
+          typename Compare = std::less<Key>,
+          typename Allocator = std::allocator<Key>>
+using multiset = std::multiset<Key, Compare, ec::node_pooled_secure_allocator<Key, Allocator>>;
+}
+
+namespace ec::pooled_secure {
+/**
+ * @brief
+ * Alias of `std::multiset<>` that allocates from the locked pool with
+ * `ec::pooled_secure_allocator<>`.
+ *
+ * @tparam Key          The key type stored in the multiset.
+ * @tparam Compare      The comparison functor type.
+ */
+template <typename Key,
+          typename Compare = std::less<Key>>
+using multiset = std::multiset<Key, Compare, ec::pooled_secure_allocator<Key>>;
+}
+
+namespace ec::pmr::secure {
+/**
+ * @brief
+ * Alias of `std::multiset<>` that allocates from a memory resource with
+ * `ec::pmr::secure_allocator<>`.
+ *
+ * @tparam Key          The key type stored in the multiset.
+ * @tparam Compare      The comparison functor type.
+ */
+template <typename Key,
+          typename Compare = std::less<Key>>
+using multiset = std::multiset<Key, Compare, ec::pmr::secure_allocator<Key>>;
+}
+
+namespace ec::pmr::numa_secure {
+/**
+ * @brief
+ * Alias of `std::multiset<>` that allocates from a memory resource with
+ * `ec::pmr::numa_secure_allocator<>`.
+ *
+ * @tparam Key          The key type stored in the multiset.
+ * @tparam Compare      The comparison functor type.
+ */
+template <typename Key,
+          typename Compare = std::less<Key>>
+using multiset = std::multiset<Key, Compare, ec::pmr::numa_secure_allocator<Key>>;
+}
+
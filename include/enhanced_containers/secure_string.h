@@ -74,3 +74,104 @@ using u16string = basic_string<char16_t>;
 using u32string = basic_string<char32_t>;
 }
 
+namespace ec::concurrent_secure {
+/**
+ * @brief
+ * Alias of `std::basic_string<>` that wraps the real alloctor with `ec::concurrent_secure_allocator<>`.
+ *
+ * @tparam CharT        The character type.
+ * @tparam Traits       The character type traits (default: `std::char_traits<CharT>`).
+ * @tparam Allocator    The real allocator (default: `std:allocator<CharT>`).
+ */
+template <typename CharT,
+          typename Traits = std::char_traits<CharT>,
+          typename Allocator = std::allocator<CharT>>
+using basic_string = std::basic_string<CharT, Traits, ec::concurrent_secure_allocator<CharT, Allocator>>;
+
+/// @brief Type alias for `char` strings using the `ec::concurrent_secure_allocator<>`.
+using string = basic_string<char>;
+/// @brief Type alias for `wchar_t` strings using the `ec::concurrent_secure_allocator<>`.
+using wstring = basic_string<wchar_t>;
+/// @brief Type alias for `char8_t` strings using the `ec::concurrent_secure_allocator<>`.
+using u8string = basic_string<char8_t>;
+/// @brief Type alias for `char16_t` strings using the `ec::concurrent_secure_allocator<>`.
+using u16string = basic_string<char16_t>;
+/// @brief Type alias for `char32_t` strings using the `ec::concurrent_secure_allocator<>`.
+using u32string = basic_string<char32_t>;
+}
+
+namespace ec::pooled_secure {
+/**
+ * @brief
+ * Alias of `std::basic_string<>` that allocates from the locked pool with
+ * `ec::pooled_secure_allocator<>`.
+ *
+ * @tparam CharT        The character type.
+ * @tparam Traits       The character type traits (default: `std::char_traits<CharT>`).
+ */
+template <typename CharT,
+          typename Traits = std::char_traits<CharT>>
+using basic_string = std::basic_string<CharT, Traits, ec::pooled_secure_allocator<CharT>>;
+
+/// @brief Type alias for `char` strings using the `ec::pooled_secure_allocator<>`.
+using string = basic_string<char>;
+/// @brief Type alias for `wchar_t` strings using the `ec::pooled_secure_allocator<>`.
+using wstring = basic_string<wchar_t>;
+/// @brief Type alias for `char8_t` strings using the `ec::pooled_secure_allocator<>`.
+using u8string = basic_string<char8_t>;
+/// @brief Type alias for `char16_t` strings using the `ec::pooled_secure_allocator<>`.
+using u16string = basic_string<char16_t>;
+/// @brief Type alias for `char32_t` strings using the `ec::pooled_secure_allocator<>`.
+using u32string = basic_string<char32_t>;
+}
+
+namespace ec::pmr::secure {
+/**
+ * @brief
+ * Alias of `std::basic_string<>` that allocates from a memory resource with
+ * `ec::pmr::secure_allocator<>`.
+ *
+ * @tparam CharT        The character type.
+ * @tparam Traits       The character type traits (default: `std::char_traits<CharT>`).
+ */
+template <typename CharT,
+          typename Traits = std::char_traits<CharT>>
+using basic_string = std::basic_string<CharT, Traits, ec::pmr::secure_allocator<CharT>>;
+
+/// @brief Type alias for `char` strings using the `ec::pmr::secure_allocator<>`.
+using string = basic_string<char>;
+/// @brief Type alias for `wchar_t` strings using the `ec::pmr::secure_allocator<>`.
+using wstring = basic_string<wchar_t>;
+/// @brief Type alias for `char8_t` strings using the `ec::pmr::secure_allocator<>`.
+using u8string = basic_string<char8_t>;
+/// @brief Type alias for `char16_t` strings using the `ec::pmr::secure_allocator<>`.
+using u16string = basic_string<char16_t>;
+/// @brief Type alias for `char32_t` strings using the `ec::pmr::secure_allocator<>`.
+using u32string = basic_string<char32_t>;
+}
+
+namespace ec::pmr::numa_secure {
+/**
+ * @brief
+ * Alias of `std::basic_string<>` that allocates from a memory resource with
+ * `ec::pmr::numa_secure_allocator<>`.
+ *
+ * @tparam CharT        The character type.
+ * @tparam Traits       The character type traits (default: `std::char_traits<CharT>`).
+ */
+template <typename CharT,
+          typename Traits = std::char_traits<CharT>>
+using basic_string = std::basic_string<CharT, Traits, ec::pmr::numa_secure_allocator<CharT>>;
+
+/// @brief Type alias for `char` strings using the `ec::pmr::numa_secure_allocator<>`.
+using string = basic_string<char>;
+/// @brief Type alias for `wchar_t` strings using the `ec::pmr::numa_secure_allocator<>`.
+using wstring = basic_string<wchar_t>;
+/// @brief Type alias for `char8_t` strings using the `ec::pmr::numa_secure_allocator<>`.
+using u8string = basic_string<char8_t>;
+/// @brief Type alias for `char16_t` strings using the `ec::pmr::numa_secure_allocator<>`.
+using u16string = basic_string<char16_t>;
+/// @brief Type alias for `char32_t` strings using the `ec::pmr::numa_secure_allocator<>`.
+using u32string = basic_string<char32_t>;
+}
+
@@ -31,13 +31,13 @@ namespace ec::unserialized_secure {
  * @tparam T            The value type stored in the unordered_map.
  * @tparam Hash         The hash functor type.
  * @tparam KeyEqual     The equal functor type for Key.
- * @tparam Allocator    The real allocator (default: `std:allocator<Key>`).
+ * @tparam Allocator    The real allocator (default: `std:allocator<std::pair<const Key, T>>`).
  */
 template <typename Key,
           typename T,
           typename Hash = std::hash<Key>,
           typename KeyEqual = std::equal_to<Key>,
-          typename Allocator = std::allocator<Key>>
+          typename Allocator = std::allocator<std::pair<const Key, T>>>
 using unordered_map = std::unordered_map<Key, T, Hash, KeyEqual,
                                          ec::unserialized_secure_allocator<std::pair<const Key, T>,
                                                                            Allocator>>;
@@ -52,14 +52,92 @@ namespace ec::serialized_secure {
  * @tparam T            The value type stored in the unordered_map.
  * @tparam Hash         The hash functor type.
  * @tparam KeyEqual     The equal functor type for Key.
- * @tparam Allocator    The real allocator (default: `std:allocator<Key>`).
+ * @tparam Allocator    The real allocator (default: `std:allocator<std::pair<const Key, T>>`).
  */
 template <typename Key,
           typename T,
           typename Hash = std::hash<Key>,
           typename KeyEqual = std::equal_to<Key>,
-          typename Allocator = std::allocator<Key>>
+          typename Allocator = std::allocator<std::pair<const Key, T>>>
 using unordered_map = std::unordered_map<Key, T, Hash, KeyEqual,
                                          ec::serialized_secure_allocator<std::pair<const Key, T>,
                                                                          Allocator>>;
 }
+
+namespace ec::concurrent_secure {
+/**
+ * @brief
+ * Alias of `std::unordered_map<>` that wraps the real alloctor with `ec::concurrent_secure_allocator<>`.
+ *
+ * @tparam Key          The value type stored in the unordered_map.
+ * @tparam T            The value type stored in the unordered_map.
+ * @tparam Hash         The hash functor type.
+ * @tparam KeyEqual     The equal functor type for Key.
+ * @tparam Allocator    The real allocator (default: `std:allocator<std::pair<const Key, T>>`).
+ */
+template <typename Key,
+          typename T,
+          typename Hash = std::hash<Key>,
+          typename KeyEqual = std::equal_to<Key>,
+          typename Allocator = std::allocator<std::pair<const Key, T>>>
+using unordered_map = std::unordered_map<Key, T, Hash, KeyEqual,
+                                         ec::concurrent_secure_allocator<std::pair<const Key, T>,
+                                                                         Allocator>>;
+}
+
+namespace ec::pooled_secure {
+/**
+ * @brief
+ * Alias of `std::unordered_map<>` that allocates from the locked pool with
+ * `ec::pooled_secure_allocator<>`.
+ *
+ * @tparam Key          The value type stored in the unordered_map.
+ * @tparam T            The value type stored in the unordered_map.
+ * @tparam Hash         The hash functor type.
+ * @tparam KeyEqual     The equal functor type for Key.
+ */
+template <typename Key,
+          typename T,
+          typename Hash = std::hash<Key>,
+          typename KeyEqual = std::equal_to<Key>>
+using unordered_map = std::unordered_map<Key, T, Hash, KeyEqual,
+                                         ec::pooled_secure_allocator<std::pair<const Key, T>>>;
+}
+
+namespace ec::pmr::secure {
+/**
+ * @brief
+ * Alias of `std::unordered_map<>` that allocates from a memory resource with
+ * `ec::pmr::secure_allocator<>`.
+ *
+ * @tparam Key          The value type stored in the unordered_map.
+ * @tparam T            The value type stored in the unordered_map.
+ * @tparam Hash         The hash functor type.
+ * @tparam KeyEqual     The equal functor type for Key.
+ */
+template <typename Key,
+          typename T,
+          typename Hash = std::hash<Key>,
+          typename KeyEqual = std::equal_to<Key>>
+using unordered_map = std::unordered_map<Key, T, Hash, KeyEqual,
+                                         ec::pmr::secure_allocator<std::pair<const Key, T>>>;
+}
+
+namespace ec::pmr::numa_secure {
+/**
+ * @brief
+ * Alias of `std::unordered_map<>` that allocates from a memory resource with
+ * `ec::pmr::numa_secure_allocator<>`.
+ *
+ * @tparam Key          The value type stored in the unordered_map.
+ * @tparam T            The value type stored in the unordered_map.
+ * @tparam Hash         The hash functor type.
+ * @tparam KeyEqual     The equal functor type for Key.
+ */
+template <typename Key,
+          typename T,
+          typename Hash = std::hash<Key>,
+          typename KeyEqual = std::equal_to<Key>>
+using unordered_map = std::unordered_map<Key, T, Hash, KeyEqual,
+                                         ec::pmr::numa_secure_allocator<std::pair<const Key, T>>>;
+}
@@ -58,3 +58,72 @@ template <typename Key,
 using unordered_set = std::unordered_set<Key, Hash, KeyEqual,
                                          ec::serialized_secure_allocator<Key, Allocator>>;
 }
+
+namespace ec::concurrent_secure {
+/**
+ * @brief
+ * Alias of `std::unordered_set<>` that wraps the real alloctor with `ec::concurrent_secure_allocator<>`.
+ *
+ * @tparam Key          The key type stored in the unordered_set.
+ * @tparam Hash         The hash functor type.
+ * @tparam KeyEqual     The equal functor type for Key.
+ * @tparam Allocator    The real allocator (default: `std:allocator<Key>`).
+ */
+template <typename Key,
+          typename Hash = std::hash<Key>,
+          typename KeyEqual = std::equal_to<Key>,
+          typename Allocator = std::allocator<Key>>
+using unordered_set = std::unordered_set<Key, Hash, KeyEqual,
+                                         ec::concurrent_secure_allocator<Key, Allocator>>;
+}
+
+namespace ec::pooled_secure {
+/**
+ * @brief
+ * Alias of `std::unordered_set<>` that allocates from the locked pool with
+ * `ec::pooled_secure_allocator<>`.
+ *
+ * @tparam Key          The key type stored in the unordered_set.
+ * @tparam Hash         The hash functor type.
+ * @tparam KeyEqual     The equal functor type for Key.
+ */
+template <typename Key,
+          typename Hash = std::hash<Key>,
+          typename KeyEqual = std::equal_to<Key>>
+using unordered_set = std::unordered_set<Key, Hash, KeyEqual,
+                                         ec::pooled_secure_allocator<Key>>;
+}
+
+namespace ec::pmr::secure {
+/**
+ * @brief
+ * Alias of `std::unordered_set<>` that allocates from a memory resource with
+ * `ec::pmr::secure_allocator<>`.
+ *
+ * @tparam Key          The key type stored in the unordered_set.
+ * @tparam Hash         The hash functor type.
+ * @tparam KeyEqual     The equal functor type for Key.
+ */
+template <typename Key,
+          typename Hash = std::hash<Key>,
+          typename KeyEqual = std::equal_to<Key>>
+using unordered_set = std::unordered_set<Key, Hash, KeyEqual,
+                                         ec::pmr::secure_allocator<Key>>;
+}
+
+namespace ec::pmr::numa_secure {
+/**
+ * @brief
+ * Alias of `std::unordered_set<>` that allocates from a memory resource with
+ * `ec::pmr::numa_secure_allocator<>`.
+ *
+ * @tparam Key          The key type stored in the unordered_set.
+ * @tparam Hash         The hash functor type.
+ * @tparam KeyEqual     The equal functor type for Key.
+ */
+template <typename Key,
+          typename Hash = std::hash<Key>,
+          typename KeyEqual = std::equal_to<Key>>
+using unordered_set = std::unordered_set<Key, Hash, KeyEqual,
+                                         ec::pmr::numa_secure_allocator<Key>>;
+}
@@ -0,0 +1,122 @@
+/**
+ * @file
+ * A collection of aliases to `ec::wiping_basic_string` that use the secure allocators.
+ *
+ * @copyright 2023 Steve Kinneberg <steve.kinneberg@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <enhanced_containers/secure_allocator.h>
+#include <enhanced_containers/wiping_string.h>
+
+namespace ec::unserialized_secure {
+/**
+ * @brief
+ * Alias of `ec::wiping_basic_string<>` that wraps the real allocator with `ec::unserialized_secure_allocator<>`.
+ *
+ * @tparam CharT        The character type.
+ * @tparam Traits       The character type traits (default: `std::char_traits<CharT>`).
+ * @tparam Allocator    The real allocator (default: `std:allocator<CharT>`).
+ */
+template <typename CharT,
+          typename Traits = std::char_traits<CharT>,
+          typename Allocator = std::allocator<CharT>>
+using wiping_basic_string = ec::wiping_basic_string<CharT, Traits, ec::unserialized_secure_allocator<CharT, Allocator>>;
+
+/// @brief Type alias for `char` strings that wipe removed characters, using the `ec::unserialized_secure_allocator<>`.
+using wiping_string = wiping_basic_string<char>;
+}
+
+namespace ec::serialized_secure {
+/**
+ * @brief
+ * Alias of `ec::wiping_basic_string<>` that wraps the real allocator with `ec::serialized_secure_allocator<>`.
+ *
+ * @tparam CharT        The character type.
+ * @tparam Traits       The character type traits (default: `std::char_traits<CharT>`).
+ * @tparam Allocator    The real allocator (default: `std:allocator<CharT>`).
+ */
+template <typename CharT,
+          typename Traits = std::char_traits<CharT>,
+          typename Allocator = std::allocator<CharT>>
+using wiping_basic_string = ec::wiping_basic_string<CharT, Traits, ec::serialized_secure_allocator<CharT, Allocator>>;
+
+/// @brief Type alias for `char` strings that wipe removed characters, using the `ec::serialized_secure_allocator<>`.
+using wiping_string = wiping_basic_string<char>;
+}
+
+namespace ec::concurrent_secure {
+/**
+ * @brief
+ * Alias of `ec::wiping_basic_string<>` that wraps the real allocator with `ec::concurrent_secure_allocator<>`.
+ *
+ * @tparam CharT        The character type.
+ * @tparam Traits       The character type traits (default: `std::char_traits<CharT>`).
+ * @tparam Allocator    The real allocator (default: `std:allocator<CharT>`).
+ */
+template <typename CharT,
+          typename Traits = std::char_traits<CharT>,
+          typename Allocator = std::allocator<CharT>>
+using wiping_basic_string = ec::wiping_basic_string<CharT, Traits, ec::concurrent_secure_allocator<CharT, Allocator>>;
+
+/// @brief Type alias for `char` strings that wipe removed characters, using the `ec::concurrent_secure_allocator<>`.
+using wiping_string = wiping_basic_string<char>;
+}
+
+namespace ec::pooled_secure {
+/**
+ * @brief
+ * Alias of `ec::wiping_basic_string<>` that allocates from the locked pool with `ec::pooled_secure_allocator<>`.
+ *
+ * @tparam CharT        The character type.
+ * @tparam Traits       The character type traits (default: `std::char_traits<CharT>`).
+ */
+template <typename CharT, typename Traits = std::char_traits<CharT>>
+using wiping_basic_string = ec::wiping_basic_string<CharT, Traits, ec::pooled_secure_allocator<CharT>>;
+
+/// @brief Type alias for `char` strings that wipe removed characters, using the `ec::pooled_secure_allocator<>`.
+using wiping_string = wiping_basic_string<char>;
+}
+
+namespace ec::pmr::secure {
+/**
+ * @brief
+ * Alias of `ec::wiping_basic_string<>` that allocates from a memory resource with `ec::pmr::secure_allocator<>`.
+ *
+ * @tparam CharT        The character type.
+ * @tparam Traits       The character type traits (default: `std::char_traits<CharT>`).
+ */
+template <typename CharT, typename Traits = std::char_traits<CharT>>
+using wiping_basic_string = ec::wiping_basic_string<CharT, Traits, ec::pmr::secure_allocator<CharT>>;
+
+/// @brief Type alias for `char` strings that wipe removed characters, using the `ec::pmr::secure_allocator<>`.
+using wiping_string = wiping_basic_string<char>;
+}
+
+namespace ec::pmr::numa_secure {
+/**
+ * @brief
+ * Alias of `ec::wiping_basic_string<>` that allocates from a memory resource with `ec::pmr::numa_secure_allocator<>`.
+ *
+ * @tparam CharT        The character type.
+ * @tparam Traits       The character type traits (default: `std::char_traits<CharT>`).
+ */
+template <typename CharT, typename Traits = std::char_traits<CharT>>
+using wiping_basic_string = ec::wiping_basic_string<CharT, Traits, ec::pmr::numa_secure_allocator<CharT>>;
+
+/// @brief Type alias for `char` strings that wipe removed characters, using the `ec::pmr::numa_secure_allocator<>`.
+using wiping_string = wiping_basic_string<char>;
+}
@@ -0,0 +1,92 @@
+/**
+ * @file
+ * A collection of aliases to `ec::wiping_vector` that use the secure allocators.
+ *
+ * @copyright 2023 Steve Kinneberg <steve.kinneberg@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <enhanced_containers/secure_allocator.h>
+#include <enhanced_containers/wiping_vector.h>
+
+namespace ec::unserialized_secure {
+/**
+ * @brief
+ * Alias of `ec::wiping_vector<>` that wraps the real allocator with `ec::unserialized_secure_allocator<>`.
+ *
+ * @tparam T            The value type stored in the vector.
+ * @tparam Allocator    The real allocator (default: `std:allocator<T>`).
+ */
+template <typename T, typename Allocator = std::allocator<T>>
+using wiping_vector = ec::wiping_vector<T, ec::unserialized_secure_allocator<T, Allocator>>;
+}
+
+namespace ec::serialized_secure {
+/**
+ * @brief
+ * Alias of `ec::wiping_vector<>` that wraps the real allocator with `ec::serialized_secure_allocator<>`.
+ *
+ * @tparam T            The value type stored in the vector.
+ * @tparam Allocator    The real allocator (default: `std:allocator<T>`).
+ */
+template <typename T, typename Allocator = std::allocator<T>>
+using wiping_vector = ec::wiping_vector<T, ec::serialized_secure_allocator<T, Allocator>>;
+}
+
+namespace ec::concurrent_secure {
+/**
+ * @brief
+ * Alias of `ec::wiping_vector<>` that wraps the real allocator with `ec::concurrent_secure_allocator<>`.
+ *
+ * @tparam T            The value type stored in the vector.
+ * @tparam Allocator    The real allocator (default: `std:allocator<T>`).
+ */
+template <typename T, typename Allocator = std::allocator<T>>
+using wiping_vector = ec::wiping_vector<T, ec::concurrent_secure_allocator<T, Allocator>>;
+}
+
+namespace ec::pooled_secure {
+/**
+ * @brief
+ * Alias of `ec::wiping_vector<>` that allocates from the locked pool with `ec::pooled_secure_allocator<>`.
+ *
+ * @tparam T            The value type stored in the vector.
+ */
+template <typename T>
+using wiping_vector = ec::wiping_vector<T, ec::pooled_secure_allocator<T>>;
+}
+
+namespace ec::pmr::secure {
+/**
+ * @brief
+ * Alias of `ec::wiping_vector<>` that allocates from a memory resource with `ec::pmr::secure_allocator<>`.
+ *
+ * @tparam T            The value type stored in the vector.
+ */
+template <typename T>
+using wiping_vector = ec::wiping_vector<T, ec::pmr::secure_allocator<T>>;
+}
+
+namespace ec::pmr::numa_secure {
+/**
+ * @brief
+ * Alias of `ec::wiping_vector<>` that allocates from a memory resource with `ec::pmr::numa_secure_allocator<>`.
+ *
+ * @tparam T            The value type stored in the vector.
+ */
+template <typename T>
+using wiping_vector = ec::wiping_vector<T, ec::pmr::numa_secure_allocator<T>>;
+}
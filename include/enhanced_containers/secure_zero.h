@@ -0,0 +1,88 @@
+/**
+ * @file
+ * Wipe memory in a way that the compiler is not allowed to optimize away.
+ *
+ * @copyright 2023 Steve Kinneberg <steve.kinneberg@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace ec {
+
+/**
+ * @brief
+ * Zero out a block of memory.
+ *
+ * Unlike `std::memset()` or `std::fill()`, the stores are guaranteed to happen even when the
+ * memory is about to be freed and never read again.
+ *
+ * The fastest kernel supported by the CPU is selected once at run-time: AVX-512, AVX2 or SSE2 on
+ * x86, with a portable fallback elsewhere.  Blocks of `details::secure_zero_non_temporal_threshold`
+ * bytes or more are wiped with non-temporal stores so that wiping large buffers runs at memory
+ * bandwidth without evicting the rest of the cache.
+ *
+ * @param ptr   Address of the memory to zero out.
+ * @param len   Number of bytes to zero out.
+ */
+void secure_zero(void* ptr, std::size_t len) noexcept;
+
+namespace details {
+
+/// @internal @brief Size at which `secure_zero()` switches to non-temporal stores.
+inline constexpr std::size_t secure_zero_non_temporal_threshold{1024 * 1024};
+
+/**
+ * @internal @brief
+ * Get the total number of bytes `secure_zero()` has wiped since the program started.
+ *
+ * Each thread counts into a counter of its own, so this never blocks `secure_zero()` callers.
+ *
+ * @return  Number of bytes wiped.
+ */
+std::uint64_t secure_zero_wiped_bytes() noexcept;
+
+#ifdef EC_UNIT_TEST_SUPPORT
+/// @internal @brief The kernels that `secure_zero()` can use.
+enum class secure_zero_kernel {
+    portable,   ///< @brief `memset()` called through a volatile function pointer.
+    sse2,       ///< @brief 16 byte vector stores.
+    avx2,       ///< @brief 32 byte vector stores.
+    avx512,     ///< @brief 64 byte vector stores.
+};
+
+/**
+ * @internal @brief
+ * Force `secure_zero()` to use a particular kernel.
+ *
+ * @param kernel    The kernel to use.
+ *
+ * @return  Whether or not the kernel is supported on this CPU.  The kernel is left unchanged if
+ *          not.
+ */
+bool set_secure_zero_kernel(secure_zero_kernel kernel) noexcept;
+
+/**
+ * @internal @brief
+ * Restore the kernel `secure_zero()` selected for this CPU.
+ */
+void reset_secure_zero_kernel() noexcept;
+#endif
+
+} // namespace details
+
+} // namespace ec
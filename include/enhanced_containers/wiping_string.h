@@ -0,0 +1,551 @@
+/**
+ * @file
+ * `std::basic_string` that wipes characters as soon as they are removed.
+ *
+ * @copyright 2023 Steve Kinneberg <steve.kinneberg@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <enhanced_containers/secure_zero.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+namespace ec {
+
+/**
+ * @brief
+ * `std::basic_string` that wipes characters as soon as they are removed.
+ *
+ * Whenever the string shrinks, just the vacated characters are wiped, whether they are in an
+ * allocation or in the small string buffer inside the object.  When the string grows out of the
+ * small string buffer into an allocation, the characters left behind in the buffer are wiped.  The
+ * source of a move is wiped as well if its buffer was not taken over, which is always the case for
+ * short strings.  Memory that is reallocated is left to the allocator, e.g.
+ * `ec::zero_on_release_allocator`.
+ *
+ * Modifying the string through a reference to its `std::basic_string` base bypasses the wiping, as
+ * do qualified calls to `std::erase()` and `std::erase_if()`; use `ec::erase()` and `ec::erase_if()`.
+ *
+ * @tparam CharT        The character type.
+ * @tparam Traits       The character traits type.
+ * @tparam Allocator    The allocator type.
+ */
+template <typename CharT,
+          typename Traits = std::char_traits<CharT>,
+          typename Allocator = std::allocator<CharT>>
+class wiping_basic_string: public std::basic_string<CharT, Traits, Allocator> {
+    /// @brief The base string type.
+    using base = std::basic_string<CharT, Traits, Allocator>;
+
+  public:
+    using typename base::size_type;
+    using typename base::iterator;
+    using typename base::const_iterator;
+    using base::npos;
+    using base::base;
+
+    /// @brief Default constructor.
+    wiping_basic_string() = default;
+
+    /// @brief Copy constructor.
+    wiping_basic_string(const wiping_basic_string&) = default;
+
+    /**
+     * @brief
+     * Move constructor.  Wipes `other` if its characters were copied rather than its buffer being
+     * taken over.
+     *
+     * @param other     The string to move from.
+     */
+    wiping_basic_string(wiping_basic_string&& other) noexcept:
+        wiping_basic_string(std::move(other), other.data(), other.size())
+    {}
+
+    /**
+     * @brief
+     * Destructor.  Wipes the small string buffer, including anything left in it by operations that
+     * bypass the wiping; an allocation is left to the allocator.
+     */
+    ~wiping_basic_string()
+    {
+        if (!is_inline()) {
+            // Hand the allocation to a temporary so that the small string buffer is back in use.
+            base allocated{std::move(static_cast<base&>(*this))};
+        }
+        wipe_buffer();
+    }
+
+    /**
+     * @brief
+     * Copy assignment.
+     *
+     * @param other     The string to copy.
+     */
+    wiping_basic_string& operator=(const wiping_basic_string& other)
+    {
+        return assign(other);
+    }
+
+    /**
+     * @brief
+     * Move assignment.  Wipes `other` if its characters were copied rather than its buffer being
+     * taken over.
+     *
+     * @param other     The string to move from.
+     */
+    wiping_basic_string& operator=(wiping_basic_string&& other)
+        noexcept(std::allocator_traits<Allocator>::propagate_on_container_move_assignment::value ||
+                 std::allocator_traits<Allocator>::is_always_equal::value)
+    {
+        if (&other != this) {
+            auto* other_data = other.data();
+            auto other_size = other.size();
+            auto* old_data = this->data();
+            auto old_size = this->size();
+            base::operator=(std::move(static_cast<base&>(other)));
+            wipe_vacated(old_data, old_size);
+            wipe_moved_from(other, other_data, other_size);
+        }
+        return *this;
+    }
+
+    /**
+     * @brief
+     * Assign anything `std::basic_string` can be assigned from, wiping any characters no longer in
+     * use.
+     *
+     * @param value     The value to assign.
+     */
+    template <typename U>
+        requires (!std::is_same_v<std::remove_cvref_t<U>, wiping_basic_string>) &&
+                 std::is_assignable_v<base&, U>
+    wiping_basic_string& operator=(U&& value)
+    {
+        auto* old_data = this->data();
+        auto old_size = this->size();
+        base::operator=(std::forward<U>(value));
+        wipe_vacated(old_data, old_size);
+        return *this;
+    }
+
+    /// @brief Assign a list of characters.
+    wiping_basic_string& operator=(std::initializer_list<CharT> init) { return assign(init); }
+
+    /**
+     * @brief
+     * Replace the contents, wiping any characters no longer in use.
+     *
+     * @param args  Arguments for `std::basic_string::assign()`.
+     *
+     * @return  This string.
+     */
+    template <typename... Args>
+    wiping_basic_string& assign(Args&&... args)
+    {
+        auto* old_data = this->data();
+        auto old_size = this->size();
+        base::assign(std::forward<Args>(args)...);
+        wipe_vacated(old_data, old_size);
+        return *this;
+    }
+
+    /// @copydoc assign(Args&&...)
+    wiping_basic_string& assign(std::initializer_list<CharT> init)
+    {
+        auto* old_data = this->data();
+        auto old_size = this->size();
+        base::assign(init);
+        wipe_vacated(old_data, old_size);
+        return *this;
+    }
+
+    /**
+     * @brief
+     * Replace part of the contents, wiping any characters no longer in use.
+     *
+     * @param args  Arguments for `std::basic_string::replace()`.
+     *
+     * @return  This string.
+     */
+    template <typename... Args>
+    wiping_basic_string& replace(Args&&... args)
+    {
+        auto* old_data = this->data();
+        auto old_size = this->size();
+        base::replace(std::forward<Args>(args)...);
+        wipe_vacated(old_data, old_size);
+        return *this;
+    }
+
+    /**
+     * @brief
+     * Append characters, wiping the small string buffer if they no longer fit in it.
+     *
+     * @param args  Arguments for `std::basic_string::append()`.
+     *
+     * @return  This string.
+     */
+    template <typename... Args>
+    wiping_basic_string& append(Args&&... args)
+    {
+        auto* old_data = this->data();
+        auto old_size = this->size();
+        base::append(std::forward<Args>(args)...);
+        wipe_vacated(old_data, old_size);
+        return *this;
+    }
+
+    /// @copydoc append(Args&&...)
+    wiping_basic_string& append(std::initializer_list<CharT> init)
+    {
+        return append(init.begin(), init.size());
+    }
+
+    /**
+     * @brief
+     * Append anything `std::basic_string` can be appended with, wiping the small string buffer if
+     * the characters no longer fit in it.
+     *
+     * @param value     The value to append.
+     *
+     * @return  This string.
+     */
+    template <typename U>
+        requires requires(base& b, U&& u) { b += std::forward<U>(u); }
+    wiping_basic_string& operator+=(U&& value)
+    {
+        auto* old_data = this->data();
+        auto old_size = this->size();
+        base::operator+=(std::forward<U>(value));
+        wipe_vacated(old_data, old_size);
+        return *this;
+    }
+
+    /// @brief Append a list of characters.
+    wiping_basic_string& operator+=(std::initializer_list<CharT> init) { return append(init); }
+
+    /**
+     * @brief
+     * Append a character, wiping the small string buffer if it no longer fits in it.
+     *
+     * @param ch    The character to append.
+     */
+    void push_back(CharT ch)
+    {
+        auto* old_data = this->data();
+        auto old_size = this->size();
+        base::push_back(ch);
+        wipe_vacated(old_data, old_size);
+    }
+
+    /**
+     * @brief
+     * Insert characters, wiping the small string buffer if they no longer fit in it.
+     *
+     * @param args  Arguments for `std::basic_string::insert()`.
+     *
+     * @return  This string, or an iterator to the first inserted character, whichever
+     *          `std::basic_string::insert()` returns.
+     */
+    template <typename... Args>
+    decltype(auto) insert(Args&&... args)
+    {
+        auto* old_data = this->data();
+        auto old_size = this->size();
+        if constexpr (std::is_same_v<decltype(base::insert(std::forward<Args>(args)...)), base&>) {
+            base::insert(std::forward<Args>(args)...);
+            wipe_vacated(old_data, old_size);
+            return static_cast<wiping_basic_string&>(*this);
+        } else {
+            auto index = base::insert(std::forward<Args>(args)...) - this->begin();
+            wipe_vacated(old_data, old_size);
+            return this->begin() + index;
+        }
+    }
+
+    /**
+     * @brief
+     * Insert a list of characters, wiping the small string buffer if they no longer fit in it.
+     *
+     * @param pos   Iterator to the character to insert before.
+     * @param init  The characters.
+     *
+     * @return  Iterator to the first inserted character.
+     */
+    iterator insert(const_iterator pos, std::initializer_list<CharT> init)
+    {
+        return insert(pos, init.begin(), init.end());
+    }
+
+    /**
+     * @brief
+     * Reserve storage, wiping the small string buffer if the characters move out of it.
+     *
+     * @param new_cap   Number of characters to reserve storage for.
+     */
+    void reserve(size_type new_cap)
+    {
+        auto* old_data = this->data();
+        auto old_size = this->size();
+        base::reserve(new_cap);
+        wipe_vacated(old_data, old_size);
+    }
+
+    /// @brief Erase all characters and wipe them, keeping the capacity.
+    void clear() noexcept
+    {
+        auto old_size = this->size();
+        base::clear();
+        wipe(this->data(), old_size);
+    }
+
+    /// @brief Erase the last character and wipe it.
+    void pop_back()
+    {
+        base::pop_back();
+        wipe(this->data() + this->size(), 1);
+    }
+
+    /**
+     * @brief
+     * Erase characters, wiping those vacated at the end.
+     *
+     * @param pos       Index of the first character to erase.
+     * @param count     Number of characters to erase.
+     *
+     * @return  This string.
+     */
+    wiping_basic_string& erase(size_type pos = 0, size_type count = npos)
+    {
+        auto old_size = this->size();
+        base::erase(pos, count);
+        wipe(this->data() + this->size(), old_size - this->size());
+        return *this;
+    }
+
+    /**
+     * @brief
+     * Erase a character, wiping the one vacated at the end.
+     *
+     * @param pos   Iterator to the character.
+     *
+     * @return  Iterator to the character after the erased one.
+     */
+    iterator erase(const_iterator pos)
+    {
+        auto it = base::erase(pos);
+        wipe(this->data() + this->size(), 1);
+        return it;
+    }
+
+    /**
+     * @brief
+     * Erase a range of characters, wiping those vacated at the end.
+     *
+     * @param first     Start of the range.
+     * @param last      End of the range.
+     *
+     * @return  Iterator to the character after the erased ones.
+     */
+    iterator erase(const_iterator first, const_iterator last)
+    {
+        auto old_size = this->size();
+        auto it = base::erase(first, last);
+        wipe(this->data() + this->size(), old_size - this->size());
+        return it;
+    }
+
+    /**
+     * @brief
+     * Change the number of characters, wiping any that are removed.
+     *
+     * @param count     New number of characters.
+     * @param ch        Character to append if growing.
+     */
+    void resize(size_type count, CharT ch = CharT{})
+    {
+        auto* old_data = this->data();
+        auto old_size = this->size();
+        base::resize(count, ch);
+        wipe_vacated(old_data, old_size);
+    }
+
+  private:
+    /// @brief Check if the characters are in the small string buffer inside the object.
+    [[nodiscard]] bool is_inline() const noexcept { return is_inline(this->data()); }
+
+    /// @brief Check if a buffer is the small string buffer inside the object.
+    [[nodiscard]] bool is_inline(const CharT* data) const noexcept
+    {
+        auto* p = reinterpret_cast<const std::byte*>(data);
+        auto* self = reinterpret_cast<const std::byte*>(this);
+        return p >= self && p < self + sizeof(*this);
+    }
+
+    /**
+     * @brief
+     * Wipe the whole small string buffer if the characters are in it, including the terminating
+     * null.  Only for use when the string is empty or about to be destroyed.
+     */
+    void wipe_buffer() noexcept
+    {
+        if (is_inline()) {
+            secure_zero(this->data(), (this->capacity() + 1) * sizeof(CharT));
+        }
+    }
+
+    /**
+     * @brief
+     * Wipe the characters left behind in the small string buffer after growing into an allocation.
+     *
+     * While an allocation is in use the standard library may keep its own data in part of the
+     * buffer (e.g., the capacity), so the allocation is moved to a temporary and back around the
+     * wipe.  The allocation itself stays the same.
+     */
+    void wipe_left_buffer()
+    {
+        base allocated{std::move(static_cast<base&>(*this))};
+        wipe_buffer();
+        // The temporary's allocator came from this string, so swapping back never reallocates.
+        base::swap(allocated);
+    }
+
+    /// @brief Move constructor that remembers where the source's characters were.
+    wiping_basic_string(wiping_basic_string&& other, const CharT* other_data, size_type other_size) noexcept:
+        base(std::move(static_cast<base&>(other)))
+    {
+        wipe_moved_from(other, other_data, other_size);
+    }
+
+    /**
+     * @brief
+     * Wipe characters.  The terminating null after them is not touched so it stays valid.
+     */
+    static void wipe(CharT* p, size_type count) noexcept
+    {
+        if (count != 0) {
+            // The vacated characters start after the new terminating null.
+            secure_zero(p + 1, count * sizeof(CharT));
+        }
+    }
+
+    /**
+     * @brief
+     * Wipe what an operation left behind: the characters vacated by shrinking if the buffer is
+     * still the same one, or the small string buffer if the characters moved out of it into an
+     * allocation.  An allocation that was replaced has either been handed back to the allocator
+     * or, by a move assignment, to the source which `wipe_moved_from()` wipes.
+     *
+     * @param old_data  Address of the buffer before the operation.
+     * @param old_size  Number of characters before the operation.
+     */
+    void wipe_vacated(const CharT* old_data, size_type old_size)
+    {
+        if (this->data() == old_data) {
+            if (this->size() < old_size) {
+                wipe(this->data() + this->size(), old_size - this->size());
+            }
+        } else if (is_inline(old_data) && !is_inline()) {
+            wipe_left_buffer();
+        }
+    }
+
+    /**
+     * @brief
+     * Wipe the source of a move if its buffer was not taken over, or whatever buffer it was handed
+     * in exchange (e.g., the old allocation of the destination of a move assignment).
+     *
+     * @param other         The string moved from.
+     * @param other_data    Address of its buffer before the move.
+     * @param other_size    Number of characters before the move.
+     */
+    static void wipe_moved_from(wiping_basic_string& other, const CharT* other_data, size_type other_size) noexcept
+    {
+        if (other.data() == other_data) {
+            other.base::clear();
+            wipe(other.data(), other_size);
+        } else if (!other.is_inline()) {
+            other.base::clear();
+            secure_zero(other.data(), (other.capacity() + 1) * sizeof(CharT));
+        }
+    }
+};
+
+/**
+ * @brief
+ * Erase all characters equal to a value, wiping the storage vacated at the end.
+ *
+ * @param c     The string.
+ * @param value The value to erase.
+ *
+ * @return  Number of characters erased.
+ */
+template <typename CharT, typename Traits, typename Allocator, typename U>
+typename wiping_basic_string<CharT, Traits, Allocator>::size_type erase(wiping_basic_string<CharT, Traits, Allocator>& c, const U& value)
+{
+    auto it = std::remove(c.begin(), c.end(), value);
+    auto erased = static_cast<typename wiping_basic_string<CharT, Traits, Allocator>::size_type>(c.end() - it);
+    c.erase(it, c.end());
+    return erased;
+}
+
+/**
+ * @brief
+ * Erase all characters satisfying a predicate, wiping the storage vacated at the end.
+ *
+ * @param c     The string.
+ * @param pred  The predicate.
+ *
+ * @return  Number of characters erased.
+ */
+template <typename CharT, typename Traits, typename Allocator, typename Pred>
+typename wiping_basic_string<CharT, Traits, Allocator>::size_type erase_if(wiping_basic_string<CharT, Traits, Allocator>& c, Pred pred)
+{
+    auto it = std::remove_if(c.begin(), c.end(), pred);
+    auto erased = static_cast<typename wiping_basic_string<CharT, Traits, Allocator>::size_type>(c.end() - it);
+    c.erase(it, c.end());
+    return erased;
+}
+
+/// @brief Type alias for `char` strings that wipe removed characters.
+using wiping_string = wiping_basic_string<char>;
+
+} // namespace ec
+
+/**
+ * @brief
+ * Hash a wiping string the same as the equivalent `std::basic_string`.
+ *
+ * @tparam CharT        The character type.
+ * @tparam Traits       The character traits type.
+ * @tparam Allocator    The allocator type.
+ */
+template <typename CharT, typename Traits, typename Allocator>
+struct std::hash<ec::wiping_basic_string<CharT, Traits, Allocator>> {
+    /// @brief Hash a string.
+    std::size_t operator()(const ec::wiping_basic_string<CharT, Traits, Allocator>& s) const noexcept
+    {
+        return std::hash<std::basic_string_view<CharT, Traits>>{}(s);
+    }
+};
@@ -0,0 +1,295 @@
+/**
+ * @file
+ * `std::vector` that wipes elements as soon as they are removed.
+ *
+ * @copyright 2023 Steve Kinneberg <steve.kinneberg@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <enhanced_containers/secure_zero.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <initializer_list>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace ec {
+
+/**
+ * @brief
+ * `std::vector` that wipes the storage of elements as soon as they are removed.
+ *
+ * `ec::zero_on_release_allocator` only wipes memory when it is deallocated, so with a plain
+ * `std::vector` the bytes of popped, cleared, erased or resized away elements stay behind in the
+ * spare capacity until the vector reallocates or is destroyed.  This wipes just the vacated tail
+ * of the buffer whenever the vector shrinks, so a clear-and-refill loop over a large buffer costs
+ * no more than the bytes actually in use.  The source of a move is wiped as well if its buffer was
+ * not taken over.
+ *
+ * Modifying the vector through a reference to its `std::vector` base bypasses the wiping, as do
+ * qualified calls to `std::erase()` and `std::erase_if()`; use `ec::erase()` and `ec::erase_if()`.
+ *
+ * @tparam T            The element type.
+ * @tparam Allocator    The allocator type.
+ */
+template <typename T, typename Allocator = std::allocator<T>>
+class wiping_vector: public std::vector<T, Allocator> {
+    static_assert(!std::is_same_v<T, bool>, "wiping_vector<bool> is not supported.");
+
+    /// @brief The base vector type.
+    using base = std::vector<T, Allocator>;
+
+  public:
+    using typename base::size_type;
+    using typename base::iterator;
+    using typename base::const_iterator;
+    using base::base;
+
+    /// @brief Default constructor.
+    wiping_vector() = default;
+
+    /// @brief Copy constructor.
+    wiping_vector(const wiping_vector&) = default;
+
+    /**
+     * @brief
+     * Move constructor.
+     *
+     * @param other     The vector to move from.
+     */
+    wiping_vector(wiping_vector&& other) noexcept:
+        base(std::move(static_cast<base&>(other)))
+    {}
+
+    /// @brief Destructor.
+    ~wiping_vector() = default;
+
+    /**
+     * @brief
+     * Copy assignment.
+     *
+     * @param other     The vector to copy.
+     */
+    wiping_vector& operator=(const wiping_vector& other)
+    {
+        auto* old_data = this->data();
+        auto old_size = this->size();
+        base::operator=(other);
+        wipe_tail(old_data, old_size);
+        return *this;
+    }
+
+    /**
+     * @brief
+     * Move assignment.  Wipes `other` if its elements were moved one by one rather than its buffer
+     * being taken over.
+     *
+     * @param other     The vector to move from.
+     */
+    wiping_vector& operator=(wiping_vector&& other)
+        noexcept(std::allocator_traits<Allocator>::propagate_on_container_move_assignment::value ||
+                 std::allocator_traits<Allocator>::is_always_equal::value)
+    {
+        auto* old_data = this->data();
+        auto old_size = this->size();
+        auto* other_data = other.data();
+        auto other_size = other.size();
+        base::operator=(std::move(static_cast<base&>(other)));
+        wipe_tail(old_data, old_size);
+        if (&other != this && other.data() == other_data) {
+            other.base::clear();
+            wipe(other.data(), other_size);
+        }
+        return *this;
+    }
+
+    /**
+     * @brief
+     * Replace the contents with a list of elements.
+     *
+     * @param init  The elements.
+     */
+    wiping_vector& operator=(std::initializer_list<T> init)
+    {
+        assign(init);
+        return *this;
+    }
+
+    /**
+     * @brief
+     * Replace the contents, wiping any elements no longer in use.
+     *
+     * @param args  Arguments for `std::vector::assign()`.
+     */
+    template <typename... Args>
+    void assign(Args&&... args)
+    {
+        auto* old_data = this->data();
+        auto old_size = this->size();
+        base::assign(std::forward<Args>(args)...);
+        wipe_tail(old_data, old_size);
+    }
+
+    /// @copydoc assign(Args&&...)
+    void assign(std::initializer_list<T> init)
+    {
+        auto* old_data = this->data();
+        auto old_size = this->size();
+        base::assign(init);
+        wipe_tail(old_data, old_size);
+    }
+
+    /// @brief Erase all elements and wipe their storage, keeping the capacity.
+    void clear() noexcept
+    {
+        auto old_size = this->size();
+        base::clear();
+        wipe(this->data(), old_size);
+    }
+
+    /// @brief Erase the last element and wipe its storage.
+    void pop_back()
+    {
+        base::pop_back();
+        wipe(this->data() + this->size(), 1);
+    }
+
+    /**
+     * @brief
+     * Erase an element, wiping the storage vacated at the end.
+     *
+     * @param pos   Iterator to the element.
+     *
+     * @return  Iterator to the element after the erased one.
+     */
+    iterator erase(const_iterator pos)
+    {
+        auto it = base::erase(pos);
+        wipe(this->data() + this->size(), 1);
+        return it;
+    }
+
+    /**
+     * @brief
+     * Erase a range of elements, wiping the storage vacated at the end.
+     *
+     * @param first     Start of the range.
+     * @param last      End of the range.
+     *
+     * @return  Iterator to the element after the erased ones.
+     */
+    iterator erase(const_iterator first, const_iterator last)
+    {
+        auto old_size = this->size();
+        auto it = base::erase(first, last);
+        wipe(this->data() + this->size(), old_size - this->size());
+        return it;
+    }
+
+    /**
+     * @brief
+     * Change the number of elements, wiping the storage of any that are removed.
+     *
+     * @param count     New number of elements.
+     */
+    void resize(size_type count)
+    {
+        auto* old_data = this->data();
+        auto old_size = this->size();
+        base::resize(count);
+        wipe_tail(old_data, old_size);
+    }
+
+    /**
+     * @brief
+     * Change the number of elements, wiping the storage of any that are removed.
+     *
+     * @param count     New number of elements.
+     * @param value     Value of any elements added.
+     */
+    void resize(size_type count, const T& value)
+    {
+        auto* old_data = this->data();
+        auto old_size = this->size();
+        base::resize(count, value);
+        wipe_tail(old_data, old_size);
+    }
+
+  private:
+    /// @brief Wipe the storage of a number of elements.
+    static void wipe(T* p, size_type count) noexcept
+    {
+        if (count != 0) {
+            secure_zero(p, count * sizeof(T));
+        }
+    }
+
+    /**
+     * @brief
+     * Wipe the storage vacated by shrinking, if the buffer is still the same one.  A buffer that
+     * was replaced has already been handed back to the allocator.
+     *
+     * @param old_data  Address of the buffer before the operation.
+     * @param old_size  Number of elements before the operation.
+     */
+    void wipe_tail(const T* old_data, size_type old_size) noexcept
+    {
+        if (this->data() == old_data && this->size() < old_size) {
+            wipe(this->data() + this->size(), old_size - this->size());
+        }
+    }
+};
+
+/**
+ * @brief
+ * Erase all elements equal to a value, wiping the storage vacated at the end.
+ *
+ * @param c     The vector.
+ * @param value The value to erase.
+ *
+ * @return  Number of elements erased.
+ */
+template <typename T, typename Allocator, typename U>
+typename wiping_vector<T, Allocator>::size_type erase(wiping_vector<T, Allocator>& c, const U& value)
+{
+    auto it = std::remove(c.begin(), c.end(), value);
+    auto erased = static_cast<typename wiping_vector<T, Allocator>::size_type>(c.end() - it);
+    c.erase(it, c.end());
+    return erased;
+}
+
+/**
+ * @brief
+ * Erase all elements satisfying a predicate, wiping the storage vacated at the end.
+ *
+ * @param c     The vector.
+ * @param pred  The predicate.
+ *
+ * @return  Number of elements erased.
+ */
+template <typename T, typename Allocator, typename Pred>
+typename wiping_vector<T, Allocator>::size_type erase_if(wiping_vector<T, Allocator>& c, Pred pred)
+{
+    auto it = std::remove_if(c.begin(), c.end(), pred);
+    auto erased = static_cast<typename wiping_vector<T, Allocator>::size_type>(c.end() - it);
+    c.erase(it, c.end());
+    return erased;
+}
+
+} // namespace ec
@@ -20,8 +20,11 @@
 #pragma once
 
 #include <algorithm>
+#include <enhanced_containers/details/allocate_batch.h>
 #include <enhanced_containers/details/common.h>
+#include <enhanced_containers/secure_zero.h>
 #include <memory>
+#include <type_traits>
 
 #if __cplusplus >= 201603L
 #include <memory_resource>
@@ -96,6 +99,27 @@ struct zero_on_release_allocator {
     /// @brief Copy constructor.
     zero_on_release_allocator(const zero_on_release_allocator&) = default;
 
+    /**
+     * @brief
+     * Constructor to wrap a specific upstream allocator.
+     *
+     * @param upstream  The allocator that will manage the actual memory allocations.
+     */
+    explicit zero_on_release_allocator(const upstream_allocator& upstream):
+        _upstream_allocator(upstream)
+    {}
+
+    /**
+     * @brief
+     * Get the allocator for a copy of a container.
+     *
+     * @return  An allocator over whatever the upstream allocator picks for the copy.
+     */
+    zero_on_release_allocator select_on_container_copy_construction() const
+    {
+        return zero_on_release_allocator{upstream_traits::select_on_container_copy_construction(_upstream_allocator)};
+    }
+
     /**
      * @brief
      * Constructor to move from an alternate allocation type.
@@ -166,18 +190,160 @@ struct zero_on_release_allocator {
     EC_CONSTEXPR_ALLOC
     void deallocate(T* ptr, std::size_t len)
     {
-        std::fill(reinterpret_cast<std::uint8_t*>(ptr),
-                  reinterpret_cast<std::uint8_t*>(ptr + len),
-                  0);
+#if defined(__cpp_lib_is_constant_evaluated)
+        if (std::is_constant_evaluated()) {
+            std::fill(reinterpret_cast<std::uint8_t*>(ptr),
+                      reinterpret_cast<std::uint8_t*>(ptr + len),
+                      0);
+        } else
+#endif
+        {
+            secure_zero(ptr, len * sizeof(T));
+        }
         _upstream_allocator.deallocate(ptr, len);
     }
 
+    /**
+     * @brief
+     * Allocate a batch of single objects.  Either all objects are allocated or none are.
+     *
+     * @param n     Number of objects to allocate.
+     * @param out   Array of at least `n` pointers to receive the addresses of the objects.
+     */
+    void allocate_batch(std::size_t n, T** out)
+    {
+        details::allocate_batch(_upstream_allocator, n, out);
+    }
+
+    /**
+     * @brief
+     * Zero out and deallocate a batch of single objects.
+     *
+     * @param ptrs  Array of the addresses of the objects.
+     * @param n     Number of objects to deallocate.
+     */
+    void deallocate_batch(T* const* ptrs, std::size_t n)
+    {
+        for (std::size_t i = 0; i < n; ++i) {
+            secure_zero(ptrs[i], sizeof(T));
+        }
+        details::deallocate_batch(_upstream_allocator, ptrs, n);
+    }
+
+    /**
+     * @brief
+     * Check if memory allocated by one allocator can be deallocated by another.
+     *
+     * @tparam Ts   The type parameters for the alternate form being compared with.
+     *
+     * @param other     The allocator being compared with.
+     *
+     * @return  Whether or not the upstream allocators are equal.
+     */
+    template <typename... Ts>
+    bool operator==(const zero_on_release_allocator<Ts...>& other) const noexcept
+    {
+        return _upstream_allocator == other._upstream_allocator;
+    }
+
   private:
-    upstream_allocator _upstream_allocator{};    ///< @brief The real allocator that will manage the actual memory allocations.
+    [[no_unique_address]] upstream_allocator _upstream_allocator{};    ///< @brief The real allocator that will manage the actual memory allocations.
 
     template <typename, typename>
     friend class zero_on_release_allocator;
 };
 
 
+#if __cplusplus >= 201603L
+namespace pmr {
+
+/**
+ * @brief
+ * This is a `std::pmr::memory_resource` adapter that will ensure that the memory it hands out is
+ * zeroed out on deallocation.
+ *
+ * @code
+ * ec::pmr::zero_on_release_resource wiping;
+ * std::pmr::unsynchronized_pool_resource pool{&wiping};
+ * @endcode
+ *
+ * Important note: Memory is zeroed out when it is returned to this resource.  A pooling resource
+ *                 layered on top only does that when it releases memory upstream, not every time
+ *                 a container deallocates.
+ */
+class zero_on_release_resource: public std::pmr::memory_resource {
+  public:
+    /**
+     * @brief
+     * Constructor.
+     *
+     * @param upstream  The resource that will manage the actual memory allocations.
+     */
+    explicit zero_on_release_resource(std::pmr::memory_resource* upstream = std::pmr::get_default_resource()) noexcept:
+        _upstream{upstream}
+    {}
+
+    /// @brief Copying is not allowed, just like the standard resources.
+    zero_on_release_resource(const zero_on_release_resource&) = delete;
+    /// @brief Copying is not allowed, just like the standard resources.
+    zero_on_release_resource& operator=(const zero_on_release_resource&) = delete;
+
+    /**
+     * @brief
+     * Get the upstream resource.
+     *
+     * @return  The resource that manages the actual memory allocations.
+     */
+    std::pmr::memory_resource* upstream_resource() const noexcept { return _upstream; }
+
+  protected:
+    /**
+     * @brief
+     * Allocate memory from the upstream resource.
+     *
+     * @param len       Number of bytes to allocate.
+     * @param alignment Required alignment of the memory.
+     *
+     * @return  Address of the allocated memory.
+     */
+    void* do_allocate(std::size_t len, std::size_t alignment) override
+    {
+        return _upstream->allocate(len, alignment);
+    }
+
+    /**
+     * @brief
+     * Zero out memory and return it to the upstream resource.
+     *
+     * @param ptr       Address of the memory to be deallocated.
+     * @param len       Number of bytes to deallocate.
+     * @param alignment Alignment the memory was allocated with.
+     */
+    void do_deallocate(void* ptr, std::size_t len, std::size_t alignment) override
+    {
+        secure_zero(ptr, len);
+        _upstream->deallocate(ptr, len, alignment);
+    }
+
+    /**
+     * @brief
+     * Check if memory allocated from this resource can be deallocated by another one.
+     *
+     * @param other     The other resource.
+     *
+     * @return  Whether or not the resources are interchangeable.
+     */
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+    {
+        const auto* that = dynamic_cast<const zero_on_release_resource*>(&other);
+        return that != nullptr && _upstream->is_equal(*that->_upstream);
+    }
+
+  private:
+    std::pmr::memory_resource* _upstream;   ///< @brief The resource that manages the actual memory allocations.
+};
+
+} // namespace pmr
+#endif
+
 } // namespace ec
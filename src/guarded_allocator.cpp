@@ -0,0 +1,293 @@
+/**
+ * @file
+ * Heap that places every allocation flush against an inaccessible guard page.
+ *
+ * @copyright 2023 Steve Kinneberg <steve.kinneberg@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <enhanced_containers/guarded_allocator.h>
+#include <enhanced_containers/no_swap_allocator.h>
+#include <enhanced_containers/secure_zero.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <random>
+
+
+#if defined(__linux__) || defined(__unix) || defined(__unix__)
+#include <sys/mman.h>
+
+namespace {
+/**
+ * @brief
+ * Linux implementation to reserve inaccessible address space.
+ *
+ * @param len   Number of bytes to reserve.
+ *
+ * @return  Address of the reserved memory.
+ */
+std::byte* reserve_memory(std::size_t len)
+{
+    void* ptr = mmap(nullptr, len, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (ptr == MAP_FAILED) {
+        throw std::bad_alloc{};
+    }
+    return static_cast<std::byte*>(ptr);
+}
+
+/**
+ * @brief
+ * Linux implementation to return reserved address space to the OS.
+ */
+void release_memory(std::byte* ptr, std::size_t len) noexcept
+{
+    munmap(ptr, len);
+}
+
+/**
+ * @brief
+ * Linux implementation to make reserved pages accessible.
+ */
+void open_pages(std::byte* ptr, std::size_t len)
+{
+    if (mprotect(ptr, len, PROT_READ | PROT_WRITE) != 0) {
+        throw std::bad_alloc{};
+    }
+}
+
+/**
+ * @brief
+ * Linux implementation to make pages inaccessible again.
+ *
+ * Mapping fresh pages over them rather than just changing the protection also drops their
+ * contents in the same OS call.  If no mapping can be made (e.g., at `vm.max_map_count`), the
+ * pages are wiped and protected in place instead.
+ *
+ * @return  Whether the pages are inaccessible and wiped, so that they may be handed out again.
+ */
+bool close_pages(std::byte* ptr, std::size_t len) noexcept
+{
+    if (mmap(ptr, len, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_FIXED, -1, 0) != MAP_FAILED) {
+        return true;
+    }
+    // A failed MAP_FIXED may already have unmapped the pages; only touch them if they are there.
+    if (mprotect(ptr, len, PROT_READ | PROT_WRITE) != 0) {
+        return false;
+    }
+    ec::secure_zero(ptr, len);
+    return mprotect(ptr, len, PROT_NONE) == 0;
+}
+}
+
+
+#elif defined(_WIN32)
+#warning Windows support has not been tested.
+#include <memoryapi.h>
+
+namespace {
+/**
+ * @brief
+ * Microsoft Windows implementation to reserve inaccessible address space.
+ */
+std::byte* reserve_memory(std::size_t len)
+{
+    void* ptr = VirtualAlloc(nullptr, len, MEM_RESERVE, PAGE_NOACCESS);
+    if (ptr == nullptr) {
+        throw std::bad_alloc{};
+    }
+    return static_cast<std::byte*>(ptr);
+}
+
+/**
+ * @brief
+ * Microsoft Windows implementation to return reserved address space to the OS.
+ */
+void release_memory(std::byte* ptr, std::size_t) noexcept
+{
+    VirtualFree(ptr, 0, MEM_RELEASE);
+}
+
+/**
+ * @brief
+ * Microsoft Windows implementation to make reserved pages accessible.
+ */
+void open_pages(std::byte* ptr, std::size_t len)
+{
+    if (VirtualAlloc(ptr, len, MEM_COMMIT, PAGE_READWRITE) == nullptr) {
+        throw std::bad_alloc{};
+    }
+}
+
+/**
+ * @brief
+ * Microsoft Windows implementation to make pages inaccessible again.
+ */
+bool close_pages(std::byte* ptr, std::size_t len) noexcept
+{
+    if (VirtualFree(ptr, len, MEM_DECOMMIT)) {
+        return true;
+    }
+    ec::secure_zero(ptr, len);
+    DWORD old_protection;
+    return VirtualProtect(ptr, len, PAGE_NOACCESS, &old_protection) != 0;
+}
+}
+
+
+#elif defined(__APPLE__) && defined(__MACOS__)
+#error Not supported yet.
+#endif
+
+
+namespace {
+/// @brief Number of words in a canary.
+constexpr std::size_t canary_words{ec::guarded_heap::canary_size / sizeof(std::uint64_t)};
+
+/**
+ * @brief
+ * Round a length up to a multiple of a power of two.
+ */
+constexpr std::size_t round_up(std::size_t len, std::size_t multiple) noexcept
+{
+    return (len + multiple - 1) & ~(multiple - 1);
+}
+
+/**
+ * @brief
+ * Get a secret that cannot be guessed by an attacker that cannot read process memory.
+ */
+std::uint64_t make_secret()
+{
+    std::random_device rd;
+    return (std::uint64_t{rd()} << 32) ^ rd();
+}
+}
+
+
+namespace ec {
+
+guarded_heap& guarded_heap::get_instance()
+{
+    static guarded_heap* self{new guarded_heap{}};
+    return *self;
+}
+
+guarded_heap::guarded_heap():
+    _canary_secret{make_secret()},
+    _page_size{details::no_swap_allocator_state::get_state_object().page_size()}
+{
+    _free_slots.resize(max_slot_size / _page_size + 1);
+}
+
+void* guarded_heap::allocate(std::size_t len, std::size_t alignment, bool canary)
+{
+    auto bytes = round_up(len == 0 ? 1 : len, alignment);
+    auto pages = round_up(bytes + (canary ? canary_size : 0), _page_size) / _page_size;
+    auto data_len = pages * _page_size;
+
+    std::byte* data;
+    if (data_len > max_slot_size) {
+        // A dedicated mapping with a guard page on either side.
+        data = reserve_memory(data_len + 2 * _page_size) + _page_size;
+        try {
+            open_pages(data, data_len);
+        } catch (...) {
+            release_memory(data - _page_size, data_len + 2 * _page_size);
+            throw;
+        }
+    } else {
+        data = take_slot(pages);
+        try {
+            open_pages(data, data_len);
+        } catch (...) {
+            std::lock_guard lk{_mutex};
+            _free_slots[pages].push_back(data);
+            throw;
+        }
+    }
+
+    auto* ptr = data + data_len - bytes;
+    if (canary) {
+        auto value = canary_value(ptr);
+        for (std::size_t i = 0; i < canary_words; ++i) {
+            std::memcpy(ptr - canary_size + i * sizeof(value), &value, sizeof(value));
+        }
+    }
+    return ptr;
+}
+
+void guarded_heap::deallocate(void* ptr, std::size_t len, std::size_t alignment, bool canary)
+{
+    auto* p = static_cast<std::byte*>(ptr);
+    auto bytes = round_up(len == 0 ? 1 : len, alignment);
+
+    if (canary) {
+        auto expected = canary_value(p);
+        for (std::size_t i = 0; i < canary_words; ++i) {
+            std::uint64_t value;
+            std::memcpy(&value, p - canary_size + i * sizeof(value), sizeof(value));
+            if (value != expected) {
+                // Something wrote before the start of the allocation.  Nothing can be trusted.
+                std::abort();
+            }
+        }
+    }
+
+    auto& state = details::no_swap_allocator_state::get_state_object();
+    auto* data = state.to_page(p - (canary ? canary_size : 0));
+    auto data_len = static_cast<std::size_t>(p + bytes - data);
+
+    if (data_len > max_slot_size) {
+        release_memory(data - _page_size, data_len + 2 * _page_size);
+        return;
+    }
+
+    if (!close_pages(data, data_len)) {
+        // Leave the slot out of circulation rather than hand out pages that may still be readable.
+        return;
+    }
+    std::lock_guard lk{_mutex};
+    _free_slots[data_len / _page_size].push_back(data);
+}
+
+std::byte* guarded_heap::take_slot(std::size_t pages)
+{
+    std::lock_guard lk{_mutex};
+
+    auto& free_slots = _free_slots[pages];
+    if (!free_slots.empty()) {
+        auto* data = free_slots.back();
+        free_slots.pop_back();
+        return data;
+    }
+
+    // Each slot is followed by a guard page; the first page of a region guards the first slot.
+    auto slot_len = (pages + 1) * _page_size;
+    if (static_cast<std::size_t>(_end - _next) < slot_len) {
+        _next = reserve_memory(region_size) + _page_size;
+        _end = _next - _page_size + region_size;
+    }
+    auto* data = _next;
+    _next += slot_len;
+    return data;
+}
+
+std::uint64_t guarded_heap::canary_value(const void* ptr) const noexcept
+{
+    return _canary_secret ^ reinterpret_cast<std::uintptr_t>(ptr);
+}
+
+} // namespace ec
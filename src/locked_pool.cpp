@@ -0,0 +1,646 @@
+/**
+ * @file
+ * Pool of memory that is locked to RAM up front.
+ *
+ * @copyright 2023 Steve Kinneberg <steve.kinneberg@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <enhanced_containers/locked_pool.h>
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <new>
+#include <utility>
+
+
+#if defined(__linux__) || defined(__unix) || defined(__unix__)
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace {
+/**
+ * @brief
+ * Linux implementation to get the number of bytes in a page of memory.
+ *
+ * @return The number of bytes in a page of memory.
+ */
+std::size_t get_page_size()
+{
+    return sysconf(_SC_PAGESIZE);
+}
+
+/**
+ * @brief
+ * Linux implementation to map fresh memory from the OS.
+ *
+ * @param len   Number of bytes to map.
+ *
+ * @return  Address of the mapped memory.
+ */
+void* map_memory(std::size_t len)
+{
+    void* ptr = mmap(nullptr, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (ptr == MAP_FAILED) {
+        throw std::bad_alloc{};
+    }
+    return ptr;
+}
+
+/**
+ * @brief
+ * Linux implementation to get the size of the huge pages backing large anonymous mappings.
+ *
+ * @return  Number of bytes in a huge page, or 0 if transparent huge pages are disabled or huge page
+ *          support was not built in.
+ */
+std::size_t get_huge_page_size() noexcept
+{
+#if defined(EC_ENABLE_HUGE_PAGES)
+    char mode[64]{};
+    if (auto* f = std::fopen("/sys/kernel/mm/transparent_hugepage/enabled", "r")) {
+        static_cast<void>(std::fgets(mode, sizeof(mode), f));
+        std::fclose(f);
+    }
+    std::size_t size{};
+    if (auto* f = std::fopen("/sys/kernel/mm/transparent_hugepage/hpage_pmd_size", "r")) {
+        if (std::fscanf(f, "%zu", &size) != 1) {
+            size = 0;
+        }
+        std::fclose(f);
+    }
+    if (std::strstr(mode, "[never]") != nullptr || !std::has_single_bit(size)) {
+        return 0;
+    }
+    return size;
+#else
+    return 0;
+#endif
+}
+
+/**
+ * @brief
+ * Linux implementation to map memory from the reserved hugetlbfs pages.
+ *
+ * Such memory is never swapped.  The pages are reserved when mapping, so this fails up front if
+ * there are not enough of them.
+ *
+ * @param len   Number of bytes to map.  Must be a multiple of the huge page size.
+ *
+ * @return  Address of the mapped memory or `nullptr` on failure.
+ */
+void* map_hugetlb_memory(std::size_t len) noexcept
+{
+#if defined(MAP_HUGETLB)
+    void* ptr = mmap(nullptr, len, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | MAP_POPULATE, -1, 0);
+    return ptr == MAP_FAILED ? nullptr : ptr;
+#else
+    static_cast<void>(len);
+    return nullptr;
+#endif
+}
+
+/**
+ * @brief
+ * Linux implementation to map memory aligned to huge pages and ask for it to be backed by
+ * transparent huge pages.
+ *
+ * The memory is not populated, so that it is faulted in as huge pages when it is locked.
+ *
+ * @param len               Number of bytes to map.
+ * @param huge_page_size    Number of bytes in a huge page.
+ *
+ * @return  Address of the mapped memory or `nullptr` on failure.
+ */
+void* map_transparent_huge_memory(std::size_t len, std::size_t huge_page_size) noexcept
+{
+    // Over-allocate by a huge page and trim the ends so that the mapping is huge page aligned.
+    auto padded = len + huge_page_size;
+    void* raw = mmap(nullptr, padded, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (raw == MAP_FAILED) {
+        return nullptr;
+    }
+    auto start = reinterpret_cast<std::uintptr_t>(raw);
+    auto aligned = (start + huge_page_size - 1) & ~(huge_page_size - 1);
+    if (aligned != start) {
+        munmap(raw, aligned - start);
+    }
+    auto tail = start + padded - (aligned + len);
+    if (tail != 0) {
+        munmap(reinterpret_cast<void*>(aligned + len), tail);
+    }
+    auto* ptr = reinterpret_cast<void*>(aligned);
+    madvise(ptr, len, MADV_HUGEPAGE);
+    return ptr;
+}
+
+/**
+ * @brief
+ * Linux implementation to map memory from `memfd_secret()`.
+ *
+ * Such memory is never swapped and is removed from the kernel's direct map.
+ *
+ * @param len   Number of bytes to map.
+ *
+ * @return  Address of the mapped memory or `nullptr` with `errno` set on failure.
+ */
+void* map_secret_memory([[maybe_unused]] std::size_t len) noexcept
+{
+#if defined(EC_ENABLE_MEMFD_SECRET) && defined(SYS_memfd_secret)
+    int fd = static_cast<int>(syscall(SYS_memfd_secret, O_CLOEXEC));
+    if (fd < 0) {
+        return nullptr;
+    }
+    void* ptr{MAP_FAILED};
+    if (ftruncate(fd, static_cast<off_t>(len)) == 0) {
+        ptr = mmap(nullptr, len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    auto saved_errno = errno;
+    close(fd);      // The mapping keeps the memory alive.
+    errno = saved_errno;
+    return ptr == MAP_FAILED ? nullptr : ptr;
+#else
+    errno = ENOSYS;
+    return nullptr;
+#endif
+}
+
+/**
+ * @brief
+ * Linux implementation to map memory that is locked by the kernel as part of the mapping.
+ *
+ * @param len   Number of bytes to map.
+ *
+ * @return  Address of the mapped memory or `nullptr` with `errno` set on failure.
+ */
+void* map_prelocked_memory(std::size_t len) noexcept
+{
+    void* ptr = mmap(nullptr, len, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS | MAP_LOCKED | MAP_POPULATE, -1, 0);
+    return ptr == MAP_FAILED ? nullptr : ptr;
+}
+
+/**
+ * @brief
+ * Linux implementation to check if a failure to map memory means that the mechanism is not
+ * available at all, as opposed to running out of memory or hitting `RLIMIT_MEMLOCK`.
+ *
+ * @return  Whether or not to stop trying the mechanism.
+ */
+bool is_unsupported() noexcept
+{
+    return errno != ENOMEM && errno != EAGAIN;
+}
+
+/**
+ * @brief
+ * Linux implementation to get the best mechanism to try first.
+ *
+ * @return  The best backend.
+ */
+ec::locked_pool_backend best_backend() noexcept
+{
+#if defined(EC_ENABLE_MEMFD_SECRET) && defined(SYS_memfd_secret)
+    return ec::locked_pool_backend::memfd_secret;
+#else
+    return ec::locked_pool_backend::map_locked;
+#endif
+}
+
+/**
+ * @brief
+ * Linux implementation to return mapped memory to the OS.
+ *
+ * @param ptr   Address of the mapped memory.
+ * @param len   Number of bytes mapped.
+ */
+void unmap_memory(void* ptr, std::size_t len) noexcept
+{
+    munmap(ptr, len);
+}
+}
+
+
+
+#elif defined(_WIN32)
+#warning Windows support has not been tested.
+#include <memoryapi.h>
+#include <sysinfoapi.h>
+
+namespace {
+/**
+ * @brief
+ * Microsoft Windows implementation to get the number of bytes in a page of memory.
+ *
+ * @return The number of bytes in a page of memory.
+ */
+std::size_t get_page_size()
+{
+    SYSTEM_INFO si;
+    GetSystemInfo(&si);
+    return si.dwPageSize;
+}
+
+/**
+ * @brief
+ * Microsoft Windows implementation to map fresh memory from the OS.
+ */
+void* map_memory(std::size_t len)
+{
+    void* ptr = VirtualAlloc(nullptr, len, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+    if (ptr == nullptr) {
+        throw std::bad_alloc{};
+    }
+    return ptr;
+}
+
+/**
+ * @brief
+ * Huge pages are not used on Microsoft Windows.  Large pages there need the lock memory privilege
+ * and cannot be mixed with normal pages in a mapping.
+ */
+std::size_t get_huge_page_size() noexcept
+{
+    return 0;
+}
+
+/**
+ * @brief
+ * Huge pages are not used on Microsoft Windows.
+ */
+void* map_hugetlb_memory(std::size_t) noexcept
+{
+    return nullptr;
+}
+
+/**
+ * @brief
+ * Huge pages are not used on Microsoft Windows.
+ */
+void* map_transparent_huge_memory(std::size_t, std::size_t) noexcept
+{
+    return nullptr;
+}
+
+/**
+ * @brief
+ * Microsoft Windows has no equivalent to `memfd_secret()`.
+ */
+void* map_secret_memory(std::size_t) noexcept
+{
+    return nullptr;
+}
+
+/**
+ * @brief
+ * Microsoft Windows cannot lock memory as part of mapping it.
+ */
+void* map_prelocked_memory(std::size_t) noexcept
+{
+    return nullptr;
+}
+
+/**
+ * @brief
+ * Microsoft Windows implementation to check if a failure to map memory means that the mechanism
+ * is not available at all.
+ */
+bool is_unsupported() noexcept
+{
+    return true;
+}
+
+/**
+ * @brief
+ * Microsoft Windows implementation to get the best mechanism to try first.
+ */
+ec::locked_pool_backend best_backend() noexcept
+{
+    return ec::locked_pool_backend::mlock;
+}
+
+/**
+ * @brief
+ * Microsoft Windows implementation to return mapped memory to the OS.
+ */
+void unmap_memory(void* ptr, std::size_t) noexcept
+{
+    VirtualFree(ptr, 0, MEM_RELEASE);
+}
+}
+
+
+#elif defined(__APPLE__) && defined(__MACOS__)
+#error Not supported yet.
+#endif
+
+
+
+namespace ec {
+
+locked_pool& locked_pool::get_instance()
+{
+    static locked_pool* self{new locked_pool{}};
+    return *self;
+}
+
+locked_pool::locked_pool():
+    _backend{best_backend()},
+    _page_size{get_page_size()},
+    _huge_page_size{get_huge_page_size()}
+{}
+
+/// @brief Per thread magazines.
+struct locked_pool::thread_cache {
+    /// @brief Life cycle of the magazines of a thread.
+    enum class state: unsigned char {
+        unused,     ///< @brief Not used by this thread yet.
+        active,     ///< @brief In use.
+        retired,    ///< @brief Returned to the pool during thread exit.
+    };
+
+    std::array<magazine, cached_class_count> magazines;     ///< @brief Magazine per cached size class.
+    state current;                                          ///< @brief Life cycle state.
+};
+
+void* locked_pool::allocate(std::size_t len)
+{
+    if (len > max_block_size) {
+        auto size = block_size(len);
+        auto* ptr = map_locked(size);
+        add_usage(_in_use_bytes, _in_use_bytes_high_water, size);
+        return ptr;
+    }
+
+    auto index = size_class_index(len);
+    if (index < cached_class_count) {
+        if (auto* cache = local_cache()) {
+            auto& mag = cache->magazines[index];
+            if (mag.head == nullptr) {
+                refill_magazine(index, mag);
+            }
+            --mag.count;
+            return std::exchange(mag.head, mag.head->next);
+        }
+    }
+
+    auto size = min_block_size << index;
+    void* ptr;
+    {
+        auto& sc = _size_classes[index];
+        std::lock_guard lk{sc.mutex};
+        ptr = take_block(sc, size);
+    }
+    add_usage(_in_use_bytes, _in_use_bytes_high_water, size);
+    return ptr;
+}
+
+void locked_pool::deallocate(void* ptr, std::size_t len)
+{
+    auto size = block_size(len);
+
+    if (len > max_block_size) {
+        _in_use_bytes.fetch_sub(size, std::memory_order_relaxed);
+        unmap_locked(ptr, size);
+        return;
+    }
+
+    auto index = size_class_index(len);
+    auto* block = ::new (ptr) free_block{};
+    if (index < cached_class_count) {
+        if (auto* cache = local_cache()) {
+            auto& mag = cache->magazines[index];
+            if (mag.count == magazine_capacity) {
+                drain_magazine(index, mag, magazine_batch);
+            }
+            block->next = std::exchange(mag.head, block);
+            ++mag.count;
+            return;
+        }
+    }
+
+    _in_use_bytes.fetch_sub(size, std::memory_order_relaxed);
+    auto& sc = _size_classes[index];
+    std::lock_guard lk{sc.mutex};
+    block->next = std::exchange(sc.free_list, block);
+}
+
+std::size_t locked_pool::block_size(std::size_t len) const noexcept
+{
+    if (len > max_block_size) {
+        return (len + _page_size - 1) / _page_size * _page_size;
+    }
+    return min_block_size << size_class_index(len);
+}
+
+locked_pool_statistics locked_pool::statistics() const noexcept
+{
+    return {
+        _locked_bytes.load(std::memory_order_relaxed),
+        _locked_bytes_high_water.load(std::memory_order_relaxed),
+        _in_use_bytes.load(std::memory_order_relaxed),
+        _in_use_bytes_high_water.load(std::memory_order_relaxed),
+    };
+}
+
+std::size_t locked_pool::size_class_index(std::size_t len) noexcept
+{
+    if (len <= min_block_size) {
+        return 0;
+    }
+    return std::bit_width(len - 1) - std::countr_zero(min_block_size);
+}
+
+locked_pool::thread_cache* locked_pool::local_cache() noexcept
+{
+    // The magazines are trivially destructible so that they remain accessible after the drainer
+    // below has run.  Deallocations made later during thread exit, e.g. by other thread_local
+    // objects, see the retired state and go straight to the shared size classes.
+    static thread_local thread_cache cache{};
+
+    if (cache.current != thread_cache::state::active) [[unlikely]] {
+        if (cache.current == thread_cache::state::retired) {
+            return nullptr;
+        }
+
+        struct drainer {
+            ~drainer()
+            {
+                auto& pool = get_instance();
+                cache.current = thread_cache::state::retired;
+                for (std::size_t i = 0; i < cached_class_count; ++i) {
+                    pool.drain_magazine(i, cache.magazines[i], cache.magazines[i].count);
+                }
+            }
+        };
+        static thread_local drainer drain_on_exit;
+        cache.current = thread_cache::state::active;
+    }
+    return &cache;
+}
+
+void* locked_pool::take_block(size_class& sc, std::size_t block_size)
+{
+    if (sc.free_list) {
+        return std::exchange(sc.free_list, sc.free_list->next);
+    }
+    if (sc.slab_cursor == sc.slab_end) {
+        refill(sc, block_size);
+    }
+    return std::exchange(sc.slab_cursor, sc.slab_cursor + block_size);
+}
+
+void locked_pool::refill_magazine(std::size_t index, magazine& mag)
+{
+    auto size = min_block_size << index;
+    auto& sc = _size_classes[index];
+    {
+        std::lock_guard lk{sc.mutex};
+        try {
+            for (; mag.count < magazine_batch; ++mag.count) {
+                mag.head = ::new (take_block(sc, size)) free_block{mag.head};
+            }
+        } catch (...) {
+            // Make do with a partial batch if there is one.
+            if (mag.count == 0) {
+                throw;
+            }
+        }
+    }
+    add_usage(_in_use_bytes, _in_use_bytes_high_water, size * mag.count);
+}
+
+void locked_pool::drain_magazine(std::size_t index, magazine& mag, std::size_t count) noexcept
+{
+    if (count == 0) {
+        return;
+    }
+
+    // Detach the first count blocks before taking the lock.
+    auto* first = mag.head;
+    auto* last = first;
+    for (std::size_t i = 1; i < count; ++i) {
+        last = last->next;
+    }
+    mag.head = last->next;
+    mag.count -= count;
+
+    auto& sc = _size_classes[index];
+    {
+        std::lock_guard lk{sc.mutex};
+        last->next = std::exchange(sc.free_list, first);
+    }
+    _in_use_bytes.fetch_sub((min_block_size << index) * count, std::memory_order_relaxed);
+}
+
+void locked_pool::refill(size_class& sc, std::size_t block_size)
+{
+    auto size = std::max(block_size, slab_size);
+
+    std::lock_guard lk{_chunk_mutex};
+    if (static_cast<std::size_t>(_chunk_end - _chunk_cursor) < size) {
+        // Whatever is left of the old chunk is too small for this slab and is abandoned.  It is
+        // never more than max_block_size - slab_size bytes.
+        _chunk_cursor = static_cast<std::byte*>(map_locked(chunk_size));
+        _chunk_end = _chunk_cursor + chunk_size;
+    }
+    sc.slab_cursor = std::exchange(_chunk_cursor, _chunk_cursor + size);
+    sc.slab_end = _chunk_cursor;
+}
+
+void* locked_pool::map_locked(std::size_t len)
+{
+    auto backend = _backend.load(std::memory_order_relaxed);
+    void* ptr{};
+    bool prelocked{};
+
+    if (_huge_page_size != 0 && len >= _huge_page_size && backend != locked_pool_backend::memfd_secret) {
+        if ((len & (_huge_page_size - 1)) == 0) {
+            // Never swapped, so nothing to lock.
+            ptr = map_hugetlb_memory(len);
+            prelocked = ptr != nullptr;
+        }
+        if (ptr == nullptr) {
+            // Locked below, which faults the memory in as huge pages.
+            ptr = map_transparent_huge_memory(len, _huge_page_size);
+        }
+    }
+
+    if (ptr == nullptr && backend == locked_pool_backend::memfd_secret) {
+        ptr = map_secret_memory(len);
+        prelocked = ptr != nullptr;
+        if (ptr == nullptr && is_unsupported()) {
+            _backend.compare_exchange_strong(backend, locked_pool_backend::map_locked,
+                                             std::memory_order_relaxed);
+            backend = locked_pool_backend::map_locked;
+        }
+    }
+    if (ptr == nullptr && backend != locked_pool_backend::mlock) {
+        ptr = map_prelocked_memory(len);
+        prelocked = ptr != nullptr;
+        if (ptr == nullptr && is_unsupported()) {
+            _backend.compare_exchange_strong(backend, locked_pool_backend::mlock,
+                                             std::memory_order_relaxed);
+        }
+    }
+
+    auto& state = details::no_swap_allocator_state::get_state_object();
+    if (prelocked) {
+        // Already unswappable.  Just make sure no swap allocators layered on top never unlock it.
+        try {
+            state.serialized_adopt_allocation(ptr, len);
+        } catch (...) {
+            unmap_memory(ptr, len);
+            throw;
+        }
+    } else {
+        if (ptr == nullptr) {
+            ptr = map_memory(len);
+        }
+        try {
+            state.serialized_add_allocation(ptr, len);
+        } catch (...) {
+            unmap_memory(ptr, len);
+            throw;
+        }
+    }
+    add_usage(_locked_bytes, _locked_bytes_high_water, len);
+    return ptr;
+}
+
+void locked_pool::unmap_locked(void* ptr, std::size_t len)
+{
+    details::no_swap_allocator_state::get_state_object().serialized_release_mapping(ptr, len);
+    unmap_memory(ptr, len);
+    _locked_bytes.fetch_sub(len, std::memory_order_relaxed);
+}
+
+void locked_pool::add_usage(std::atomic<std::size_t>& counter, std::atomic<std::size_t>& high_water,
+                            std::size_t len) noexcept
+{
+    auto now = counter.fetch_add(len, std::memory_order_relaxed) + len;
+    auto peak = high_water.load(std::memory_order_relaxed);
+    while (now > peak && !high_water.compare_exchange_weak(peak, now, std::memory_order_relaxed)) {
+    }
+}
+
+} // namespace ec
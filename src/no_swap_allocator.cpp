@@ -19,12 +19,21 @@
  */
 
 #include <enhanced_containers/no_swap_allocator.h>
+#include <enhanced_containers/secure_zero.h>
 
-#include <unordered_map>
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <limits>
+#include <new>
+#include <stdexcept>
+#include <system_error>
+#include <utility>
 
 
 #if defined(__linux__) || defined(__unix) || defined(__unix__)
 #include <sys/mman.h>
+#include <sys/resource.h>
 #include <unistd.h>
 
 namespace {
@@ -70,6 +79,21 @@ void unpin_memory(const void* ptr, std::size_t len)
         throw std::system_error{errno, std::system_category(), "unpinning memory"};
     }
 }
+
+/**
+ * @brief
+ * Linux implementation to get the most bytes of memory the process may lock to RAM.
+ *
+ * @return  The `RLIMIT_MEMLOCK` soft limit, or the maximum value if unlimited.
+ */
+std::uint64_t get_pin_limit() noexcept
+{
+    rlimit limit{};
+    if (getrlimit(RLIMIT_MEMLOCK, &limit) != 0 || limit.rlim_cur == RLIM_INFINITY) {
+        return std::numeric_limits<std::uint64_t>::max();
+    }
+    return limit.rlim_cur;
+}
 }
 
 
@@ -118,6 +142,16 @@ void unpin_memory(const void* ptr, std::size_t len)
         throw std::system_error(GetLastError(), "pinning memory");
     }
 }
+
+/**
+ * @brief
+ * Microsoft Windows implementation to get the most bytes of memory the process may lock to RAM.
+ * The limit is the process working set size, which is not tracked here.
+ */
+std::uint64_t get_pin_limit() noexcept
+{
+    return std::numeric_limits<std::uint64_t>::max();
+}
 }
 
 
@@ -132,85 +166,688 @@ namespace ec {
 
 namespace details {
 
-std::shared_ptr<no_swap_allocator_state> no_swap_allocator_state::_self{};
+namespace {
+/**
+ * @brief
+ * Merges consecutive, contiguous page ranges into maximal runs before handing them off so that
+ * runs that cross shard boundaries still result in a single OS call.
+ *
+ * @tparam F    Function type with the signature `void(page_range_table::address,
+ *              page_range_table::address)`.
+ */
+template <typename F>
+class run_accumulator {
+  public:
+    /// @brief Type alias for the address type used in the page range tables.
+    using address = page_range_table::address;
+
+    /**
+     * @brief
+     * Constructor.
+     *
+     * @param f     Function to call with the bounds of each maximal run.
+     */
+    explicit run_accumulator(F f): _f{std::move(f)} {}
+
+    /**
+     * @brief
+     * Add a range to the current run, or start a new run if it is not contiguous.
+     *
+     * @param start     Start of the range.
+     * @param end       End of the range.
+     */
+    void operator()(address start, address end)
+    {
+        if (_start != _end && _end == start) {
+            _end = end;
+            return;
+        }
+        flush();
+        _start = start;
+        _end = end;
+    }
+
+    /// @brief Hand off the current run, if any.
+    void flush()
+    {
+        if (_start != _end) {
+            auto start = std::exchange(_start, address{});
+            auto end = std::exchange(_end, address{});
+            _f(start, end);
+        }
+    }
+
+  private:
+    F _f;               ///< @brief Function to call with each maximal run.
+    address _start{};   ///< @brief Start of the current run.
+    address _end{};     ///< @brief End of the current run.
+};
 
-std::shared_ptr<no_swap_allocator_state> no_swap_allocator_state::get_state_object()
+/**
+ * @brief
+ * Make an OS call and add the time spent in it to a counter, whether or not it fails.
+ *
+ * @tparam F    Function type with the signature `void()`.
+ *
+ * @param nanoseconds   Counter to add the time spent to.
+ * @param f             Function making the OS call.
+ */
+template <typename F>
+void timed_syscall(std::atomic<std::uint64_t>& nanoseconds, F&& f)
 {
-    if (!_self) {
-        _self.reset(new no_swap_allocator_state{});
+    auto begin = std::chrono::steady_clock::now();
+    auto charge = [&nanoseconds, begin]() noexcept {
+        auto elapsed = std::chrono::steady_clock::now() - begin;
+        nanoseconds.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count(),
+                              std::memory_order_relaxed);
+    };
+    try {
+        f();
+    } catch (...) {
+        charge();
+        throw;
     }
-    return _self;
+    charge();
+}
+
+/**
+ * @brief
+ * Get the current time of the steady clock.
+ *
+ * @return  Nanoseconds since the steady clock's epoch.
+ */
+std::int64_t steady_nanoseconds() noexcept
+{
+    auto now = std::chrono::steady_clock::now().time_since_epoch();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(now).count();
+}
 }
 
+#if EC_PAGE_SIZE
+no_swap_allocator_state::no_swap_allocator_state()
+{
+    if (get_page_size() != EC_PAGE_SIZE) {
+        throw std::runtime_error("EC_PAGE_SIZE does not match the page size of the system");
+    }
+}
+#else
 no_swap_allocator_state::no_swap_allocator_state():
-    _page_size{get_page_size()}
+    _page_shift{static_cast<std::size_t>(std::countr_zero(get_page_size()))}
 {}
+#endif
 
 
 void no_swap_allocator_state::add_allocation(void* ptr, std::size_t len)
 {
-    auto bptr = reinterpret_cast<std::byte*>(ptr);
-    auto page = to_page(bptr);
+    auto [start, end] = to_page_range(ptr, len);
+    add_pages(start, end);
+    stats_for(start).live_allocations.fetch_add(1, std::memory_order_relaxed);
+}
+
+void no_swap_allocator_state::remove_allocation(void* ptr, std::size_t len)
+{
+    auto [start, end] = to_page_range(ptr, len);
+    remove_pages(start, end, false);
+    stats_for(start).live_allocations.fetch_sub(1, std::memory_order_relaxed);
+    release_retained_if_due();
+}
+
+void no_swap_allocator_state::serialized_add_allocation(void* ptr, std::size_t len)
+{
+    auto [start, end] = to_page_range(ptr, len);
+    serialized_add_pages(start, end);
+    stats_for(start).live_allocations.fetch_add(1, std::memory_order_relaxed);
+}
+
+void no_swap_allocator_state::serialized_remove_allocation(void* ptr, std::size_t len)
+{
+    auto [start, end] = to_page_range(ptr, len);
+    serialized_remove_pages(start, end, false);
+    stats_for(start).live_allocations.fetch_sub(1, std::memory_order_relaxed);
+    release_retained_if_due();
+}
+
+void no_swap_allocator_state::serialized_release_mapping(void* ptr, std::size_t len)
+{
+    auto [start, end] = to_page_range(ptr, len);
+    serialized_remove_pages(start, end, false);
+    stats_for(start).live_allocations.fetch_sub(1, std::memory_order_relaxed);
+}
+
+void no_swap_allocator_state::concurrent_add_allocation(void* ptr, std::size_t len)
+{
+    auto [start, end] = to_page_range(ptr, len);
+    concurrent_add_pages(start, end);
+    stats_for(start).live_allocations.fetch_add(1, std::memory_order_relaxed);
+}
+
+void no_swap_allocator_state::concurrent_remove_allocation(void* ptr, std::size_t len)
+{
+    auto [start, end] = to_page_range(ptr, len);
+    concurrent_remove_pages(start, end, false);
+    stats_for(start).live_allocations.fetch_sub(1, std::memory_order_relaxed);
+    release_retained_if_due();
+}
+
+bool no_swap_allocator_state::park_allocation(void* ptr, std::size_t len, release_block_function release)
+{
+    return park(ptr, len, release, [this](address start, address end) {
+        remove_pages(start, end, true);
+    });
+}
+
+bool no_swap_allocator_state::serialized_park_allocation(void* ptr, std::size_t len, release_block_function release)
+{
+    return park(ptr, len, release, [this](address start, address end) {
+        serialized_remove_pages(start, end, true);
+    });
+}
+
+bool no_swap_allocator_state::concurrent_park_allocation(void* ptr, std::size_t len, release_block_function release)
+{
+    return park(ptr, len, release, [this](address start, address end) {
+        concurrent_remove_pages(start, end, true);
+    });
+}
+
+void* no_swap_allocator_state::reuse_allocation(std::size_t len, release_block_function release)
+{
+    return reuse(len, release, [this](address start, address end) { add_pages(start, end); });
+}
+
+void* no_swap_allocator_state::serialized_reuse_allocation(std::size_t len, release_block_function release)
+{
+    return reuse(len, release, [this](address start, address end) { serialized_add_pages(start, end); });
+}
+
+void* no_swap_allocator_state::concurrent_reuse_allocation(std::size_t len, release_block_function release)
+{
+    return reuse(len, release, [this](address start, address end) { concurrent_add_pages(start, end); });
+}
+
+void no_swap_allocator_state::serialized_adopt_allocation(void* ptr, std::size_t len)
+{
+    auto [start, end] = to_page_range(ptr, len);
+    auto shards = shards_for(start, end);
+    auto added_end = start;
+    std::uint64_t adopted_pages{};
+
+    lock_shards(shards);
+    try {
+        auto count_adopted = [&adopted_pages, this](address run_start, address run_end) {
+            adopted_pages += (run_end - run_start) >> _page_shift;
+        };
+        for_each_piece(start, end, [&count_adopted](shard& s, address piece_start, address piece_end) {
+            for_each_unlocked(s, piece_start, piece_end, count_adopted);
+        });
+        for_each_piece(start, end, [this](shard& s, address piece_start, address piece_end) {
+            reclaim_retained(s, piece_start, piece_end);
+        });
+        for_each_piece(start, end, [&added_end](shard& s, address piece_start, address piece_end) {
+            s.page_ranges.add_reference(piece_start, piece_end);
+            added_end = piece_end;
+        });
+    } catch (...) {
+        for_each_piece(start, added_end, [](shard& s, address piece_start, address piece_end) {
+            try {
+                s.page_ranges.remove_reference(piece_start, piece_end);
+            } catch (const std::bad_alloc&) {
+            }
+        });
+        unlock_shards(shards);
+        throw;
+    }
+    unlock_shards(shards);
+
+    auto& stats = stats_for(start);
+    stats.pinned_pages.fetch_add(adopted_pages, std::memory_order_relaxed);
+    stats.live_allocations.fetch_add(1, std::memory_order_relaxed);
+}
+
+void no_swap_allocator_state::add_pages(address start, address end)
+{
+    auto pinned_end = start;
+    auto reclaimed_end = start;
+    auto added_end = start;
+
+    try {
+        run_accumulator pin_runs{[&pinned_end, this](address run_start, address run_end) {
+            pin_run(run_start, run_end);
+            pinned_end = run_end;
+        }};
+        for_each_piece(start, end, [&pin_runs](shard& s, address piece_start, address piece_end) {
+            for_each_unlocked(s, piece_start, piece_end, pin_runs);
+        });
+        pin_runs.flush();
+
+        // Retained pages are still locked, so they only need to stop being retained.
+        for_each_piece(start, end, [&reclaimed_end, this](shard& s, address piece_start, address piece_end) {
+            reclaim_retained(s, piece_start, piece_end);
+            reclaimed_end = piece_end;
+        });
+
+        for_each_piece(start, end, [&added_end](shard& s, address piece_start, address piece_end) {
+            s.page_ranges.add_reference(piece_start, piece_end);
+            added_end = piece_end;
+        });
+    } catch (...) {
+        // Undo everything done for this allocation before reporting the failure.  Pages are only
+        // unlocked if they ended up unreferenced again.
+        for_each_piece(start, added_end, [](shard& s, address piece_start, address piece_end) {
+            try {
+                s.page_ranges.remove_reference(piece_start, piece_end);
+            } catch (const std::bad_alloc&) {
+            }
+        });
+        run_accumulator unpin_runs{[this](address run_start, address run_end) {
+            try {
+                unpin_run(run_start, run_end);
+            } catch (const std::system_error&) {
+            }
+        }};
+        for_each_piece(start, std::max(pinned_end, reclaimed_end),
+                       [&unpin_runs](shard& s, address piece_start, address piece_end) {
+            for_each_unlocked(s, piece_start, piece_end, unpin_runs);
+        });
+        unpin_runs.flush();
+        throw;
+    }
+}
+
+void no_swap_allocator_state::remove_pages(address start, address end, bool retain)
+{
+    bool tracked{true};
+    for_each_piece(start, end, [&tracked](shard& s, address piece_start, address piece_end) {
+        tracked = tracked && s.page_ranges.is_referenced(piece_start, piece_end);
+    });
+    if (!tracked) {
+        throw std::runtime_error("Releasing memory not tracked by no_swap_allocator");
+    }
+
+    // Allocate everything dropping the references needs up front, so that no piece is left
+    // half updated and no page is unlocked while the table still counts references to it.
+    for_each_piece(start, end, [](shard& s, address piece_start, address piece_end) {
+        s.page_ranges.split_boundaries(piece_start, piece_end);
+    });
+
+    if (retain) {
+        // The whole range was referenced, so whatever is unreferenced afterwards just lost its
+        // last reference.
+        for_each_piece(start, end, [](shard& s, address piece_start, address piece_end) {
+            s.page_ranges.remove_reference(piece_start, piece_end);
+        });
+        for_each_piece(start, end, [this](shard& s, address piece_start, address piece_end) {
+            s.page_ranges.for_each_unreferenced(piece_start, piece_end, [&s, this](address run_start, address run_end) {
+                retain_run(s, run_start, run_end);
+            });
+        });
+        return;
+    }
+
+    run_accumulator unpin_runs{[this](address run_start, address run_end) {
+        unpin_run(run_start, run_end);
+    }};
+    for_each_piece(start, end, [&unpin_runs](shard& s, address piece_start, address piece_end) {
+        s.page_ranges.for_each_last_reference(piece_start, piece_end, unpin_runs);
+    });
+    unpin_runs.flush();
+
+    for_each_piece(start, end, [](shard& s, address piece_start, address piece_end) {
+        s.page_ranges.remove_reference(piece_start, piece_end);
+    });
+}
 
-    while (page < bptr + len) {
-        auto it = _page_ref_count.find(page);
-        if (it == _page_ref_count.end()) {
-            _page_ref_count.emplace(page, 1);
-            pin_memory(page, _page_size);
-        } else {
-            ++it->second;
+void no_swap_allocator_state::serialized_add_pages(address start, address end)
+{
+    auto shards = shards_for(start, end);
+
+    lock_shards(shards);
+    try {
+        add_pages(start, end);
+    } catch (...) {
+        unlock_shards(shards);
+        throw;
+    }
+    unlock_shards(shards);
+}
+
+void no_swap_allocator_state::serialized_remove_pages(address start, address end, bool retain)
+{
+    auto shards = shards_for(start, end);
+
+    lock_shards(shards);
+    try {
+        remove_pages(start, end, retain);
+    } catch (...) {
+        unlock_shards(shards);
+        throw;
+    }
+    unlock_shards(shards);
+}
+
+void no_swap_allocator_state::concurrent_add_pages(address start, address end)
+{
+    _concurrent_pages.add_reference(
+        start, end,
+        [this](address run_start, address run_end) { serialized_add_pages(run_start, run_end); },
+        [this](address run_start, address run_end) {
+            try {
+                serialized_remove_pages(run_start, run_end, false);
+            } catch (...) {
+            }
+        });
+}
+
+void no_swap_allocator_state::concurrent_remove_pages(address start, address end, bool retain)
+{
+    _concurrent_pages.remove_reference(start, end, [retain, this](address run_start, address run_end) {
+        serialized_remove_pages(run_start, run_end, retain);
+    });
+}
+
+template <typename F>
+bool no_swap_allocator_state::park(void* ptr, std::size_t len, release_block_function release, F&& remove)
+{
+    auto [start, end] = to_page_range(ptr, len);
+    if (!should_retain(start, end)) {
+        return false;
+    }
+
+    {
+        std::lock_guard lk{_parked_mutex};
+        auto parked_bytes = _parked_bytes.load(std::memory_order_relaxed);
+        if (_parked_count == max_parked_blocks ||
+            parked_bytes + len > _retain_max_bytes.load(std::memory_order_relaxed)) {
+            return false;
+        }
+        if (_parked_count == 0 && _retained_pages.load(std::memory_order_relaxed) == 0) {
+            _retained_since.store(steady_nanoseconds(), std::memory_order_relaxed);
         }
-        page += _page_size;
+
+        // The block stays allocated from the upstream allocator, so its retained pages stay
+        // mapped, and thus locked, until the block is released.
+        remove(start, end);
+        _parked[_parked_count++] = parked_block{ptr, len, release};
+        _parked_bytes.store(parked_bytes + len, std::memory_order_relaxed);
     }
+    stats_for(start).live_allocations.fetch_sub(1, std::memory_order_relaxed);
+    release_retained_if_due();
+    return true;
 }
 
-void no_swap_allocator_state::remove_allocation(void* ptr, std::size_t len)
+template <typename F>
+void* no_swap_allocator_state::reuse(std::size_t len, release_block_function release, F&& add)
+{
+    if (_parked_bytes.load(std::memory_order_relaxed) == 0) {
+        return nullptr;
+    }
+
+    void* ptr{};
+    {
+        std::lock_guard lk{_parked_mutex};
+        auto parked_end = _parked.begin() + _parked_count;
+        auto it = std::find_if(_parked.begin(), parked_end, [len, release](const parked_block& block) {
+            return block.len == len && block.release == release;
+        });
+        if (it == parked_end) {
+            return nullptr;
+        }
+        ptr = it->ptr;
+        *it = _parked[--_parked_count];
+        _parked_bytes.fetch_sub(len, std::memory_order_relaxed);
+    }
+
+    auto [start, end] = to_page_range(ptr, len);
+    try {
+        add(start, end);
+    } catch (...) {
+        release(ptr, len);
+        throw;
+    }
+    stats_for(start).live_allocations.fetch_add(1, std::memory_order_relaxed);
+    return ptr;
+}
+
+void no_swap_allocator_state::pin_run(address start, address end)
+{
+    auto& stats = stats_for(start);
+    stats.pin_calls.fetch_add(1, std::memory_order_relaxed);
+    try {
+        timed_syscall(stats.syscall_nanoseconds, [start, end] {
+            pin_memory(reinterpret_cast<void*>(start), end - start);
+        });
+    } catch (...) {
+        stats.pin_failures.fetch_add(1, std::memory_order_relaxed);
+        throw;
+    }
+    stats.pinned_pages.fetch_add((end - start) >> _page_shift, std::memory_order_relaxed);
+}
+
+void no_swap_allocator_state::unpin_run(address start, address end)
+{
+    auto& stats = stats_for(start);
+    stats.unpin_calls.fetch_add(1, std::memory_order_relaxed);
+    timed_syscall(stats.syscall_nanoseconds, [start, end] {
+        unpin_memory(reinterpret_cast<void*>(start), end - start);
+    });
+    stats.pinned_pages.fetch_sub((end - start) >> _page_shift, std::memory_order_relaxed);
+}
+
+void no_swap_allocator_state::retain_run(shard& s, address start, address end)
+{
+    try {
+        s.retained.add_reference(start, end);
+    } catch (const std::bad_alloc&) {
+        try {
+            unpin_run(start, end);
+        } catch (const std::system_error&) {
+        }
+        return;
+    }
+    if (_retained_pages.fetch_add((end - start) >> _page_shift, std::memory_order_relaxed) == 0) {
+        _retained_since.store(steady_nanoseconds(), std::memory_order_relaxed);
+    }
+}
+
+void no_swap_allocator_state::reclaim_retained(shard& s, address start, address end)
+{
+    if (s.retained.empty()) {
+        return;
+    }
+    std::uint64_t pages{};
+    s.retained.for_each_last_reference(start, end, [&pages, this](address run_start, address run_end) {
+        pages += (run_end - run_start) >> _page_shift;
+    });
+    if (pages != 0) {
+        s.retained.erase(start, end);
+        _retained_pages.fetch_sub(pages, std::memory_order_relaxed);
+    }
+}
+
+void no_swap_allocator_state::release_retained_if_due()
+{
+    auto pages = _retained_pages.load(std::memory_order_relaxed);
+    if (pages == 0 && _parked_bytes.load(std::memory_order_relaxed) == 0) {
+        return;
+    }
+    auto max_bytes = _retain_max_bytes.load(std::memory_order_relaxed);
+    auto retained_for = steady_nanoseconds() - _retained_since.load(std::memory_order_relaxed);
+    if (max_bytes == 0 || (pages << _page_shift) > max_bytes ||
+        retained_for >= _retain_max_idle.load(std::memory_order_relaxed)) {
+        release_retained_pages();
+    }
+}
+
+void no_swap_allocator_state::set_retention_policy(const no_swap_retention_policy& policy)
+{
+    _retain_max_idle.store(policy.max_idle.count(), std::memory_order_relaxed);
+    _retain_max_allocation.store(policy.max_allocation, std::memory_order_relaxed);
+    _retain_max_bytes.store(policy.max_bytes, std::memory_order_relaxed);
+    release_retained_if_due();
+}
+
+void no_swap_allocator_state::release_retained_pages()
 {
-    auto bptr = reinterpret_cast<std::byte*>(ptr);
-    auto page = to_page(bptr);
-
-    while (page < bptr + len) {
-        auto it = _page_ref_count.find(page);
-        if (it == _page_ref_count.end()) {
-            throw std::runtime_error("Releasing memory not tracked by no_swap_allocator");
-        } else {
-            --it->second;
-            if (it->second == 0) {
-                unpin_memory(page, _page_size);
-                _page_ref_count.erase(it);
+    shard_set shards;
+    shards.set();
+    std::uint64_t released{};
+    std::array<parked_block, max_parked_blocks> parked;
+    std::size_t parked_count{};
+
+    {
+        std::lock_guard lk{_parked_mutex};
+        lock_shards(shards);
+        try {
+            run_accumulator unpin_runs{[&released, this](address run_start, address run_end) {
+                auto pages = (run_end - run_start) >> _page_shift;
+                released += pages;
+                try {
+                    unpin_run(run_start, run_end);
+                } catch (const std::system_error&) {
+                    // The pages are no longer tracked either way.
+                    stats_for(run_start).pinned_pages.fetch_sub(pages, std::memory_order_relaxed);
+                }
+            }};
+            for (auto& s : _shards) {
+                if (!s.retained.empty()) {
+                    s.retained.for_each_last_reference(0, std::numeric_limits<address>::max(), unpin_runs);
+                    s.retained.erase(0, std::numeric_limits<address>::max());
+                }
             }
+            unpin_runs.flush();
+        } catch (...) {
+            _retained_pages.fetch_sub(released, std::memory_order_relaxed);
+            unlock_shards(shards);
+            throw;
         }
-        page += _page_size;
+        _retained_pages.fetch_sub(released, std::memory_order_relaxed);
+        unlock_shards(shards);
+
+        parked = _parked;
+        parked_count = std::exchange(_parked_count, 0);
+        _parked_bytes.store(0, std::memory_order_relaxed);
+    }
+
+    // The pages are unlocked by now, so the upstream allocators may do with the blocks as they
+    // please.
+    for (std::size_t i = 0; i < parked_count; ++i) {
+        parked[i].release(parked[i].ptr, parked[i].len);
     }
 }
 
-std::byte* no_swap_allocator_state::to_page(void* ptr)
+no_swap_allocator_stats no_swap_allocator_state::snapshot() const noexcept
 {
-    auto fake_buffer_size = 2 * _page_size;
-    auto ptr2 = ptr; // Make copy since std::align will modify it.
-    auto page = reinterpret_cast<std::byte*>(std::align(_page_size, 1, ptr2, fake_buffer_size));
-    if (page > ptr) {
-        page -= _page_size;
+    // Counters are charged to the shard an operation started in, which need not be the shard it
+    // is later undone in, so individual shards may wrap around.  The sums are still exact.
+    no_swap_allocator_stats stats;
+    std::uint64_t syscall_nanoseconds{};
+    for (const auto& s : _shards) {
+        stats.pinned_pages += s.stats.pinned_pages.load(std::memory_order_relaxed);
+        stats.live_allocations += s.stats.live_allocations.load(std::memory_order_relaxed);
+        stats.pin_calls += s.stats.pin_calls.load(std::memory_order_relaxed);
+        stats.unpin_calls += s.stats.unpin_calls.load(std::memory_order_relaxed);
+        stats.pin_failures += s.stats.pin_failures.load(std::memory_order_relaxed);
+        syscall_nanoseconds += s.stats.syscall_nanoseconds.load(std::memory_order_relaxed);
+    }
+    stats.pinned_bytes = stats.pinned_pages << _page_shift;
+    stats.retained_pages = _retained_pages.load(std::memory_order_relaxed);
+    stats.pinned_bytes_limit = get_pin_limit();
+    stats.bytes_wiped = secure_zero_wiped_bytes();
+    stats.syscall_time = std::chrono::nanoseconds{syscall_nanoseconds};
+    return stats;
+}
+
+template <typename F>
+void no_swap_allocator_state::for_each_piece(address start, address end, F&& f)
+{
+    while (start < end) {
+        auto index = shard_index(start);
+        auto piece_end = start;
+        // Neighboring regions hashed onto the same shard form one piece, so that updating a piece
+        // never merges table entries at the boundary of the next one.
+        do {
+            piece_end = std::min(end, ((piece_end >> shard_region_shift) + 1) << shard_region_shift);
+        } while (piece_end < end && shard_index(piece_end) == index);
+        f(_shards[index], start, piece_end);
+        start = piece_end;
+    }
+}
+
+std::size_t no_swap_allocator_state::shard_index(address addr) noexcept
+{
+    // Fibonacci hashing of the region number spreads neighboring regions across all the shards.
+    constexpr std::uint64_t multiplier{0x9e3779b97f4a7c15};
+    constexpr std::size_t index_bits{std::countr_zero(shard_count)};
+    auto region = static_cast<std::uint64_t>(addr >> shard_region_shift);
+    return static_cast<std::size_t>((region * multiplier) >> (64 - index_bits));
+}
+
+no_swap_allocator_state::shard_set no_swap_allocator_state::shards_for(address start,
+                                                                       address end) noexcept
+{
+    shard_set shards;
+    auto first_region = start >> shard_region_shift;
+    auto last_region = (end - 1) >> shard_region_shift;
+    for (auto region = first_region; region <= last_region && !shards.all(); ++region) {
+        shards.set(shard_index(region << shard_region_shift));
+    }
+    return shards;
+}
+
+void no_swap_allocator_state::lock_shards(const shard_set& shards)
+{
+    for (std::size_t i = 0; i < shard_count; ++i) {
+        if (shards.test(i)) {
+            try {
+                _shards[i].mutex.lock();
+            } catch (...) {
+                unlock_shards(shards & ((shard_set{}.set() >> (shard_count - i))));
+                throw;
+            }
+        }
+    }
+}
+
+void no_swap_allocator_state::unlock_shards(const shard_set& shards) noexcept
+{
+    for (std::size_t i = 0; i < shard_count; ++i) {
+        if (shards.test(i)) {
+            _shards[i].mutex.unlock();
+        }
     }
-    return page;
 }
 
 
 #ifdef EC_UNIT_TEST_SUPPORT
 void no_swap_allocator_state::clear_pages(void* ptr, std::size_t len)
 {
-    auto page = to_page(ptr);
-
-    while (page < reinterpret_cast<std::byte*>(ptr) + len) {
-        _page_ref_count.erase(page);
-        page += _page_size;
+    auto [start, end] = to_page_range(ptr, len);
+    for_each_piece(start, end, [this](shard& s, address piece_start, address piece_end) {
+        s.page_ranges.erase(piece_start, piece_end);
+        reclaim_retained(s, piece_start, piece_end);
+    });
+    _concurrent_pages.clear(start, end);
+
+    std::lock_guard lk{_parked_mutex};
+    for (auto i = _parked_count; i > 0; --i) {
+        auto& block = _parked[i - 1];
+        auto block_start = reinterpret_cast<address>(block.ptr);
+        if (block_start >= start && block_start < end) {
+            _parked_bytes.fetch_sub(block.len, std::memory_order_relaxed);
+            block = _parked[--_parked_count];
+        }
     }
 }
 
 bool no_swap_allocator_state::is_lock_held()
 {
-    std::unique_lock lk{_mutex, std::try_to_lock};
-    return !lk.owns_lock();
+    for (auto& s : _shards) {
+        std::unique_lock lk{s.mutex, std::try_to_lock};
+        if (!lk.owns_lock()) {
+            return true;
+        }
+    }
+    return false;
 }
 
 #endif
@@ -218,5 +855,35 @@ bool no_swap_allocator_state::is_lock_held()
 
 } // namespace detail
 
+#if __cplusplus >= 201603L
+namespace pmr {
+
+void* no_swap_resource::do_allocate(std::size_t len, std::size_t alignment)
+{
+    void* ptr = _upstream->allocate(len, alignment);
+    try {
+        details::no_swap_allocator_state::get_state_object().serialized_add_allocation(ptr, len);
+    } catch (...) {
+        _upstream->deallocate(ptr, len, alignment);
+        throw;
+    }
+    return ptr;
+}
+
+void no_swap_resource::do_deallocate(void* ptr, std::size_t len, std::size_t alignment)
+{
+    details::no_swap_allocator_state::get_state_object().serialized_remove_allocation(ptr, len);
+    _upstream->deallocate(ptr, len, alignment);
+}
+
+bool no_swap_resource::do_is_equal(const std::pmr::memory_resource& other) const noexcept
+{
+    const auto* that = dynamic_cast<const no_swap_resource*>(&other);
+    return that != nullptr && _upstream->is_equal(*that->_upstream);
+}
+
+} // namespace pmr
+#endif
+
 
 } // namespace ec
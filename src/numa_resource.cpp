@@ -0,0 +1,270 @@
+/**
+ * @file
+ * Secure memory resources that keep memory local to a NUMA node.
+ *
+ * @copyright 2023 Steve Kinneberg <steve.kinneberg@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <enhanced_containers/numa_resource.h>
+#include <enhanced_containers/no_swap_allocator.h>
+#include <enhanced_containers/zero_on_release_allocator.h>
+
+#include <array>
+#include <atomic>
+#include <new>
+#include <stdexcept>
+#include <system_error>
+
+
+#if defined(__linux__) || defined(__unix) || defined(__unix__)
+#include <cerrno>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace {
+/**
+ * @brief
+ * Linux implementation to get the number of bytes in a page of memory.
+ *
+ * @return The number of bytes in a page of memory.
+ */
+std::size_t get_page_size() noexcept
+{
+    return sysconf(_SC_PAGESIZE);
+}
+
+/**
+ * @brief
+ * Linux implementation to get the NUMA node of the CPU the calling thread is running on.
+ *
+ * @return  The node number.
+ */
+unsigned get_current_node() noexcept
+{
+    unsigned cpu{};
+    unsigned node{};
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 29))
+    // Goes through the vDSO, so it is cheap enough to call for each allocator constructed.
+    if (getcpu(&cpu, &node) != 0) {
+        return 0;
+    }
+#elif defined(SYS_getcpu)
+    if (syscall(SYS_getcpu, &cpu, &node, nullptr) != 0) {
+        return 0;
+    }
+#endif
+    return node;
+}
+
+/**
+ * @brief
+ * Linux implementation to map fresh memory from a NUMA node.
+ *
+ * The memory policy is set on the mapping before any of it is touched, so that the pages are
+ * allocated on the node when they are first faulted in.  Kernels built without NUMA support, and
+ * nodes that have no memory this process may use, just get memory under the default policy.
+ *
+ * @param len   Number of bytes to map.  Must be a multiple of the page size.
+ * @param node  The NUMA node.
+ *
+ * @return  Address of the mapped memory.
+ */
+void* map_node_memory(std::size_t len, unsigned node)
+{
+    void* ptr = mmap(nullptr, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (ptr == MAP_FAILED) {
+        throw std::bad_alloc{};
+    }
+#if defined(SYS_mbind)
+    constexpr int mpol_preferred = 1;   // MPOL_PREFERRED from <linux/mempolicy.h>.
+    unsigned long nodemask = 1UL << node;
+    // The kernel drops the last bit of maxnode, hence the + 1.
+    if (syscall(SYS_mbind, ptr, len, mpol_preferred, &nodemask, ec::pmr::max_numa_nodes + 1, 0) != 0 &&
+        errno != ENOSYS && errno != EINVAL) {
+        auto err = errno;
+        munmap(ptr, len);
+        throw std::system_error{err, std::system_category(), "binding memory to NUMA node"};
+    }
+#endif
+    return ptr;
+}
+
+/**
+ * @brief
+ * Linux implementation to return mapped memory to the OS.
+ *
+ * @param ptr   Address of the mapped memory.
+ * @param len   Number of bytes mapped.
+ */
+void unmap_node_memory(void* ptr, std::size_t len) noexcept
+{
+    munmap(ptr, len);
+}
+}
+
+
+
+#elif defined(_WIN32)
+#warning Windows support has not been tested.
+#include <memoryapi.h>
+#include <processthreadsapi.h>
+#include <sysinfoapi.h>
+#include <systemtopologyapi.h>
+
+namespace {
+/**
+ * @brief
+ * Microsoft Windows implementation to get the number of bytes in a page of memory.
+ *
+ * @return The number of bytes in a page of memory.
+ */
+std::size_t get_page_size() noexcept
+{
+    SYSTEM_INFO si;
+    GetSystemInfo(&si);
+    return si.dwPageSize;
+}
+
+/**
+ * @brief
+ * Microsoft Windows implementation to get the NUMA node of the CPU the calling thread is running on.
+ */
+unsigned get_current_node() noexcept
+{
+    PROCESSOR_NUMBER cpu;
+    GetCurrentProcessorNumberEx(&cpu);
+    USHORT node{};
+    if (!GetNumaProcessorNodeEx(&cpu, &node)) {
+        return 0;
+    }
+    return node;
+}
+
+/**
+ * @brief
+ * Microsoft Windows implementation to map fresh memory from a NUMA node.
+ */
+void* map_node_memory(std::size_t len, unsigned node)
+{
+    void* ptr = VirtualAllocExNuma(GetCurrentProcess(), nullptr, len, MEM_COMMIT | MEM_RESERVE,
+                                   PAGE_READWRITE, node);
+    if (ptr == nullptr) {
+        throw std::bad_alloc{};
+    }
+    return ptr;
+}
+
+/**
+ * @brief
+ * Microsoft Windows implementation to return mapped memory to the OS.
+ */
+void unmap_node_memory(void* ptr, std::size_t) noexcept
+{
+    VirtualFree(ptr, 0, MEM_RELEASE);
+}
+}
+#endif
+
+
+namespace {
+/**
+ * @brief
+ * The secure arena of a NUMA node.  Members are declared in upstream to downstream order.
+ */
+struct numa_arena {
+    /**
+     * @brief
+     * Constructor.
+     *
+     * @param node  The NUMA node.
+     */
+    explicit numa_arena(unsigned node):
+        node_memory{node}
+    {}
+
+    ec::pmr::numa_node_resource node_memory;                        ///< @brief Locked pages on the node.
+    std::pmr::synchronized_pool_resource pool{&node_memory};        ///< @brief Carves up the pages.
+    ec::pmr::zero_on_release_resource zero_on_release{&pool};       ///< @brief Zeros out memory going back to the pool.
+};
+
+/// @brief The arenas of the NUMA nodes, created on first use and never destroyed.
+std::array<std::atomic<numa_arena*>, ec::pmr::max_numa_nodes> arenas{};
+}
+
+
+namespace ec::pmr {
+
+unsigned current_numa_node() noexcept
+{
+    return get_current_node();
+}
+
+void* numa_node_resource::do_allocate(std::size_t len, std::size_t alignment)
+{
+    static const std::size_t page_size = get_page_size();
+    if (_node >= max_numa_nodes) {
+        throw std::out_of_range{"NUMA node out of range"};
+    }
+    if (alignment > page_size) {
+        throw std::bad_alloc{};
+    }
+    len = (len + page_size - 1) & ~(page_size - 1);
+    void* ptr = map_node_memory(len, _node);
+    try {
+        // Locking faults in all of the pages, and so places them on the node.
+        details::no_swap_allocator_state::get_state_object().serialized_add_allocation(ptr, len);
+    } catch (...) {
+        unmap_node_memory(ptr, len);
+        throw;
+    }
+    return ptr;
+}
+
+void numa_node_resource::do_deallocate(void* ptr, std::size_t len, std::size_t)
+{
+    static const std::size_t page_size = get_page_size();
+    len = (len + page_size - 1) & ~(page_size - 1);
+    details::no_swap_allocator_state::get_state_object().serialized_release_mapping(ptr, len);
+    unmap_node_memory(ptr, len);
+}
+
+bool numa_node_resource::do_is_equal(const std::pmr::memory_resource& other) const noexcept
+{
+    // Each allocation is a mapping of its own, so any resource for the same node can release it.
+    const auto* that = dynamic_cast<const numa_node_resource*>(&other);
+    return that != nullptr && that->_node == _node;
+}
+
+std::pmr::memory_resource* get_numa_local_resource(unsigned node)
+{
+    if (node >= max_numa_nodes) {
+        throw std::out_of_range{"NUMA node out of range"};
+    }
+    auto& slot = arenas[node];
+    auto* arena = slot.load(std::memory_order_acquire);
+    if (arena == nullptr) {
+        auto* fresh = new numa_arena{node};
+        if (slot.compare_exchange_strong(arena, fresh, std::memory_order_acq_rel, std::memory_order_acquire)) {
+            arena = fresh;
+        } else {
+            delete fresh;   // Another thread got there first.
+        }
+    }
+    return &arena->zero_on_release;
+}
+
+} // namespace ec::pmr
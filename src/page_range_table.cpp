@@ -0,0 +1,156 @@
+/**
+ * @file
+ * Reference counted table of page aligned memory ranges.
+ *
+ * @copyright 2023 Steve Kinneberg <steve.kinneberg@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <enhanced_containers/details/page_range_table.h>
+
+namespace ec::details {
+
+bool page_range_table::is_referenced(address start, address end) const
+{
+    auto cursor = start;
+    for (auto it = first_overlapping(start); cursor < end; ++it) {
+        if (it == _ranges.end() || it->first > cursor) {
+            return false;
+        }
+        cursor = it->second.end;
+    }
+    return true;
+}
+
+void page_range_table::add_reference(address start, address end)
+{
+    if (start >= end) {
+        return;
+    }
+
+    try {
+        split(start);
+        split(end);
+        // Fill the gaps with unreferenced placeholders so that nothing below can throw.
+        for_each_unreferenced(start, end, [this](address s, address e) {
+            _ranges.emplace(s, range{e, 0});
+        });
+    } catch (...) {
+        normalize(start, end);
+        throw;
+    }
+
+    for (auto it = _ranges.find(start); it != _ranges.end() && it->first < end; ++it) {
+        ++it->second.ref_count;
+    }
+    normalize(start, end);
+}
+
+void page_range_table::remove_reference(address start, address end)
+{
+    if (start >= end) {
+        return;
+    }
+
+    try {
+        split(start);
+        split(end);
+    } catch (...) {
+        normalize(start, end);
+        throw;
+    }
+
+    for (auto it = _ranges.find(start); it != _ranges.end() && it->first < end; ++it) {
+        --it->second.ref_count;
+    }
+    normalize(start, end);
+}
+
+void page_range_table::split_boundaries(address start, address end)
+{
+    if (start >= end) {
+        return;
+    }
+
+    try {
+        split(start);
+        split(end);
+    } catch (...) {
+        normalize(start, end);
+        throw;
+    }
+}
+
+void page_range_table::erase(address start, address end)
+{
+    if (start >= end) {
+        return;
+    }
+
+    split(start);
+    split(end);
+    _ranges.erase(_ranges.lower_bound(start), _ranges.lower_bound(end));
+    normalize(start, end);
+}
+
+std::uint32_t page_range_table::ref_count(address addr) const
+{
+    auto it = first_overlapping(addr);
+    if (it == _ranges.end() || it->first > addr) {
+        return 0;
+    }
+    return it->second.ref_count;
+}
+
+void page_range_table::split(address addr)
+{
+    auto it = _ranges.upper_bound(addr);
+    if (it == _ranges.begin()) {
+        return;
+    }
+
+    auto prev = std::prev(it);
+    if (prev->first < addr && addr < prev->second.end) {
+        _ranges.emplace_hint(it, addr, range{prev->second.end, prev->second.ref_count});
+        prev->second.end = addr;
+    }
+}
+
+void page_range_table::normalize(address start, address end) noexcept
+{
+    auto it = _ranges.lower_bound(start);
+    if (it != _ranges.begin()) {
+        --it;
+    }
+    auto last = _ranges.upper_bound(end);
+
+    while (it != last) {
+        if (it->second.ref_count == 0) {
+            it = _ranges.erase(it);
+            continue;
+        }
+
+        auto next = std::next(it);
+        if (next != last &&
+            next->first == it->second.end &&
+            next->second.ref_count == it->second.ref_count) {
+            it->second.end = next->second.end;
+            _ranges.erase(next);
+        } else {
+            it = next;
+        }
+    }
+}
+
+} // namespace ec::details
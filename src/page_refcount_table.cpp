@@ -0,0 +1,158 @@
+/**
+ * @internal @file
+ * Lock-free table of per page reference counts.
+ *
+ * @copyright 2023 Steve Kinneberg <steve.kinneberg@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <enhanced_containers/details/page_refcount_table.h>
+
+#include <stdexcept>
+
+namespace {
+/**
+ * @brief
+ * Get the child at an index of a level, creating it if necessary.
+ *
+ * The loser of a race to create the child deletes its copy and uses the winner's.
+ *
+ * @tparam Child    The type of the child.
+ *
+ * @param slot  The entry of the level holding the child.
+ *
+ * @return  The child.
+ */
+template <typename Child>
+Child& get_or_create(std::atomic<Child*>& slot)
+{
+    auto* child = slot.load(std::memory_order_acquire);
+    if (child == nullptr) {
+        auto* fresh = new Child{};
+        if (slot.compare_exchange_strong(child, fresh, std::memory_order_acq_rel, std::memory_order_acquire)) {
+            child = fresh;
+        } else {
+            delete fresh;
+        }
+    }
+    return *child;
+}
+}
+
+namespace ec::details {
+
+namespace {
+/// @brief Mask of the index bits of a leaf.
+constexpr page_refcount_table::address leaf_mask{(page_refcount_table::address{1} << page_refcount_table::leaf_shift) - 1};
+
+/// @brief Mask of the index bits of a directory.
+constexpr page_refcount_table::address directory_mask{(page_refcount_table::address{1} << page_refcount_table::directory_shift) - 1};
+
+/// @brief Shift of the page number to the lower directory index.
+constexpr std::size_t lower_shift{page_refcount_table::leaf_shift};
+
+/// @brief Shift of the page number to the upper directory index.
+constexpr std::size_t upper_shift{lower_shift + page_refcount_table::directory_shift};
+
+/// @brief Shift of the page number to the root index.
+constexpr std::size_t root_index_shift{upper_shift + page_refcount_table::directory_shift};
+}
+
+template <typename Child>
+page_refcount_table::directory<Child>::~directory()
+{
+    for (auto& child : children) {
+        delete child.load(std::memory_order_relaxed);
+    }
+}
+
+page_refcount_table::~page_refcount_table()
+{
+    for (auto& upper : _root) {
+        delete upper.load(std::memory_order_relaxed);
+    }
+}
+
+page_refcount_table::counter& page_refcount_table::counter_for(address page_number)
+{
+    auto root_index = page_number >> root_index_shift;
+    if (root_index >= _root.size()) {
+        throw std::out_of_range("Address beyond the range of the page reference count table");
+    }
+    auto& upper = get_or_create(_root[root_index]);
+    auto& lower = get_or_create(upper.children[(page_number >> upper_shift) & directory_mask]);
+    auto& l = get_or_create(lower.children[(page_number >> lower_shift) & directory_mask]);
+    return l.counts[page_number & leaf_mask];
+}
+
+page_refcount_table::counter* page_refcount_table::find_counter(address page_number) const noexcept
+{
+    auto root_index = page_number >> root_index_shift;
+    if (root_index >= _root.size()) {
+        return nullptr;
+    }
+    auto* upper = _root[root_index].load(std::memory_order_acquire);
+    if (upper == nullptr) {
+        return nullptr;
+    }
+    auto* lower = upper->children[(page_number >> upper_shift) & directory_mask].load(std::memory_order_acquire);
+    if (lower == nullptr) {
+        return nullptr;
+    }
+    auto* l = lower->children[(page_number >> lower_shift) & directory_mask].load(std::memory_order_acquire);
+    if (l == nullptr) {
+        return nullptr;
+    }
+    return &l->counts[page_number & leaf_mask];
+}
+
+void page_refcount_table::publish(address first, address last, std::uint32_t value) noexcept
+{
+    // The levels of pages in transition already exist, so looking them up cannot throw.
+    for (auto page = first; page < last; ++page) {
+        find_counter(page)->store(value, std::memory_order_release);
+    }
+}
+
+bool page_refcount_table::is_referenced(address start, address end) const noexcept
+{
+    for (auto page = start >> _page_shift; page < (end >> _page_shift); ++page) {
+        const auto* c = find_counter(page);
+        if (c == nullptr || c->load(std::memory_order_acquire) == 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::uint32_t page_refcount_table::reference_count(address page) const noexcept
+{
+    const auto* c = find_counter(page >> _page_shift);
+    if (c == nullptr) {
+        return 0;
+    }
+    auto n = c->load(std::memory_order_acquire);
+    return (n & busy) != 0 ? 1 : n;
+}
+
+void page_refcount_table::clear(address start, address end) noexcept
+{
+    for (auto page = start >> _page_shift; page < (end >> _page_shift); ++page) {
+        if (auto* c = find_counter(page)) {
+            c->store(0, std::memory_order_relaxed);
+        }
+    }
+}
+
+} // namespace ec::details
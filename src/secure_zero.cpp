@@ -0,0 +1,401 @@
+/**
+ * @file
+ * Wipe memory in a way that the compiler is not allowed to optimize away.
+ *
+ * @copyright 2023 Steve Kinneberg <steve.kinneberg@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <enhanced_containers/secure_zero.h>
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define EC_SECURE_ZERO_X86 1
+#include <immintrin.h>
+#endif
+
+
+namespace {
+
+/// @brief Signature of the wipe kernels.
+using kernel_fn = void (*)(void*, std::size_t) noexcept;
+
+/**
+ * @brief
+ * Tell the compiler that the memory may be read after it was written so that the stores cannot be
+ * removed as dead.
+ *
+ * @param ptr   Address of the memory that was written.
+ */
+inline void compiler_barrier(void* ptr) noexcept
+{
+#if defined(__GNUC__) || defined(__clang__)
+    __asm__ __volatile__("" : : "r"(ptr) : "memory");
+#else
+    static_cast<void>(ptr);
+    std::atomic_signal_fence(std::memory_order_seq_cst);
+#endif
+}
+
+/**
+ * @brief
+ * `memset()` called through a volatile pointer so that the compiler cannot see what is being
+ * called and therefore cannot elide the call.
+ */
+void* (*volatile memset_fn)(void*, int, std::size_t){std::memset};
+
+/**
+ * @brief
+ * Portable kernel.
+ *
+ * @param ptr   Address of the memory to zero out.
+ * @param len   Number of bytes to zero out.
+ */
+void zero_portable(void* ptr, std::size_t len) noexcept
+{
+    memset_fn(ptr, 0, len);
+}
+
+
+/**
+ * @brief
+ * Kernel for blocks smaller than a vector.
+ *
+ * @param ptr   Address of the memory to zero out.
+ * @param len   Number of bytes to zero out.
+ */
+void zero_bytes(void* ptr, std::size_t len) noexcept
+{
+    auto* p = static_cast<volatile unsigned char*>(ptr);
+    for (std::size_t i = 0; i < len; ++i) {
+        p[i] = 0;
+    }
+}
+
+
+#ifdef EC_SECURE_ZERO_X86
+// The kernels below all follow the same pattern.  Small blocks are written with overlapping
+// unaligned stores.  Large blocks have their head and tail written with unaligned stores and the
+// aligned body with non-temporal stores followed by a store fence.  They are spelled out
+// individually because intrinsics can only be used in functions compiled for the matching target.
+
+/**
+ * @brief
+ * Round an address up past its current vector.
+ *
+ * @param p     The address.
+ * @param width Vector width in bytes.
+ *
+ * @return  The first `width` aligned address after `p`.
+ */
+inline unsigned char* next_aligned(unsigned char* p, std::size_t width) noexcept
+{
+    return reinterpret_cast<unsigned char*>(
+        (reinterpret_cast<std::uintptr_t>(p) + width) & ~static_cast<std::uintptr_t>(width - 1));
+}
+
+/**
+ * @brief
+ * SSE2 kernel.
+ *
+ * @param ptr   Address of the memory to zero out.
+ * @param len   Number of bytes to zero out.
+ */
+__attribute__((target("sse2")))
+void zero_sse2(void* ptr, std::size_t len) noexcept
+{
+    constexpr std::size_t width{sizeof(__m128i)};
+    if (len < width) {
+        zero_bytes(ptr, len);
+        return;
+    }
+
+    const auto zero = _mm_setzero_si128();
+    auto* p = static_cast<unsigned char*>(ptr);
+    auto* last = p + len - width;
+    if (len >= ec::details::secure_zero_non_temporal_threshold) {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(p), zero);
+        for (auto* q = next_aligned(p, width); q <= last; q += width) {
+            _mm_stream_si128(reinterpret_cast<__m128i*>(q), zero);
+        }
+        _mm_sfence();
+    } else {
+        for (auto* q = p; q < last; q += width) {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(q), zero);
+        }
+    }
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(last), zero);
+}
+
+/**
+ * @brief
+ * AVX2 kernel.
+ *
+ * @param ptr   Address of the memory to zero out.
+ * @param len   Number of bytes to zero out.
+ */
+__attribute__((target("avx2")))
+void zero_avx2(void* ptr, std::size_t len) noexcept
+{
+    constexpr std::size_t width{sizeof(__m256i)};
+    if (len < width) {
+        zero_sse2(ptr, len);
+        return;
+    }
+
+    const auto zero = _mm256_setzero_si256();
+    auto* p = static_cast<unsigned char*>(ptr);
+    auto* last = p + len - width;
+    if (len >= ec::details::secure_zero_non_temporal_threshold) {
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), zero);
+        for (auto* q = next_aligned(p, width); q <= last; q += width) {
+            _mm256_stream_si256(reinterpret_cast<__m256i*>(q), zero);
+        }
+        _mm_sfence();
+    } else {
+        for (auto* q = p; q < last; q += width) {
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(q), zero);
+        }
+    }
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(last), zero);
+    _mm256_zeroupper();
+}
+
+/**
+ * @brief
+ * AVX-512 kernel.
+ *
+ * @param ptr   Address of the memory to zero out.
+ * @param len   Number of bytes to zero out.
+ */
+__attribute__((target("avx512f")))
+void zero_avx512(void* ptr, std::size_t len) noexcept
+{
+    constexpr std::size_t width{sizeof(__m512i)};
+    if (len < width) {
+        zero_avx2(ptr, len);
+        return;
+    }
+
+    const auto zero = _mm512_setzero_si512();
+    auto* p = static_cast<unsigned char*>(ptr);
+    auto* last = p + len - width;
+    if (len >= ec::details::secure_zero_non_temporal_threshold) {
+        _mm512_storeu_si512(p, zero);
+        for (auto* q = next_aligned(p, width); q <= last; q += width) {
+            _mm512_stream_si512(reinterpret_cast<__m512i*>(q), zero);
+        }
+        _mm_sfence();
+    } else {
+        for (auto* q = p; q < last; q += width) {
+            _mm512_storeu_si512(q, zero);
+        }
+    }
+    _mm512_storeu_si512(last, zero);
+    _mm256_zeroupper();
+}
+#endif
+
+/**
+ * @brief
+ * Pick the fastest kernel supported by the CPU.
+ *
+ * @return  The kernel to use.
+ */
+kernel_fn select_kernel() noexcept
+{
+#ifdef EC_SECURE_ZERO_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) {
+        return zero_avx512;
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        return zero_avx2;
+    }
+    if (__builtin_cpu_supports("sse2")) {
+        return zero_sse2;
+    }
+#endif
+    return zero_portable;
+}
+
+/**
+ * @brief
+ * Get the kernel currently in use.
+ *
+ * This is a function local static so that it is safe to use during static initialization.
+ *
+ * @return  Reference to the kernel in use.
+ */
+std::atomic<kernel_fn>& active_kernel() noexcept
+{
+    static std::atomic<kernel_fn> kernel{select_kernel()};
+    return kernel;
+}
+
+/**
+ * @brief
+ * Count of bytes wiped, on its own cache line so that threads using different counters do not
+ * falsely share.
+ */
+struct alignas(64) wipe_counter {
+    std::atomic<std::uint64_t> bytes{};    ///< @brief Number of bytes wiped.
+    std::atomic<bool> owned{};             ///< @brief Whether a thread has claimed this counter.
+};
+
+/// @brief Number of wipe counters.
+constexpr std::size_t wipe_counter_count{64};
+
+/**
+ * @brief
+ * The wipe counters.  Constant initialized so that they are usable during static initialization
+ * and destruction.
+ *
+ * Each thread claims a counter of its own and is then the only writer, so it can update it with a
+ * plain load and store instead of a locked read-modify-write.  The first counter is shared by any
+ * threads left over once all the others are claimed, and by threads that are exiting.
+ */
+std::array<wipe_counter, wipe_counter_count> wipe_counters;
+
+/// @brief The calling thread's wipe counter, or null if it has not claimed one yet.
+thread_local wipe_counter* this_thread_wipe_counter{};
+
+/**
+ * @brief
+ * Claim a wipe counter for the calling thread.  It is handed back when the thread exits, without
+ * resetting it, so that the bytes counted are never lost.
+ *
+ * @return  The counter claimed, or the shared one if none are free.
+ */
+wipe_counter* claim_wipe_counter() noexcept
+{
+    /// @brief Hands the claimed counter back on thread exit.
+    struct releaser {
+        wipe_counter* counter;  ///< @brief The claimed counter.
+
+        ~releaser()
+        {
+            this_thread_wipe_counter = &wipe_counters[0];
+            counter->owned.store(false, std::memory_order_release);
+        }
+    };
+
+    this_thread_wipe_counter = &wipe_counters[0];
+    for (std::size_t i = 1; i < wipe_counter_count; ++i) {
+        if (!wipe_counters[i].owned.exchange(true, std::memory_order_acquire)) {
+            this_thread_wipe_counter = &wipe_counters[i];
+            thread_local releaser release{&wipe_counters[i]};
+            break;
+        }
+    }
+    return this_thread_wipe_counter;
+}
+
+/**
+ * @brief
+ * Add to the calling thread's count of bytes wiped.
+ *
+ * @param len   Number of bytes wiped.
+ */
+inline void count_wiped(std::size_t len) noexcept
+{
+    auto* counter = this_thread_wipe_counter;
+    if (counter == nullptr) {
+        counter = claim_wipe_counter();
+    }
+    if (counter == &wipe_counters[0]) {
+        counter->bytes.fetch_add(len, std::memory_order_relaxed);
+    } else {
+        counter->bytes.store(counter->bytes.load(std::memory_order_relaxed) + len, std::memory_order_relaxed);
+    }
+}
+
+} // namespace
+
+
+namespace ec {
+
+void secure_zero(void* ptr, std::size_t len) noexcept
+{
+    if (len == 0) {
+        return;
+    }
+    active_kernel().load(std::memory_order_relaxed)(ptr, len);
+    compiler_barrier(ptr);
+    count_wiped(len);
+}
+
+namespace details {
+
+std::uint64_t secure_zero_wiped_bytes() noexcept
+{
+    std::uint64_t total{};
+    for (const auto& counter : wipe_counters) {
+        total += counter.bytes.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+} // namespace details
+
+
+#ifdef EC_UNIT_TEST_SUPPORT
+namespace details {
+
+bool set_secure_zero_kernel(secure_zero_kernel kernel) noexcept
+{
+    kernel_fn fn{zero_portable};
+    switch (kernel) {
+    case secure_zero_kernel::portable:
+        break;
+#ifdef EC_SECURE_ZERO_X86
+    case secure_zero_kernel::sse2:
+        if (!__builtin_cpu_supports("sse2")) {
+            return false;
+        }
+        fn = zero_sse2;
+        break;
+    case secure_zero_kernel::avx2:
+        if (!__builtin_cpu_supports("avx2")) {
+            return false;
+        }
+        fn = zero_avx2;
+        break;
+    case secure_zero_kernel::avx512:
+        if (!__builtin_cpu_supports("avx512f")) {
+            return false;
+        }
+        fn = zero_avx512;
+        break;
+#endif
+    default:
+        return false;
+    }
+    active_kernel().store(fn, std::memory_order_relaxed);
+    return true;
+}
+
+void reset_secure_zero_kernel() noexcept
+{
+    active_kernel().store(select_kernel(), std::memory_order_relaxed);
+}
+
+} // namespace details
+#endif
+
+} // namespace ec
@@ -0,0 +1,258 @@
+/**
+ * @file
+ * Unit tests for the open addressing hash map.
+ *
+ * @copyright 2023 Steve Kinneberg <steve.kinneberg@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <enhanced_containers/flat_hash_map.h>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+
+namespace {
+/// @brief Value that is easy to spot in memory.
+constexpr std::uint64_t marker{0x5EC12E7C0FFEE123};
+
+/// @brief Count the copies of `marker` in a block of memory.
+std::size_t count_markers(const void* ptr, std::size_t len)
+{
+    std::size_t count{};
+    const auto* p = static_cast<const std::byte*>(ptr);
+    for (std::size_t i = 0; i + sizeof(marker) <= len; i += sizeof(marker)) {
+        std::uint64_t v;
+        std::memcpy(&v, p + i, sizeof(v));
+        count += (v == marker);
+    }
+    return count;
+}
+
+/// @brief Record of the most recent allocation and whether any freed one held a marker.
+struct allocation_log {
+    void* last{};
+    std::size_t last_len{};
+    std::size_t stale_markers{};
+};
+
+allocation_log alloc_log;
+
+/// @brief Allocator that checks freed memory for markers.
+template <typename T>
+struct checking_allocator {
+    using value_type = T;
+
+    checking_allocator() = default;
+    template <typename U> checking_allocator(const checking_allocator<U>&) {}
+
+    T* allocate(std::size_t n)
+    {
+        auto* p = std::allocator<T>{}.allocate(n);
+        alloc_log.last = p;
+        alloc_log.last_len = n * sizeof(T);
+        return p;
+    }
+
+    void deallocate(T* p, std::size_t n)
+    {
+        alloc_log.stale_markers += count_markers(p, n * sizeof(T));
+        std::allocator<T>{}.deallocate(p, n);
+    }
+
+    bool operator==(const checking_allocator&) const = default;
+};
+
+using checked_map = ec::flat_hash_map<std::uint64_t, std::uint64_t, std::hash<std::uint64_t>,
+                                      std::equal_to<std::uint64_t>,
+                                      checking_allocator<std::pair<const std::uint64_t, std::uint64_t>>>;
+
+/// @brief Transparent string hash.
+struct string_hash {
+    using is_transparent = void;
+    std::size_t operator()(std::string_view s) const { return std::hash<std::string_view>{}(s); }
+};
+
+/// @brief Number of hashes left before `throwing_hash` throws, if it is armed.
+int hashes_before_throw{-1};
+
+/// @brief Hash that throws once `hashes_before_throw` runs out.
+struct throwing_hash {
+    std::size_t operator()(const std::string& s) const
+    {
+        if (hashes_before_throw >= 0 && hashes_before_throw-- == 0) {
+            throw std::runtime_error("hash");
+        }
+        return std::hash<std::string>{}(s);
+    }
+};
+}
+
+TEST(flat_hash_map_test, insert_and_lookup)
+{
+    ec::flat_hash_map<int, int> m;
+
+    EXPECT_TRUE(m.insert({1, 10}).second);
+    EXPECT_TRUE(m.emplace(2, 20).second);
+    EXPECT_TRUE(m.try_emplace(3, 30).second);
+    EXPECT_FALSE(m.insert({1, 0}).second);
+    EXPECT_FALSE(m.try_emplace(2, 0).second);
+    EXPECT_EQ(m.size(), 3);
+
+    EXPECT_EQ(m.at(1), 10);
+    EXPECT_EQ(m.find(2)->second, 20);
+    EXPECT_TRUE(m.contains(3));
+    EXPECT_EQ(m.count(4), 0);
+    EXPECT_EQ(m.find(4), m.end());
+    EXPECT_THROW(m.at(4), std::out_of_range);
+
+    m[4] = 40;
+    m[1] += 1;
+    EXPECT_FALSE(m.insert_or_assign(2, 21).second);
+    EXPECT_EQ(m, (ec::flat_hash_map<int, int>{{1, 11}, {2, 21}, {3, 30}, {4, 40}}));
+}
+
+TEST(flat_hash_map_test, matches_std_map_through_growth_and_erasure)
+{
+    ec::flat_hash_map<int, int> m;
+    std::map<int, int> expected;
+
+    for (int i = 0; i < 10000; ++i) {
+        m.emplace(i * 7, i);
+        expected.emplace(i * 7, i);
+    }
+    for (int i = 0; i < 10000; i += 3) {
+        EXPECT_EQ(m.erase(i * 7), 1);
+        expected.erase(i * 7);
+    }
+    // Churn so that tombstones get reused and cleaned out.
+    for (int round = 0; round < 5; ++round) {
+        for (int i = 0; i < 2000; ++i) {
+            m.emplace(100000 + i, i);
+        }
+        for (int i = 0; i < 2000; ++i) {
+            m.erase(100000 + i);
+        }
+    }
+
+    EXPECT_EQ(m.size(), expected.size());
+    EXPECT_LE(m.load_factor(), m.max_load_factor());
+    std::map<int, int> contents(m.begin(), m.end());
+    EXPECT_EQ(contents, expected);
+    for (int i = 0; i < 10000; ++i) {
+        EXPECT_EQ(m.contains(i * 7), i % 3 != 0) << i;
+    }
+}
+
+TEST(flat_hash_map_test, erase_wipes_slot)
+{
+    checked_map m;
+    for (std::uint64_t i = 0; i < 10; ++i) {
+        m.emplace(i, i == 5 ? marker : i);
+    }
+    ASSERT_EQ(count_markers(alloc_log.last, alloc_log.last_len), 1);
+
+    EXPECT_EQ(m.erase(5), 1);
+    EXPECT_EQ(count_markers(alloc_log.last, alloc_log.last_len), 0);
+
+    m.emplace(marker, 1);
+    auto it = m.erase(m.find(marker));
+    EXPECT_EQ(count_markers(alloc_log.last, alloc_log.last_len), 0);
+    EXPECT_TRUE(it == m.end() || it->first != marker);
+}
+
+TEST(flat_hash_map_test, rehash_wipes_old_table)
+{
+    alloc_log = {};
+    {
+        checked_map m;
+        for (std::uint64_t i = 0; i < 1000; ++i) {
+            m.emplace(i, marker);
+        }
+        EXPECT_EQ(alloc_log.stale_markers, 0);
+        m.rehash(4096);
+        EXPECT_EQ(alloc_log.stale_markers, 0);
+        m.clear();
+        EXPECT_EQ(count_markers(alloc_log.last, alloc_log.last_len), 0);
+        m.emplace(1, marker);
+    }
+    EXPECT_EQ(alloc_log.stale_markers, 0);
+}
+
+TEST(flat_hash_map_test, throwing_rehash_leaves_map_intact)
+{
+    ec::flat_hash_map<std::string, std::string, throwing_hash> m;
+    for (int i = 0; i < 100; ++i) {
+        m.emplace(std::to_string(i), std::string(32, 'a' + i % 26));
+    }
+
+    hashes_before_throw = 50;
+    EXPECT_THROW(m.rehash(1024), std::runtime_error);
+    hashes_before_throw = -1;
+
+    EXPECT_EQ(m.size(), 100);
+    for (int i = 0; i < 100; ++i) {
+        auto it = m.find(std::to_string(i));
+        ASSERT_NE(it, m.end());
+        EXPECT_EQ(it->second, std::string(32, 'a' + i % 26));
+    }
+
+    m.rehash(1024);
+    EXPECT_EQ(m.size(), 100);
+    EXPECT_EQ(m.at("42"), std::string(32, 'a' + 42 % 26));
+}
+
+TEST(flat_hash_map_test, copy_move_and_swap)
+{
+    ec::flat_hash_map<std::string, int> a{{"one", 1}, {"two", 2}};
+
+    auto b = a;
+    EXPECT_EQ(a, b);
+    b["three"] = 3;
+    EXPECT_NE(a, b);
+
+    auto c = std::move(b);
+    EXPECT_TRUE(b.empty());
+    EXPECT_EQ(c.size(), 3);
+
+    swap(a, c);
+    EXPECT_EQ(a.size(), 3);
+    EXPECT_EQ(c.size(), 2);
+
+    c = a;
+    EXPECT_EQ(a, c);
+    c = std::move(a);
+    EXPECT_EQ(c.size(), 3);
+}
+
+TEST(flat_hash_map_test, erase_if_and_heterogeneous_lookup)
+{
+    ec::flat_hash_map<std::string, int, string_hash, std::equal_to<>> m;
+    for (int i = 0; i < 100; ++i) {
+        m.emplace(std::to_string(i), i);
+    }
+
+    EXPECT_EQ(ec::erase_if(m, [](const auto& kv) { return kv.second % 2 == 0; }), 50);
+    EXPECT_EQ(m.size(), 50);
+    EXPECT_TRUE(m.contains(std::string_view{"51"}));
+    EXPECT_FALSE(m.contains(std::string_view{"50"}));
+    EXPECT_EQ(m.find("99")->second, 99);
+}
@@ -0,0 +1,166 @@
+/**
+ * @file
+ * Unit tests for the flat map and flat set container adapters.
+ *
+ * @copyright 2023 Steve Kinneberg <steve.kinneberg@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <enhanced_containers/flat_map.h>
+#include <enhanced_containers/flat_set.h>
+
+#include <gtest/gtest.h>
+
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+static_assert(std::random_access_iterator<ec::flat_map<int, int>::iterator>);
+static_assert(std::random_access_iterator<ec::flat_set<int>::iterator>);
+
+TEST(flat_map_test, construction_sorts_and_drops_duplicates)
+{
+    ec::flat_map<int, std::string> m{{3, "c"}, {1, "a"}, {2, "b"}, {1, "x"}};
+
+    EXPECT_EQ(m.size(), 3);
+    EXPECT_EQ(m.keys(), (std::vector<int>{1, 2, 3}));
+    EXPECT_EQ(m.values(), (std::vector<std::string>{"a", "b", "c"}));
+
+    ec::flat_map<int, int> s{ec::sorted_unique, {1, 2, 3}, {4, 5, 6}};
+    EXPECT_EQ(s.at(2), 5);
+}
+
+TEST(flat_map_test, insert_and_lookup)
+{
+    ec::flat_map<int, int> m;
+
+    EXPECT_TRUE(m.insert({5, 50}).second);
+    EXPECT_TRUE(m.emplace(1, 10).second);
+    EXPECT_TRUE(m.try_emplace(3, 30).second);
+    EXPECT_FALSE(m.insert({5, 0}).second);
+    EXPECT_FALSE(m.try_emplace(3, 0).second);
+
+    EXPECT_EQ(m.keys(), (std::vector<int>{1, 3, 5}));
+    EXPECT_EQ(m.values(), (std::vector<int>{10, 30, 50}));
+
+    EXPECT_TRUE(m.contains(3));
+    EXPECT_FALSE(m.contains(4));
+    EXPECT_EQ(m.count(5), 1);
+    EXPECT_EQ(m.find(4), m.end());
+    EXPECT_EQ(m.find(5)->second, 50);
+    EXPECT_EQ(m.lower_bound(4)->first, 5);
+    EXPECT_EQ(m.upper_bound(3)->first, 5);
+    EXPECT_EQ(std::distance(m.equal_range(3).first, m.equal_range(3).second), 1);
+    EXPECT_EQ(std::distance(m.equal_range(4).first, m.equal_range(4).second), 0);
+
+    EXPECT_THROW(m.at(4), std::out_of_range);
+
+    m[4] = 40;
+    m[5] += 5;
+    EXPECT_EQ(m.values(), (std::vector<int>{10, 30, 40, 55}));
+
+    EXPECT_FALSE(m.insert_or_assign(1, 11).second);
+    EXPECT_TRUE(m.insert_or_assign(2, 20).second);
+    EXPECT_EQ(m.values(), (std::vector<int>{11, 20, 30, 40, 55}));
+}
+
+TEST(flat_map_test, iteration)
+{
+    ec::flat_map<int, int> m{{2, 20}, {1, 10}, {3, 30}};
+
+    int expected = 1;
+    for (auto [k, v] : m) {
+        EXPECT_EQ(k, expected);
+        EXPECT_EQ(v, expected * 10);
+        v += 1;
+        ++expected;
+    }
+    EXPECT_EQ(m.values(), (std::vector<int>{11, 21, 31}));
+
+    EXPECT_EQ(m.rbegin()->first, 3);
+    EXPECT_EQ(m.end() - m.begin(), 3);
+    EXPECT_EQ(m.begin()[1].second, 21);
+}
+
+TEST(flat_map_test, erase)
+{
+    ec::flat_map<int, int> m{{1, 10}, {2, 20}, {3, 30}, {4, 40}, {5, 50}};
+
+    EXPECT_EQ(m.erase(3), 1);
+    EXPECT_EQ(m.erase(3), 0);
+    auto it = m.erase(m.begin());
+    EXPECT_EQ(it->first, 2);
+    it = m.erase(m.begin(), std::next(m.begin()));
+    EXPECT_EQ(it->first, 4);
+    EXPECT_EQ(m.keys(), (std::vector<int>{4, 5}));
+    EXPECT_EQ(m.values(), (std::vector<int>{40, 50}));
+
+    m.insert({{1, 10}, {6, 60}, {7, 70}});
+    EXPECT_EQ(ec::erase_if(m, [](const auto& kv) { return kv.second % 20 == 0; }), 2);
+    EXPECT_EQ(m.keys(), (std::vector<int>{1, 5, 7}));
+    EXPECT_EQ(m.values(), (std::vector<int>{10, 50, 70}));
+
+    m.clear();
+    EXPECT_TRUE(m.empty());
+}
+
+TEST(flat_map_test, extract_and_replace)
+{
+    ec::flat_map<int, int> m{{2, 20}, {1, 10}};
+
+    auto c = std::move(m).extract();
+    EXPECT_TRUE(m.empty());
+    EXPECT_EQ(c.keys, (std::vector<int>{1, 2}));
+    EXPECT_EQ(c.values, (std::vector<int>{10, 20}));
+
+    c.keys.push_back(3);
+    c.values.push_back(30);
+    m.replace(std::move(c.keys), std::move(c.values));
+    EXPECT_EQ(m.at(3), 30);
+    EXPECT_EQ(m, (ec::flat_map<int, int>{{1, 10}, {2, 20}, {3, 30}}));
+}
+
+TEST(flat_map_test, heterogeneous_lookup)
+{
+    ec::flat_map<std::string, int, std::less<>> m{{"b", 2}, {"a", 1}};
+
+    EXPECT_TRUE(m.contains(std::string_view{"a"}));
+    EXPECT_EQ(m.find("b")->second, 2);
+    EXPECT_EQ(m.find("c"), m.end());
+}
+
+TEST(flat_set_test, basic_usage)
+{
+    ec::flat_set<int> s{5, 1, 3, 1};
+
+    EXPECT_EQ(s.size(), 3);
+    EXPECT_TRUE(s.insert(2).second);
+    EXPECT_FALSE(s.insert(3).second);
+    EXPECT_EQ(*s.emplace(4).first, 4);
+    s.insert({9, 0, 9});
+    EXPECT_EQ(std::vector<int>(s.begin(), s.end()), (std::vector<int>{0, 1, 2, 3, 4, 5, 9}));
+
+    EXPECT_TRUE(s.contains(4));
+    EXPECT_FALSE(s.contains(6));
+    EXPECT_EQ(*s.lower_bound(6), 9);
+    EXPECT_EQ(*s.upper_bound(4), 5);
+
+    EXPECT_EQ(s.erase(9), 1);
+    EXPECT_EQ(s.erase(9), 0);
+    EXPECT_EQ(ec::erase_if(s, [](int k) { return k % 2 != 0; }), 3);
+    EXPECT_EQ(std::move(s).extract(), (std::vector<int>{0, 2, 4}));
+    EXPECT_TRUE(s.empty());
+}
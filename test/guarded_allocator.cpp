@@ -0,0 +1,146 @@
+/**
+ * @file
+ * Unit tests for the allocator that places allocations flush against guard pages.
+ *
+ * @copyright 2023 Steve Kinneberg <steve.kinneberg@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <enhanced_containers/guarded_allocator.h>
+#include <enhanced_containers/secure_string.h>
+#include <enhanced_containers/secure_vector.h>
+
+#include "mock_c_lib.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <unistd.h>
+
+// Compile-time compatibility with STL containers.
+ec::serialized_secure::vector<std::uint8_t, ec::guarded_allocator<std::uint8_t>> test_vector;
+ec::serialized_secure::basic_string<char, std::char_traits<char>, ec::guarded_allocator<char>> test_string;
+
+namespace {
+const auto page_size = static_cast<std::uintptr_t>(sysconf(_SC_PAGESIZE));
+
+/// @brief Check if the kernel reports the mapping holding an address as locked.
+bool is_locked(const void* ptr)
+{
+    auto addr = reinterpret_cast<std::uintptr_t>(ptr);
+    std::ifstream smaps{"/proc/self/smaps"};
+    bool in_mapping{};
+    for (std::string line; std::getline(smaps, line);) {
+        std::uintptr_t start{};
+        std::uintptr_t end{};
+        if (std::sscanf(line.c_str(), "%" SCNxPTR "-%" SCNxPTR, &start, &end) == 2) {
+            in_mapping = start <= addr && addr < end;
+        } else if (in_mapping && line.starts_with("VmFlags:")) {
+            return (line + " ").find(" lo ") != std::string::npos;
+        }
+    }
+    return false;
+}
+}
+
+TEST(guarded_allocator_test, allocation_ends_at_page_boundary)
+{
+    ec::guarded_allocator<std::uint32_t> alloc;
+    for (std::size_t len : {1, 3, 1000, 1024, 100000}) {
+        auto* ptr = alloc.allocate(len);
+        EXPECT_EQ(reinterpret_cast<std::uintptr_t>(ptr + len) % page_size, 0) << "len: " << len;
+        ptr[0] = 1;
+        ptr[len - 1] = 2;
+        alloc.deallocate(ptr, len);
+    }
+}
+
+TEST(guarded_allocator_test, freed_slots_are_reused)
+{
+    ec::guarded_allocator<char> alloc;
+    auto* first = alloc.allocate(100);
+    alloc.deallocate(first, 100);
+    auto* second = alloc.allocate(100);
+    EXPECT_EQ(first, second);
+    EXPECT_EQ(second[0], 0);    // Contents were dropped.
+    alloc.deallocate(second, 100);
+}
+
+TEST(guarded_allocator_test, slot_wiped_in_place_when_it_cannot_be_remapped)
+{
+    ec::guarded_allocator<char> alloc;
+    auto* first = alloc.allocate(100);
+    std::fill_n(first, 100, 'k');
+
+    mock::c_lib::fail_fixed_mappings(true);
+    alloc.deallocate(first, 100);
+    mock::c_lib::fail_fixed_mappings(false);
+
+    auto* second = alloc.allocate(100);
+    EXPECT_EQ(first, second);
+    EXPECT_EQ(std::count(second, second + 100, 0), 100);
+    alloc.deallocate(second, 100);
+}
+
+TEST(guarded_allocator_test, reused_slot_is_locked_under_retention)
+{
+    // Closing a slot maps fresh pages over it, which drops any lock, so its pages must not be
+    // retained as if they were still locked.
+    ec::set_no_swap_retention_policy({.max_bytes = 1024 * 1024});
+    ec::serialized_secure_allocator<char, ec::guarded_allocator<char>> alloc;
+    auto retained = ec::no_swap_allocator_snapshot().retained_pages;
+    auto* first = alloc.allocate(100);
+    EXPECT_TRUE(is_locked(first));
+    alloc.deallocate(first, 100);
+    EXPECT_EQ(ec::no_swap_allocator_snapshot().retained_pages, retained);
+
+    auto* second = alloc.allocate(100);
+    EXPECT_EQ(first, second);
+    EXPECT_TRUE(is_locked(second));
+    alloc.deallocate(second, 100);
+    ec::set_no_swap_retention_policy({});
+}
+
+TEST(guarded_allocator_test, secure_vector)
+{
+    ec::serialized_secure::vector<int, ec::guarded_allocator<int>> v;
+    for (int i = 0; i < 10000; ++i) {
+        v.push_back(i);
+    }
+    EXPECT_EQ(v.back(), 9999);
+}
+
+TEST(guarded_allocator_death_test, overrun_faults)
+{
+    ec::guarded_allocator<char> alloc;
+    auto* ptr = alloc.allocate(10);
+    EXPECT_DEATH(static_cast<volatile char*>(ptr)[10] = 1, "");
+    alloc.deallocate(ptr, 10);
+}
+
+TEST(guarded_allocator_death_test, underrun_is_detected)
+{
+    ec::guarded_allocator<char> alloc;
+    auto* ptr = alloc.allocate(10);
+    EXPECT_DEATH({
+        static_cast<volatile char*>(ptr)[-1] = 1;
+        alloc.deallocate(ptr, 10);
+    }, "");
+    alloc.deallocate(ptr, 10);
+}
@@ -0,0 +1,241 @@
+/**
+ * @file
+ * Unit tests for the pool of memory that is locked to RAM up front.
+ *
+ * @copyright 2023 Steve Kinneberg <steve.kinneberg@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <enhanced_containers/locked_pool.h>
+#include <enhanced_containers/secure_string.h>
+#include <enhanced_containers/secure_vector.h>
+
+#include <gtest/gtest.h>
+
+#include <bit>
+#include <cstdint>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Compile-time compatibility with STL containers.
+ec::pooled_secure::vector<int> test_vector;
+ec::pooled_secure::string test_string;
+
+class locked_pool_test: public ::testing::Test {
+  protected:
+    ec::locked_pool& pool{ec::locked_pool::get_instance()};
+};
+
+TEST_F(locked_pool_test, block_sizes)
+{
+    EXPECT_EQ(pool.block_size(1), ec::locked_pool::min_block_size);
+    EXPECT_EQ(pool.block_size(16), 16);
+    EXPECT_EQ(pool.block_size(17), 32);
+    EXPECT_EQ(pool.block_size(1000), 1024);
+    EXPECT_EQ(pool.block_size(ec::locked_pool::max_block_size), ec::locked_pool::max_block_size);
+    EXPECT_GT(pool.block_size(ec::locked_pool::max_block_size + 1), ec::locked_pool::max_block_size);
+}
+
+TEST_F(locked_pool_test, freed_blocks_are_reused)
+{
+    auto* first = pool.allocate(100);
+    pool.deallocate(first, 100);
+    auto* second = pool.allocate(100);
+    EXPECT_EQ(first, second);
+    pool.deallocate(second, 100);
+}
+
+TEST_F(locked_pool_test, churn_does_not_lock_more_memory)
+{
+    constexpr std::size_t block_count{64};
+    std::vector<void*> blocks(block_count);
+
+    for (auto& b : blocks) {
+        b = pool.allocate(256);
+    }
+    for (auto* b : blocks) {
+        pool.deallocate(b, 256);
+    }
+    auto before = pool.statistics();
+
+    for (int i = 0; i < 1000; ++i) {
+        for (auto& b : blocks) {
+            b = pool.allocate(256);
+        }
+        for (auto* b : blocks) {
+            pool.deallocate(b, 256);
+        }
+    }
+
+    auto after = pool.statistics();
+    EXPECT_EQ(after.locked_bytes, before.locked_bytes);
+    EXPECT_EQ(after.in_use_bytes, before.in_use_bytes);
+    EXPECT_EQ(after.locked_bytes % ec::locked_pool::chunk_size, 0);
+}
+
+TEST_F(locked_pool_test, large_allocations_get_dedicated_mapping)
+{
+    constexpr std::size_t len{ec::locked_pool::max_block_size * 2};
+    auto before = pool.statistics();
+
+    auto* ptr = pool.allocate(len);
+    auto during = pool.statistics();
+    EXPECT_EQ(during.locked_bytes, before.locked_bytes + len);
+    EXPECT_EQ(during.in_use_bytes, before.in_use_bytes + len);
+    EXPECT_GE(during.locked_bytes_high_water_mark, during.locked_bytes);
+    EXPECT_GE(during.in_use_bytes_high_water_mark, during.in_use_bytes);
+
+    pool.deallocate(ptr, len);
+    auto after = pool.statistics();
+    EXPECT_EQ(after.locked_bytes, before.locked_bytes);
+    EXPECT_EQ(after.in_use_bytes, before.in_use_bytes);
+    EXPECT_EQ(after.locked_bytes_high_water_mark, during.locked_bytes_high_water_mark);
+}
+
+TEST_F(locked_pool_test, pooled_secure_containers)
+{
+    auto use_containers = [this]() {
+        ec::pooled_secure::vector<int> v;
+        for (int i = 0; i < 1000; ++i) {
+            v.push_back(i);
+        }
+        ec::pooled_secure::string s(100, 'x');
+        EXPECT_EQ(v.back(), 999);
+        EXPECT_EQ(s.size(), 100);
+    };
+
+    use_containers();
+    auto before = pool.statistics();
+    use_containers();
+    auto after = pool.statistics();
+    EXPECT_EQ(after.locked_bytes, before.locked_bytes);
+    EXPECT_EQ(after.in_use_bytes, before.in_use_bytes);
+}
+
+TEST_F(locked_pool_test, thread_exit_returns_cached_blocks)
+{
+    constexpr std::size_t block_count{40};
+    constexpr std::size_t len{48};
+    std::vector<void*> blocks(block_count);
+    auto before = pool.statistics();
+
+    std::thread{[this, &blocks]() {
+        for (auto& b : blocks) {
+            b = pool.allocate(len);
+        }
+        // Keep half of the blocks past the end of the thread.
+        for (std::size_t i = 0; i < block_count / 2; ++i) {
+            pool.deallocate(blocks[i], len);
+        }
+    }}.join();
+
+    EXPECT_EQ(pool.statistics().in_use_bytes,
+              before.in_use_bytes + pool.block_size(len) * (block_count / 2));
+
+    for (std::size_t i = block_count / 2; i < block_count; ++i) {
+        pool.deallocate(blocks[i], len);
+    }
+}
+
+TEST_F(locked_pool_test, concurrent_allocations)
+{
+    constexpr std::size_t thread_count{8};
+    constexpr std::size_t iteration_count{1000};
+    std::vector<std::thread> threads;
+
+    for (std::size_t t = 0; t < thread_count; ++t) {
+        threads.emplace_back([this]() {
+            std::vector<std::pair<std::uint64_t*, std::size_t>> blocks;
+            for (std::size_t i = 0; i < iteration_count; ++i) {
+                auto len = 8 + (i * 37) % 2048;
+                auto* ptr = static_cast<std::uint64_t*>(pool.allocate(len));
+                ptr[0] = i;
+                blocks.emplace_back(ptr, len);
+                if (blocks.size() == 32) {
+                    for (auto [p, l] : blocks) {
+                        pool.deallocate(p, l);
+                    }
+                    blocks.clear();
+                }
+            }
+            for (auto [p, l] : blocks) {
+                pool.deallocate(p, l);
+            }
+        });
+    }
+
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+TEST_F(locked_pool_test, backend_memory_is_usable)
+{
+    auto backend = pool.backend();
+    EXPECT_TRUE(backend == ec::locked_pool_backend::mlock ||
+                backend == ec::locked_pool_backend::map_locked ||
+                backend == ec::locked_pool_backend::memfd_secret);
+
+    // Large blocks get their own mapping from the backend.
+    constexpr std::size_t len{ec::locked_pool::max_block_size * 2};
+    auto before = pool.statistics();
+    auto* ptr = static_cast<unsigned char*>(pool.allocate(len));
+    ASSERT_NE(ptr, nullptr);
+    ptr[0] = 1;
+    ptr[len - 1] = 2;
+    EXPECT_GE(pool.statistics().locked_bytes, before.locked_bytes + len);
+    EXPECT_EQ(ptr[0], 1);
+    EXPECT_EQ(ptr[len - 1], 2);
+    pool.deallocate(ptr, len);
+    EXPECT_EQ(pool.statistics().locked_bytes, before.locked_bytes);
+
+    // Falling back never goes the other way.
+    EXPECT_LE(static_cast<int>(pool.backend()), static_cast<int>(backend));
+}
+
+TEST_F(locked_pool_test, large_allocations_are_huge_page_aligned)
+{
+    auto huge_page_size = pool.huge_page_size();
+    if (huge_page_size == 0 || pool.backend() == ec::locked_pool_backend::memfd_secret) {
+        GTEST_SKIP() << "Huge pages are not used";
+    }
+    EXPECT_TRUE(std::has_single_bit(huge_page_size));
+
+    // A whole number of huge pages, which may come from hugetlbfs, and a length that can only use
+    // transparent huge pages.
+    for (auto len : {huge_page_size, huge_page_size + huge_page_size / 2}) {
+        auto before = pool.statistics();
+        auto* ptr = static_cast<unsigned char*>(pool.allocate(len));
+        EXPECT_EQ(reinterpret_cast<std::uintptr_t>(ptr) & (huge_page_size - 1), 0U);
+        EXPECT_EQ(pool.statistics().locked_bytes, before.locked_bytes + pool.block_size(len));
+        ptr[0] = 1;
+        ptr[len - 1] = 2;
+        EXPECT_EQ(ptr[0], 1);
+        EXPECT_EQ(ptr[len - 1], 2);
+        pool.deallocate(ptr, len);
+        EXPECT_EQ(pool.statistics().locked_bytes, before.locked_bytes);
+    }
+}
+
+#if defined(__cpp_lib_allocate_at_least)
+TEST_F(locked_pool_test, allocate_at_least_reports_block_capacity)
+{
+    ec::locked_pool_allocator<std::uint32_t> alloc;
+    auto r = alloc.allocate_at_least(5);
+    EXPECT_EQ(r.count, pool.block_size(5 * sizeof(std::uint32_t)) / sizeof(std::uint32_t));
+    r.ptr[r.count - 1] = 1;
+    alloc.deallocate(r.ptr, r.count);
+}
+#endif
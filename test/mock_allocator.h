@@ -24,6 +24,7 @@
 #include <enhanced_containers/details/common.h>
 #include <gmock/gmock.h>
 #include <memory>
+#include <memory_resource>
 
 namespace mock {
 
@@ -80,16 +81,19 @@ struct allocator {
 template <typename T>
 struct monitored_allocator: allocator<T> {
     using value_type = T;
+    // All instances share the same monitor and memory, so released blocks may be parked.
+    using parks_released_blocks = std::true_type;
 
     monitored_allocator() {
-        auto alloc = [this](std::size_t n)
+        // The monitor outlives any one allocator, so its default actions must not refer to this one.
+        auto alloc = [](std::size_t n)
         {
-            auto* ptr = allocator<T>::allocate(n / sizeof(T));
+            auto* ptr = allocator<T>{}.allocate(n / sizeof(T));
             return ptr;
         };
-        auto dealloc = [this](void* p, std::size_t n)
+        auto dealloc = [](void* p, std::size_t n)
         {
-            allocator<T>::deallocate(reinterpret_cast<T*>(p), n / sizeof(T));
+            allocator<T>{}.deallocate(reinterpret_cast<T*>(p), n / sizeof(T));
         };
         ON_CALL(*_monitor, void_allocate)
             .WillByDefault(alloc);
@@ -124,7 +128,7 @@ struct monitored_allocator: allocator<T> {
 #if defined(__cpp_lib_allocate_at_least)
     auto allocate_at_least(std::size_t n)
     {
-        return reinterpret_cast<T*>(_monitor->void_allocate(n * sizeof(T)));
+        return std::allocation_result{reinterpret_cast<T*>(_monitor->void_allocate(n * sizeof(T))), n};
     }
 
 #endif
@@ -137,4 +141,38 @@ struct monitored_allocator: allocator<T> {
     std::shared_ptr<allocation_monitor> _monitor{allocation_monitor::get_instance()};
 };
 
+class memory_resource: public std::pmr::memory_resource {
+  public:
+    memory_resource() {
+        auto alloc = [this](std::size_t n)
+        {
+            return _memory->acquire(n);
+        };
+        ON_CALL(*_monitor, void_allocate)
+            .WillByDefault(alloc);
+        ON_CALL(*_monitor, void_deallocate)
+            .WillByDefault([](void*, std::size_t) {});
+    }
+
+  protected:
+    void* do_allocate(std::size_t n, std::size_t) override
+    {
+        return _monitor->void_allocate(n);
+    }
+
+    void do_deallocate(void* p, std::size_t n, std::size_t) override
+    {
+        _monitor->void_deallocate(p, n);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+    {
+        return this == &other;
+    }
+
+  private:
+    std::shared_ptr<memory> _memory{memory::get_instance()};
+    std::shared_ptr<allocation_monitor> _monitor{allocation_monitor::get_instance()};
+};
+
 } //namespace mock
@@ -20,12 +20,15 @@
 #include "mock_c_lib.h"
 
 #include "mock_memory.h"
+#include <atomic>
+#include <cerrno>
 #include <memory>
 
 namespace real {
 int   (*mlock)(const void*, std::size_t){};
 int   (*munlock)(const void*, std::size_t){};
 void* (*memset)(void*, int, std::size_t){};
+void* (*mmap)(void*, std::size_t, int, int, int, off_t){};
 }
 
 namespace {
@@ -35,8 +38,16 @@ void bind_real()
         real::mlock   = reinterpret_cast<int   (*)(const void*, std::size_t)>(dlsym(RTLD_NEXT, "mlock"));
         real::munlock = reinterpret_cast<int   (*)(const void*, std::size_t)>(dlsym(RTLD_NEXT, "munlock"));
         real::memset  = reinterpret_cast<void* (*)(void*, int, std::size_t)> (dlsym(RTLD_NEXT, "memset"));
+        real::mmap    = reinterpret_cast<void* (*)(void*, std::size_t, int, int, int, off_t)>(dlsym(RTLD_NEXT, "mmap"));
     }
 }
+
+std::atomic<std::size_t> mlock_calls{};
+std::atomic<std::size_t> mlock_bytes{};
+std::atomic<std::size_t> munlock_calls{};
+std::atomic<std::size_t> munlock_bytes{};
+std::atomic<bool> simulate{};
+std::atomic<bool> fail_fixed{};
 }
 
 
@@ -52,6 +63,29 @@ std::shared_ptr<c_lib> c_lib::get_instance()
     return _self;
 }
 
+syscall_counts c_lib::counts() noexcept
+{
+    return {mlock_calls.load(), mlock_bytes.load(), munlock_calls.load(), munlock_bytes.load()};
+}
+
+void c_lib::reset_counts() noexcept
+{
+    mlock_calls = 0;
+    mlock_bytes = 0;
+    munlock_calls = 0;
+    munlock_bytes = 0;
+}
+
+void c_lib::simulate_memory_locking(bool enable) noexcept
+{
+    simulate = enable;
+}
+
+void c_lib::fail_fixed_mappings(bool enable) noexcept
+{
+    fail_fixed = enable;
+}
+
 #if defined(__linux__) || defined(__unix) || defined(__unix__)
 int c_lib::mock_mlock(const void* addr, std::size_t len) noexcept
 {
@@ -59,7 +93,9 @@ int c_lib::mock_mlock(const void* addr, std::size_t len) noexcept
     if (_self && memory::get_instance()->is_mock_memory(addr)) {
         return _self->mlock(addr, len);
     }
-    return real::mlock(addr, len);
+    ++mlock_calls;
+    mlock_bytes += len;
+    return simulate ? 0 : real::mlock(addr, len);
 }
 
 int c_lib::mock_munlock(const void* addr, std::size_t len) noexcept
@@ -68,7 +104,9 @@ int c_lib::mock_munlock(const void* addr, std::size_t len) noexcept
     if (_self && memory::get_instance()->is_mock_memory(addr)) {
         return _self->munlock(addr, len);
     }
-    return real::munlock(addr, len);
+    ++munlock_calls;
+    munlock_bytes += len;
+    return simulate ? 0 : real::munlock(addr, len);
 }
 
 void* c_lib::mock_memset(void* s, int c, std::size_t n) noexcept
@@ -80,6 +118,16 @@ void* c_lib::mock_memset(void* s, int c, std::size_t n) noexcept
     }
     return real::memset(s, c, n);
 }
+
+void* c_lib::mock_mmap(void* addr, std::size_t len, int prot, int flags, int fd, off_t offset) noexcept
+{
+    bind_real();
+    if (fail_fixed && (flags & MAP_FIXED) != 0) {
+        errno = ENOMEM;
+        return MAP_FAILED;
+    }
+    return real::mmap(addr, len, prot, flags, fd, offset);
+}
 #endif
 
 } // namespace mock
@@ -104,5 +152,10 @@ void* memset(void* s, int c, std::size_t n)
     return mock::c_lib::mock_memset(s, c, n);
 }
 
+void* mmap(void* addr, std::size_t len, int prot, int flags, int fd, off_t offset)
+{
+    return mock::c_lib::mock_mmap(addr, len, prot, flags, fd, offset);
+}
+
 }
 #endif
@@ -20,6 +20,7 @@
 #pragma once
 
 #include <gmock/gmock.h>
+#include <cstddef>
 #include <memory>
 
 #if defined(__linux__) || defined(__unix) || defined(__unix__)
@@ -46,18 +47,49 @@ namespace real {
 extern int   (*mlock)  (const void*, std::size_t);
 extern int   (*munlock)(const void*, std::size_t);
 extern void* (*memset) (void*, int, std::size_t);
+extern void* (*mmap)   (void*, std::size_t, int, int, int, off_t);
 }
 #endif
 
 namespace mock {
 
+/**
+ * Counts of the memory locking calls made outside of the mock memory, for tests that hold
+ * workloads to a syscall budget.
+ */
+struct syscall_counts {
+    std::size_t mlock_calls{};      ///< Number of mlock() calls.
+    std::size_t mlock_bytes{};      ///< Bytes passed to mlock().
+    std::size_t munlock_calls{};    ///< Number of munlock() calls.
+    std::size_t munlock_bytes{};    ///< Bytes passed to munlock().
+};
+
 struct c_lib {
     static std::shared_ptr<c_lib> get_instance();
 
+    /// Get the counts of calls made since the last reset.
+    static syscall_counts counts() noexcept;
+
+    /// Reset the counts of calls.
+    static void reset_counts() noexcept;
+
+    /**
+     * When enabled, mlock() and munlock() calls outside of the mock memory are counted but not
+     * passed on to the OS, so that workloads larger than RLIMIT_MEMLOCK can be measured.
+     */
+    static void simulate_memory_locking(bool enable) noexcept;
+
+    /**
+     * When enabled, mmap() calls with MAP_FIXED fail with ENOMEM, the way they do once the
+     * process reaches vm.max_map_count.
+     */
+    static void fail_fixed_mappings(bool enable) noexcept;
+
 #if defined(__linux__) || defined(__unix) || defined(__unix__)
     static int   mock_mlock(const void* addr, std::size_t len) noexcept;
     static int   mock_munlock(const void* addr, std::size_t len) noexcept;
     static void* mock_memset(void* s, int c, std::size_t n) noexcept;
+    static void* mock_mmap(void* addr, std::size_t len, int prot, int flags, int fd, off_t offset) noexcept;
 
     MOCK_METHOD(int,   mlock,   (const void* addr, std::size_t len), (noexcept));
     MOCK_METHOD(int,   munlock, (const void* addr, std::size_t len), (noexcept));
@@ -19,6 +19,7 @@
  */
 
 #include <enhanced_containers/no_swap_allocator.h>
+#include <enhanced_containers/secure_zero.h>
 
 #include "mock_allocator.h"
 #include "mock_c_lib.h"
@@ -26,6 +27,8 @@
 
 #include <fmt/format.h>
 
+#include <array>
+#include <chrono>
 #include <deque>
 #include <forward_list>
 #include <list>
@@ -33,8 +36,11 @@
 #include <queue>
 #include <set>
 #include <stack>
+#include <system_error>
+#include <thread>
 #include <unordered_map>
 #include <unordered_set>
+#include <vector>
 
 // Compile-time compatibility with STL containers.  Also, may test construction/destruction ordering
 // of globals with the allocation tracker data structure.
@@ -72,12 +78,31 @@ class unserialized_no_swap_allocator_typed_test: public ::testing::Test {
     std::shared_ptr<mock::c_lib> mock_c_lib{mock::c_lib::get_instance()};
     std::unique_ptr<ec::unserialized_no_swap_allocator<TypeParam, mock::monitored_allocator<TypeParam>>> allocator;
 
+    /**
+     * Group page numbers into runs of contiguous pages since the allocator locks/unlocks each run
+     * with a single call.
+     */
+    template <typename... P>
+    static std::vector<std::pair<std::size_t, std::size_t>> to_page_runs(P... page_num)
+    {
+        std::array<std::size_t, sizeof...(P)> pages{static_cast<std::size_t>(page_num)...};
+        std::vector<std::pair<std::size_t, std::size_t>> runs;
+        for (auto page : pages) {
+            if (!runs.empty() && runs.back().first + runs.back().second == page) {
+                ++runs.back().second;
+            } else {
+                runs.emplace_back(page, 1);
+            }
+        }
+        return runs;
+    }
+
     virtual void SetUp()
     {
         memory->reset();
         allocator = std::make_unique<ec::unserialized_no_swap_allocator<TypeParam, mock::monitored_allocator<TypeParam>>>();
         auto& mem = memory->get_memory_array();
-        ec::details::no_swap_allocator_state::get_state_object()->clear_pages(mem.data(), mem.size());
+        ec::details::no_swap_allocator_state::get_state_object().clear_pages(mem.data(), mem.size());
     }
 
     virtual void TearDown()
@@ -96,11 +121,11 @@ class unserialized_no_swap_allocator_typed_test: public ::testing::Test {
             EXPECT_CALL(*mock_c_lib, mlock(_, _))
                 .Times(0);
         } else {
-            (
-                EXPECT_CALL(*mock_c_lib, mlock(memory_base + (page_size * page_num), page_size))
-                    .WillOnce(Return(0)),
-                ...
-             );
+            for (auto [first_page, page_count] : to_page_runs(page_num...)) {
+                EXPECT_CALL(*mock_c_lib, mlock(memory_base + (page_size * first_page),
+                                               page_size * page_count))
+                    .WillOnce(Return(0));
+            }
         }
 
         memory->set_next_allocation_offset(alloc_offset);
@@ -119,11 +144,11 @@ class unserialized_no_swap_allocator_typed_test: public ::testing::Test {
             EXPECT_CALL(*mock_c_lib, munlock(_, _))
                 .Times(0);
         } else {
-            (
-                EXPECT_CALL(*mock_c_lib, munlock(memory_base + (page_size * page_num), page_size))
-                        .WillOnce(Return(0)),
-                ...
-             );
+            for (auto [first_page, page_count] : to_page_runs(page_num...)) {
+                EXPECT_CALL(*mock_c_lib, munlock(memory_base + (page_size * first_page),
+                                                 page_size * page_count))
+                    .WillOnce(Return(0));
+            }
         }
         allocator->deallocate(alloc_addr, alloc_size);
     }
@@ -229,6 +254,28 @@ TYPED_TEST(unserialized_no_swap_allocator_typed_test, two_disjoint_allocations_i
     TEST_DEALLOCATE(alloc_offset2, alloc_size, 1);
 }
 
+TYPED_TEST(unserialized_no_swap_allocator_typed_test, multi_page_array_single_lock_call)
+{
+    auto alloc_size = 8 * this->page_size / sizeof(TypeParam);
+    auto alloc_offset = 0;
+
+    TEST_ALLOCATE(alloc_offset, alloc_size, 0, 1, 2, 3, 4, 5, 6, 7);
+    TEST_DEALLOCATE(alloc_offset, alloc_size, 0, 1, 2, 3, 4, 5, 6, 7);
+}
+
+TYPED_TEST(unserialized_no_swap_allocator_typed_test, multi_page_array_around_pinned_page)
+{
+    auto small_size = 1;
+    auto small_offset = 2 * this->page_size;
+    auto large_size = 4 * this->page_size / sizeof(TypeParam);
+    auto large_offset = this->page_size;
+
+    TEST_ALLOCATE(small_offset, small_size, 2);
+    TEST_ALLOCATE(large_offset, large_size, 1, 3, 4);
+    TEST_DEALLOCATE(small_offset, small_size);
+    TEST_DEALLOCATE(large_offset, large_size, 1, 2, 3, 4);
+}
+
 TYPED_TEST(unserialized_no_swap_allocator_typed_test, mlock_failed)
 {
     auto alloc_size = 1;
@@ -288,7 +335,7 @@ TEST(serialized_no_swap_allocator_test, lock_held_during_allocate_and_deallocate
     auto mock_c_lib = mock::c_lib::get_instance();
     auto allocator = std::make_unique<ec::serialized_no_swap_allocator<int, mock::monitored_allocator<int>>>();
     auto mock_allocator{mock::allocation_monitor::get_instance()};
-    auto& state_obj = *ec::details::no_swap_allocator_state::get_state_object();
+    auto& state_obj = ec::details::no_swap_allocator_state::get_state_object();
     state_obj.clear_pages(memory->get_memory_array().data(), memory->get_memory_array().size());
 
     int lock_count{};
@@ -314,3 +361,331 @@ TEST(serialized_no_swap_allocator_test, lock_held_during_allocate_and_deallocate
 
     EXPECT_EQ(lock_count, 2);
 }
+
+TEST(serialized_no_swap_allocator_test, concurrent_allocations)
+{
+    constexpr std::size_t thread_count{8};
+    constexpr std::size_t iteration_count{1000};
+    std::vector<std::thread> threads;
+
+    for (std::size_t t = 0; t < thread_count; ++t) {
+        threads.emplace_back([]() {
+            ec::serialized_no_swap_allocator<std::uint64_t> allocator;
+            for (std::size_t i = 0; i < iteration_count; ++i) {
+                auto len = 1 + (i * 37) % 2048;
+                auto* ptr = allocator.allocate(len);
+                ptr[0] = i;
+                ptr[len - 1] = i;
+                allocator.deallocate(ptr, len);
+            }
+        });
+    }
+
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+TEST(concurrent_no_swap_allocator_test, locks_shared_pages_once)
+{
+    const std::size_t page_size{static_cast<std::size_t>(sysconf(_SC_PAGESIZE))};
+    auto memory{mock::memory::get_instance()};
+    auto mock_c_lib = mock::c_lib::get_instance();
+    auto mock_allocator{mock::allocation_monitor::get_instance()};
+    ec::concurrent_no_swap_allocator<std::uint8_t, mock::monitored_allocator<std::uint8_t>> concurrent;
+    ec::serialized_no_swap_allocator<std::uint8_t, mock::monitored_allocator<std::uint8_t>> serialized;
+    auto& state_obj = ec::details::no_swap_allocator_state::get_state_object();
+    memory->reset();
+    state_obj.clear_pages(memory->get_memory_array().data(), memory->get_memory_array().size());
+    auto memory_base = memory->get_memory_array().data();
+
+    EXPECT_CALL(*mock_allocator, void_allocate(_))
+        .Times(3);
+    EXPECT_CALL(*mock_c_lib, mlock(memory_base, page_size))
+        .WillOnce(Return(0));
+    memory->set_next_allocation_offset(0);
+    auto* a = concurrent.allocate(64);
+    memory->set_next_allocation_offset(64);
+    auto* b = concurrent.allocate(64);
+    memory->set_next_allocation_offset(128);
+    auto* c = serialized.allocate(64);
+
+    // The page stays locked while the serialized allocation still uses it.
+    EXPECT_CALL(*mock_allocator, void_deallocate(_, _))
+        .Times(3);
+    EXPECT_CALL(*mock_c_lib, munlock(_, _))
+        .Times(0);
+    concurrent.deallocate(a, 64);
+    concurrent.deallocate(b, 64);
+    ::testing::Mock::VerifyAndClearExpectations(mock_c_lib.get());
+
+    EXPECT_CALL(*mock_c_lib, munlock(memory_base, page_size))
+        .WillOnce(Return(0));
+    serialized.deallocate(c, 64);
+}
+
+TEST(concurrent_no_swap_allocator_test, failed_lock_leaves_nothing_tracked)
+{
+    auto memory{mock::memory::get_instance()};
+    auto mock_c_lib = mock::c_lib::get_instance();
+    auto mock_allocator{mock::allocation_monitor::get_instance()};
+    ec::concurrent_no_swap_allocator<std::uint8_t, mock::monitored_allocator<std::uint8_t>> allocator;
+    auto& state_obj = ec::details::no_swap_allocator_state::get_state_object();
+    memory->reset();
+    state_obj.clear_pages(memory->get_memory_array().data(), memory->get_memory_array().size());
+    auto before = ec::no_swap_allocator_snapshot();
+
+    EXPECT_CALL(*mock_allocator, void_allocate(_));
+    EXPECT_CALL(*mock_allocator, void_deallocate(_, _));
+    EXPECT_CALL(*mock_c_lib, mlock(_, _))
+        .WillOnce(Return(-1));
+    errno = ENOMEM;
+    memory->set_next_allocation_offset(0);
+    EXPECT_THROW((void)allocator.allocate(1), std::system_error);
+    errno = 0;
+
+    auto after = ec::no_swap_allocator_snapshot();
+    EXPECT_EQ(after.pinned_pages, before.pinned_pages);
+    EXPECT_EQ(after.live_allocations, before.live_allocations);
+}
+
+TEST(concurrent_no_swap_allocator_test, concurrent_allocations)
+{
+    constexpr std::size_t thread_count{8};
+    constexpr std::size_t iteration_count{1000};
+    std::vector<std::thread> threads;
+    auto before = ec::no_swap_allocator_snapshot();
+
+    for (std::size_t t = 0; t < thread_count; ++t) {
+        threads.emplace_back([]() {
+            ec::concurrent_no_swap_allocator<std::uint64_t> allocator;
+            ec::serialized_no_swap_allocator<std::uint64_t> serialized;
+            for (std::size_t i = 0; i < iteration_count; ++i) {
+                auto len = 1 + (i * 37) % 2048;
+                auto* ptr = allocator.allocate(len);
+                auto* other = serialized.allocate(len);
+                ptr[0] = i;
+                ptr[len - 1] = i;
+                allocator.deallocate(ptr, len);
+                serialized.deallocate(other, len);
+            }
+        });
+    }
+
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    auto after = ec::no_swap_allocator_snapshot();
+    EXPECT_EQ(after.pinned_pages, before.pinned_pages);
+    EXPECT_EQ(after.live_allocations, before.live_allocations);
+}
+
+TEST(no_swap_allocator_state_test, snapshot_tracks_pinned_memory)
+{
+    const std::size_t page_size{static_cast<std::size_t>(sysconf(_SC_PAGESIZE))};
+    auto memory{mock::memory::get_instance()};
+    auto mock_c_lib = mock::c_lib::get_instance();
+    auto mock_allocator{mock::allocation_monitor::get_instance()};
+    ec::serialized_no_swap_allocator<std::uint8_t, mock::monitored_allocator<std::uint8_t>> allocator;
+    auto& state_obj = ec::details::no_swap_allocator_state::get_state_object();
+    memory->reset();
+    state_obj.clear_pages(memory->get_memory_array().data(), memory->get_memory_array().size());
+
+    auto before = ec::no_swap_allocator_snapshot();
+
+    // Taking a snapshot while a shard mutex is held must not block.
+    ec::no_swap_allocator_stats during{};
+    EXPECT_CALL(*mock_allocator, void_allocate(_));
+    EXPECT_CALL(*mock_c_lib, mlock(_, page_size * 3))
+        .WillOnce([&during](const void*, std::size_t) {
+            during = ec::no_swap_allocator_snapshot();
+            return 0;
+        });
+    memory->set_next_allocation_offset(0);
+    auto* addr = allocator.allocate(page_size * 3);
+
+    auto after_allocate = ec::no_swap_allocator_snapshot();
+    EXPECT_EQ(during.pin_calls, before.pin_calls + 1);
+    EXPECT_EQ(after_allocate.pinned_pages, before.pinned_pages + 3);
+    EXPECT_EQ(after_allocate.pinned_bytes, after_allocate.pinned_pages * page_size);
+    EXPECT_EQ(after_allocate.live_allocations, before.live_allocations + 1);
+    EXPECT_EQ(after_allocate.pin_calls, before.pin_calls + 1);
+    EXPECT_GE(after_allocate.syscall_time, before.syscall_time);
+    EXPECT_GT(after_allocate.pinned_bytes_limit, 0U);
+
+    EXPECT_CALL(*mock_allocator, void_deallocate(_, _));
+    EXPECT_CALL(*mock_c_lib, munlock(_, page_size * 3))
+        .WillOnce(Return(0));
+    allocator.deallocate(addr, page_size * 3);
+
+    auto after_deallocate = ec::no_swap_allocator_snapshot();
+    EXPECT_EQ(after_deallocate.pinned_pages, before.pinned_pages);
+    EXPECT_EQ(after_deallocate.live_allocations, before.live_allocations);
+    EXPECT_EQ(after_deallocate.unpin_calls, before.unpin_calls + 1);
+    EXPECT_EQ(after_deallocate.pin_failures, before.pin_failures);
+
+    EXPECT_CALL(*mock_allocator, void_allocate(_));
+    EXPECT_CALL(*mock_c_lib, mlock(_, _))
+        .WillOnce(Return(-1));
+    errno = ENOMEM;
+    EXPECT_THROW((void)allocator.allocate(1), std::system_error);
+    errno = 0;
+
+    auto after_failure = ec::no_swap_allocator_snapshot();
+    EXPECT_EQ(after_failure.pin_failures, before.pin_failures + 1);
+    EXPECT_EQ(after_failure.pinned_pages, before.pinned_pages);
+    EXPECT_EQ(after_failure.live_allocations, before.live_allocations);
+}
+
+TEST(no_swap_allocator_state_test, snapshot_counts_wiped_bytes)
+{
+    std::array<std::byte, 100> buffer{};
+    auto before = ec::no_swap_allocator_snapshot();
+    ec::secure_zero(buffer.data(), buffer.size());
+    EXPECT_EQ(ec::no_swap_allocator_snapshot().bytes_wiped, before.bytes_wiped + buffer.size());
+
+    // Bytes wiped by threads that have since exited are still counted.
+    constexpr std::size_t thread_count{8};
+    std::vector<std::thread> threads;
+    for (std::size_t t = 0; t < thread_count; ++t) {
+        threads.emplace_back([]() {
+            std::array<std::byte, 100> local{};
+            ec::secure_zero(local.data(), local.size());
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(ec::no_swap_allocator_snapshot().bytes_wiped, before.bytes_wiped + buffer.size() * (thread_count + 1));
+}
+
+TEST(no_swap_allocator_state_test, retention_keeps_released_pages_locked)
+{
+    const std::size_t page_size{static_cast<std::size_t>(sysconf(_SC_PAGESIZE))};
+    auto memory{mock::memory::get_instance()};
+    auto mock_c_lib = mock::c_lib::get_instance();
+    auto mock_allocator{mock::allocation_monitor::get_instance()};
+    ec::serialized_no_swap_allocator<std::uint8_t, mock::monitored_allocator<std::uint8_t>> allocator;
+    auto& state_obj = ec::details::no_swap_allocator_state::get_state_object();
+    memory->reset();
+    state_obj.clear_pages(memory->get_memory_array().data(), memory->get_memory_array().size());
+    auto memory_base = memory->get_memory_array().data();
+    auto before = ec::no_swap_allocator_snapshot();
+
+    ec::set_no_swap_retention_policy({.max_bytes = 4 * page_size, .max_idle = std::chrono::hours{1}});
+
+    // Only the first allocation locks the page.  Releasing it parks the block and keeps the page
+    // locked, and the next allocations get the same block back without calling anything.
+    EXPECT_CALL(*mock_allocator, void_allocate(_))
+        .Times(1);
+    EXPECT_CALL(*mock_allocator, void_deallocate(_, _))
+        .Times(0);
+    EXPECT_CALL(*mock_c_lib, mlock(memory_base, page_size))
+        .WillOnce(Return(0));
+    EXPECT_CALL(*mock_c_lib, munlock(_, _))
+        .Times(0);
+    memory->set_next_allocation_offset(0);
+    auto* first = allocator.allocate(64);
+    allocator.deallocate(first, 64);
+    for (int i = 0; i < 2; ++i) {
+        auto* addr = allocator.allocate(64);
+        EXPECT_EQ(addr, first);
+        allocator.deallocate(addr, 64);
+    }
+
+    auto retained = ec::no_swap_allocator_snapshot();
+    EXPECT_EQ(retained.retained_pages, before.retained_pages + 1);
+    EXPECT_EQ(retained.pinned_pages, before.pinned_pages + 1);
+    EXPECT_EQ(retained.live_allocations, before.live_allocations);
+    ::testing::Mock::VerifyAndClearExpectations(mock_c_lib.get());
+
+    // The block goes back upstream only once its page is unlocked.
+    ::testing::InSequence seq;
+    EXPECT_CALL(*mock_c_lib, munlock(memory_base, page_size))
+        .WillOnce(Return(0));
+    EXPECT_CALL(*mock_allocator, void_deallocate(first, 64))
+        .Times(1);
+    ec::release_retained_pages();
+
+    auto released = ec::no_swap_allocator_snapshot();
+    EXPECT_EQ(released.retained_pages, before.retained_pages);
+    EXPECT_EQ(released.pinned_pages, before.pinned_pages);
+
+    ec::set_no_swap_retention_policy({});
+}
+
+TEST(no_swap_allocator_state_test, retention_releases_pages_over_budget_or_idle)
+{
+    const std::size_t page_size{static_cast<std::size_t>(sysconf(_SC_PAGESIZE))};
+    auto memory{mock::memory::get_instance()};
+    auto mock_c_lib = mock::c_lib::get_instance();
+    auto mock_allocator{mock::allocation_monitor::get_instance()};
+    ec::serialized_no_swap_allocator<std::uint8_t, mock::monitored_allocator<std::uint8_t>> allocator;
+    auto& state_obj = ec::details::no_swap_allocator_state::get_state_object();
+    memory->reset();
+    state_obj.clear_pages(memory->get_memory_array().data(), memory->get_memory_array().size());
+    auto memory_base = memory->get_memory_array().data();
+    auto before = ec::no_swap_allocator_snapshot();
+
+    EXPECT_CALL(*mock_allocator, void_allocate(_))
+        .Times(3);
+    EXPECT_CALL(*mock_allocator, void_deallocate(_, _))
+        .Times(3);
+    EXPECT_CALL(*mock_c_lib, mlock(_, _))
+        .WillRepeatedly(Return(0));
+
+    // Two pages do not fit in a budget of one, so they are unlocked with a single call.
+    ec::set_no_swap_retention_policy({.max_bytes = page_size, .max_idle = std::chrono::hours{1}});
+    EXPECT_CALL(*mock_c_lib, munlock(memory_base, 2 * page_size))
+        .WillOnce(Return(0));
+    memory->set_next_allocation_offset(0);
+    allocator.deallocate(allocator.allocate(2 * page_size), 2 * page_size);
+    EXPECT_EQ(ec::no_swap_allocator_snapshot().retained_pages, before.retained_pages);
+    ::testing::Mock::VerifyAndClearExpectations(mock_c_lib.get());
+
+    // Pages are unlocked once retained for longer than the idle time.
+    ec::set_no_swap_retention_policy({.max_bytes = 4 * page_size, .max_idle = std::chrono::nanoseconds{0}});
+    EXPECT_CALL(*mock_c_lib, mlock(_, _))
+        .WillRepeatedly(Return(0));
+    EXPECT_CALL(*mock_c_lib, munlock(memory_base, page_size))
+        .WillOnce(Return(0));
+    memory->set_next_allocation_offset(0);
+    allocator.deallocate(allocator.allocate(64), 64);
+    EXPECT_EQ(ec::no_swap_allocator_snapshot().retained_pages, before.retained_pages);
+    ::testing::Mock::VerifyAndClearExpectations(mock_c_lib.get());
+
+    // Allocations larger than the limit are never retained.
+    ec::set_no_swap_retention_policy({.max_bytes = 4 * page_size, .max_idle = std::chrono::hours{1},
+                                      .max_allocation = page_size});
+    EXPECT_CALL(*mock_c_lib, mlock(_, _))
+        .WillRepeatedly(Return(0));
+    EXPECT_CALL(*mock_c_lib, munlock(memory_base, 2 * page_size))
+        .WillOnce(Return(0));
+    memory->set_next_allocation_offset(0);
+    allocator.deallocate(allocator.allocate(2 * page_size), 2 * page_size);
+    EXPECT_EQ(ec::no_swap_allocator_snapshot().pinned_pages, before.pinned_pages);
+
+    ec::set_no_swap_retention_policy({});
+}
+
+TEST(no_swap_allocator_state_test, singleton_shared_across_threads)
+{
+    constexpr std::size_t thread_count{8};
+    std::array<ec::details::no_swap_allocator_state*, thread_count> states{};
+    std::vector<std::thread> threads;
+
+    for (std::size_t t = 0; t < thread_count; ++t) {
+        threads.emplace_back([&states, t]() {
+            states[t] = &ec::details::no_swap_allocator_state::get_state_object();
+        });
+    }
+
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    for (auto* state : states) {
+        EXPECT_EQ(state, &ec::details::no_swap_allocator_state::get_state_object());
+    }
+}
@@ -0,0 +1,165 @@
+/**
+ * @file
+ * Unit tests for the node pool allocator and the batch allocation extension.
+ *
+ * @copyright 2023 Steve Kinneberg <steve.kinneberg@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <enhanced_containers/node_pool_allocator.h>
+#include <enhanced_containers/secure_forward_list.h>
+#include <enhanced_containers/secure_list.h>
+#include <enhanced_containers/secure_map.h>
+#include <enhanced_containers/secure_set.h>
+
+#include <gtest/gtest.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <utility>
+
+// Compile-time compatibility with STL containers.
+ec::node_pooled_secure::map<int, int> test_map;
+ec::node_pooled_secure::set<int> test_set;
+ec::node_pooled_secure::list<int> test_list;
+ec::node_pooled_secure::forward_list<int> test_forward_list;
+
+namespace {
+/// @brief Number of calls made to the counting allocator.
+std::size_t upstream_allocations{};
+
+/// @brief Allocator that counts how often it is called.
+template <typename T>
+struct counting_allocator: std::allocator<T> {
+    template <typename U>
+    struct rebind {
+        using other = counting_allocator<U>;
+    };
+
+    counting_allocator() = default;
+
+    template <typename U>
+    counting_allocator(const counting_allocator<U>&) {}
+
+    T* allocate(std::size_t n)
+    {
+        ++upstream_allocations;
+        return std::allocator<T>::allocate(n);
+    }
+};
+
+using pair_type = std::pair<const int, int>;
+using counted_map = std::map<int, int, std::less<int>,
+                             ec::node_pool_allocator<pair_type, counting_allocator<pair_type>>>;
+}
+
+TEST(node_pool_allocator_test, freed_blocks_are_reused)
+{
+    ec::node_pool_allocator<int> alloc;
+    auto* first = alloc.allocate(1);
+    alloc.deallocate(first, 1);
+    auto* second = alloc.allocate(1);
+    EXPECT_EQ(first, second);
+    alloc.deallocate(second, 1);
+    EXPECT_EQ(alloc.chunk_count(), 1);
+}
+
+TEST(node_pool_allocator_test, arrays_bypass_the_pool)
+{
+    ec::node_pool_allocator<int> alloc;
+    auto* ptr = alloc.allocate(100);
+    EXPECT_EQ(alloc.chunk_count(), 0);
+    alloc.deallocate(ptr, 100);
+}
+
+TEST(node_pool_allocator_test, large_map_uses_few_chunks)
+{
+    constexpr int entry_count{1000000};
+    upstream_allocations = 0;
+    {
+        counted_map m;
+        for (int i = 0; i < entry_count; ++i) {
+            m.emplace_hint(m.end(), i, i);
+        }
+        EXPECT_EQ(m.size(), entry_count);
+    }
+    EXPECT_LT(upstream_allocations, 100);
+}
+
+TEST(node_pool_allocator_test, container_copies_get_their_own_pool)
+{
+    counted_map a{{1, 1}, {2, 2}};
+    counted_map b{a};
+    EXPECT_NE(a.get_allocator(), b.get_allocator());
+
+    counted_map c{std::move(a)};
+    a.emplace(3, 3);    // The moved-from container must still be able to allocate.
+    EXPECT_EQ(a.size(), 1);
+    EXPECT_EQ(c.size(), 2);
+
+    // Also through the secure allocators layered on top of the pool.
+    ec::node_pooled_secure::map<int, int> secure_map{{1, 1}, {2, 2}};
+    auto secure_map_copy{secure_map};
+    EXPECT_NE(secure_map.get_allocator(), secure_map_copy.get_allocator());
+    EXPECT_EQ(secure_map_copy, secure_map);
+
+    ec::node_pooled_secure::list<int> secure_list{1, 2, 3};
+    auto secure_list_copy{secure_list};
+    EXPECT_NE(secure_list.get_allocator(), secure_list_copy.get_allocator());
+
+    ec::node_pooled_secure::set<int> secure_set{1, 2, 3};
+    auto secure_set_copy{secure_set};
+    EXPECT_NE(secure_set.get_allocator(), secure_set_copy.get_allocator());
+
+    ec::serialized_no_swap_allocator<int, ec::node_pool_allocator<int>> no_swap;
+    using no_swap_traits = std::allocator_traits<decltype(no_swap)>;
+    EXPECT_NE(no_swap_traits::select_on_container_copy_construction(no_swap), no_swap);
+}
+
+TEST(node_pool_allocator_test, batches)
+{
+    ec::node_pooled_secure_allocator<std::uint64_t> alloc;
+    std::array<std::uint64_t*, 100> ptrs{};
+    alloc.allocate_batch(ptrs.size(), ptrs.data());
+    for (auto* ptr : ptrs) {
+        *ptr = 0xdeadbeef;
+    }
+    alloc.deallocate_batch(ptrs.data(), ptrs.size());
+    for (auto* ptr : ptrs) {
+        EXPECT_NE(*ptr, 0xdeadbeef);    // Zeroed out, then reused for the free list.
+    }
+}
+
+TEST(node_pool_allocator_test, serialized_secure_batches)
+{
+    ec::serialized_secure_allocator<std::uint64_t> alloc;
+    std::array<std::uint64_t*, 100> ptrs{};
+    alloc.allocate_batch(ptrs.size(), ptrs.data());
+    for (auto* ptr : ptrs) {
+        *ptr = 0xdeadbeef;
+    }
+    alloc.deallocate_batch(ptrs.data(), ptrs.size());
+}
+
+TEST(node_pool_allocator_test, secure_map)
+{
+    ec::node_pooled_secure::map<int, int> m;
+    for (int i = 0; i < 100000; ++i) {
+        m.emplace_hint(m.end(), i, i);
+    }
+    EXPECT_EQ(m.rbegin()->second, 99999);
+}
@@ -0,0 +1,154 @@
+/**
+ * @file
+ * Unit tests for the NUMA node local secure memory resources.
+ *
+ * @copyright 2023 Steve Kinneberg <steve.kinneberg@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <enhanced_containers/numa_resource.h>
+#include <enhanced_containers/no_swap_allocator.h>
+#include <enhanced_containers/secure_map.h>
+#include <enhanced_containers/secure_string.h>
+#include <enhanced_containers/secure_vector.h>
+
+#include "mock_c_lib.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// Compile-time compatibility with STL containers.
+ec::pmr::numa_secure::string test_string;
+ec::pmr::numa_secure::map<int, int> test_map;
+
+namespace {
+
+/**
+ * @brief
+ * Get the NUMA node of the page at an address.
+ *
+ * @return  The node number, or -1 if the kernel has no NUMA support.
+ */
+int node_of(const void* addr)
+{
+    constexpr unsigned long mpol_f_node = 1;    // MPOL_F_NODE from <linux/mempolicy.h>.
+    constexpr unsigned long mpol_f_addr = 2;    // MPOL_F_ADDR from <linux/mempolicy.h>.
+    int node{-1};
+    if (syscall(SYS_get_mempolicy, &node, nullptr, 0, addr, mpol_f_node | mpol_f_addr) != 0) {
+        return -1;
+    }
+    return node;
+}
+
+} // namespace
+
+TEST(numa_node_resource_test, allocates_locked_pages_on_the_node)
+{
+    const std::size_t page_size{static_cast<std::size_t>(sysconf(_SC_PAGESIZE))};
+    ec::pmr::numa_node_resource resource{ec::pmr::current_numa_node()};
+    auto before = ec::no_swap_allocator_snapshot();
+
+    auto* ptr = static_cast<char*>(resource.allocate(2 * page_size + 1));
+    EXPECT_EQ(reinterpret_cast<std::uintptr_t>(ptr) % page_size, 0);
+    EXPECT_EQ(ec::no_swap_allocator_snapshot().pinned_pages, before.pinned_pages + 3);
+    auto node = node_of(ptr + 2 * page_size);
+    if (node >= 0) {
+        EXPECT_EQ(static_cast<unsigned>(node), resource.node());
+    }
+
+    resource.deallocate(ptr, 2 * page_size + 1);
+    EXPECT_EQ(ec::no_swap_allocator_snapshot().pinned_pages, before.pinned_pages);
+}
+
+TEST(numa_node_resource_test, missing_node_falls_back_to_other_nodes)
+{
+    auto last = ec::pmr::max_numa_nodes - 1;
+    if (std::filesystem::exists("/sys/devices/system/node/node" + std::to_string(last))) {
+        GTEST_SKIP() << "Every NUMA node is present.";
+    }
+    ec::pmr::numa_node_resource resource{last};
+    auto* ptr = static_cast<char*>(resource.allocate(1));
+    ptr[0] = 1;
+    resource.deallocate(ptr, 1);
+}
+
+TEST(numa_node_resource_test, rejects_nodes_beyond_the_mask)
+{
+    ec::pmr::numa_node_resource resource{ec::pmr::max_numa_nodes};
+    EXPECT_THROW(static_cast<void>(resource.allocate(1)), std::out_of_range);
+}
+
+TEST(numa_node_resource_test, equal_for_the_same_node)
+{
+    ec::pmr::numa_node_resource a{0};
+    ec::pmr::numa_node_resource b{0};
+    ec::pmr::numa_node_resource c{1};
+    EXPECT_TRUE(a.is_equal(b));
+    EXPECT_FALSE(a.is_equal(c));
+}
+
+TEST(numa_local_resource_test, one_arena_per_node)
+{
+    auto* current = ec::pmr::get_numa_local_resource();
+    EXPECT_EQ(current, ec::pmr::get_numa_local_resource(ec::pmr::current_numa_node()));
+    EXPECT_EQ(ec::pmr::get_numa_local_resource(0), ec::pmr::get_numa_local_resource(0));
+    EXPECT_NE(ec::pmr::get_numa_local_resource(0), ec::pmr::get_numa_local_resource(1));
+    EXPECT_THROW(static_cast<void>(ec::pmr::get_numa_local_resource(ec::pmr::max_numa_nodes)),
+                 std::out_of_range);
+}
+
+TEST(numa_local_resource_test, zeros_memory_returned_to_the_arena)
+{
+    auto* arena = ec::pmr::get_numa_local_resource();
+    auto* ptr = arena->allocate(64);
+    auto before = ec::no_swap_allocator_snapshot();
+    arena->deallocate(ptr, 64);
+    EXPECT_GE(ec::no_swap_allocator_snapshot().bytes_wiped, before.bytes_wiped + 64);
+}
+
+TEST(numa_secure_allocator_test, containers_keep_the_node_of_the_creating_thread)
+{
+    std::optional<ec::pmr::numa_secure::map<int, int>> m;
+    std::pmr::memory_resource* created_on{};
+    std::thread worker{[&]() {
+        created_on = ec::pmr::get_numa_local_resource();
+        ec::pmr::numa_secure::map<int, int> local;
+        local.emplace(1, 1);
+        m.emplace(std::move(local));
+    }};
+    worker.join();
+
+    // Moved out of the worker, the map still allocates from the worker's node.
+    EXPECT_EQ(m->get_allocator().resource(), created_on);
+    m->emplace(2, 2);
+    EXPECT_EQ(m->size(), 2);
+
+    // Copies are made on the node of the copying thread.
+    ec::pmr::numa_secure::vector<int> v;
+    EXPECT_EQ(v.get_allocator().resource(), ec::pmr::get_numa_local_resource());
+    std::pmr::monotonic_buffer_resource other;
+    ec::pmr::numa_secure::vector<int> elsewhere{&other};
+    auto copy = elsewhere;
+    EXPECT_EQ(copy.get_allocator().resource(), ec::pmr::get_numa_local_resource());
+}
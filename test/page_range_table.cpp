@@ -0,0 +1,173 @@
+/**
+ * @file
+ * Unit tests for the reference counted page range table.
+ *
+ * @copyright 2023 Steve Kinneberg <steve.kinneberg@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <enhanced_containers/details/page_range_table.h>
+
+#include <gtest/gtest.h>
+
+#include <utility>
+#include <vector>
+
+using address = ec::details::page_range_table::address;
+using run_list = std::vector<std::pair<address, address>>;
+
+namespace {
+constexpr address page{0x1000};
+
+constexpr address pg(std::size_t n) { return 0x100000 + n * page; }
+}
+
+class page_range_table_test: public ::testing::Test {
+  protected:
+    ec::details::page_range_table table;
+
+    run_list unreferenced(address start, address end) const
+    {
+        run_list runs;
+        table.for_each_unreferenced(start, end, [&runs](address s, address e) { runs.emplace_back(s, e); });
+        return runs;
+    }
+
+    run_list last_reference(address start, address end) const
+    {
+        run_list runs;
+        table.for_each_last_reference(start, end, [&runs](address s, address e) { runs.emplace_back(s, e); });
+        return runs;
+    }
+};
+
+TEST_F(page_range_table_test, single_range)
+{
+    EXPECT_EQ(unreferenced(pg(0), pg(4)), (run_list{{pg(0), pg(4)}}));
+
+    table.add_reference(pg(0), pg(4));
+    EXPECT_EQ(table.size(), 1);
+    EXPECT_TRUE(table.is_referenced(pg(0), pg(4)));
+    EXPECT_TRUE(unreferenced(pg(0), pg(4)).empty());
+    EXPECT_EQ(last_reference(pg(0), pg(4)), (run_list{{pg(0), pg(4)}}));
+
+    table.remove_reference(pg(0), pg(4));
+    EXPECT_TRUE(table.empty());
+}
+
+TEST_F(page_range_table_test, overlapping_ranges_split_and_merge)
+{
+    table.add_reference(pg(0), pg(4));
+    table.add_reference(pg(2), pg(6));
+
+    EXPECT_EQ(table.size(), 3);
+    EXPECT_EQ(table.ref_count(pg(1)), 1);
+    EXPECT_EQ(table.ref_count(pg(2)), 2);
+    EXPECT_EQ(table.ref_count(pg(3)), 2);
+    EXPECT_EQ(table.ref_count(pg(5)), 1);
+    EXPECT_EQ(table.ref_count(pg(6)), 0);
+
+    EXPECT_EQ(last_reference(pg(0), pg(4)), (run_list{{pg(0), pg(2)}}));
+
+    table.remove_reference(pg(0), pg(4));
+    EXPECT_EQ(table.size(), 1);
+    EXPECT_FALSE(table.is_referenced(pg(0), pg(2)));
+    EXPECT_TRUE(table.is_referenced(pg(2), pg(6)));
+
+    table.remove_reference(pg(2), pg(6));
+    EXPECT_TRUE(table.empty());
+}
+
+TEST_F(page_range_table_test, gaps_around_referenced_pages)
+{
+    table.add_reference(pg(2), pg(3));
+    table.add_reference(pg(5), pg(6));
+
+    EXPECT_EQ(unreferenced(pg(0), pg(8)),
+              (run_list{{pg(0), pg(2)}, {pg(3), pg(5)}, {pg(6), pg(8)}}));
+
+    table.add_reference(pg(0), pg(8));
+    EXPECT_EQ(last_reference(pg(0), pg(8)),
+              (run_list{{pg(0), pg(2)}, {pg(3), pg(5)}, {pg(6), pg(8)}}));
+}
+
+TEST_F(page_range_table_test, adjacent_ranges_coalesce)
+{
+    table.add_reference(pg(0), pg(2));
+    table.add_reference(pg(2), pg(4));
+
+    EXPECT_EQ(table.size(), 1);
+    EXPECT_EQ(last_reference(pg(0), pg(4)), (run_list{{pg(0), pg(4)}}));
+}
+
+TEST_F(page_range_table_test, untracked_range_is_not_referenced)
+{
+    table.add_reference(pg(0), pg(1));
+    table.add_reference(pg(2), pg(3));
+
+    EXPECT_TRUE(table.is_referenced(pg(0), pg(1)));
+    EXPECT_FALSE(table.is_referenced(pg(0), pg(3)));
+    EXPECT_FALSE(table.is_referenced(pg(4), pg(5)));
+}
+
+TEST_F(page_range_table_test, erase_ignores_reference_counts)
+{
+    table.add_reference(pg(0), pg(8));
+    table.add_reference(pg(0), pg(8));
+    table.erase(pg(2), pg(4));
+
+    EXPECT_EQ(table.size(), 2);
+    EXPECT_EQ(table.ref_count(pg(1)), 2);
+    EXPECT_EQ(table.ref_count(pg(2)), 0);
+    EXPECT_EQ(table.ref_count(pg(4)), 2);
+}
+
+TEST_F(page_range_table_test, split_boundaries_keeps_reference_counts)
+{
+    table.add_reference(pg(0), pg(8));
+    table.split_boundaries(pg(2), pg(4));
+
+    EXPECT_EQ(table.size(), 3);
+    EXPECT_EQ(table.ref_count(pg(1)), 1);
+    EXPECT_EQ(table.ref_count(pg(2)), 1);
+    EXPECT_EQ(table.ref_count(pg(4)), 1);
+
+    // The update with the same bounds merges the entries again.
+    table.remove_reference(pg(2), pg(4));
+    EXPECT_EQ(table.size(), 2);
+    table.add_reference(pg(2), pg(4));
+    EXPECT_EQ(table.size(), 1);
+}
+
+TEST_F(page_range_table_test, entries_scale_with_allocations_not_pages)
+{
+    // One huge allocation is a single entry no matter how many pages it spans.
+    table.add_reference(pg(0), pg(1 << 18));
+    EXPECT_EQ(table.size(), 1);
+    table.remove_reference(pg(0), pg(1 << 18));
+
+    // Many small allocations packed into shared pages never need more than one entry per page
+    // boundary.
+    constexpr std::size_t allocation_count{100000};
+    for (std::size_t i = 0; i < allocation_count; ++i) {
+        table.add_reference(pg(i / 4), pg(i / 4 + 1));
+    }
+    EXPECT_EQ(table.size(), 1);
+    EXPECT_EQ(table.ref_count(pg(0)), 4);
+
+    for (std::size_t i = 0; i < allocation_count; ++i) {
+        table.remove_reference(pg(i / 4), pg(i / 4 + 1));
+    }
+    EXPECT_TRUE(table.empty());
+}
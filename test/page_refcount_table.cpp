@@ -0,0 +1,184 @@
+/**
+ * @file
+ * Unit tests for the lock-free page reference count table.
+ *
+ * @copyright 2023 Steve Kinneberg <steve.kinneberg@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <enhanced_containers/details/page_refcount_table.h>
+
+#include <gtest/gtest.h>
+
+#include <array>
+#include <atomic>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using address = ec::details::page_refcount_table::address;
+using run_list = std::vector<std::pair<address, address>>;
+
+namespace {
+constexpr std::size_t page_shift{12};
+constexpr address page{address{1} << page_shift};
+
+constexpr address pg(std::size_t n) { return 0x100000 + n * page; }
+}
+
+class page_refcount_table_test: public ::testing::Test {
+  protected:
+    ec::details::page_refcount_table table{page_shift};
+    run_list pinned;
+    run_list unpinned;
+
+    void add(address start, address end)
+    {
+        table.add_reference(start, end,
+                            [this](address s, address e) { pinned.emplace_back(s, e); },
+                            [this](address s, address e) { unpinned.emplace_back(s, e); });
+    }
+
+    void remove(address start, address end)
+    {
+        table.remove_reference(start, end, [this](address s, address e) { unpinned.emplace_back(s, e); });
+    }
+};
+
+TEST_F(page_refcount_table_test, only_first_and_last_references_pin_and_unpin)
+{
+    add(pg(0), pg(3));
+    EXPECT_EQ(pinned, (run_list{{pg(0), pg(3)}}));
+
+    add(pg(1), pg(2));
+    EXPECT_EQ(pinned.size(), 1);
+    EXPECT_EQ(table.reference_count(pg(0)), 1);
+    EXPECT_EQ(table.reference_count(pg(1)), 2);
+
+    remove(pg(1), pg(2));
+    EXPECT_TRUE(unpinned.empty());
+
+    remove(pg(0), pg(3));
+    EXPECT_EQ(unpinned, (run_list{{pg(0), pg(3)}}));
+    EXPECT_FALSE(table.is_referenced(pg(0), pg(1)));
+}
+
+TEST_F(page_refcount_table_test, runs_split_around_referenced_pages)
+{
+    add(pg(2), pg(3));
+    pinned.clear();
+
+    add(pg(0), pg(5));
+    EXPECT_EQ(pinned, (run_list{{pg(0), pg(2)}, {pg(3), pg(5)}}));
+
+    remove(pg(0), pg(5));
+    EXPECT_EQ(unpinned, (run_list{{pg(0), pg(2)}, {pg(3), pg(5)}}));
+    EXPECT_EQ(table.reference_count(pg(2)), 1);
+}
+
+TEST_F(page_refcount_table_test, runs_cross_leaf_boundaries)
+{
+    constexpr auto leaf_pages = std::size_t{1} << ec::details::page_refcount_table::leaf_shift;
+    auto start = pg(leaf_pages - 2);
+    auto end = pg(leaf_pages + 2);
+
+    add(start, end);
+    EXPECT_EQ(pinned, (run_list{{start, end}}));
+    EXPECT_TRUE(table.is_referenced(start, end));
+
+    remove(start, end);
+    EXPECT_EQ(unpinned, (run_list{{start, end}}));
+}
+
+TEST_F(page_refcount_table_test, failed_pin_restores_previous_state)
+{
+    add(pg(2), pg(3));
+    pinned.clear();
+
+    auto pin = [this](address s, address e) {
+        if (s == pg(3)) {
+            throw std::runtime_error{"pin failed"};
+        }
+        pinned.emplace_back(s, e);
+    };
+    auto unpin = [this](address s, address e) { unpinned.emplace_back(s, e); };
+    EXPECT_THROW(table.add_reference(pg(0), pg(5), pin, unpin), std::runtime_error);
+
+    EXPECT_EQ(pinned, (run_list{{pg(0), pg(2)}}));
+    EXPECT_EQ(unpinned, (run_list{{pg(0), pg(2)}}));
+    for (std::size_t n : {0, 1, 3, 4}) {
+        EXPECT_EQ(table.reference_count(pg(n)), 0) << n;
+    }
+    EXPECT_EQ(table.reference_count(pg(2)), 1);
+}
+
+TEST_F(page_refcount_table_test, removing_unreferenced_pages_throws)
+{
+    EXPECT_THROW(remove(pg(0), pg(1)), std::runtime_error);
+
+    add(pg(0), pg(1));
+    EXPECT_THROW(remove(pg(0), pg(2)), std::runtime_error);
+    EXPECT_EQ(table.reference_count(pg(0)), 1);
+}
+
+TEST(page_refcount_table_concurrency_test, pages_pinned_exactly_while_referenced)
+{
+    constexpr std::size_t thread_count{8};
+    constexpr std::size_t iteration_count{20000};
+    constexpr std::size_t page_count{16};
+
+    ec::details::page_refcount_table table{page_shift};
+    std::array<std::atomic<int>, page_count> pins{};
+    std::atomic<bool> double_pin{false};
+    std::atomic<bool> double_unpin{false};
+
+    auto pin = [&](address s, address e) {
+        for (auto p = s; p < e; p += page) {
+            if (pins[(p - pg(0)) >> page_shift].fetch_add(1) != 0) {
+                double_pin = true;
+            }
+        }
+    };
+    auto unpin = [&](address s, address e) {
+        for (auto p = s; p < e; p += page) {
+            if (pins[(p - pg(0)) >> page_shift].fetch_sub(1) != 1) {
+                double_unpin = true;
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (std::size_t t = 0; t < thread_count; ++t) {
+        threads.emplace_back([&, t]() {
+            for (std::size_t i = 0; i < iteration_count; ++i) {
+                auto first = (t + i * 7) % page_count;
+                auto last = first + 1 + (i % 3);
+                last = last > page_count ? page_count : last;
+                table.add_reference(pg(first), pg(last), pin, unpin);
+                table.remove_reference(pg(first), pg(last), unpin);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    EXPECT_FALSE(double_pin);
+    EXPECT_FALSE(double_unpin);
+    for (std::size_t n = 0; n < page_count; ++n) {
+        EXPECT_EQ(pins[n], 0) << n;
+        EXPECT_EQ(table.reference_count(pg(n)), 0) << n;
+    }
+}
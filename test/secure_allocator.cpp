@@ -19,6 +19,7 @@
  */
 
 #include <enhanced_containers/secure_allocator.h>
+#include <enhanced_containers/secure_vector.h>
 
 #include "mock_allocator.h"
 #include "mock_c_lib.h"
@@ -26,16 +27,19 @@
 
 #include <fmt/format.h>
 
+#include <array>
 #include <deque>
 #include <forward_list>
 #include <iterator>
 #include <list>
 #include <map>
+#include <memory_resource>
 #include <queue>
 #include <set>
 #include <stack>
 #include <unordered_map>
 #include <unordered_set>
+#include <vector>
 
 // Compile-time compatibility with STL containers.  Also, may test construction/destruction ordering
 // of globals with the allocation tracker data structure.
@@ -71,6 +75,25 @@ class unserialized_secure_allocator_typed_test: public ::testing::Test {
     std::shared_ptr<mock::c_lib> mock_c_lib{mock::c_lib::get_instance()};
     std::unique_ptr<ec::unserialized_secure_allocator<TypeParam, mock::monitored_allocator<TypeParam>>> allocator;
 
+    /**
+     * Group page numbers into runs of contiguous pages since the allocator locks/unlocks each run
+     * with a single call.
+     */
+    template <typename... P>
+    static std::vector<std::pair<std::size_t, std::size_t>> to_page_runs(P... page_num)
+    {
+        std::array<std::size_t, sizeof...(P)> pages{static_cast<std::size_t>(page_num)...};
+        std::vector<std::pair<std::size_t, std::size_t>> runs;
+        for (auto page : pages) {
+            if (!runs.empty() && runs.back().first + runs.back().second == page) {
+                ++runs.back().second;
+            } else {
+                runs.emplace_back(page, 1);
+            }
+        }
+        return runs;
+    }
+
     virtual void SetUp()
     {
         auto& mem = memory->get_memory_array();
@@ -79,7 +102,7 @@ class unserialized_secure_allocator_typed_test: public ::testing::Test {
             .WillOnce(Return(memory->get_memory_array().data()));
         memory->fill();
         allocator = std::make_unique<ec::unserialized_secure_allocator<TypeParam, mock::monitored_allocator<TypeParam>>>();
-        ec::details::no_swap_allocator_state::get_state_object()->clear_pages(mem.data(), mem.size());
+        ec::details::no_swap_allocator_state::get_state_object().clear_pages(mem.data(), mem.size());
     }
 
     virtual void TearDown()
@@ -138,11 +161,11 @@ class unserialized_secure_allocator_typed_test: public ::testing::Test {
             EXPECT_CALL(*mock_c_lib, mlock(_, _))
                 .Times(0);
         } else {
-            (
-                EXPECT_CALL(*mock_c_lib, mlock(memory_base + (page_size * page_num), page_size))
-                    .WillOnce(Return(0)),
-                ...
-             );
+            for (auto [first_page, page_count] : to_page_runs(page_num...)) {
+                EXPECT_CALL(*mock_c_lib, mlock(memory_base + (page_size * first_page),
+                                               page_size * page_count))
+                    .WillOnce(Return(0));
+            }
         }
 
         memory->set_next_allocation_offset(alloc_offset);
@@ -175,11 +198,11 @@ class unserialized_secure_allocator_typed_test: public ::testing::Test {
                     << report_memory(alloc_offset, alloc_size * sizeof(TypeParam));
                 return 0;
             };
-            (
-                EXPECT_CALL(*mock_c_lib, munlock(memory_base + (page_size * page_num), page_size))
-                    .WillOnce(check_memory),
-                ...
-            );
+            for (auto [first_page, page_count] : to_page_runs(page_num...)) {
+                EXPECT_CALL(*mock_c_lib, munlock(memory_base + (page_size * first_page),
+                                                 page_size * page_count))
+                    .WillOnce(check_memory);
+            }
 
             EXPECT_CALL(*mock_allocator, void_deallocate(alloc_addr, alloc_size * sizeof(TypeParam)));
         }
@@ -347,7 +370,7 @@ TEST(serialized_secure_allocator_test, lock_held_during_allocate_and_deallocate)
     auto mock_c_lib = mock::c_lib::get_instance();
     auto allocator = std::make_unique<ec::serialized_no_swap_allocator<int, mock::monitored_allocator<int>>>();
     auto mock_allocator{mock::allocation_monitor::get_instance()};
-    auto& state_obj = *ec::details::no_swap_allocator_state::get_state_object();
+    auto& state_obj = ec::details::no_swap_allocator_state::get_state_object();
     state_obj.clear_pages(memory->get_memory_array().data(), memory->get_memory_array().size());
 
     int lock_count{};
@@ -373,3 +396,92 @@ TEST(serialized_secure_allocator_test, lock_held_during_allocate_and_deallocate)
 
     EXPECT_EQ(lock_count, 2);
 }
+
+class secure_resource_test: public ::testing::Test {
+  protected:
+    const std::size_t page_size{static_cast<std::size_t>(sysconf(_SC_PAGESIZE))};
+    std::shared_ptr<mock::memory> memory{mock::memory::get_instance()};
+    std::shared_ptr<mock::allocation_monitor> mock_allocator{mock::allocation_monitor::get_instance()};
+    std::shared_ptr<mock::c_lib> mock_c_lib{mock::c_lib::get_instance()};
+    mock::memory_resource upstream;
+
+    virtual void SetUp()
+    {
+        auto& mem = memory->get_memory_array();
+        memory->reset();
+        EXPECT_CALL(*mock_c_lib, memset(mem.data(), _, mem.size()))
+            .WillOnce(Return(memory->get_memory_array().data()));
+        memory->fill();
+        ec::details::no_swap_allocator_state::get_state_object().clear_pages(mem.data(), mem.size());
+    }
+
+    bool is_memory_zeroed_out(std::size_t offset, std::size_t len)
+    {
+        const auto& mem = memory->get_memory_array();
+        auto is_zeroed = [](const auto& v) { return v == std::byte{0}; };
+        return (std::all_of(std::next(mem.begin(), offset), std::next(mem.begin(), offset + len),
+                            is_zeroed));
+    }
+};
+
+TEST_F(secure_resource_test, locks_and_zeros_memory)
+{
+    auto memory_base = memory->get_memory_array().data();
+    ec::pmr::secure_resource resource{&upstream};
+
+    EXPECT_CALL(*mock_allocator, void_allocate(page_size));
+    EXPECT_CALL(*mock_c_lib, mlock(memory_base, page_size))
+        .WillOnce(Return(0));
+    auto* ptr = resource.allocate(page_size);
+    EXPECT_EQ(ptr, memory_base);
+
+    EXPECT_CALL(*mock_c_lib, munlock(memory_base, page_size))
+        .WillOnce([this](const void*, std::size_t) {
+            EXPECT_TRUE(is_memory_zeroed_out(0, page_size));
+            return 0;
+        });
+    EXPECT_CALL(*mock_allocator, void_deallocate(memory_base, page_size));
+    resource.deallocate(ptr, page_size);
+}
+
+TEST_F(secure_resource_test, upstream_of_monotonic_buffer_resource)
+{
+    auto memory_base = memory->get_memory_array().data();
+    ec::pmr::secure_resource resource{&upstream};
+
+    std::size_t arena_size{};
+
+    EXPECT_CALL(*mock_allocator, void_allocate(_))
+        .WillOnce([this, &arena_size](std::size_t n) {
+            arena_size = n;
+            return memory->acquire(n);
+        });
+    EXPECT_CALL(*mock_c_lib, mlock(memory_base, _))
+        .WillOnce(Return(0));
+    {
+        std::pmr::monotonic_buffer_resource arena{page_size, &resource};
+        ec::pmr::secure::vector<int> v{&arena};
+        for (int i = 0; i < 100; ++i) {
+            v.push_back(i);
+        }
+        EXPECT_EQ(v.get_allocator().resource(), &arena);
+
+        EXPECT_CALL(*mock_c_lib, munlock(memory_base, _))
+            .WillOnce([this, &arena_size](const void*, std::size_t) {
+                EXPECT_TRUE(is_memory_zeroed_out(0, arena_size));
+                return 0;
+            });
+        EXPECT_CALL(*mock_allocator, void_deallocate(memory_base, _));
+    }
+}
+
+TEST(secure_pmr_allocator_test, defaults_to_secure_resource)
+{
+    ec::pmr::secure_allocator<int> allocator;
+    EXPECT_EQ(allocator.resource(), ec::pmr::get_secure_resource());
+
+    std::pmr::monotonic_buffer_resource arena;
+    ec::pmr::secure::vector<int> v{&arena};
+    auto copy = v;
+    EXPECT_EQ(copy.get_allocator().resource(), ec::pmr::get_secure_resource());
+}
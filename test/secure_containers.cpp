@@ -19,6 +19,9 @@
 
 #include <cstddef>
 #include <enhanced_containers/secure_deque.h>
+#include <enhanced_containers/secure_flat_hash_map.h>
+#include <enhanced_containers/secure_flat_map.h>
+#include <enhanced_containers/secure_flat_set.h>
 #include <enhanced_containers/secure_forward_list.h>
 #include <enhanced_containers/secure_list.h>
 #include <enhanced_containers/secure_map.h>
@@ -97,6 +100,16 @@ struct test_value_generator {
 }
 
 
+// The secure allocators carry no state of their own, so the containers are the same size as their
+// std counterparts.
+static_assert(std::is_empty_v<ec::unserialized_secure_allocator<int>>);
+static_assert(std::is_empty_v<ec::serialized_secure_allocator<int>>);
+static_assert(ec::serialized_secure_allocator<int>::is_always_equal::value);
+static_assert(sizeof(ec::serialized_secure::string) == sizeof(std::string));
+static_assert(sizeof(ec::serialized_secure::vector<int>) == sizeof(std::vector<int>));
+static_assert(sizeof(ec::serialized_secure::map<int, int>) == sizeof(std::map<int, int>));
+static_assert(sizeof(ec::unserialized_secure::unordered_map<int, int>) == sizeof(std::unordered_map<int, int>));
+
 template <typename TypeParam>
 class secure_containers_typed_test: public ::testing::Test {
   protected:
@@ -111,7 +124,7 @@ class secure_containers_typed_test: public ::testing::Test {
         EXPECT_CALL(*mock_c_lib, memset(mem.data(), _, mem.size()))
             .WillOnce(Return(memory->get_memory_array().data()));
         memory->fill();
-        ec::details::no_swap_allocator_state::get_state_object()->clear_pages(mem.data(), mem.size());
+        ec::details::no_swap_allocator_state::get_state_object().clear_pages(mem.data(), mem.size());
     }
 
     virtual void TearDown()
@@ -170,11 +183,14 @@ using test_types = ::testing::Types<
     ec::unserialized_secure::map<std::uint32_t, std::uint32_t, std::less<std::uint32_t>, pair_monitored_allocator>,
     ec::unserialized_secure::multiset<std::uint32_t, std::less<std::uint32_t>, monitored_allocator>,
     ec::unserialized_secure::multimap<std::uint32_t, std::uint32_t, std::less<std::uint32_t>, pair_monitored_allocator>,
+    ec::unserialized_secure::flat_set<std::uint32_t, std::less<std::uint32_t>, monitored_allocator>,
+    ec::unserialized_secure::flat_map<std::uint32_t, std::uint32_t, std::less<std::uint32_t>, monitored_allocator>,
 
     ec::unserialized_secure::unordered_set<std::uint32_t, std::hash<std::uint32_t>, std::equal_to<std::uint32_t>, monitored_allocator>,
     ec::unserialized_secure::unordered_map<std::uint32_t, std::uint32_t, std::hash<std::uint32_t>, std::equal_to<std::uint32_t>, pair_monitored_allocator>,
     ec::unserialized_secure::unordered_multiset<std::uint32_t, std::hash<std::uint32_t>, std::equal_to<std::uint32_t>, monitored_allocator>,
-    ec::unserialized_secure::unordered_multimap<std::uint32_t, std::uint32_t, std::hash<std::uint32_t>, std::equal_to<std::uint32_t>, pair_monitored_allocator>
+    ec::unserialized_secure::unordered_multimap<std::uint32_t, std::uint32_t, std::hash<std::uint32_t>, std::equal_to<std::uint32_t>, pair_monitored_allocator>,
+    ec::unserialized_secure::flat_hash_map<std::uint32_t, std::uint32_t, std::hash<std::uint32_t>, std::equal_to<std::uint32_t>, pair_monitored_allocator>
     >;
 
 TYPED_TEST_SUITE(secure_containers_typed_test, test_types);
@@ -0,0 +1,170 @@
+/**
+ * @file
+ * Unit tests for the secure string with an inline buffer.
+ *
+ * @copyright 2023 Steve Kinneberg <steve.kinneberg@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <enhanced_containers/secure_inline_string.h>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+
+using namespace std::literals;
+
+namespace {
+std::size_t allocations{};
+
+/// @brief Allocator that counts allocations.
+template <typename T>
+struct counting_allocator {
+    using value_type = T;
+
+    counting_allocator() = default;
+    template <typename U> counting_allocator(const counting_allocator<U>&) {}
+
+    T* allocate(std::size_t n) { ++allocations; return std::allocator<T>{}.allocate(n); }
+    void deallocate(T* p, std::size_t n) { std::allocator<T>{}.deallocate(p, n); }
+
+    bool operator==(const counting_allocator&) const = default;
+};
+
+using string16 = ec::basic_secure_inline_string<16, char, std::char_traits<char>, counting_allocator<char>>;
+
+/// @brief Check that a buffer holds nothing but zeroes.
+bool is_wiped(const char* p, std::size_t len)
+{
+    return std::all_of(p, p + len, [](char c) { return c == 0; });
+}
+}
+
+TEST(secure_inline_string_test, short_contents_stay_inline)
+{
+    allocations = 0;
+    string16 s{"correct horse"};
+
+    EXPECT_TRUE(s.is_inline());
+    EXPECT_EQ(s, "correct horse"sv);
+    EXPECT_EQ(s.size(), 13);
+    EXPECT_EQ(s.capacity(), 16);
+    EXPECT_EQ(s.c_str()[13], '\0');
+
+    s += "xyz";
+    s.reserve(16);
+    EXPECT_TRUE(s.is_inline());
+    EXPECT_EQ(allocations, 0);
+}
+
+TEST(secure_inline_string_test, long_contents_use_allocator)
+{
+    allocations = 0;
+    string16 s{"battery"};
+    const auto* buffer = s.data();
+
+    s.append(" staple and more");
+    EXPECT_FALSE(s.is_inline());
+    EXPECT_EQ(allocations, 1);
+    EXPECT_EQ(s, "battery staple and more"sv);
+    // The inline buffer was wiped when the contents moved out.
+    EXPECT_TRUE(is_wiped(buffer, 16));
+
+    s.resize(5);
+    s.shrink_to_fit();
+    EXPECT_TRUE(s.is_inline());
+    EXPECT_EQ(s, "batte"sv);
+
+    s.append(s.data(), s.size());
+    EXPECT_EQ(s, "battebatte"sv);
+    s.append(s.data(), s.size());
+    EXPECT_EQ(s, "battebattebattebatte"sv);
+}
+
+TEST(secure_inline_string_test, clear_erase_and_pop_back_wipe)
+{
+    string16 s{"hunter2hunter2"};
+    const auto* buffer = s.data();
+
+    s.pop_back();
+    EXPECT_EQ(buffer[13], '\0');
+    s.erase(0, 7);
+    EXPECT_EQ(s, "hunter"sv);
+    EXPECT_TRUE(is_wiped(buffer + 6, 10));
+    s.clear();
+    EXPECT_TRUE(s.empty());
+    EXPECT_TRUE(is_wiped(buffer, 17));
+
+    EXPECT_THROW(s.erase(1), std::out_of_range);
+    EXPECT_THROW(s.at(0), std::out_of_range);
+}
+
+TEST(secure_inline_string_test, move_wipes_source)
+{
+    string16 a{"swordfish"};
+    const auto* a_buffer = a.data();
+    string16 b{std::move(a)};
+    const auto* b_buffer = b.data();
+
+    EXPECT_EQ(b, "swordfish"sv);
+    EXPECT_TRUE(a.empty());
+    EXPECT_TRUE(a.is_inline());
+    EXPECT_TRUE(is_wiped(a_buffer, 17));
+
+    string16 c{"a much longer secret than fits"};
+    a = std::move(c);
+    EXPECT_EQ(a, "a much longer secret than fits"sv);
+    EXPECT_TRUE(c.empty());
+    EXPECT_TRUE(c.is_inline());
+
+    b = std::move(a);
+    EXPECT_EQ(b, "a much longer secret than fits"sv);
+    EXPECT_TRUE(is_wiped(b_buffer, 17));
+
+    a = "short";
+    swap(a, b);
+    EXPECT_EQ(a, "a much longer secret than fits"sv);
+    EXPECT_EQ(b, "short"sv);
+
+    string16 d{b};
+    EXPECT_EQ(d, b);
+    d = a;
+    EXPECT_EQ(d, a);
+}
+
+TEST(secure_inline_string_test, destruction_wipes_inline_buffer)
+{
+    alignas(string16) std::byte storage[sizeof(string16)];
+    auto* s = new (storage) string16{"open sesame"};
+    const auto* buffer = s->data();
+    s->~string16();
+
+    EXPECT_TRUE(is_wiped(buffer, 17));
+}
+
+TEST(secure_inline_string_test, default_allocator)
+{
+    ec::secure_inline_string<8> s{"pin"};
+    EXPECT_TRUE(s.is_inline());
+    s.append(100, 'x');
+    EXPECT_FALSE(s.is_inline());
+    EXPECT_EQ(s.size(), 103);
+    EXPECT_TRUE(s < "piz"sv);
+}
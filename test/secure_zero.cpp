@@ -0,0 +1,124 @@
+/**
+ * @file
+ * Unit tests for wiping memory in a way that the compiler is not allowed to optimize away.
+ *
+ * @copyright 2023 Steve Kinneberg <steve.kinneberg@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <enhanced_containers/secure_zero.h>
+
+#include "mock_c_lib.h"
+#include "mock_memory.h"
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <array>
+#include <vector>
+
+using ::testing::_;
+using ::testing::Return;
+using kernel = ec::details::secure_zero_kernel;
+
+class secure_zero_test: public ::testing::Test {
+  protected:
+    static constexpr std::array kernels{kernel::portable, kernel::sse2, kernel::avx2, kernel::avx512};
+
+    std::shared_ptr<mock::memory> memory{mock::memory::get_instance()};
+    std::shared_ptr<mock::c_lib> mock_c_lib{mock::c_lib::get_instance()};
+
+    virtual void SetUp()
+    {
+        auto& mem = memory->get_memory_array();
+        memory->reset();
+        EXPECT_CALL(*mock_c_lib, memset(mem.data(), _, mem.size()))
+            .WillOnce(Return(mem.data()));
+        memory->fill();
+    }
+
+    virtual void TearDown()
+    {
+        ec::details::reset_secure_zero_kernel();
+    }
+
+    static bool is_zeroed(const std::byte* begin, const std::byte* end)
+    {
+        return std::all_of(begin, end, [](auto v) { return v == std::byte{0}; });
+    }
+
+    static bool is_untouched(const std::byte* begin, const std::byte* end)
+    {
+        return std::none_of(begin, end, [](auto v) { return v == std::byte{0}; });
+    }
+};
+
+TEST_F(secure_zero_test, portable_kernel_calls_memset)
+{
+    auto* mem = memory->get_memory_array().data();
+    ASSERT_TRUE(ec::details::set_secure_zero_kernel(kernel::portable));
+
+    EXPECT_CALL(*mock_c_lib, memset(mem + 16, 0, 100))
+        .WillOnce(Return(mem + 16));
+    ec::secure_zero(mem + 16, 100);
+
+    EXPECT_TRUE(is_untouched(mem, mem + 16));
+    EXPECT_TRUE(is_zeroed(mem + 16, mem + 116));
+    EXPECT_TRUE(is_untouched(mem + 116, mem + 200));
+}
+
+TEST_F(secure_zero_test, exact_range_zeroed)
+{
+    auto& data = memory->get_memory_array();
+    auto* mem = data.data();
+
+    // Refilling the memory and the portable kernel both call memset.
+    EXPECT_CALL(*mock_c_lib, memset(_, _, _))
+        .WillRepeatedly([](void* s, int, std::size_t) { return s; });
+
+    for (auto k : kernels) {
+        if (!ec::details::set_secure_zero_kernel(k)) {
+            continue;
+        }
+        for (std::size_t offset : {0, 1, 7, 31, 64}) {
+            for (std::size_t len : {1, 15, 16, 17, 63, 64, 65, 100, 255, 256, 4097}) {
+                SCOPED_TRACE(fmt::format("kernel = {}  offset = {}  len = {}",
+                                         static_cast<int>(k), offset, len));
+                std::fill(data.begin(), data.end(), std::byte{0x5a});
+                ec::secure_zero(mem + offset, len);
+                EXPECT_TRUE(is_untouched(mem, mem + offset));
+                EXPECT_TRUE(is_zeroed(mem + offset, mem + offset + len));
+                EXPECT_TRUE(is_untouched(mem + offset + len, mem + offset + len + 64));
+            }
+        }
+    }
+}
+
+TEST_F(secure_zero_test, large_buffer_non_temporal)
+{
+    constexpr std::size_t len{ec::details::secure_zero_non_temporal_threshold * 3 + 5};
+    std::vector<std::byte> buffer(len + 128, std::byte{0x5a});
+
+    for (auto k : kernels) {
+        if (!ec::details::set_secure_zero_kernel(k)) {
+            continue;
+        }
+        SCOPED_TRACE(fmt::format("kernel = {}", static_cast<int>(k)));
+        std::fill(buffer.begin(), buffer.end(), std::byte{0x5a});
+        ec::secure_zero(buffer.data() + 3, len);
+        EXPECT_TRUE(is_untouched(buffer.data(), buffer.data() + 3));
+        EXPECT_TRUE(is_zeroed(buffer.data() + 3, buffer.data() + 3 + len));
+        EXPECT_TRUE(is_untouched(buffer.data() + 3 + len, buffer.data() + buffer.size()));
+    }
+}
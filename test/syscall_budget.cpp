@@ -0,0 +1,181 @@
+/**
+ * @file
+ * Syscall and wipe budgets for canonical secure container workloads.
+ *
+ * @copyright 2023 Steve Kinneberg <steve.kinneberg@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <enhanced_containers/no_swap_allocator.h>
+#include <enhanced_containers/secure_flat_hash_map.h>
+#include <enhanced_containers/secure_map.h>
+#include <enhanced_containers/secure_string.h>
+#include <enhanced_containers/secure_vector.h>
+
+#include "mock_c_lib.h"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstddef>
+#include <vector>
+
+/*
+ * These tests count the memory locking calls and the bytes wiped by canonical workloads and hold
+ * them to the budgets below.  Counts do not depend on timing, so a change that makes the secure
+ * allocators pin or wipe far more than they need to fails deterministically.
+ *
+ * Memory locking is simulated so that the workloads are not limited by RLIMIT_MEMLOCK.  The budgets
+ * leave some headroom over what the current implementation uses so that they do not depend on the
+ * exact behavior of malloc.  Tighten them when an optimization lowers the counts.
+ */
+
+namespace {
+
+/// Resources used by a workload.
+struct usage {
+    std::size_t mlock_calls{};
+    std::size_t munlock_calls{};
+    std::size_t mlock_bytes{};
+    std::size_t wiped_bytes{};
+};
+
+/// Run a workload and measure the resources it used.
+template <typename F>
+usage measure(F&& workload)
+{
+    mock::c_lib::simulate_memory_locking(true);
+    mock::c_lib::reset_counts();
+    auto before = ec::no_swap_allocator_snapshot();
+
+    workload();
+
+    auto after = ec::no_swap_allocator_snapshot();
+    auto counts = mock::c_lib::counts();
+    mock::c_lib::simulate_memory_locking(false);
+
+    // Every workload releases everything it pinned.
+    EXPECT_EQ(after.live_allocations, before.live_allocations);
+    EXPECT_EQ(after.pinned_pages, before.pinned_pages);
+    EXPECT_EQ(counts.mlock_bytes, counts.munlock_bytes);
+
+    usage used{counts.mlock_calls, counts.munlock_calls, counts.mlock_bytes,
+               static_cast<std::size_t>(after.bytes_wiped - before.bytes_wiped)};
+    ::testing::Test::RecordProperty("mlock_calls", static_cast<int>(used.mlock_calls));
+    ::testing::Test::RecordProperty("munlock_calls", static_cast<int>(used.munlock_calls));
+    ::testing::Test::RecordProperty("wiped_bytes", static_cast<int>(used.wiped_bytes));
+    return used;
+}
+
+constexpr std::size_t KiB{1024};
+constexpr std::size_t MiB{1024 * KiB};
+
+} // namespace
+
+TEST(syscall_budget_test, build_10k_element_map)
+{
+    constexpr int element_count{10'000};
+
+    auto used = measure([] {
+        ec::serialized_secure::map<int, int> m;
+        for (int i = 0; i < element_count; ++i) {
+            m.emplace(i, i);
+        }
+    });
+
+    // Nodes are allocated one at a time, so at worst every page of nodes is locked separately.
+    EXPECT_LE(used.mlock_calls, 150U);
+    EXPECT_LE(used.munlock_calls, 150U);
+    EXPECT_LE(used.wiped_bytes, element_count * 48U);
+}
+
+TEST(syscall_budget_test, grow_vector_to_64_mib)
+{
+    constexpr std::size_t final_size{64 * MiB};
+
+    auto used = measure([] {
+        ec::serialized_secure::vector<char> v;
+        while (v.size() < final_size) {
+            v.resize(v.size() + 64 * KiB);
+        }
+    });
+
+    // Geometric growth: one lock per reallocation and everything released adds up to less than
+    // twice the final capacity.
+    EXPECT_LE(used.mlock_calls, 12U);
+    EXPECT_LE(used.munlock_calls, 12U);
+    EXPECT_LE(used.mlock_bytes, 2 * final_size + 16 * KiB);
+    EXPECT_LE(used.wiped_bytes, 2 * final_size);
+}
+
+TEST(syscall_budget_test, churn_10k_pooled_strings)
+{
+    constexpr int string_count{10'000};
+
+    auto churn = [] {
+        for (int i = 0; i < string_count; ++i) {
+            ec::pooled_secure::string s(64, 'x');
+        }
+    };
+
+    // The pool keeps its pinned memory, so once warmed up churning through strings must not make
+    // any memory locking calls at all.
+    churn();
+    auto used = measure(churn);
+
+    EXPECT_EQ(used.mlock_calls, 0U);
+    EXPECT_EQ(used.munlock_calls, 0U);
+    EXPECT_LE(used.wiped_bytes, string_count * 72U);
+}
+
+TEST(syscall_budget_test, churn_10k_strings_with_retention)
+{
+    constexpr int string_count{10'000};
+
+    ec::set_no_swap_retention_policy({.max_bytes = 64 * KiB, .max_idle = std::chrono::hours{1}});
+    auto used = measure([] {
+        for (int i = 0; i < string_count; ++i) {
+            ec::serialized_secure::string s(64, 'x');
+        }
+        ec::release_retained_pages();
+    });
+    ec::set_no_swap_retention_policy({});
+
+    // Without retention every string locks and unlocks its page.  With it, the page stays locked
+    // until the end.
+    EXPECT_LE(used.mlock_calls, 2U);
+    EXPECT_LE(used.munlock_calls, 2U);
+    EXPECT_LE(used.wiped_bytes, string_count * 72U);
+}
+
+TEST(syscall_budget_test, insert_and_erase_10k_hash_map_elements)
+{
+    constexpr int element_count{10'000};
+
+    auto used = measure([] {
+        ec::serialized_secure::flat_hash_map<int, int> m;
+        for (int i = 0; i < element_count; ++i) {
+            m.emplace(i, i);
+        }
+        for (int i = 0; i < element_count; ++i) {
+            m.erase(i);
+        }
+    });
+
+    // Tables double in size, so only a dozen or so allocations are locked.  Erasing wipes only
+    // the erased slots, and growing wipes the old tables.
+    EXPECT_LE(used.mlock_calls, 16U);
+    EXPECT_LE(used.munlock_calls, 16U);
+    EXPECT_LE(used.wiped_bytes, element_count * 64U);
+}
@@ -0,0 +1,277 @@
+/**
+ * @file
+ * Unit tests for the vector and string that wipe removed elements.
+ *
+ * @copyright 2023 Steve Kinneberg <steve.kinneberg@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <enhanced_containers/secure_wiping_string.h>
+#include <enhanced_containers/secure_wiping_vector.h>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <new>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace {
+/// @brief Check that a buffer holds nothing but zeroes.
+template <typename T>
+bool is_wiped(const T* p, std::size_t len)
+{
+    return std::all_of(p, p + len, [](T v) { return v == T{}; });
+}
+
+/// @brief Allocator whose instances never compare equal, so moves cannot steal buffers.
+template <typename T>
+struct unequal_allocator: std::allocator<T> {
+    template <typename U> struct rebind { using other = unequal_allocator<U>; };
+    using propagate_on_container_move_assignment = std::false_type;
+    using is_always_equal = std::false_type;
+
+    unequal_allocator() = default;
+    template <typename U> unequal_allocator(const unequal_allocator<U>&) {}
+
+    bool operator==(const unequal_allocator&) const { return false; }
+};
+
+const std::string secret = "correct horse battery staple, and then some more";
+}
+
+TEST(wiping_vector_test, shrinking_wipes_only_the_vacated_tail)
+{
+    ec::wiping_vector<std::uint32_t> v{1, 2, 3, 4, 5, 6, 7, 8};
+    const auto* p = v.data();
+
+    v.pop_back();
+    EXPECT_TRUE(is_wiped(p + 7, 1));
+
+    v.erase(v.begin());
+    EXPECT_EQ(v.front(), 2U);
+    EXPECT_TRUE(is_wiped(p + 6, 2));
+
+    v.erase(v.begin(), v.begin() + 2);
+    EXPECT_TRUE(is_wiped(p + 4, 4));
+
+    v.resize(2);
+    EXPECT_TRUE(is_wiped(p + 2, 6));
+    EXPECT_EQ(v[0], 4U);
+    EXPECT_EQ(v[1], 5U);
+
+    v.resize(3, 9);
+    EXPECT_EQ(v[2], 9U);
+
+    v.assign(1, 7);
+    EXPECT_TRUE(is_wiped(p + 1, 7));
+
+    v = {1, 2, 3};
+    v.clear();
+    EXPECT_EQ(v.data(), p);
+    EXPECT_TRUE(is_wiped(p, 8));
+}
+
+TEST(wiping_vector_test, clear_and_refill_leaves_capacity_alone)
+{
+    ec::wiping_vector<char> v;
+    v.reserve(1024);
+    std::fill_n(v.data(), v.capacity(), 'x');
+
+    v.assign(16, 's');
+    v.clear();
+    EXPECT_TRUE(is_wiped(v.data(), 16));
+    // Bytes that were never part of the vector are not touched.
+    EXPECT_EQ(v.data()[16], 'x');
+    EXPECT_EQ(v.data()[1023], 'x');
+}
+
+TEST(wiping_vector_test, moved_from_source_is_wiped)
+{
+    using vector = ec::wiping_vector<char, unequal_allocator<char>>;
+    vector src(secret.begin(), secret.end());
+    const auto* p = src.data();
+
+    vector dst;
+    dst = std::move(src);
+    EXPECT_EQ(std::string(dst.begin(), dst.end()), secret);
+    EXPECT_TRUE(src.empty());
+    EXPECT_TRUE(is_wiped(p, secret.size()));
+
+    ec::serialized_secure::wiping_vector<char> stolen(secret.begin(), secret.end());
+    auto taken = std::move(stolen);
+    EXPECT_EQ(taken.size(), secret.size());
+}
+
+TEST(wiping_vector_test, erase_and_erase_if_wipe_the_vacated_tail)
+{
+    ec::wiping_vector<std::uint32_t> v{1, 2, 3, 2, 5, 6, 7, 2};
+    const auto* p = v.data();
+
+    EXPECT_EQ(ec::erase(v, 2U), 3U);
+    EXPECT_EQ(v, (std::vector<std::uint32_t>{1, 3, 5, 6, 7}));
+    EXPECT_TRUE(is_wiped(p + 5, 3));
+
+    // Unqualified calls find the wiping overloads through argument dependent lookup.
+    EXPECT_EQ(erase_if(v, [](std::uint32_t x) { return x % 2 == 1; }), 4U);
+    EXPECT_EQ(v, (std::vector<std::uint32_t>{6}));
+    EXPECT_TRUE(is_wiped(p + 1, 7));
+}
+
+TEST(wiping_string_test, shrinking_wipes_only_the_vacated_tail)
+{
+    ec::serialized_secure::wiping_string s(secret);
+    const auto* p = s.data();
+    const auto size = s.size();
+
+    s.pop_back();
+    EXPECT_EQ(p[size - 1], '\0');
+    EXPECT_TRUE(is_wiped(p + size - 1, 2));
+
+    s.erase(0, 4);
+    EXPECT_EQ(std::string_view(s), secret.substr(4, size - 5));
+    EXPECT_TRUE(is_wiped(p + s.size(), 6));
+
+    s.erase(s.begin());
+    s.erase(s.begin(), s.begin() + 2);
+    EXPECT_TRUE(is_wiped(p + s.size(), size + 1 - s.size()));
+
+    s.resize(5);
+    EXPECT_EQ(std::string_view(s), secret.substr(7, 5));
+    EXPECT_TRUE(is_wiped(p + 5, size - 4));
+
+    s = "abc";
+    EXPECT_TRUE(is_wiped(p + 3, size - 2));
+
+    s.replace(0, 3, "z");
+    EXPECT_EQ(s, "z");
+    EXPECT_TRUE(is_wiped(p + 1, size));
+
+    s.assign(secret);
+    s.clear();
+    EXPECT_EQ(s.data(), p);
+    EXPECT_TRUE(is_wiped(p, size + 1));
+}
+
+TEST(wiping_string_test, moved_from_source_is_wiped)
+{
+    // Short strings are copied out of the small string buffer, which must then be wiped.
+    ec::wiping_string small("hunter2");
+    const auto* p = small.data();
+    auto moved = std::move(small);
+    EXPECT_EQ(moved, "hunter2");
+    EXPECT_EQ(small.data(), p);
+    EXPECT_TRUE(is_wiped(p, 8));
+
+    ec::wiping_string assigned;
+    ec::wiping_string other("letmein");
+    p = other.data();
+    assigned = std::move(other);
+    EXPECT_EQ(assigned, "letmein");
+    EXPECT_TRUE(is_wiped(p, 8));
+
+    // Long strings with allocators that cannot steal the buffer are copied as well.
+    using string = ec::wiping_basic_string<char, std::char_traits<char>, unequal_allocator<char>>;
+    string src(secret.c_str());
+    string dst;
+    p = src.data();
+    dst = std::move(src);
+    EXPECT_EQ(std::string_view(dst), secret);
+    EXPECT_TRUE(src.empty());
+    EXPECT_TRUE(is_wiped(p, secret.size() + 1));
+
+    // Stealing a long string may hand the destination's old allocation to the source.
+    ec::wiping_string old_secret(40, 'A');
+    ec::wiping_string new_secret(40, 'B');
+    old_secret = std::move(new_secret);
+    EXPECT_EQ(old_secret, std::string(40, 'B'));
+    EXPECT_TRUE(new_secret.empty());
+    EXPECT_TRUE(is_wiped(new_secret.data(), new_secret.capacity() + 1));
+}
+
+TEST(wiping_string_test, growing_out_of_the_small_string_buffer_wipes_it)
+{
+    // The standard library only overwrites part of the small string buffer when growing into an
+    // allocation, so the rest of a short secret would stay in the object.
+    const std::vector<std::function<void(ec::wiping_string&)>> grow{
+        [](auto& s) { s.append(20, 'x'); },
+        [](auto& s) { s += std::string(20, 'x'); },
+        [](auto& s) { s.push_back('x'); },
+        [](auto& s) { s.insert(0, "xx"); },
+        [](auto& s) { s.insert(s.begin(), {'x', 'x'}); },
+        [](auto& s) { s.reserve(64); },
+        [](auto& s) { s.resize(40, 'x'); },
+        [](auto& s) { s.assign(40, 'x'); },
+        [](auto& s) { s = std::string(40, 'x'); },
+        [](auto& s) { s = ec::wiping_string(40, 'x'); },
+    };
+
+    for (const auto& f : grow) {
+        alignas(ec::wiping_string) std::byte storage[sizeof(ec::wiping_string)];
+        auto leaked = [&storage] {
+            std::string_view bytes{reinterpret_cast<const char*>(storage), sizeof(storage)};
+            return bytes.find("IJKLMNO") != std::string_view::npos;
+        };
+
+        auto* s = new (storage) ec::wiping_string("ABCDEFGHIJKLMNO");
+        ASSERT_TRUE(leaked());
+        f(*s);
+        EXPECT_FALSE(leaked());
+        s->~wiping_basic_string();
+        EXPECT_FALSE(leaked());
+    }
+
+    // Growing through the base class bypasses the wiping, but destroying the string does not.
+    alignas(ec::wiping_string) std::byte storage[sizeof(ec::wiping_string)];
+    auto* s = new (storage) ec::wiping_string("ABCDEFGHIJKLMNO");
+    static_cast<std::string&>(*s).append(20, 'x');
+    s->~wiping_basic_string();
+    std::string_view bytes{reinterpret_cast<const char*>(storage), sizeof(storage)};
+    EXPECT_EQ(bytes.find("IJKLMNO"), std::string_view::npos);
+}
+
+TEST(wiping_string_test, erase_and_erase_if_wipe_the_vacated_tail)
+{
+    ec::wiping_string s(secret.c_str());
+    const auto* p = s.data();
+    const auto size = s.size();
+
+    auto spaces = static_cast<std::size_t>(std::count(secret.begin(), secret.end(), ' '));
+    EXPECT_EQ(ec::erase(s, ' '), spaces);
+    EXPECT_EQ(s.find(' '), ec::wiping_string::npos);
+    EXPECT_TRUE(is_wiped(p + s.size(), size + 1 - s.size()));
+
+    EXPECT_EQ(erase_if(s, [](char c) { return c != 'e'; }), size - spaces - 7);
+    EXPECT_EQ(s, "eeeeeee");
+    EXPECT_TRUE(is_wiped(p + 7, size - 6));
+}
+
+TEST(wiping_string_test, behaves_like_a_string)
+{
+    ec::pooled_secure::wiping_string s("key");
+    s += "=value";
+    EXPECT_EQ(s, "key=value");
+    EXPECT_EQ(s.substr(0, 3), "key");
+    EXPECT_TRUE(s.starts_with("key"));
+
+    std::unordered_set<ec::wiping_string> set{"one", "two"};
+    EXPECT_TRUE(set.contains("two"));
+    EXPECT_EQ(std::hash<ec::wiping_string>{}("two"), std::hash<std::string_view>{}("two"));
+}